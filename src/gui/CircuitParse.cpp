@@ -314,7 +314,7 @@ bool CircuitParse::parseGateToSend(string type, string ID, string position, vect
 	}
 
 	if (libGate.logicType.size() > 0)
-		gCanvas->getCircuit()->sendMessageToCore(klsMessage::Message(klsMessage::MT_CREATE_GATE, new klsMessage::Message_CREATE_GATE(wxGetApp().libraries[wxGetApp().gateNameToLibrary[type]][type].logicType, id)));
+		gCanvas->getCircuit()->sendMessageToCore(klsMessage::Message(klsMessage::Message_CREATE_GATE(wxGetApp().libraries[wxGetApp().gateNameToLibrary[type]][type].logicType, id)));
 	// Create gate for GUI
 	istringstream issa(position.substr(0,position.find(",")+1));
 	issa >> x;
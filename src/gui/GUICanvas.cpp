@@ -626,19 +626,13 @@ void GUICanvas::OnMouseMove( GLdouble glX, GLdouble glY, bool ShiftDown, bool Ct
 	if (wxGetApp().appSystemTime.Time() > wxGetApp().appSettings.refreshRate) {
 		wxGetApp().appSystemTime.Pause();
 		if (gCircuit->panic) return;
-		wxCriticalSectionLocker locker(wxGetApp().m_critsect);
-		while (wxGetApp().mexMessages.TryLock() == wxMUTEX_BUSY) wxYield();
-		while (wxGetApp().dLOGICtoGUI.size() > 0) {
-			gCircuit->parseMessage(wxGetApp().dLOGICtoGUI.front());
-			wxGetApp().dLOGICtoGUI.pop_front();
-		}
-		wxGetApp().mexMessages.Unlock();
+		gCircuit->receiveMessagesFromCore();
 		if (gCircuit->panic) return;
 		// Do function of number of milliseconds that passed since last step
 		gCircuit->lastTime = wxGetApp().appSystemTime.Time();
 		gCircuit->lastTimeMod = wxGetApp().timeStepMod;
 		gCircuit->lastNumSteps = wxGetApp().appSystemTime.Time() / wxGetApp().timeStepMod;
-		gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::MT_STEPSIM, new klsMessage::Message_STEPSIM(wxGetApp().appSystemTime.Time() / wxGetApp().timeStepMod)));
+		gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::Message_STEPSIM(wxGetApp().appSystemTime.Time() / wxGetApp().timeStepMod)));
 		gCircuit->setSimulate(false);
 		wxGetApp().appSystemTime.Start(wxGetApp().appSystemTime.Time() % wxGetApp().timeStepMod);
 		shouldRender = true;
@@ -1485,19 +1479,13 @@ void GUICanvas::Update() {
 	if (wxGetApp().appSystemTime.Time() > wxGetApp().appSettings.refreshRate) {
 		wxGetApp().appSystemTime.Pause();
 		if (gCircuit->panic) return;
-		wxCriticalSectionLocker locker(wxGetApp().m_critsect);
-		while (wxGetApp().mexMessages.TryLock() == wxMUTEX_BUSY) wxYield();
-		while (wxGetApp().dLOGICtoGUI.size() > 0) {
-			gCircuit->parseMessage(wxGetApp().dLOGICtoGUI.front());
-			wxGetApp().dLOGICtoGUI.pop_front();
-		}
-		wxGetApp().mexMessages.Unlock();
+		gCircuit->receiveMessagesFromCore();
 		if (gCircuit->panic) return;
 		// Do function of number of milliseconds that passed since last step
 		gCircuit->lastTime = wxGetApp().appSystemTime.Time();
 		gCircuit->lastTimeMod = wxGetApp().timeStepMod;
 		gCircuit->lastNumSteps = wxGetApp().appSystemTime.Time() / wxGetApp().timeStepMod;
-		gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::MT_STEPSIM, new klsMessage::Message_STEPSIM(wxGetApp().appSystemTime.Time() / wxGetApp().timeStepMod)));
+		gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::Message_STEPSIM(wxGetApp().appSystemTime.Time() / wxGetApp().timeStepMod)));
 		gCircuit->setSimulate(false);
 		wxGetApp().appSystemTime.Start(wxGetApp().appSystemTime.Time() % wxGetApp().timeStepMod);
 	}
@@ -220,44 +220,20 @@ void GUICircuit::parseMessage(klsMessage::Message message) {
 		case klsMessage::MT_SET_WIRE_STATE: {
 			// SET WIRE id STATE TO state
 			shouldRender = true;
-			klsMessage::Message_SET_WIRE_STATE* msgSetWireState = (klsMessage::Message_SET_WIRE_STATE*)(message.mStruct);
-			setWireState(msgSetWireState->wireId, msgSetWireState->state);
-			delete msgSetWireState;
+			setWireState(message.mSetWireState.wireId, message.mSetWireState.state);
 			break;
 		}
 		case klsMessage::MT_SET_GATE_PARAM: {
 			// SET GATE id PARAMETER name val
 			shouldRender = true;
 			klsMessage::Message_SET_GATE_PARAM* msgSetGateParam = (klsMessage::Message_SET_GATE_PARAM*)(message.mStruct);
-			if (gateList.find(msgSetGateParam->gateId) != gateList.end()) gateList[msgSetGateParam->gateId]->setLogicParam(msgSetGateParam->paramName, msgSetGateParam->paramValue);
-			//************************************************************
-			//Edit by Joshua Lansford 11/24/06
-			//the perpose of this edit is to allow logic gates to be able
-			//to pause the simulation.  This is so that the 
-			//Z_80LogicGate can 'single step' through T states and
-			//instruction states by pauseing the simulation when it
-			//compleates eather.
-			//
-			//The way that this is acomplished is that when ever any gate
-			//signals that a property has changed, and the name of that
-			//property is "PAUSE_SIM", then the core should bail out
-			//and not finnish the requested number of steps.
-			//The GUI will also see this property fly by and will toggle
-			//the pause button.
-			//
-			//This spacific edit is so that the GUI thread will
-			//hit the pause button
-			if( msgSetGateParam->paramName == "PAUSE_SIM" ){
-				pausing = true;
-				panic = true;
-			}
-			//End of edit*************************************************
+			setGateParam(*msgSetGateParam);
 			delete msgSetGateParam;
 			break;
 		}
 		case klsMessage::MT_DONESTEP: { // DONESTEP
 			simulate = true;
-			int logicTime = ((klsMessage::Message_DONESTEP*)(message.mStruct))->logicTime;
+			int logicTime = message.mDoneStep.logicTime;
 			// Panic if core isn't keeping up, keep a 3ms buffer...
 			panic = (logicTime > lastTime+3) || panic;
 			// Now we can send the waiting messages
@@ -266,40 +242,127 @@ void GUICircuit::parseMessage(klsMessage::Message message) {
 			// Only render at the end of a step and only if necessary
 			if (shouldRender) gCanvas->Refresh();
 			shouldRender = false;
-			delete ((klsMessage::Message_DONESTEP*)(message.mStruct));
 			break;
 		}
 		case klsMessage::MT_COMPLETE_INTERIM_STEP: {// COMPLETE INTERIM STEP - UPDATE OSCOPE
 			myOscope->UpdateData();
 			break;
 		}
+		case klsMessage::MT_WIRE_FRAME: {// WIRE FRAME - WIRE STATES OF A STEPSIM
+			klsMessage::Message_WIRE_FRAME* frame = (klsMessage::Message_WIRE_FRAME*)(message.mStruct);
+			if (!frame->changes.empty() || !frame->params.empty()) shouldRender = true;
+			// The oscope samples the wires after every step, even while it
+			// is hidden, so the steps are replayed while it is open or has
+			// any feeds. (Its last feed box is always the empty one.) They
+			// are also replayed when the gates changed parameters, so those
+			// come after the wires of their own step:
+			if (myOscope->IsShown() || myOscope->numberOfFeeds() > 1 || !frame->params.empty()) {
+				unsigned int change = 0, param = 0;
+				for (unsigned int step = 0; step < frame->stepEnds.size(); step++) {
+					for (; change < frame->stepEnds[step]; change++) {
+						applyWireState(frame->changes[change].wireId, frame->changes[change].state);
+					}
+					for (; param < frame->paramEnds[step]; param++) {
+						setGateParam(frame->params[param]);
+					}
+					myOscope->UpdateData();
+				}
+			} else {
+				for (unsigned int i = 0; i < frame->finalStates.size(); i++) {
+					applyWireState(frame->finalStates[i].wireId, frame->finalStates[i].state);
+				}
+				if (!frame->stepEnds.empty()) myOscope->UpdateData();
+			}
+			delete frame;
+			break;
+		}
+		case klsMessage::MT_RAM_CHANGES: {// RAM CHANGES - BLOCKS OF WORDS WRITTEN TO RAM GATES
+			shouldRender = true;
+			klsMessage::Message_RAM_CHANGES* ramChanges = (klsMessage::Message_RAM_CHANGES*)(message.mStruct);
+			for (unsigned int i = 0; i < ramChanges->gates.size(); i++) {
+				if (gateList.find(ramChanges->gates[i].gateId) != gateList.end()) gateList[ramChanges->gates[i].gateId]->setMemoryChanges(ramChanges->gates[i]);
+			}
+			delete ramChanges;
+			break;
+		}
 		default:
 			break;
 	}
 }
 
 void GUICircuit::sendMessageToCore(klsMessage::Message message) {
-	wxMutexLocker lock(wxGetApp().mexMessages);
-
-	if (waitToSendMessage) {
-		
-		if (simulate) {
-			wxGetApp().dGUItoLOGIC.push_back(message);
-		} else {
-			messageQueue.push_back(message);
-		}
-	} else{
-		wxGetApp().dGUItoLOGIC.push_back(message);
-	}	
+	if (waitToSendMessage && !simulate) {
+		messageQueue.push_back(message);
+		return;
+	}
+
+	// The GUI thread never waits for the core. Messages are kept in
+	// order behind the ones that didn't fit in the ring before:
+	flushMessagesToCore();
+	if (!pendingToCore.empty() || !wxGetApp().GUItoLOGIC.push(message)) {
+		pendingToCore.push_back(message);
+	}
+}
+
+void GUICircuit::flushMessagesToCore() {
+	while (!pendingToCore.empty() && wxGetApp().GUItoLOGIC.push(pendingToCore.front())) {
+		pendingToCore.pop_front();
+	}
+}
+
+void GUICircuit::receiveMessagesFromCore() {
+	flushMessagesToCore();
+	// Only parse what is there now, the core keeps sending meanwhile:
+	unsigned long long numMessages = wxGetApp().LOGICtoGUI.size();
+	klsMessage::Message message;
+	for (unsigned long long i = 0; i < numMessages && wxGetApp().LOGICtoGUI.pop(message); i++) {
+		parseMessage(message);
+	}
+}
+
+void GUICircuit::discardMessages() {
+	pendingToCore.clear();
+	wxGetApp().GUItoLOGIC.discard();
+	wxGetApp().LOGICtoGUI.discard();
 }
 
 void GUICircuit::setWireState( long wid, long state ) {
+	applyWireState(wid, state);
+	gCanvas->Refresh();
+	return;
+}
+
+void GUICircuit::applyWireState( long wid, long state ) {
 	// If the wire doesn't exist, then don't set it's state!
 	if( wireList.find(wid) == wireList.end() ) return;
 	
 	buslineToWire[wid]->setSubState(wid, state);
-	gCanvas->Refresh();
-	return;
+}
+
+void GUICircuit::setGateParam( const klsMessage::Message_SET_GATE_PARAM &param ) {
+	if (gateList.find(param.gateId) != gateList.end()) gateList[param.gateId]->setLogicParam(param.getParamName(), param.paramValue);
+	//********************************************************
+	//Edit by Joshua Lansford 11/24/06
+	//the perpose of this edit is to allow logic gates to be able
+	//to pause the simulation.  This is so that the 
+	//Z_80LogicGate can 'single step' through T states and
+	//instruction states by pauseing the simulation when it
+	//compleates eather.
+	//
+	//The way that this is acomplished is that when ever any gate
+	//signals that a property has changed, and the name of that
+	//property is "PAUSE_SIM", then the core should bail out
+	//and not finnish the requested number of steps.
+	//The GUI will also see this property fly by and will toggle
+	//the pause button.
+	//
+	//This spacific edit is so that the GUI thread will
+	//hit the pause button
+	if( param.getParamName() == "PAUSE_SIM" ){
+		pausing = true;
+		panic = true;
+	}
+	//End of edit*************************************************
 }
 
 void GUICircuit::printState() {
@@ -11,6 +11,7 @@
 #ifndef GUICIRCUIT_H_
 #define GUICIRCUIT_H_
 
+#include <deque>
 #include <map>
 #include <stack>
 #include <vector>
@@ -59,6 +60,10 @@ public:
 
 	// Sets a wire's state
 	void setWireState(long wid, long state);
+	// Sets a wire's state without refreshing the canvas
+	void applyWireState(long wid, long state);
+	// Sets a logic parameter the core changed on a gate
+	void setGateParam(const klsMessage::Message_SET_GATE_PARAM &param);
 	// Delete components and sync the core
 	void deleteWire(unsigned long wid);
 	void deleteGate(unsigned long gid, bool waitToUpdate = false);
@@ -72,6 +77,10 @@ public:
 
 	void sendMessageToCore(klsMessage::Message message);
 	void parseMessage(klsMessage::Message message);
+	// Parse the messages that the core has sent so far
+	void receiveMessagesFromCore();
+	// Throw away the messages that are on their way to and from the core
+	void discardMessages();
 	
 	void setSimulate(bool state) { simulate = state; };
 	bool getSimulate() { return simulate; };
@@ -124,6 +133,11 @@ private:
     unsigned long  m_LastRedraw;
  
     vector < klsMessage::Message > messageQueue;
+    // Messages that didn't fit in wxGetApp().GUItoLOGIC yet:
+    deque < klsMessage::Message > pendingToCore;
+
+	// Move pendingToCore into the ring, as far as there is room:
+	void flushMessagesToCore();
 };
 
 #endif /*GUICIRCUIT_H*/
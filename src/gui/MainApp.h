@@ -24,6 +24,7 @@
 #include "LibraryParse.h"
 #include "gl_defs.h"
 #include "klsMessage.h"
+#include "klsMessageRing.h"
 #include "settings_values.h"
 #include <deque>
 #include <string>
@@ -85,9 +86,11 @@ public:
 	wxSemaphore simulate;
 	wxSemaphore readyToSend;
 
-	wxMutex mexMessages;
-	deque< klsMessage::Message > dGUItoLOGIC;
-	deque< klsMessage::Message > dLOGICtoGUI;
+	// The messages between the GUI and the logic thread. The GUI thread only
+	// pushes to GUItoLOGIC and pops from LOGICtoGUI, and the logic thread the
+	// other way around, see klsMessageRing:
+	klsMessageRing< klsMessage::Message, 4096 > GUItoLOGIC;
+	klsMessageRing< klsMessage::Message, 65536 > LOGICtoGUI;
 	// Use a stopwatch for timing between step calls
 	wxStopWatch appSystemTime;
 	unsigned long timeStepMod;
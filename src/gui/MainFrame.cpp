@@ -411,6 +411,7 @@ MainFrame::~MainFrame() {
 	stopTimers();
 
 	// Shut down the detached thread and wait for it to exit
+	wxGetApp().logicThread->stop();
 	wxGetApp().logicThread->Delete();
 	wxGetApp().saveThread->Delete();
 
@@ -589,8 +590,7 @@ void MainFrame::OnNew(wxCommandEvent& event) {
 
 	pauseTimers();
 
-	wxGetApp().dGUItoLOGIC.clear();
-	wxGetApp().dLOGICtoGUI.clear();
+	gCircuit->discardMessages();
 
 	for (unsigned int i = 0; i < canvases.size(); i++) canvases[i]->clearCircuit();
 	gCircuit->reInitializeLogicCircuit();
@@ -666,8 +666,7 @@ void MainFrame::loadCircuitFile( string fileName ){
 	
 	openedFilename = path;
 	this->SetTitle(VERSION_TITLE() + " - " + path );
-	while (!(wxGetApp().dGUItoLOGIC.empty())) wxGetApp().dGUItoLOGIC.pop_front();
-	while (!(wxGetApp().dLOGICtoGUI.empty())) wxGetApp().dLOGICtoGUI.pop_front();
+	gCircuit->discardMessages();
 	for (unsigned int i = 0; i < canvases.size(); i++) canvases[i]->clearCircuit();
 	gCircuit->reInitializeLogicCircuit();
 	commandProcessor->ClearCommands();
@@ -679,7 +678,9 @@ void MainFrame::loadCircuitFile( string fileName ){
 	}
 	
     CircuitParse cirp((const char *)path.c_str(), canvases); // KAS
+	gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::MT_BEGIN_BATCH));
 	canvases = cirp.parseFile();
+	gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::MT_COMMIT_BATCH));
 	
 	//JV - Put pages back into canvas book
 	for (unsigned int i = 1; i < canvases.size(); i++) 
@@ -790,19 +791,13 @@ void MainFrame::OnTimer(wxTimerEvent& event) {
 	gCircuit->lastTime = wxGetApp().appSystemTime.Time();
 	gCircuit->lastTimeMod = wxGetApp().timeStepMod;
 	gCircuit->lastNumSteps = wxGetApp().appSystemTime.Time() / wxGetApp().timeStepMod;
-	gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::MT_STEPSIM, new klsMessage::Message_STEPSIM(wxGetApp().appSystemTime.Time() / wxGetApp().timeStepMod)));
+	gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::Message_STEPSIM(wxGetApp().appSystemTime.Time() / wxGetApp().timeStepMod)));
 	currentCanvas->getCircuit()->setSimulate(false);
 	wxGetApp().appSystemTime.Start(wxGetApp().appSystemTime.Time() % wxGetApp().timeStepMod);
 }
 
 void MainFrame::OnIdle(wxTimerEvent& event) {
-	wxCriticalSectionLocker locker(wxGetApp().m_critsect);
-	while (wxGetApp().mexMessages.TryLock() == wxMUTEX_BUSY) wxYield();
-	while (wxGetApp().dLOGICtoGUI.size() > 0) {
-		gCircuit->parseMessage(wxGetApp().dLOGICtoGUI.front());
-		wxGetApp().dLOGICtoGUI.pop_front();
-	}
-	wxGetApp().mexMessages.Unlock();
+	gCircuit->receiveMessagesFromCore();
 
 	if (mainSizer == NULL) return;
 	
@@ -1189,7 +1184,7 @@ void MainFrame::OnStep(wxCommandEvent& event) {
 	if (!(currentCanvas->getCircuit()->getSimulate())) {
 		return;
 	}
-	gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::MT_STEPSIM, new klsMessage::Message_STEPSIM(1)));
+	gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::Message_STEPSIM(1)));
 	currentCanvas->getCircuit()->setSimulate(false);
 }
 
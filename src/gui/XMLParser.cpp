@@ -26,9 +26,9 @@ XMLParser::XMLParser(fstream* strIO, bool writing)
 
 		// Pedro Casanova (casanova@ujaen.es) 2020/04-12
 		// Now permit LF (UNIX) and CRLF (WINDOWS)
-		if (temp.c_str()[strlen(temp.c_str()) - 1] == '\r')
+		if (!temp.empty() && temp[temp.length() - 1] == '\r')
 		{
-			temp[strlen(temp.c_str()) - 1] = '\n';
+			temp[temp.length() - 1] = '\n';
 			lines.push_back(temp);
 		}
 		else
@@ -218,6 +218,11 @@ bool XMLParser::isCloseTag(long idx) {
 	return (nextToken.tokenType == XML_CTAG);
 }
 
+// isEOF returns true iff the whole file has been read
+bool XMLParser::isEOF() {
+	return (nextToken.tokenType == XML_EOF);
+}
+
 // readTag reads and opens a tag for reading its value
 //	returns null string if the token is a close tag
 string XMLParser::readTag() {
@@ -247,6 +252,18 @@ string XMLParser::readCloseTag() {
 	return returnToken.data;
 }
 
+// skipTag skips the rest of the most open tag, including
+//	any tags inside of it, and closes it
+void XMLParser::skipTag() {
+	while (nextToken.tokenType != XML_EOF) {
+		if (readTag() == "") {
+			readCloseTag();
+			return;
+		}
+		skipTag();
+	}
+}
+
 // Debug function used to print out the vector of lines
 void XMLParser::printAllLines(ostream& oss) {
 	for (unsigned int i = 0; i < lines.size(); i++)
@@ -61,9 +61,11 @@ public:
 	string readTag();
 	string readTagValue(string tagName);
 	string readCloseTag();
+	void skipTag();
 	long getCurrentIndex();
 	bool isTag(long);
 	bool isCloseTag(long);
+	bool isEOF();
 	
 	void printAllLines(ostream&);
 	
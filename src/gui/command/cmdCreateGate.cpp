@@ -34,7 +34,7 @@ bool cmdCreateGate::Do() {
 	string logicType = wxGetApp().libParser.getGateLogicType(gateType);
 	if (logicType.size() > 0) {
 		ostringstream oss;
-		gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::MT_CREATE_GATE, new klsMessage::Message_CREATE_GATE(logicType, gid)));
+		gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::Message_CREATE_GATE(logicType, gid)));
 	} // if( logic type is non-null )
 
 	cmdSetParams setgateparams(gCircuit, gid, paramSet((*(gCircuit->getGates()))[gid]->getAllGUIParams(), (*(gCircuit->getGates()))[gid]->getAllLogicParams()), fromString);
@@ -112,7 +112,7 @@ bool cmdCreateGate::Undo() {
 	gCircuit->deleteGate(gid);
 	string logicType = wxGetApp().libParser.getGateLogicType(gateType);
 	if (logicType.size() > 0) {
-		gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::MT_DELETE_GATE, new klsMessage::Message_DELETE_GATE(gid)));
+		gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::Message_DELETE_GATE(gid)));
 	}
 	return true;
 }
@@ -113,7 +113,7 @@ bool cmdDeleteGate::Do() {
 	gCircuit->deleteGate(gateId, true);
 	std::string logicType = wxGetApp().libParser.getGateLogicType(gateType);
 	if (logicType.size() > 0) {
-		gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::MT_DELETE_GATE, new klsMessage::Message_DELETE_GATE(gateId)));
+		gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::Message_DELETE_GATE(gateId)));
 	}
 	return true;
 }
@@ -123,7 +123,7 @@ bool cmdDeleteGate::Undo() {
 
 	std::string logicType = wxGetApp().libParser.getGateLogicType(gateType);
 	if (logicType.size() > 0) {
-		gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::MT_CREATE_GATE, new klsMessage::Message_CREATE_GATE(logicType, gateId)));
+		gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::Message_CREATE_GATE(logicType, gateId)));
 	}
 	gCanvas->insertGate(gateId, (*(gCircuit->getGates()))[gateId], 0, 0);
 
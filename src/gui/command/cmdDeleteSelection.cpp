@@ -26,6 +26,8 @@ cmdDeleteSelection::~cmdDeleteSelection() {
 
 bool cmdDeleteSelection::Do() {
 
+	// The logic core takes the selection apart as one batch:
+	gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::MT_BEGIN_BATCH));
 	for (unsigned int i = 0; i < wires.size(); i++) {
 		cmdList.push(new cmdDeleteWire(gCircuit, gCanvas, wires[i]));
 		cmdList.top()->Do();
@@ -34,6 +36,7 @@ bool cmdDeleteSelection::Do() {
 		cmdList.push(new cmdDeleteGate(gCircuit, gCanvas, gates[i]));
 		cmdList.top()->Do();
 	}
+	gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::MT_COMMIT_BATCH));
 	if (gCircuit->getOscope() != NULL) gCircuit->getOscope()->UpdateMenu();
 
 	return true;
@@ -41,11 +44,13 @@ bool cmdDeleteSelection::Do() {
 
 bool cmdDeleteSelection::Undo() {
 
+	gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::MT_BEGIN_BATCH));
 	while (!(cmdList.empty())) {
 		cmdList.top()->Undo();
 		delete cmdList.top();
 		cmdList.pop();
 	}
+	gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::MT_COMMIT_BATCH));
 	if (gCircuit->getOscope() != NULL) gCircuit->getOscope()->UpdateMenu();
 	return true;
 }
\ No newline at end of file
@@ -1,9 +1,11 @@
 
 #include "cmdPasteBlock.h"
+#include "../GUICircuit.h"
 
-cmdPasteBlock::cmdPasteBlock(std::vector<klsCommand *> &cmdList) :
+cmdPasteBlock::cmdPasteBlock(GUICircuit* gCircuit, std::vector<klsCommand *> &cmdList) :
 		klsCommand(true, "Paste") {
 
+	this->gCircuit = gCircuit;
 	for (unsigned int i = 0; i < cmdList.size(); i++) this->cmdList.push_back(cmdList[i]);
 
 	m_init = false;
@@ -16,16 +18,21 @@ bool cmdPasteBlock::Do() {
 		return true;
 	}
 
+	// The logic core builds the whole block as one batch:
+	gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::MT_BEGIN_BATCH));
 	for (unsigned int i = 0; i < cmdList.size(); i++) cmdList[i]->Do();
+	gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::MT_COMMIT_BATCH));
 
 	return true;
 }
 
 bool cmdPasteBlock::Undo() {
 
+	gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::MT_BEGIN_BATCH));
 	for (int i = cmdList.size() - 1; i >= 0; i--) {
 		cmdList[i]->Undo();
 	}
+	gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::MT_COMMIT_BATCH));
 
 	return true;
 }
\ No newline at end of file
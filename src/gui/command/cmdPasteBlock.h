@@ -5,7 +5,7 @@
 // cmdPasteBlock - Paste's a block of gates/wires
 class cmdPasteBlock : public klsCommand {
 public:
-	cmdPasteBlock(std::vector<klsCommand*> &cmdList);
+	cmdPasteBlock(GUICircuit* gCircuit, std::vector<klsCommand*> &cmdList);
 
 	bool Do();
 
@@ -1830,6 +1830,19 @@ void guiGateRAM::setLogicParam( string paramName, string value ){
 		memory.clear();
 		if( ramPopupDialog != NULL )
 		    ramPopupDialog->notifyAllChanged();
+	}else if( paramName == "MemoryReloaded" ){
+		//the whole memory, after a file was loaded:
+		//"count address data address data ..." in hex
+		memory.clear();
+		istringstream wordsiss( value );
+		wordsiss >> hex;
+		unsigned long count = 0, address = 0, data = 0;
+		wordsiss >> count;
+		for( unsigned long i = 0; i < count && ( wordsiss >> address >> data ); i++ ){
+			memory[ address ] = data;
+		}
+		if( ramPopupDialog != NULL )
+		    ramPopupDialog->notifyAllChanged();
 	}else if( paramName == "ADDRESS_BITS" ) {
 		istringstream dataiss( value );
 		dataiss >> addressBits;
@@ -1844,6 +1857,27 @@ void guiGateRAM::setLogicParam( string paramName, string value ){
 	}
 }
 
+//The words that the logic gate wrote come in blocks,
+//once per step, rather than as "Address:" params
+void guiGateRAM::setMemoryChanges( const klsMessage::Message_RAM_CHANGES::Gate &changes ){
+	for( unsigned int b = 0; b < changes.blocks.size(); b++ ){
+		const klsMessage::Message_RAM_CHANGES::Block &block = changes.blocks[b];
+		//the words that are 0 are left out of the map
+		for( unsigned long i = 0; i < block.words.size(); i++ ){
+			unsigned long address = (unsigned long)( block.address + i );
+			if( block.words[i] != 0 ){
+				memory[ address ] = (unsigned long)block.words[i];
+			}else{
+				memory.erase( address );
+			}
+		}
+	}
+	lastWritten = (long)changes.lastWritten;
+	//the pop-up only fetches the rows that are showing
+	if( ramPopupDialog != NULL )
+		ramPopupDialog->updateGridDisplay();
+}
+
 //This method is used by the RamPopupDialog to
 //learn what values are at different addresses
 //in memory.
@@ -145,6 +145,10 @@ public:
 	virtual string getLogicParam( string paramName ) { return lparams[paramName]; };
 	map < string, string >* getAllLogicParams() { return &lparams; };
 
+	// For gates with a memory: take the blocks of words that the logic
+	// gate wrote during a step (see klsMessage::MT_RAM_CHANGES):
+	virtual void setMemoryChanges( const klsMessage::Message_RAM_CHANGES::Gate &changes ) {};
+
 	void declareInput(string name) { isInput[name] = true; };
 	void declareOutput(string name) { isInput[name] = false; };
 	// Pedro Casanova (casanova@ujaen.es) 2020/04-12
@@ -509,6 +513,10 @@ public:
 	//Thus we catch it here
 	virtual void setLogicParam( string paramName, string value );
 
+	//The words that the logic gate wrote come in blocks,
+	//once per step, rather than as "Address:" params
+	virtual void setMemoryChanges( const klsMessage::Message_RAM_CHANGES::Gate &changes );
+
 	//This method is used by the RamPopupDialog to
 	//learn what values are at different addresses
 	//in memory.
@@ -41,6 +41,8 @@ cmdPasteBlock* klsClipboard::pasteBlock( GUICircuit* gCircuit, GUICanvas* gCanva
 		
 		TranslationMap gateids;
 		TranslationMap wireids;
+		// The logic core builds the whole block as one batch:
+		gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::MT_BEGIN_BATCH));
     	while (getline( iss, temp, '\n' )) {
 			_MSG("%s", temp.c_str());
     		klsCommand* cg = NULL;
@@ -99,6 +101,7 @@ cmdPasteBlock* klsClipboard::pasteBlock( GUICircuit* gCircuit, GUICanvas* gCanva
     		cg->Do();
 	    	if (iss.str().find('\n',0) == string::npos) return NULL;
     	}
+		gCircuit->sendMessageToCore(klsMessage::Message(klsMessage::MT_COMMIT_BATCH));
 		gCanvas->unselectAllGates();
 		gCanvas->unselectAllWires();
 		TranslationMap::iterator gateWalk = gateids.begin();
@@ -117,7 +120,7 @@ cmdPasteBlock* klsClipboard::pasteBlock( GUICircuit* gCircuit, GUICanvas* gCanva
 		gCircuit->getOscope()->UpdateMenu();
     }
 
-	if (cmdList.size() > 0) return new cmdPasteBlock ( cmdList );
+	if (cmdList.size() > 0) return new cmdPasteBlock ( gCircuit, cmdList );
 	return NULL;
 }
 
@@ -3,18 +3,24 @@
 
 #include <string>
 #include <sstream>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <vector>
 
 // ALL inter-thread message structures defined here
 namespace klsMessage {
 	using std::string;
 	using std::ostringstream;
-	
+
 	enum MessageType {
 		// core -> GUI
 		MT_SET_WIRE_STATE = 0, // SET WIRE id STATE TO state
 		MT_DONESTEP, // DONESTEP
 		MT_COMPLETE_INTERIM_STEP, // COMPLETE INTERIM STEP - UPDATE OSCOPE
-		
+		MT_WIRE_FRAME, // WIRE FRAME - WIRE STATES OF A STEPSIM
+		MT_RAM_CHANGES, // RAM CHANGES - BLOCKS OF WORDS WRITTEN TO RAM GATES
+
 		// GUI -> core
 		MT_REINITIALIZE, // REINITIALIZE LOGIC CIRCUIT
 		MT_CREATE_GATE, // CREATE GATE TYPE type ID id
@@ -27,16 +33,82 @@ namespace klsMessage {
 		MT_SET_GATE_OUTPUT_PARAM, // SET GATE ID id OUTPUT ID id PARAM name value
 		MT_SET_GATE_PARAM, // SET GATE ID id PARAMETER paramname paramval
 		MT_STEPSIM, // STEPSIM numsteps
-		MT_UPDATE_GATES // UPDATE GATES
+		MT_UPDATE_GATES, // UPDATE GATES
+		MT_BEGIN_BATCH, // BEGIN BATCH - A LOAD OR PASTE OF MANY ITEMS
+		MT_COMMIT_BATCH // COMMIT BATCH
 	};
 
-	class Message {
+	// Gate types and pin names are sent as numbers, so that the messages
+	// that carry them fit in a Message. The same few names are used over
+	// and over, so each one is stored once, and kept for as long as the
+	// program runs. Both threads use the table. Only the names that come
+	// from the gate libraries belong in it: parameter names, which can be
+	// made up (like the RAM's "Address:N"), are sent as strings.
+	//
+	// intern() takes a lock, but name() doesn't: a name is written before
+	// its number is handed out, and the number only reaches the other
+	// thread through a message ring, which orders the two. The names are
+	// kept in chunks that never move, so no reader sees a reallocation:
+	class NameTable {
 	public:
-		MessageType mType;
-		void* mStruct;
-		Message( MessageType t, void* s = NULL ) : mType(t), mStruct(s) {};
+		static int intern( const string &name ) {
+			NameTable &table = get();
+			std::lock_guard< std::mutex > lock( table.mutex );
+			std::map< string, int >::iterator found = table.ids.find( name );
+			if( found != table.ids.end() ) return found->second;
+
+			// (The table is full: this can't happen with the names of the
+			// gate libraries, but answer with the empty name rather than fail.)
+			int id = table.count;
+			if( id >= MAX_NAMES ) return 0;
+
+			std::string *chunk = table.chunks[id >> CHUNK_BITS].load( std::memory_order_relaxed );
+			if( chunk == NULL ) {
+				chunk = new std::string[CHUNK_SIZE];
+				table.chunks[id >> CHUNK_BITS].store( chunk, std::memory_order_release );
+			}
+			chunk[id & (CHUNK_SIZE - 1)] = name;
+			table.ids[name] = id;
+			table.count++;
+			return id;
+		};
+
+		static const string& name( int id ) {
+			const std::string *chunk = get().chunks[id >> CHUNK_BITS].load( std::memory_order_acquire );
+			return chunk[id & (CHUNK_SIZE - 1)];
+		};
+
+	private:
+		static const int CHUNK_BITS = 10;
+		static const int CHUNK_SIZE = 1 << CHUNK_BITS;
+		static const int MAX_CHUNKS = 1024;
+		static const int MAX_NAMES = CHUNK_SIZE * MAX_CHUNKS;
+
+		// (Name 0 is the empty name.)
+		NameTable() : count(1) {
+			for( int i = 0; i < MAX_CHUNKS; i++ ) chunks[i].store( NULL, std::memory_order_relaxed );
+			chunks[0].store( new std::string[CHUNK_SIZE], std::memory_order_relaxed );
+			ids[""] = 0;
+		};
+
+		~NameTable() {
+			for( int i = 0; i < MAX_CHUNKS; i++ ) delete[] chunks[i].load( std::memory_order_relaxed );
+		};
+
+		static NameTable& get() {
+			static NameTable table;
+			return table;
+		};
+
+		std::mutex mutex;
+		std::atomic< std::string* > chunks[MAX_CHUNKS];
+		int count;
+		std::map< string, int > ids;
 	};
-	
+
+	// The small messages are copied into the Message itself (see below),
+	// so their classes must stay trivially copyable:
+
 	class Message_SET_WIRE_STATE {
 	public:
 		int wireId;
@@ -51,14 +123,15 @@ namespace klsMessage {
 	};
 
 	// no parameters for COMPLETE_INTERIM_STEP
-	
+
 	// no parameters for REINITIALIZE
-	
+
 	class Message_CREATE_GATE {
 	public:
-		string gateType;
+		int gateType; // See NameTable
 		int gateId;
-		Message_CREATE_GATE( string gt, int gid ) : gateType(gt), gateId(gid) {};
+		Message_CREATE_GATE( const string &gt, int gid ) : gateType(NameTable::intern(gt)), gateId(gid) {};
+		const string& getGateType() const { return NameTable::name(gateType); };
 	};
 
 	class Message_CREATE_WIRE {
@@ -82,37 +155,74 @@ namespace klsMessage {
 	class Message_SET_GATE_INPUT {
 	public:
 		int gateId;
-		string inputId;
+		int inputId; // See NameTable
 		int wireId;
 		bool disconnect;
-		Message_SET_GATE_INPUT( int gid, string iid, int wid, bool d = false ) : gateId(gid), inputId(iid), wireId(wid), disconnect(d) {};
+		Message_SET_GATE_INPUT( int gid, const string &iid, int wid, bool d = false ) : gateId(gid), inputId(NameTable::intern(iid)), wireId(wid), disconnect(d) {};
+		const string& getInputId() const { return NameTable::name(inputId); };
 	};
 
-	class Message_SET_GATE_INPUT_PARAM {
+	class Message_SET_GATE_OUTPUT {
 	public:
 		int gateId;
-		string inputId;
-		string paramName;
-		string paramValue;
-		Message_SET_GATE_INPUT_PARAM( int gid, string iid, string pN, string pV ) : gateId(gid), inputId(iid), paramName(pN), paramValue(pV) {};
+		int outputId; // See NameTable
+		int wireId;
+		bool disconnect;
+		Message_SET_GATE_OUTPUT( int gid, const string &oid, int wid, bool d = false ) : gateId(gid), outputId(NameTable::intern(oid)), wireId(wid), disconnect(d) {};
+		const string& getOutputId() const { return NameTable::name(outputId); };
 	};
 
-	class Message_SET_GATE_OUTPUT {
+	class Message_STEPSIM {
+	public:
+		int numSteps;
+		Message_STEPSIM( int n ) : numSteps(n) {};
+	};
+
+	// no parameters for UPDATE_GATES
+
+	// no parameters for BEGIN_BATCH or COMMIT_BATCH
+
+	// The messages with a parameter value or a frame are new'd by the
+	// sender, and deleted by the receiver:
+
+	// The words that RAM gates wrote during a STEPSIM or UPDATE_GATES, as
+	// runs of words from an address, rather than one parameter per word:
+	class Message_RAM_CHANGES {
+	public:
+		class Block {
+		public:
+			unsigned long long address;
+			std::vector< unsigned long long > words;
+		};
+		class Gate {
+		public:
+			int gateId;
+			unsigned long long lastWritten;
+			std::vector< Block > blocks;
+		};
+		std::vector< Gate > gates;
+	};
+
+	class Message_SET_GATE_INPUT_PARAM {
 	public:
 		int gateId;
-		string outputId;
-		int wireId;
-		bool disconnect;
-		Message_SET_GATE_OUTPUT( int gid, string oid, int wid, bool d = false ) : gateId(gid), outputId(oid), wireId(wid), disconnect(d) {};
+		int inputId; // See NameTable
+		string paramName;
+		string paramValue;
+		Message_SET_GATE_INPUT_PARAM( int gid, const string &iid, const string &pN, string pV ) : gateId(gid), inputId(NameTable::intern(iid)), paramName(pN), paramValue(pV) {};
+		const string& getInputId() const { return NameTable::name(inputId); };
+		const string& getParamName() const { return paramName; };
 	};
 
 	class Message_SET_GATE_OUTPUT_PARAM {
 	public:
 		int gateId;
-		string outputId;
+		int outputId; // See NameTable
 		string paramName;
 		string paramValue;
-		Message_SET_GATE_OUTPUT_PARAM( int gid, string oid, string pN, string pV ) : gateId(gid), outputId(oid), paramName(pN), paramValue(pV) {};
+		Message_SET_GATE_OUTPUT_PARAM( int gid, const string &oid, const string &pN, string pV ) : gateId(gid), outputId(NameTable::intern(oid)), paramName(pN), paramValue(pV) {};
+		const string& getOutputId() const { return NameTable::name(outputId); };
+		const string& getParamName() const { return paramName; };
 	};
 
 	class Message_SET_GATE_PARAM {
@@ -120,19 +230,62 @@ namespace klsMessage {
 		int gateId;
 		string paramName;
 		string paramValue;
-		Message_SET_GATE_PARAM( int gid, string pN, string pV ) : gateId(gid), paramName(pN), paramValue(pV) {};
-		Message_SET_GATE_PARAM( int gid, string pN, long pV, bool useHex = false ) : gateId(gid), paramName(pN) {
+		Message_SET_GATE_PARAM( int gid, const string &pN, string pV ) : gateId(gid), paramName(pN), paramValue(pV) {};
+		Message_SET_GATE_PARAM( int gid, const string &pN, long pV, bool useHex = false ) : gateId(gid), paramName(pN) {
 			ostringstream oss; oss << (useHex ? std::hex : std::dec) << pV; paramValue = oss.str();
 		};
+		const string& getParamName() const { return paramName; };
 	};
 
-	class Message_STEPSIM {
+	// All of the wire changes of one STEPSIM. The display only needs the
+	// final state of each wire, and the oscope needs the state after every
+	// step, which the step log replays: the changes of step i are
+	// changes[stepEnds[i-1]] up to changes[stepEnds[i]]. The parameters
+	// that the gates changed are kept by step the same way (paramEnds),
+	// so they reach the GUI after the wires of their step, as they did
+	// when every change was its own message:
+	class Message_WIRE_FRAME {
 	public:
-		int numSteps;
-		Message_STEPSIM( int n ) : numSteps(n) {};
+		std::vector< Message_SET_WIRE_STATE > finalStates;
+		std::vector< Message_SET_WIRE_STATE > changes;
+		std::vector< unsigned int > stepEnds;
+		std::vector< Message_SET_GATE_PARAM > params;
+		std::vector< unsigned int > paramEnds;
+	};
+
+	// A message is passed by value. The small messages are kept in the
+	// union, so sending them doesn't allocate anything. Only the messages
+	// with a parameter value, the wire frames and the RAM changes still
+	// point to a struct:
+	class Message {
+	public:
+		MessageType mType;
+		union {
+			void* mStruct;
+			Message_SET_WIRE_STATE mSetWireState;
+			Message_DONESTEP mDoneStep;
+			Message_CREATE_GATE mCreateGate;
+			Message_CREATE_WIRE mCreateWire;
+			Message_DELETE_GATE mDeleteGate;
+			Message_DELETE_WIRE mDeleteWire;
+			Message_SET_GATE_INPUT mSetGateInput;
+			Message_SET_GATE_OUTPUT mSetGateOutput;
+			Message_STEPSIM mStepSim;
+		};
+
+		Message( MessageType t, void* s = NULL ) : mType(t), mStruct(s) {};
+		Message( const Message_SET_WIRE_STATE &m ) : mType(MT_SET_WIRE_STATE), mSetWireState(m) {};
+		Message( const Message_DONESTEP &m ) : mType(MT_DONESTEP), mDoneStep(m) {};
+		Message( const Message_CREATE_GATE &m ) : mType(MT_CREATE_GATE), mCreateGate(m) {};
+		Message( const Message_CREATE_WIRE &m ) : mType(MT_CREATE_WIRE), mCreateWire(m) {};
+		Message( const Message_DELETE_GATE &m ) : mType(MT_DELETE_GATE), mDeleteGate(m) {};
+		Message( const Message_DELETE_WIRE &m ) : mType(MT_DELETE_WIRE), mDeleteWire(m) {};
+		Message( const Message_SET_GATE_INPUT &m ) : mType(MT_SET_GATE_INPUT), mSetGateInput(m) {};
+		Message( const Message_SET_GATE_OUTPUT &m ) : mType(MT_SET_GATE_OUTPUT), mSetGateOutput(m) {};
+		Message( const Message_STEPSIM &m ) : mType(MT_STEPSIM), mStepSim(m) {};
+		// An empty message, for the slots of the message rings:
+		Message() : mType(MT_SET_WIRE_STATE), mStruct(NULL) {};
 	};
-	
-	// no parameters for UPDATE_GATES
 }
 
 #endif /*KLSMESSAGE_H_*/
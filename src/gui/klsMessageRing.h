@@ -0,0 +1,147 @@
+/*****************************************************************************
+   Project: CEDAR Logic Simulator
+   Copyright 2006 Cedarville University, Benjamin Sprague,
+                     Matt Lewellyn, and David Knierim
+   All rights reserved.
+   For license information see license.txt included with distribution.
+
+   klsMessageRing: Lock-free message channel between the GUI and logic threads
+*****************************************************************************/
+
+#ifndef KLSMESSAGERING_H_
+#define KLSMESSAGERING_H_
+
+#include "wx/thread.h"
+#include <atomic>
+#include <vector>
+
+// Class klsWakeUp:
+//	Lets one thread sleep until another thread has something for it.
+//	The sleeping flag makes sure that wake() only signals when the other
+//	thread is (about to be) asleep, so that the common case costs one
+//	fence and one load.
+class klsWakeUp {
+public:
+	klsWakeUp() : sleeping(false), cond(mutex) {};
+
+	// Sleep until ready() is true. The flag is set and ready() checked
+	// again under the lock, so a wake() in between is never lost: either
+	// wake() sees the flag and signals after the wait has started, or
+	// ready() sees what was published before wake():
+	template< class Ready >
+	void wait( Ready ready ) {
+		if( ready() ) return;
+		wxMutexLocker lock( mutex );
+		sleeping.store( true, std::memory_order_release );
+		std::atomic_thread_fence( std::memory_order_seq_cst );
+		while( !ready() ) cond.Wait();
+		sleeping.store( false, std::memory_order_release );
+	};
+
+	// Call after publishing what the other thread's ready() checks:
+	void wake( void ) {
+		std::atomic_thread_fence( std::memory_order_seq_cst );
+		if( sleeping.load( std::memory_order_acquire ) ) {
+			wxMutexLocker lock( mutex );
+			cond.Signal();
+		}
+	};
+
+private:
+	std::atomic< bool > sleeping;
+	wxMutex mutex;
+	wxCondition cond;
+};
+
+// Class klsMessageRing:
+//	A bounded single-producer / single-consumer ring of messages. One thread
+//	only pushes and the other only pops, so neither side takes a lock.
+//	Size must be a power of two. The counters are 64 bits, so they never wrap.
+template< class T, unsigned long Size >
+class klsMessageRing {
+public:
+	klsMessageRing() : items(Size), head(0), tail(0), discardTo(0) {
+		static_assert( (Size & (Size - 1)) == 0, "klsMessageRing size must be a power of two" );
+	};
+
+	// Producer: add a message. Returns false if the ring is full:
+	bool push( const T &item ) {
+		unsigned long long t = tail.load( std::memory_order_relaxed );
+		if( t - head.load( std::memory_order_acquire ) >= Size ) return false;
+		items[t & (Size - 1)] = item;
+		tail.store( t + 1, std::memory_order_release );
+		popWakeUp.wake();
+		return true;
+	};
+
+	// Consumer: take the oldest message. Returns false if the ring is empty:
+	bool pop( T &item ) {
+		unsigned long long h = head.load( std::memory_order_relaxed );
+		while( true ) {
+			// Skip the messages that were discarded. discardTo is read
+			// before tail, so the skipped messages have all been pushed:
+			unsigned long long d = discardTo.load( std::memory_order_acquire );
+			unsigned long long t = tail.load( std::memory_order_acquire );
+			if( d > h ) {
+				h = d;
+				head.store( h, std::memory_order_release );
+				pushWakeUp.wake();
+			}
+			if( h == t ) return false;
+
+			item = items[h & (Size - 1)];
+
+			// A discard while the message was copied drops it too:
+			if( discardTo.load( std::memory_order_acquire ) > h ) continue;
+
+			head.store( h + 1, std::memory_order_release );
+			pushWakeUp.wake();
+			return true;
+		}
+	};
+
+	// The number of messages waiting. Exact for the consumer, and
+	// an upper bound of the room that is used for the producer:
+	unsigned long long size( void ) const {
+		return tail.load( std::memory_order_acquire ) - head.load( std::memory_order_acquire );
+	};
+
+	bool empty( void ) const { return size() == 0; };
+
+	// Drop every message that was pushed so far. This only moves the
+	// discard mark, and the consumer skips up to it in pop(), so it may
+	// be called by either thread, but always by the same one. The mark
+	// never moves back, and it never passes a message that hasn't been
+	// pushed yet, since tail is read after the push that it counts:
+	void discard( void ) {
+		unsigned long long t = tail.load( std::memory_order_acquire );
+		if( t > discardTo.load( std::memory_order_relaxed ) ) {
+			discardTo.store( t, std::memory_order_release );
+		}
+	};
+
+	// Consumer: sleep until there is a message, or until cancel is set
+	// and wake() is called:
+	void waitToPop( const std::atomic< bool > &cancel ) {
+		popWakeUp.wait( [this, &cancel]() { return !empty() || cancel.load(); } );
+	};
+
+	// Producer: sleep until there is room for a message, or until cancel
+	// is set and wake() is called:
+	void waitToPush( const std::atomic< bool > &cancel ) {
+		pushWakeUp.wait( [this, &cancel]() { return size() < Size || cancel.load(); } );
+	};
+
+	// Wake up both threads, so they can check their cancel flags:
+	void wake( void ) {
+		popWakeUp.wake();
+		pushWakeUp.wake();
+	};
+
+private:
+	std::vector< T > items;
+	std::atomic< unsigned long long > head, tail, discardTo;
+	klsWakeUp popWakeUp, pushWakeUp;
+};
+
+#endif /*KLSMESSAGERING_H_*/
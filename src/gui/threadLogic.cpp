@@ -27,6 +27,7 @@ DECLARE_APP(MainApp)
 // Added theGUICircuit parameter
 threadLogic::threadLogic(GUICircuit* theGUICircuit) : wxThread() {
 	GUIcir = theGUICircuit;
+	stopping = false;
 	return;
 }
 
@@ -38,26 +39,34 @@ void *threadLogic::Entry() {
 	logicIDs = new map < IDType, IDType >;
 		
 	cir = new Circuit(GUIcir);
+	cir->setEventScheduler(EventQueue::SCHED_TIMING_WHEEL);
+	cir->setCompiledNetlist(true);
 	// Pedro Casanova (casanova@ujaen.es) 2020/04-12
 	this->GUIcir->setCircuit((void*)cir);
 	while (!TestDestroy()) {
 		checkMessages();
-		wxThread::Sleep(1);
+		// Sleep until the GUI sends a message. After stop() there is
+		// nothing left to do but wait for Delete():
+		if (stopping) wxThread::Sleep(1);
+		else wxGetApp().GUItoLOGIC.waitToPop(stopping);
 	}
 	
 	return NULL;
 }
 
 void threadLogic::checkMessages() {
-	wxCriticalSectionLocker locker(wxGetApp().m_critsect);
-	while (wxGetApp().mexMessages.TryLock() == wxMUTEX_BUSY) wxYield();
-	while (wxGetApp().dGUItoLOGIC.size() > 0) {
-		parseMessage(wxGetApp().dGUItoLOGIC.front());
-		wxGetApp().dGUItoLOGIC.pop_front();
+	klsMessage::Message message;
+	while (!stopping && wxGetApp().GUItoLOGIC.pop(message)) {
+		parseMessage(message);
 	}
-	wxGetApp().mexMessages.Unlock();
 }	
 
+void threadLogic::stop() {
+	stopping = true;
+	wxGetApp().GUItoLOGIC.wake();
+	wxGetApp().LOGICtoGUI.wake();
+}
+
 void threadLogic::OnExit() {
 	wxCriticalSectionLocker locker(wxGetApp().m_critsect);
 	delete cir;
@@ -74,6 +83,8 @@ bool threadLogic::parseMessage(klsMessage::Message input) {
 		// REINITIALIZE LOGIC CIRCUIT
 		delete cir;
 		cir = new Circuit(GUIcir);
+		cir->setEventScheduler(EventQueue::SCHED_TIMING_WHEEL);
+		cir->setCompiledNetlist(true);
 		// Pedro Casanova (casanova@ujaen.es) 2020/04-12
 		this->GUIcir->setCircuit((void*)cir);
 		logicIDs->clear();
@@ -81,51 +92,44 @@ bool threadLogic::parseMessage(klsMessage::Message input) {
 	}
 	case klsMessage::MT_CREATE_GATE: {
 		// CREATE GATE TYPE type ID id
-		klsMessage::Message_CREATE_GATE* msgCreateGate = (klsMessage::Message_CREATE_GATE*)(input.mStruct);
-
 		// tell logic core to create a gate id of type OR
-		cir->newGate( msgCreateGate->gateType, msgCreateGate->gateId );
-		delete msgCreateGate;
+		cir->newGate( input.mCreateGate.getGateType(), input.mCreateGate.gateId );
 		break;
 	}
 	case klsMessage::MT_CREATE_WIRE: {
 		// CREATE WIRE ID id
-		id = ((klsMessage::Message_CREATE_WIRE*)(input.mStruct))->wireId;
+		id = input.mCreateWire.wireId;
 		// tell logic core to create wire id
 		(*logicIDs)[id] = cir->newWire( id );
-		delete ((klsMessage::Message_CREATE_WIRE*)(input.mStruct));
 		break;
 	}
 	case klsMessage::MT_DELETE_GATE: {
 		// DELETE GATE id
-		id = ((klsMessage::Message_DELETE_GATE*)(input.mStruct))->gateId;
+		id = input.mDeleteGate.gateId;
 		cir->deleteGate(id);
-		delete ((klsMessage::Message_DELETE_GATE*)(input.mStruct));
 		break;
 	}
 	case klsMessage::MT_DELETE_WIRE: {
 		// DELETE WIRE id
-		id = ((klsMessage::Message_DELETE_WIRE*)(input.mStruct))->wireId;
+		id = input.mDeleteWire.wireId;
 		cir->deleteWire((*logicIDs)[id]);
-		delete ((klsMessage::Message_DELETE_WIRE*)(input.mStruct));
 		break;
 	}
 	case klsMessage::MT_SET_GATE_INPUT: {
 		// SET GATE ID id INPUT ID id TO DISCONNECT/wid
-		id = ((klsMessage::Message_SET_GATE_INPUT*)(input.mStruct))->gateId;
-		pinID = ((klsMessage::Message_SET_GATE_INPUT*)(input.mStruct))->inputId;
+		id = input.mSetGateInput.gateId;
+		pinID = input.mSetGateInput.getInputId();
 		// tell logic core to set gate id's input id to connect with wireID
-		if (((klsMessage::Message_SET_GATE_INPUT*)(input.mStruct))->disconnect) {
+		if (input.mSetGateInput.disconnect) {
 			cir->disconnectGateInput( id, pinID );
 		} else {
-			wireID = ((klsMessage::Message_SET_GATE_INPUT*)(input.mStruct))->wireId;
+			wireID = input.mSetGateInput.wireId;
 			if (logicIDs->find(wireID) == logicIDs->end()) {
 				(*logicIDs)[wireID] = cir->connectGateInput( id, pinID, wireID );
 			} else {
 				cir->connectGateInput( id, pinID, (*logicIDs)[wireID] );
 			}
 		}
-		delete ((klsMessage::Message_SET_GATE_INPUT*)(input.mStruct));
 		break;
 	}
 	case klsMessage::MT_SET_GATE_INPUT_PARAM: {
@@ -133,26 +137,25 @@ bool threadLogic::parseMessage(klsMessage::Message input) {
 		klsMessage::Message_SET_GATE_INPUT_PARAM* msgSetGateInputParam = (klsMessage::Message_SET_GATE_INPUT_PARAM*)(input.mStruct);
 		// Now input holds the pValue
 		// Send name "pName" and value "input" to gate for input pin settings
-		cir->setGateInputParameter( msgSetGateInputParam->gateId, msgSetGateInputParam->inputId, msgSetGateInputParam->paramName, msgSetGateInputParam->paramValue );
+		cir->setGateInputParameter( msgSetGateInputParam->gateId, msgSetGateInputParam->getInputId(), msgSetGateInputParam->getParamName(), msgSetGateInputParam->paramValue );
 		delete msgSetGateInputParam;
 		break;
 	}
 	case klsMessage::MT_SET_GATE_OUTPUT: {
 		// SET GATE ID id OUTPUT ID id TO DISCONNECT/wid
-		id = ((klsMessage::Message_SET_GATE_OUTPUT*)(input.mStruct))->gateId;
-		pinID = ((klsMessage::Message_SET_GATE_OUTPUT*)(input.mStruct))->outputId;
+		id = input.mSetGateOutput.gateId;
+		pinID = input.mSetGateOutput.getOutputId();
 		// tell logic core to set gate id's output id to connect with wireID
-		if (((klsMessage::Message_SET_GATE_OUTPUT*)(input.mStruct))->disconnect) {
+		if (input.mSetGateOutput.disconnect) {
 			cir->disconnectGateOutput( id, pinID );
 		} else {
-			wireID = ((klsMessage::Message_SET_GATE_OUTPUT*)(input.mStruct))->wireId;
+			wireID = input.mSetGateOutput.wireId;
 			if (logicIDs->find(wireID) == logicIDs->end()) {
 				(*logicIDs)[wireID] = cir->connectGateOutput( id, pinID, wireID );
 			} else {
 				cir->connectGateOutput( id, pinID, (*logicIDs)[wireID] );
 			}
 		}
-		delete ((klsMessage::Message_SET_GATE_OUTPUT*)(input.mStruct));
 		break;
 	}
 
@@ -161,32 +164,46 @@ bool threadLogic::parseMessage(klsMessage::Message input) {
 		klsMessage::Message_SET_GATE_OUTPUT_PARAM* msgSetGateOutputParam = (klsMessage::Message_SET_GATE_OUTPUT_PARAM*)(input.mStruct);
 		// Now input holds the pValue
 		// Send name "pName" and value "input" to gate for input pin settings
-		cir->setGateOutputParameter( msgSetGateOutputParam->gateId, msgSetGateOutputParam->outputId, msgSetGateOutputParam->paramName, msgSetGateOutputParam->paramValue );
+		cir->setGateOutputParameter( msgSetGateOutputParam->gateId, msgSetGateOutputParam->getOutputId(), msgSetGateOutputParam->getParamName(), msgSetGateOutputParam->paramValue );
 		delete msgSetGateOutputParam;
 		break;
 	}
 	case klsMessage::MT_SET_GATE_PARAM: {
 		// SET GATE ID id PARAMETER paramname paramval
 		klsMessage::Message_SET_GATE_PARAM* msgSetGateParam = (klsMessage::Message_SET_GATE_PARAM*)(input.mStruct);
-		cir->setGateParameter(msgSetGateParam->gateId, msgSetGateParam->paramName, msgSetGateParam->paramValue);
+		cir->setGateParameter(msgSetGateParam->gateId, msgSetGateParam->getParamName(), msgSetGateParam->paramValue);
 		delete msgSetGateParam;
 		break;
 	}
 	case klsMessage::MT_STEPSIM: {
 		// STEPSIM numSteps
 		wxStopWatch simTime;
-		int numSteps = ((klsMessage::Message_STEPSIM*)(input.mStruct))->numSteps;
+		int numSteps = input.mStepSim.numSteps;
 		bool pauseingSim = false;
+		// The wire and parameter changes are sent in one frame when the
+		// steps are done:
+		klsMessage::Message_WIRE_FRAME* frame = new klsMessage::Message_WIRE_FRAME;
+		ID_SET< IDType > frameWires;
 		// Do that many steps and then notify GUI that we're done
-		for (int i = 0; i < numSteps && !pauseingSim; i++) {
+		TimeType endTime = cir->getSystemTime() + (numSteps > 0 ? numSteps : 0);
+		while (cir->getSystemTime() < endTime && !pauseingSim) {
+			// Skip the steps where nothing happens. The oscope still
+			// needs an (empty) entry in the frame for each of them:
+			TimeType idleSteps = cir->fastForward(endTime);
+			frame->stepEnds.insert(frame->stepEnds.end(), (size_t) idleSteps, (unsigned int) frame->changes.size());
+			frame->paramEnds.insert(frame->paramEnds.end(), (size_t) idleSteps, (unsigned int) frame->params.size());
+			if (cir->getSystemTime() >= endTime) break;
+
 			ID_SET< IDType > changedWires;
 			
 			cir->step(&changedWires);
 			ID_SET< IDType >::iterator cw = changedWires.begin();
 			while (cw != changedWires.end()) {
-				sendMessage(klsMessage::Message(klsMessage::MT_SET_WIRE_STATE, new klsMessage::Message_SET_WIRE_STATE(*cw, (int) cir->getWireState(*cw))));
+				frame->changes.push_back(klsMessage::Message_SET_WIRE_STATE(*cw, (int) cir->getWireState(*cw)));
 				cw++;
 			}
+			frameWires.insert(changedWires.begin(), changedWires.end());
+			frame->stepEnds.push_back(frame->changes.size());
 			
 			// Update the possibly changed parameters:
 			vector < changedParam > changedParams = cir->getParamUpdateList(); // Get the parameters that changed during this time step.
@@ -195,7 +212,7 @@ bool threadLogic::parseMessage(klsMessage::Message input) {
 			for( unsigned int i = 0; i < changedParams.size(); i++ ) {
 				paramVal = cir->getGateParameter( changedParams[i].gateID, changedParams[i].paramName );
 				if( paramVal.size() > 0 ) {
-					sendMessage(klsMessage::Message(klsMessage::MT_SET_GATE_PARAM, new klsMessage::Message_SET_GATE_PARAM(changedParams[i].gateID, changedParams[i].paramName, paramVal)));
+					frame->params.push_back(klsMessage::Message_SET_GATE_PARAM(changedParams[i].gateID, changedParams[i].paramName, paramVal));
 				}
 				
 				//************************************************************
@@ -220,11 +237,16 @@ bool threadLogic::parseMessage(klsMessage::Message input) {
 				}
 				//End of Edit************************************************
 			}
-			// send interim done step message
-			sendMessage(klsMessage::Message(klsMessage::MT_COMPLETE_INTERIM_STEP));
+			frame->paramEnds.push_back(frame->params.size());
+		}
+		ID_SET< IDType >::iterator fw = frameWires.begin();
+		while (fw != frameWires.end()) {
+			frame->finalStates.push_back(klsMessage::Message_SET_WIRE_STATE(*fw, (int) cir->getWireState(*fw)));
+			fw++;
 		}
-		sendMessage(klsMessage::Message(klsMessage::MT_DONESTEP, new klsMessage::Message_DONESTEP(simTime.Time())));
-		delete ((klsMessage::Message_STEPSIM*)(input.mStruct));
+		sendMessage(klsMessage::Message(klsMessage::MT_WIRE_FRAME, frame));
+		sendMemoryChanges();
+		sendMessage(klsMessage::Message(klsMessage::Message_DONESTEP(simTime.Time())));
 		break;
 	}
 	case klsMessage::MT_UPDATE_GATES: {
@@ -251,6 +273,17 @@ bool threadLogic::parseMessage(klsMessage::Message input) {
 			}
 	
 		}
+		sendMemoryChanges();
+		break;
+	}
+	case klsMessage::MT_BEGIN_BATCH: {
+		// BEGIN BATCH
+		cir->beginBatch();
+		break;
+	}
+	case klsMessage::MT_COMMIT_BATCH: {
+		// COMMIT BATCH
+		cir->commitBatch();
 		break;
 	}
 	default:
@@ -261,7 +294,31 @@ bool threadLogic::parseMessage(klsMessage::Message input) {
 	return false;
 }
 
+void threadLogic::sendMemoryChanges() {
+	vector< RamChanges > changes;
+	cir->takeMemoryChanges(changes);
+	if (changes.empty()) return;
+
+	klsMessage::Message_RAM_CHANGES* ramChanges = new klsMessage::Message_RAM_CHANGES;
+	ramChanges->gates.resize(changes.size());
+	for (unsigned int i = 0; i < changes.size(); i++) {
+		klsMessage::Message_RAM_CHANGES::Gate &gate = ramChanges->gates[i];
+		gate.gateId = (int) changes[i].gateID;
+		gate.lastWritten = changes[i].lastWritten;
+		gate.blocks.resize(changes[i].blocks.size());
+		for (unsigned int b = 0; b < changes[i].blocks.size(); b++) {
+			gate.blocks[b].address = changes[i].blocks[b].address;
+			gate.blocks[b].words.swap(changes[i].blocks[b].words);
+		}
+	}
+	sendMessage(klsMessage::Message(klsMessage::MT_RAM_CHANGES, ramChanges));
+}
+
 void threadLogic::sendMessage(klsMessage::Message message) {
-	wxMutexLocker lock(wxGetApp().mexMessages);
-	wxGetApp().dLOGICtoGUI.push_back(message);
+	// If the GUI is behind, wait for it to make room. The message is
+	// dropped if the thread is stopped meanwhile:
+	while (!wxGetApp().LOGICtoGUI.push(message)) {
+		if (stopping) return;
+		wxGetApp().LOGICtoGUI.waitToPush(stopping);
+	}
 }
@@ -17,6 +17,7 @@
 #include "klsMessage.h"
 #include "../logic/logic_values.h"
 #include "GUICircuit.h"
+#include <atomic>
 #include <fstream>
 #include <map>
 
@@ -34,6 +35,10 @@ public:
 
 	void checkMessages();
 
+	// Wake the thread up for good, so that Delete() doesn't wait for a
+	// message from the GUI. Call it before Delete():
+	void stop();
+
     // called when the thread exits - whether it terminates normally or is
     // stopped with Delete() (but not when it is Kill()ed!)
     virtual void OnExit();
@@ -41,6 +46,9 @@ public:
     bool parseMessage(klsMessage::Message input);
 
     void sendMessage(klsMessage::Message message);
+
+	// Send the words that RAM gates wrote, if there are any:
+	void sendMemoryChanges();
     
 private:
 	Circuit* cir;
@@ -48,6 +56,7 @@ private:
 	GUICircuit * GUIcir;
 	map < IDType, IDType >* logicIDs;
 	ofstream logfile;
+	std::atomic< bool > stopping;
 };
 
 #endif /*THREADLOGIC_H_*/
@@ -0,0 +1,89 @@
+/*****************************************************************************
+   Project: CEDAR Logic Simulator
+   Copyright 2006 Cedarville University, Benjamin Sprague,
+                     Matt Lewellyn, and David Knierim
+   All rights reserved.
+   For license information see license.txt included with distribution.
+
+   logic_bus_value: The states of a bus, packed into 64-bit words for the
+   gates that do arithmetic on busses
+*****************************************************************************/
+
+#ifndef LOGIC_BUS_VALUE_H
+#define LOGIC_BUS_VALUE_H
+
+#include "logic_values.h"
+
+// The type of the number on a bus. It is 64 bits on every system, unlike
+// unsigned long, which is only 32 bits on Windows:
+typedef unsigned long long BusWord;
+
+// The widest bus that a BusValue holds. (The bits of a wider bus past
+// this read as ZERO.)
+const unsigned long MAX_BUS_BITS = 64;
+
+// The states of a bus, one bit per pin, with pin 0 in bit 0. "value" has
+// the bits that are ONE, "unknown" the bits that are UNKNOWN and "hiZ" the
+// bits that are HI_Z. A CONFLICT bit is set in both "unknown" and "hiZ",
+// and the other bits are ZERO.
+//
+// A bit that isn't ONE reads as 0 in "value", the same way that
+// Gate::bus_to_ulong() reads a bus.
+struct BusValue {
+	BusWord value;
+	BusWord unknown;
+	BusWord hiZ;
+	unsigned long width;
+
+	BusValue() : value(0), unknown(0), hiZ(0), width(0) {};
+
+	// A binary number on a bus "numBits" wide:
+	BusValue( BusWord number, unsigned long numBits ) :
+		value( number & mask( numBits ) ), unknown(0), hiZ(0), width(numBits) {};
+
+	// The bits of a bus "numBits" wide:
+	static BusWord mask( unsigned long numBits ) {
+		return ( numBits >= MAX_BUS_BITS ) ? ~0ULL : ( ( 1ULL << numBits ) - 1 );
+	};
+
+	// The bits that are not ONE or ZERO:
+	BusWord notBinary( void ) const { return unknown | hiZ; };
+
+	// Return the state of one bit:
+	StateType getState( unsigned long bit ) const {
+		if( bit >= MAX_BUS_BITS ) return ZERO;
+		BusWord theBit = 1ULL << bit;
+		if( hiZ & theBit ) return ( unknown & theBit ) ? CONFLICT : HI_Z;
+		if( unknown & theBit ) return UNKNOWN;
+		return ( value & theBit ) ? ONE : ZERO;
+	};
+
+	// Set the state of one bit:
+	void setState( unsigned long bit, StateType theState ) {
+		if( bit >= MAX_BUS_BITS ) return;
+		BusWord theBit = 1ULL << bit;
+		value &= ~theBit;
+		unknown &= ~theBit;
+		hiZ &= ~theBit;
+		switch( theState ) {
+		case ONE:
+			value |= theBit;
+			break;
+		case HI_Z:
+			hiZ |= theBit;
+			break;
+		case CONFLICT:
+			hiZ |= theBit;
+			unknown |= theBit;
+			break;
+		case UNKNOWN:
+			unknown |= theBit;
+			break;
+		case ZERO:
+		default:
+			break;
+		}
+	};
+};
+
+#endif // LOGIC_BUS_VALUE_H
@@ -13,27 +13,43 @@
 #include "logic_circuit.h"
 #include <iostream>
 #include <algorithm>
-#include <stack>
 #include <iterator>
 
 #ifndef _PRODUCTION_
 ofstream* logiclog;
 #endif
 
+// A step only uses the gate threads when it updates at least this many
+// gates, and gives each thread runs of at least PARALLEL_RUN_GATES gates.
+// Below that, waking the threads costs more than they save:
+const size_t PARALLEL_MIN_GATES = 256;
+const size_t PARALLEL_RUN_GATES = 32;
+
+thread_local Circuit::GateStage *Circuit::currentStage = NULL;
+
 
 // Pedro Casanova (casanova@ujaen.es) 2020/04-12
 // Add theGUICircuit param
-Circuit::Circuit(GUICircuit * theGUICircuit)
+Circuit::Circuit(GUICircuit * theGUICircuit) : cycleSim( this )
 {
 	ourGUICircuit = theGUICircuit;
 
 	// Set time to begin starting:
 	systemTime = 0;
+	eventCount = 0;
+	lastEventTime = 0;
+	cancelledUntil = 0;
+	batchMode = false;
 	
 	// Set the initial ID values:
 	gateIDCount = 0;
 	wireIDCount = 0;
 	juncIDCount = 0;
+
+	useNetlist = false;
+	useCycles = false;
+	inCycleStep = false;
+	cycleStatesLoaded = false;
 	
 #ifndef _PRODUCTION_
 	logiclog = new ofstream( "corelog.log");
@@ -47,6 +63,9 @@ Circuit::~Circuit()
 	// objects are removed:
 	// (This is needed so that if their destructors call
 	// any Circuit methods, they won't crash.)
+	// The junction groups don't matter anymore, so don't keep them up
+	// to date while the junctions are taken apart:
+	batchMode = true;
 
 	gateList.clear();
 }
@@ -62,6 +81,9 @@ void Circuit::stepOnlyGates(){
 	ID_SET< IDType >::iterator updateGate = gateUpdateList.begin();
 	while( updateGate != gateUpdateList.end() ) {
 		gateList[*updateGate]->updateGate( *updateGate, this, ourGUICircuit);
+
+		// A polled gate may need polling again after an update:
+		schedulePoll( *updateGate, systemTime );
 		updateGate++;
 	}
 	gateUpdateList.clear();
@@ -69,17 +91,68 @@ void Circuit::stepOnlyGates(){
 //End of Edit*****************************
 
 
+void Circuit::pollGates( void ) {
+	// Gather the gates of every due time, so that they are polled in ID
+	// order, just as if all of them were polled at each step:
+	ID_SET< IDType > dueGates;
+	while( !pollSchedule.empty() && ( pollSchedule.begin()->first <= systemTime ) ) {
+		dueGates.insert( pollSchedule.begin()->second.begin(), pollSchedule.begin()->second.end() );
+		pollSchedule.erase( pollSchedule.begin() );
+	}
+
+	ID_SET< IDType >::iterator gateToPoll = dueGates.begin();
+	while( gateToPoll != dueGates.end() ) {
+		// Skip the gates that were deleted or moved to a later time:
+		ID_MAP< IDType, TimeType >::iterator polled = polledGates.find( *gateToPoll );
+		if( ( polled != polledGates.end() ) && ( polled->second <= systemTime ) ) {
+			GATE_PTR myGate = gateList[*gateToPoll];
+			myGate->updateGate( *gateToPoll, this, ourGUICircuit );
+
+			// Ask the gate when it needs to be polled again:
+			polled->second = TIME_NONE;
+			schedulePoll( *gateToPoll, myGate->getNextPollTime( systemTime ) );
+		}
+		gateToPoll++;
+	}
+}
+
+
+void Circuit::schedulePoll( IDType gateID, TimeType pollTime ) {
+	if( pollTime == TIME_NONE ) return;
+
+	ID_MAP< IDType, TimeType >::iterator polled = polledGates.find( gateID );
+	if( ( polled == polledGates.end() ) || ( polled->second <= pollTime ) ) return;
+
+	polled->second = pollTime;
+	pollSchedule[pollTime].insert( gateID );
+}
+
+
 void Circuit::step(ID_SET< IDType > *changedWires)
 {
-	// NOTE: Should activate the polled gates here:
-	// Basically just loop through the things in polledGates and call updateGate() on them.
-	ID_SET< IDType >::iterator gateToPoll = polledGates.begin();
-	while (gateToPoll != polledGates.end()) {
+	if (batchMode) commitBatch();
 
-		gateList[*gateToPoll]->updateGate(*gateToPoll, this, ourGUICircuit);
-		gateToPoll++;
+	if (useCycles) {
+		if (canStepCycle()) {
+			stepCycle(changedWires);
+			return;
+		}
+		// The event engine changes the wires without the CycleSim:
+		cycleStatesLoaded = false;
 	}
 
+	if (useNetlist) {
+		stepNetlist(changedWires);
+		return;
+	}
+
+	// The changed wires are collected even if the caller doesn't want them:
+	ID_SET< IDType > localChangedWires;
+	if (changedWires == NULL) changedWires = &localChangedWires;
+
+	// Activate the polled gates that are due:
+	pollGates();
+
 	stepOnlyGates();
 
 	int processedEvents = 0;
@@ -89,6 +162,12 @@ void Circuit::step(ID_SET< IDType > *changedWires)
 		// Pop the event off of the event queue:
 		eventQueue.pop();
 
+		// Skip the events of disconnected gate outputs:
+		if (!cancelledOutputs.empty() && isCancelled(myEvent)) {
+			if (!eventQueue.empty()) myEvent = eventQueue.top();
+			continue;
+		}
+
 		// If the event is a junction event, handle it as a junction:
 		if (myEvent.isJunctionEvent) {
 			// Handle the junction event:
@@ -102,19 +181,25 @@ void Circuit::step(ID_SET< IDType > *changedWires)
 		else {
 			// Else, make the event happen to the wire:
 			WIRE_PTR myWire = wireList[myEvent.wireID];
-			myWire->setInputState(myEvent.gateID, myEvent.gateOutputID, myEvent.newState);
+			myWire->setInputState(myEvent.gateID, myEvent.gateOutputPin, myEvent.newState);
 
 			// Insert all attached wires into the changed wires list:
-			set< IDType > wireGroup = getJunctionGroupIDs(myEvent.wireID);
-			changedWires->insert(wireGroup.begin(), wireGroup.end());
+			insertJunctionGroup(myEvent.wireID, *changedWires);
 		}
 
 		// Look at the next thing in the list:
 		if (!eventQueue.empty()) myEvent = eventQueue.top();
 
 		processedEvents++;
+		eventCount++;
 	}
 
+	// Every cancelled event has come up once the time passes cancelledUntil:
+	if (!cancelledOutputs.empty() && (systemTime >= cancelledUntil)) cancelledOutputs.clear();
+
+	// The junctions are done changing for this step:
+	splitDirtyJunctionGroups();
+
 	// Insert the wires that have been disconnected (or were part of a junction that changed) within
 	// the last call to step() so that they will be properly updated:
 	changedWires->insert(wireUpdateList.begin(), wireUpdateList.end());
@@ -125,27 +210,32 @@ void Circuit::step(ID_SET< IDType > *changedWires)
 	ID_SET< IDType > changedGates;
 	vector< IDType > affectedGates;
 
-	// This keeps track of wires that share junctions that have already
-	// calculated their state:
-	ID_SET< IDType > doneWires;
+	// Each junction group's state is only worked out once:
+	if (groupResolved.size() < junctionGroups.size()) groupResolved.resize(junctionGroups.size(), 0);
+	resolvedGroups.clear();
 	ID_SET< IDType >::iterator chgWireIterator = changedWires->begin();
 	while (chgWireIterator != changedWires->end()) {
 		WIRE_PTR myWire = wireList[*chgWireIterator];
 
 		// Calculate the new state of a wire:
-		// (Note: It sends the group of attached wires to the Wire::calculateState() method.
-		if (doneWires.find(*chgWireIterator) == doneWires.end()) {
-			set< IDType > wireGroupIDs = getJunctionGroupIDs(*chgWireIterator);
-			set< WIRE_PTR > wireGroup = getJunctionGroup(&wireGroupIDs);
-			StateType juncState = myWire->calculateState(wireGroup);
-
-			set< WIRE_PTR >::iterator wgWire = wireGroup.begin();
-			while (wgWire != wireGroup.end()) {
-				(*wgWire)->forceState(juncState);
-				wgWire++;
+		// (Note: It sends the state masks of the attached wires to the Wire::calculateState() method.
+		GroupIndex wireGroup = myWire->junctionGroup;
+		if (wireGroup == GROUP_NONE) {
+			myWire->calculateState(myWire->getStateMask());
+		}
+		else if (!groupResolved[wireGroup]) {
+			const vector< IDType > &groupIDs = junctionGroups[wireGroup].wireIDs;
+			unsigned int groupMask = 0;
+			for (size_t i = 0; i < groupIDs.size(); i++) {
+				groupMask |= wireList[groupIDs[i]]->getStateMask();
+			}
+			StateType juncState = myWire->calculateState(groupMask);
+			for (size_t i = 0; i < groupIDs.size(); i++) {
+				wireList[groupIDs[i]]->forceState(juncState);
 			}
 
-			doneWires.insert(wireGroupIDs.begin(), wireGroupIDs.end());
+			groupResolved[wireGroup] = 1;
+			resolvedGroups.push_back(wireGroup);
 		}
 
 		// Add this wire's gates to the overall gate list:
@@ -157,17 +247,32 @@ void Circuit::step(ID_SET< IDType > *changedWires)
 		// Move on to the next wire in the list:
 		chgWireIterator++;
 	}
+	for (size_t i = 0; i < resolvedGroups.size(); i++) {
+		groupResolved[resolvedGroups[i]] = 0;
+	}
 
 	// Update the gate's states and post the events from the gates:
 	ID_SET< IDType >::iterator changedGatesIterator = changedGates.begin();
 
 
 	// Update all of the gates and retrieve the events from them:
-	while (changedGatesIterator != changedGates.end()) {
-		GATE_PTR myGate = gateList[*changedGatesIterator];
-		myGate->updateGate(*changedGatesIterator, this, ourGUICircuit);	
+	if (gatePool.getNumThreads() > 1 && changedGates.size() >= PARALLEL_MIN_GATES) {
+		parallelIDs.clear();
+		parallelGates.clear();
+		while (changedGatesIterator != changedGates.end()) {
+			parallelIDs.push_back(*changedGatesIterator);
+			parallelGates.push_back(gateList[*changedGatesIterator].get());
+			changedGatesIterator++;
+		}
+		updateGatesInParallel();
+	}
+	else {
+		while (changedGatesIterator != changedGates.end()) {
+			GATE_PTR myGate = gateList[*changedGatesIterator];
+			myGate->updateGate(*changedGatesIterator, this, ourGUICircuit);	
 
-		changedGatesIterator++;
+			changedGatesIterator++;
+		}
 	}
 
 	// Increment the system timer, because this timestep is complete:
@@ -175,6 +280,403 @@ void Circuit::step(ID_SET< IDType > *changedWires)
 
 }
 
+bool Circuit::canStepCycle( void ) {
+	if( !cycleSim.isBuilt() ) cycleSim.build();
+	if( !cycleSim.canRun() ) {
+		cycleFallback = cycleSim.getFallbackReason();
+		return false;
+	}
+
+	// Edits, parameter changes and the events in the queue are run by the
+	// event engine until the circuit settles. (A cancelled event doesn't
+	// count, so drop those.)
+	if( !gateUpdateList.empty() || !wireUpdateList.empty() ) {
+		cycleFallback = "gates or wires waiting to be updated";
+		return false;
+	}
+	while( !cancelledOutputs.empty() && !eventQueue.empty() && isCancelled( eventQueue.top() ) ) {
+		eventQueue.pop();
+	}
+	if( !eventQueue.empty() ) {
+		cycleFallback = "events in the queue";
+		return false;
+	}
+
+	cycleFallback = "";
+	return true;
+}
+
+
+void Circuit::stepCycle( ID_SET< IDType > *changedWires )
+{
+	// The wire states are only kept in the Wire objects, so the compiled
+	// netlist would go out of date:
+	if( netlist.isBuilt() ) netlist.clear();
+
+	if( !cycleStatesLoaded ) {
+		cycleSim.loadStates();
+		cycleStatesLoaded = true;
+	}
+	inCycleStep = true;
+
+	// The clock toggles here at its edges:
+	pollGates();
+
+	// The wires that the caller passed in:
+	if( changedWires != NULL ) {
+		ID_SET< IDType >::iterator updateWire = changedWires->begin();
+		while( updateWire != changedWires->end() ) {
+			cycleSim.updateWire( *updateWire );
+			updateWire++;
+		}
+	}
+
+	cycleSim.settle( changedWires );
+
+	inCycleStep = false;
+	systemTime++;
+}
+
+
+TimeType Circuit::fastForward( TimeType endTime ) {
+	if( systemTime >= endTime ) return 0;
+
+	// Gates and wires that are waiting to be updated, or an open batch,
+	// need a step now:
+	if( batchMode || !gateUpdateList.empty() || !wireUpdateList.empty() ) return 0;
+
+	// Otherwise, the next step that does anything has an event or a poll.
+	// (A cancelled event doesn't count, so drop those first.)
+	while( !cancelledOutputs.empty() && !eventQueue.empty() && isCancelled( eventQueue.top() ) ) {
+		eventQueue.pop();
+	}
+	TimeType nextTime = endTime;
+	if( !eventQueue.empty() ) nextTime = min( nextTime, eventQueue.top().eventTime );
+	if( !pollSchedule.empty() ) nextTime = min( nextTime, pollSchedule.begin()->first );
+	if( nextTime <= systemTime ) return 0;
+
+	TimeType skippedSteps = nextTime - systemTime;
+	systemTime = nextTime;
+	return skippedSteps;
+}
+
+
+void Circuit::runUntil( TimeType endTime ) {
+	while( systemTime < endTime ) {
+		fastForward( endTime );
+		if( systemTime < endTime ) step();
+	}
+}
+
+
+void Circuit::beginBatch( void ) {
+	batchMode = true;
+}
+
+
+void Circuit::commitBatch( void ) {
+	if( !batchMode ) return;
+	batchMode = false;
+
+	rebuildJunctionGroups();
+
+	// The wires whose junctions changed, and the wires of the enabled
+	// junctions that changed, need to be updated with the rest of their
+	// groups. Each group is only added once:
+	ID_SET< IDType > changedWires = batchWires;
+	ID_SET< IDType >::iterator juncWalk = batchJunctions.begin();
+	while( juncWalk != batchJunctions.end() ) {
+		ID_MAP< IDType, JUNC_PTR >::iterator theJunc = juncList.find( *juncWalk );
+		if( ( theJunc != juncList.end() ) && theJunc->second->getEnableState() ) {
+			ID_SET< IDType > juncWires = theJunc->second->getWires();
+			changedWires.insert( juncWires.begin(), juncWires.end() );
+		}
+		juncWalk++;
+	}
+
+	vector< bool > doneGroups( junctionGroups.size(), false );
+	ID_SET< IDType >::iterator wireWalk = changedWires.begin();
+	while( wireWalk != changedWires.end() ) {
+		ID_MAP< IDType, WIRE_PTR >::iterator theWire = wireList.find( *wireWalk );
+		if( theWire != wireList.end() ) {
+			GroupIndex theGroup = theWire->second->junctionGroup;
+			if( theGroup == GROUP_NONE ) {
+				wireUpdateList.insert( *wireWalk );
+			} else if( !doneGroups[theGroup] ) {
+				doneGroups[theGroup] = true;
+				wireUpdateList.insert( junctionGroups[theGroup].wireIDs.begin(), junctionGroups[theGroup].wireIDs.end() );
+			}
+		}
+		wireWalk++;
+	}
+
+	// Take the deleted junctions out of the event list, all at once:
+	if( !batchDeletedJunctions.empty() ) {
+		ID_SET< IDType > &deletedJunctions = batchDeletedJunctions;
+		eventQueue.removeEvents( [&deletedJunctions]( const Event &tempEvent ) {
+			return (tempEvent.isJunctionEvent) && (deletedJunctions.find( tempEvent.junctionID ) != deletedJunctions.end());
+		} );
+	}
+
+	batchWires.clear();
+	batchJunctions.clear();
+	batchDeletedJunctions.clear();
+}
+
+
+// The same as step(), but working on the compiled netlist's arrays:
+void Circuit::stepNetlist(ID_SET< IDType > *changedWires)
+{
+	// Catch the arrays up with any edits since the last step:
+	netlist.sync(wireList, gateList);
+
+	pollGates();
+
+	stepOnlyGates();
+
+	vector< NetIndex > &changedList = netlist.changedList;
+	changedList.clear();
+
+	Event myEvent;
+	if (!eventQueue.empty()) myEvent = eventQueue.top();
+	while (!eventQueue.empty() && (myEvent.eventTime <= systemTime)) {
+		eventQueue.pop();
+
+		if (!cancelledOutputs.empty() && isCancelled(myEvent)) {
+			if (!eventQueue.empty()) myEvent = eventQueue.top();
+			continue;
+		}
+
+		if (myEvent.isJunctionEvent) {
+			setJunctionState(myEvent.junctionID, myEvent.newJunctionState);
+		}
+		else {
+			NetIndex wire = netlist.findWire(myEvent.wireID);
+			if (wire == NET_NONE) {
+				WARNING("Circuit::stepNetlist() - Event for a wire that does not exist.");
+				_MSGW("Wire ID: %lld\n", myEvent.wireID);
+			}
+			else {
+				if (!netlist.setDriverState(wire, myEvent.gateID, myEvent.gateOutputPin, myEvent.newState)) {
+					WARNING("Wire::setInputState() - Invalid input ID.");
+					_MSG("Wire Input ID: %lld pin %lu", myEvent.gateID, myEvent.gateOutputPin);
+				}
+				netlistWireChanged(wire);
+			}
+		}
+		eventCount++;
+
+		if (!eventQueue.empty()) myEvent = eventQueue.top();
+	}
+	if (!cancelledOutputs.empty() && (systemTime >= cancelledUntil)) cancelledOutputs.clear();
+
+	// The junctions are done changing for this step:
+	splitDirtyJunctionGroups();
+
+	// The wires that were disconnected or had a junction change, and any
+	// that the caller passed in:
+	ID_SET< IDType >::iterator updateWire = wireUpdateList.begin();
+	while (updateWire != wireUpdateList.end()) {
+		NetIndex wire = netlist.findWire(*updateWire);
+		if (wire != NET_NONE && !netlist.wireChanged[wire]) {
+			netlist.wireChanged[wire] = 1;
+			changedList.push_back(wire);
+		}
+		updateWire++;
+	}
+	wireUpdateList.clear();
+	if (changedWires != NULL) {
+		updateWire = changedWires->begin();
+		while (updateWire != changedWires->end()) {
+			NetIndex wire = netlist.findWire(*updateWire);
+			if (wire != NET_NONE && !netlist.wireChanged[wire]) {
+				netlist.wireChanged[wire] = 1;
+				changedList.push_back(wire);
+			}
+			updateWire++;
+		}
+	}
+
+	// Resolve each changed wire's junction group once, and collect the gates
+	// fed by the changed wires:
+	vector< NetIndex > &doneList = netlist.doneList;
+	vector< NetIndex > &gateUpdates = netlist.gateUpdates;
+	doneList.clear();
+	gateUpdates.clear();
+	for (size_t i = 0; i < changedList.size(); i++) {
+		NetIndex wire = changedList[i];
+
+		if (!netlist.wireDone[wire]) {
+			GroupIndex wireGroup = netlist.getJunctionGroup(wire);
+			if (wireGroup == GROUP_NONE) {
+				netlist.setWireState(wire, STATE_MASK_TABLE.state[netlist.getStateMask(wire)]);
+				netlist.wireDone[wire] = 1;
+				doneList.push_back(wire);
+			}
+			else {
+				vector< NetIndex > &groupList = netlist.groupList;
+				const vector< IDType > &groupIDs = junctionGroups[wireGroup].wireIDs;
+				groupList.clear();
+				for (size_t j = 0; j < groupIDs.size(); j++) {
+					NetIndex member = netlist.findWire(groupIDs[j]);
+					if (member != NET_NONE) groupList.push_back(member);
+				}
+
+				unsigned int stateMask = 0;
+				for (size_t j = 0; j < groupList.size(); j++) {
+					stateMask |= netlist.getStateMask(groupList[j]);
+				}
+				StateType juncState = STATE_MASK_TABLE.state[stateMask];
+				for (size_t j = 0; j < groupList.size(); j++) {
+					netlist.setWireState(groupList[j], juncState);
+					if (!netlist.wireDone[groupList[j]]) {
+						netlist.wireDone[groupList[j]] = 1;
+						doneList.push_back(groupList[j]);
+					}
+				}
+			}
+		}
+
+		NetIndex last = netlist.fanoutStart[wire] + netlist.fanoutCount[wire];
+		for (NetIndex j = netlist.fanoutStart[wire]; j < last; j++) {
+			NetIndex gate = netlist.fanout[j];
+			if (!netlist.gateChanged[gate]) {
+				netlist.gateChanged[gate] = 1;
+				gateUpdates.push_back(gate);
+			}
+		}
+	}
+
+	// Report the changed wires, and clear the flags for the next step:
+	for (size_t i = 0; i < changedList.size(); i++) {
+		if (changedWires != NULL) changedWires->insert(netlist.wireIDs[changedList[i]]);
+		netlist.wireChanged[changedList[i]] = 0;
+	}
+	for (size_t i = 0; i < doneList.size(); i++) {
+		netlist.wireDone[doneList[i]] = 0;
+	}
+
+	// Update the gates in ID order, the same as step() does:
+	const vector< IDType > &gateIDs = netlist.gateIDs;
+	sort(gateUpdates.begin(), gateUpdates.end(), [&gateIDs](NetIndex left, NetIndex right) {
+		return gateIDs[left] < gateIDs[right];
+	});
+	if (gatePool.getNumThreads() > 1 && gateUpdates.size() >= PARALLEL_MIN_GATES) {
+		parallelIDs.clear();
+		parallelGates.clear();
+		for (size_t i = 0; i < gateUpdates.size(); i++) {
+			NetIndex gate = gateUpdates[i];
+			netlist.gateChanged[gate] = 0;
+			parallelIDs.push_back(gateIDs[gate]);
+			parallelGates.push_back(netlist.gatePtrs[gate]);
+		}
+		updateGatesInParallel();
+	}
+	else {
+		for (size_t i = 0; i < gateUpdates.size(); i++) {
+			NetIndex gate = gateUpdates[i];
+			netlist.gateChanged[gate] = 0;
+			netlist.gatePtrs[gate]->updateGate(gateIDs[gate], this, ourGUICircuit);
+		}
+	}
+
+	systemTime++;
+}
+
+void Circuit::updateGatesInParallel( void ) {
+	// Split the gates into runs, a few per thread, so that the threads
+	// that get the quick gates can take more runs:
+	size_t numGates = parallelGates.size();
+	size_t numRuns = min( (size_t) gatePool.getNumThreads() * 4, numGates / PARALLEL_RUN_GATES );
+	if( numRuns < 1 ) numRuns = 1;
+	if( gateStages.size() < numRuns ) gateStages.resize( numRuns );
+
+	gatePool.run( numRuns, [this, numGates, numRuns]( size_t run ) {
+		size_t first = numGates * run / numRuns;
+		size_t last = numGates * ( run + 1 ) / numRuns;
+		currentStage = &( gateStages[run] );
+		for( size_t i = first; i < last; i++ ) {
+			parallelGates[i]->updateGate( parallelIDs[i], this, ourGUICircuit );
+		}
+		currentStage = NULL;
+	} );
+
+	// The runs are in gate ID order, so this creates the events in the
+	// same order that updating the gates one by one would:
+	for( size_t run = 0; run < numRuns; run++ ) {
+		GateStage &stage = gateStages[run];
+		for( size_t i = 0; i < stage.events.size(); i++ ) {
+			StagedEvent &staged = stage.events[i];
+			if( staged.isJunctionEvent ) {
+				createJunctionEvent( staged.eventTime, staged.targetID, staged.newJunctionState );
+			} else {
+				createEvent( staged.eventTime, staged.targetID, staged.gateID, staged.gateOutputPin, staged.newState );
+			}
+		}
+		paramUpdateList.insert( paramUpdateList.end(), stage.params.begin(), stage.params.end() );
+		memoryChangeList.insert( memoryChangeList.end(), stage.memoryGates.begin(), stage.memoryGates.end() );
+		stage.events.clear();
+		stage.params.clear();
+		stage.memoryGates.clear();
+	}
+}
+
+void Circuit::setGateThreads( unsigned int numThreads ) {
+	gatePool.setNumThreads( numThreads );
+}
+
+unsigned int Circuit::getGateThreads( void ) {
+	return gatePool.getNumThreads();
+}
+
+void Circuit::setCycleMode( bool useIt ) {
+	cycleSim.clear();
+	useCycles = useIt;
+	cycleFallback = "";
+}
+
+bool Circuit::getCycleMode( void ) {
+	return useCycles;
+}
+
+string Circuit::getCycleFallback( void ) {
+	return cycleFallback;
+}
+
+void Circuit::setCompiledGates( bool useIt ) {
+	cycleSim.setCompileGates( useIt );
+}
+
+bool Circuit::getCompiledGates( void ) {
+	return cycleSim.isCompiled();
+}
+
+string Circuit::getCompileFallback( void ) {
+	return cycleSim.getCompileFallback();
+}
+
+// Mark a wire (and the rest of its junction group) as changed during stepNetlist():
+void Circuit::netlistWireChanged(NetIndex wire)
+{
+	GroupIndex wireGroup = netlist.getJunctionGroup(wire);
+	if (wireGroup == GROUP_NONE) {
+		if (!netlist.wireChanged[wire]) {
+			netlist.wireChanged[wire] = 1;
+			netlist.changedList.push_back(wire);
+		}
+		return;
+	}
+
+	const vector< IDType > &groupIDs = junctionGroups[wireGroup].wireIDs;
+	for (size_t i = 0; i < groupIDs.size(); i++) {
+		NetIndex member = netlist.findWire(groupIDs[i]);
+		if (member != NET_NONE && !netlist.wireChanged[member]) {
+			netlist.wireChanged[member] = 1;
+			netlist.changedList.push_back(member);
+		}
+	}
+}
+
 IDType Circuit::newGate(const string &type, IDType gateID ) {
 	IDType thisGateID;
 
@@ -212,11 +714,11 @@ IDType Circuit::newGate(const string &type, IDType gateID ) {
 		} else if( type == "CLOCK" ) {
 			gateList[thisGateID] = GATE_PTR( new Gate_CLOCK );
 			// This is a polled gate, so insert it into the polled gates queue!
-			polledGates.insert(thisGateID);
+			polledGates[thisGateID] = TIME_NONE;
 		} else if( type == "PULSE" ) {
 			gateList[thisGateID] = GATE_PTR( new Gate_PULSE );
 			// This is a polled gate, so insert it into the polled gates queue!
-			polledGates.insert(thisGateID);
+			polledGates[thisGateID] = TIME_NONE;
 		} else if( type == "DRIVER" ) {
 			gateList[thisGateID] = GATE_PTR( new Gate_DRIVER );
 		} else if( type == "ADDER" ) {
@@ -252,7 +754,7 @@ IDType Circuit::newGate(const string &type, IDType gateID ) {
 		} else if (type == "FSM_ASYNC") {											// Pedro Casanova (casanova@ujaen.es) 2021/01-03
 			gateList[thisGateID] = GATE_PTR(new Gate_FSM_ASYNC());
 			// This is a polled gate, so insert it into the polled gates queue!
-			polledGates.insert(thisGateID);
+			polledGates[thisGateID] = TIME_NONE;
 		} else {
 			WARNING( "Circuit::newGate() - Invalid logic type!" );
 			_MSGW("Logic type: %s\n", type.c_str());
@@ -260,6 +762,10 @@ IDType Circuit::newGate(const string &type, IDType gateID ) {
 		// Pedro Casanova (casanova@ujaen.es) 2021/01-03
 		// Needed to know logicType in Circuit
 		gateList[thisGateID]->logicType = type;
+
+		// Polled gates are first polled at the next step:
+		schedulePoll( thisGateID, systemTime );
+		cycleSim.clear();
 	} else {
 		WARNING( "Circuit::newGate() - Re-used gate ID!" );
 		_MSGW("Gate ID: %lld\n", thisGateID);		
@@ -286,6 +792,8 @@ IDType Circuit::newWire( IDType wireID ) {
 	// If the wire isn't already created, then make it:
 	if( wireList.find(thisWireID) == wireList.end() ) {
 		wireList[thisWireID] = myWire;
+		netlist.markWire( thisWireID );
+		cycleSim.clear();
 	} else {
 		WARNING( "Circuit::newWire() - Re-used wire ID!" );
 		_MSGW("wire ID: %lld\n", thisWireID);
@@ -345,7 +853,10 @@ void Circuit::deleteGate( IDType theGate ) {
 	
 	// Remove the gate from the circuit:
 	gateList.erase( theGate );
-	if ( polledGates.find( theGate ) != polledGates.end() ) polledGates.erase( theGate );
+	// (Its entries in the poll schedule are skipped from now on.)
+	polledGates.erase( theGate );
+	netlist.removeGate( theGate );
+	cycleSim.clear();
 }
 
 void Circuit::deleteWire( IDType theWire ) {
@@ -385,8 +896,18 @@ void Circuit::deleteWire( IDType theWire ) {
 	// updating after it's gone!
 	wireUpdateList.erase( theWire );
 
+	// Its old junction group may not be split yet, so take it out of that too:
+	GroupIndex wireGroup = myWire->junctionGroup;
+	if( wireGroup != GROUP_NONE ) {
+		vector< IDType > &groupWires = junctionGroups[wireGroup].wireIDs;
+		groupWires.erase( remove( groupWires.begin(), groupWires.end(), theWire ), groupWires.end() );
+		myWire->junctionGroup = GROUP_NONE;
+	}
+
 	// Remove the wire from the circuit:
 	wireList.erase( theWire );
+	netlist.removeWire( theWire );
+	cycleSim.clear();
 }
 
 void Circuit::deleteJunction( IDType theJunc ) {
@@ -408,21 +929,13 @@ void Circuit::deleteJunction( IDType theJunc ) {
 	}
 
 	// Take the junction out of the event list, to avoid calling events on it
-	// after it has been removed.
-	// Empty the priority queue into a temporary stack, filtering out outdated events:
-	stack< Event > tempEventStack;
-	while( !eventQueue.empty() ) {
-		Event tempEvent = eventQueue.top();
-		if( !((tempEvent.isJunctionEvent) && (tempEvent.junctionID == theJunc)) ) {
-			tempEventStack.push( tempEvent );
-		}
-		eventQueue.pop();
-	}
-		
-	// Push the stack back into the event queue:
-	while( !tempEventStack.empty() ) {
-		eventQueue.push( tempEventStack.top() );
-		tempEventStack.pop();
+	// after it has been removed. (A batch does this once for all of them.)
+	if( batchMode ) {
+		batchDeletedJunctions.insert( theJunc );
+	} else {
+		eventQueue.removeEvents( [theJunc]( const Event &tempEvent ) {
+			return (tempEvent.isJunctionEvent) && (tempEvent.junctionID == theJunc);
+		} );
 	}
 
 	// Remove the junction from the circuit:
@@ -440,6 +953,8 @@ IDType Circuit::connectGateInput( IDType gateID, const string &gateInputID, IDTy
 	
 	// Hook the wire output to the gateID:
 	(wireList[wireID])->connectOutput( gateID, gateInputID );
+	netlist.markWire( wireID );
+	cycleSim.clear();
 
 
 	//TODO: Should trigger some kind of event since the wire now is connected to this here gate,
@@ -458,11 +973,14 @@ IDType Circuit::connectGateOutput( IDType gateID, const string &gateOutputID, ID
 		returnWireID = newWire(wireID);
 	}
 
-	// Connect the wire input to the gate:
-	(wireList[wireID])->connectInput( gateID, gateOutputID );
-
 	// Connect the gate output to the wire:
+	// (This declares the output if the gate hasn't, so it has a pin index.)
 	(gateList[gateID])->connectOutput( gateOutputID, wireID );
+
+	// Connect the wire input to the gate:
+	(wireList[wireID])->connectInput( gateID, (gateList[gateID])->getOutputPin( gateOutputID ), gateOutputID );
+	netlist.markWire( wireID );
+	cycleSim.clear();
 	
 	
 	// Send an event putting the output's value on the wire.
@@ -511,6 +1029,8 @@ void Circuit::disconnectGateInput( IDType gateID, const string &gateInputID ) {
 	if( wireList.find( theWire ) != wireList.end() ) {
 		WIRE_PTR myWire = wireList[ theWire ];
 		myWire->disconnectOutput(gateID, gateInputID );
+		netlist.markWire( theWire );
+		cycleSim.clear();
 	} else if( theWire != ID_NONE ) {
 		WARNING("Circuit::disconnectGateInput() - Wire not found.");
 		_MSGW("Wire ID: %lld\n", theWire);
@@ -529,14 +1049,18 @@ void Circuit::disconnectGateOutput( IDType gateID, const string &gateOutputID )
 		return;
 	}
 	GATE_PTR myGate = gateList[ gateID ];
+	PinIndex gateOutputPin = myGate->getOutputPin( gateOutputID );
 
 	// Wire needs to update based on its other inputs and
 	// cause its output gates to update as well. Just force it onto the update list.
 	// ADDITION: All wires connected by junctions also need to be updated, and
 	// the list needs to be made *before* the wire is disconnected.
 	IDType theWire = myGate->getOutputWire( gateOutputID );
-	ID_SET< IDType > juncWires = getJunctionGroupIDs( theWire );
-	wireUpdateList.insert( juncWires.begin(), juncWires.end() );
+	if( batchMode ) {
+		batchWires.insert( theWire );
+	} else {
+		insertJunctionGroup( theWire, wireUpdateList );
+	}
 
 	// Disconnect the gate from the wire:
 	myGate->disconnectOutput( gateOutputID );
@@ -544,35 +1068,35 @@ void Circuit::disconnectGateOutput( IDType gateID, const string &gateOutputID )
 	// Disconnect the wire from the gate:
 	if( wireList.find( theWire ) != wireList.end() ) {
 		WIRE_PTR myWire = wireList[ theWire ];
-		myWire->disconnectInput(gateID, gateOutputID );
+		myWire->disconnectInput(gateID, gateOutputPin, gateOutputID );
+		netlist.markWire( theWire );
+		cycleSim.clear();
 	} else if( theWire != ID_NONE ) {
 		WARNING("Circuit::disconnectGateOutput() - Wire not found.");
 		_MSGW("Wire ID: %lld\n", theWire);
 		return;
 	}
 
-	// You also have to clear the event queue of any events scheduled for this
-	// gate/gateOutput combination.
-	
-	// Empty the priority queue into a temporary stack, filtering out outdated events:
-	stack< Event > tempEventStack;
-	while( !eventQueue.empty() ) {
-		Event tempEvent = eventQueue.top();
-		if( !((!tempEvent.isJunctionEvent) && (tempEvent.gateID == gateID) && (tempEvent.gateOutputID == gateOutputID)) ) {
-			tempEventStack.push( tempEvent );
-		}
-		eventQueue.pop();
-	}
-	
-	// Push the stack back into the event queue:
-	while( !tempEventStack.empty() ) {
-		eventQueue.push( tempEventStack.top() );
-		tempEventStack.pop();
-	}
+	// You also have to cancel any events scheduled for this gate/gateOutput
+	// combination. They are skipped when they come up, so the event queue
+	// doesn't have to be searched:
+	cancelledOutputs[gateID][gateOutputPin] = Event::getNextCreationTime();
+	cancelledUntil = max( cancelledUntil, lastEventTime );
 
 	return;
 }
 
+
+bool Circuit::isCancelled( const Event &theEvent ) {
+	if( theEvent.isJunctionEvent ) return false;
+
+	ID_MAP< IDType, ID_MAP< PinIndex, TimeType > >::iterator cancelledGate = cancelledOutputs.find( theEvent.gateID );
+	if( cancelledGate == cancelledOutputs.end() ) return false;
+
+	ID_MAP< PinIndex, TimeType >::iterator cancelledOutput = cancelledGate->second.find( theEvent.gateOutputPin );
+	return ( cancelledOutput != cancelledGate->second.end() ) && ( theEvent.getCreationTime() < cancelledOutput->second );
+}
+
 void Circuit::connectJunction( IDType juncID, IDType wireID ) {
 //TODO: Warn the user when a junction cannot happen!
 	if( juncList.find( juncID ) == juncList.end() ) return;
@@ -588,12 +1112,22 @@ void Circuit::connectJunction( IDType juncID, IDType wireID ) {
 
 	// Connect the wire to the junction:
 	myWire->addJunction( juncID );
+	cycleSim.clear();
+
+	// In a batch, the groups are built by commitBatch():
+	if( batchMode ) {
+		batchWires.insert( wireID );
+		batchJunctions.insert( juncID );
+		return;
+	}
+
+	// Join the wire to the junction's group:
+	joinJunctionGroup( myJunc );
 
 	// Put all the wires of the junction group into the update list to have its
 	// state updated during the next step.
 	// (Note: Do this before after hooking up the wire!)
-	ID_SET< IDType > juncWires = getJunctionGroupIDs( wireID );
-	wireUpdateList.insert( juncWires.begin(), juncWires.end() );
+	insertJunctionGroup( wireID, wireUpdateList );
 }
 
 void Circuit::disconnectJunction( IDType juncID, IDType wireID ) {
@@ -604,48 +1138,92 @@ void Circuit::disconnectJunction( IDType juncID, IDType wireID ) {
 	// Put all the wires of the junction group into the update list to have its
 	// state updated during the next step.
 	// (Note: Do this before unhooking the wire!)
-	ID_SET< IDType > juncWires = getJunctionGroupIDs( wireID );
-	wireUpdateList.insert( juncWires.begin(), juncWires.end() );
+	if( batchMode ) {
+		batchWires.insert( wireID );
+		batchJunctions.insert( juncID );
+	} else {
+		insertJunctionGroup( wireID, wireUpdateList );
+	}
 
 	// Get the junction and wire:
 	JUNC_PTR myJunc = juncList[juncID];
 	WIRE_PTR myWire = wireList[wireID];
 	
+	cycleSim.clear();
+
 	// Unlink the wire from the junction.
 	if( myJunc->disconnectWire( wireID ) ) {
 		// If the junction has no more of this wire
 		// connected to it, then unhook the wire from the junction:
 		myWire->removeJunction( juncID );
+
+		// The wire's group may have come apart:
+		if( !batchMode && myJunc->getEnableState() && ( myWire->junctionGroup != GROUP_NONE ) ) {
+			markJunctionGroupDirty( myWire->junctionGroup );
+		}
 	}
 }
 
-void Circuit::createEvent( TimeType eventTime, IDType wireID, IDType gateID, const string &gateOutputID, StateType newState ) {
+void Circuit::createEvent( TimeType eventTime, IDType wireID, IDType gateID, PinIndex gateOutputPin, StateType newState ) {
+	// On a gate thread, keep the event until the threads are done:
+	if( currentStage != NULL ) {
+		StagedEvent staged;
+		staged.isJunctionEvent = false;
+		staged.newJunctionState = false;
+		staged.eventTime = eventTime;
+		staged.targetID = wireID;
+		staged.gateID = gateID;
+		staged.gateOutputPin = gateOutputPin;
+		staged.newState = newState;
+		currentStage->events.push_back( staged );
+		return;
+	}
+
+	// In a cycle step, the wire changes at once:
+	if( inCycleStep ) {
+		cycleSim.driveWire( wireID, gateID, gateOutputPin, newState );
+		eventCount++;
+		return;
+	}
+
 	Event myEvent;
 	myEvent.eventTime = eventTime;
 	myEvent.wireID = wireID;
 	myEvent.gateID = gateID;
-	myEvent.gateOutputID = gateOutputID;
+	myEvent.gateOutputPin = gateOutputPin;
 	myEvent.newState = newState;
 
 #if defined(_MSG_) || !defined(_PRODUCTION_)
 	ostringstream oss;
-	oss << "Creating event for gate " << gateID << " output " << gateOutputID << " to state " << (int) newState << " at time = " << eventTime << "." << endl;
+	oss << "Creating event for gate " << gateID << " output " << gateOutputPin << " to state " << (int) newState << " at time = " << eventTime << "." << endl;
 	WARNING(oss.str().c_str());
 #endif
 
 	// Push the event onto the event queue:
 	eventQueue.push(myEvent);
-	
+	lastEventTime = max( lastEventTime, eventTime );
 }
 
-TimeType Circuit::createDelayedEvent( TimeType delay, IDType wireID, IDType gateID, const string &gateOutputID, StateType newState ) {
-	if( (wireID != ID_NONE) && (gateOutputID != "") ) {
-		createEvent( delay + getSystemTime(), wireID, gateID, gateOutputID, newState );
+TimeType Circuit::createDelayedEvent( TimeType delay, IDType wireID, IDType gateID, PinIndex gateOutputPin, StateType newState ) {
+	if( (wireID != ID_NONE) && (gateOutputPin != PIN_NONE) ) {
+		createEvent( delay + getSystemTime(), wireID, gateID, gateOutputPin, newState );
 	}
 	return delay + getSystemTime();
 }
 
 void Circuit::createJunctionEvent( TimeType eventTime, IDType juncID, bool newState ) {
+	if( currentStage != NULL ) {
+		StagedEvent staged;
+		staged.isJunctionEvent = true;
+		staged.newJunctionState = newState;
+		staged.eventTime = eventTime;
+		staged.targetID = juncID;
+		staged.gateID = ID_NONE;
+		staged.newState = UNKNOWN;
+		currentStage->events.push_back( staged );
+		return;
+	}
+
 	Event myEvent;
 	myEvent.eventTime = eventTime;
 	myEvent.isJunctionEvent = true;
@@ -656,11 +1234,29 @@ void Circuit::createJunctionEvent( TimeType eventTime, IDType juncID, bool newSt
 	eventQueue.push(myEvent);
 }
 
+void Circuit::setEventScheduler( EventQueue::SchedulerType newType ) {
+	eventQueue.setSchedulerType( newType );
+}
+
+EventQueue::SchedulerType Circuit::getEventScheduler( void ) {
+	return eventQueue.getSchedulerType();
+}
+
+void Circuit::setCompiledNetlist( bool useIt ) {
+	// The arrays aren't kept up to date while they are unused, so always
+	// start over from the wire and gate maps:
+	netlist.clear();
+	useNetlist = useIt;
+}
+
+bool Circuit::getCompiledNetlist( void ) {
+	return useNetlist;
+}
+
 void Circuit::destroyAllEvents( void ) {
 
-	while( !eventQueue.empty() ) {
-		eventQueue.pop();
-	}
+	eventQueue.clear();
+	cancelledOutputs.clear();
 
 	gateUpdateList.clear();
 	wireUpdateList.clear();
@@ -673,6 +1269,9 @@ void Circuit::setGateParameter( IDType gateID, const string &paramName, const st
 			// add it to the gateUpdateList:
 			gateUpdateList.insert( gateID );
 		}
+
+		// Parameters can change when a polled gate needs polling:
+		schedulePoll( gateID, systemTime );
 	} else {
 		WARNING("Circuit::setGateParameter() - Gate not found.");
 		_MSGW("Gate ID: %lld\n", gateID);
@@ -687,6 +1286,9 @@ void Circuit::setGateInputParameter( IDType gateID, const string & inputID, cons
 			// add it to the gateUpdateList:
 			gateUpdateList.insert( gateID );
 		}
+
+		// Parameters can change when a polled gate needs polling:
+		schedulePoll( gateID, systemTime );
 	} else {
 		WARNING("Circuit::setGateParameter() - Gate not found.");
 		_MSGW("Gate ID: %lld\n", gateID);
@@ -701,6 +1303,12 @@ void Circuit::setGateOutputParameter( IDType gateID, const string & outputID, co
 			// add it to the gateUpdateList:
 			gateUpdateList.insert( gateID );
 		}
+
+		// (An output's enable pin decides if cycle mode can run.)
+		cycleSim.clear();
+
+		// Parameters can change when a polled gate needs polling:
+		schedulePoll( gateID, systemTime );
 	} else {
 		WARNING("Circuit::setGateParameter() - Gate not found.");
 		_MSGW("Gate ID: %lld\n", gateID);
@@ -709,6 +1317,10 @@ void Circuit::setGateOutputParameter( IDType gateID, const string & outputID, co
 }
 
 void Circuit::addUpdateParam(IDType gateID, const string & paramName) {
+	if (currentStage != NULL) {
+		currentStage->params.push_back(changedParam(gateID, paramName));
+		return;
+	}
 	paramUpdateList.push_back(changedParam(gateID, paramName));
 }
 
@@ -720,6 +1332,29 @@ void Circuit::clearParamUpdateList() {
 	paramUpdateList.clear();
 };
 
+void Circuit::addMemoryChange( IDType gateID ) {
+	if( currentStage != NULL ) {
+		currentStage->memoryGates.push_back( gateID );
+		return;
+	}
+	memoryChangeList.push_back( gateID );
+}
+
+void Circuit::takeMemoryChanges( vector< RamChanges > &changes ) {
+	for( size_t i = 0; i < memoryChangeList.size(); i++ ) {
+		// (The gate may have been deleted since it was listed.)
+		ID_MAP< IDType, GATE_PTR >::iterator theGate = gateList.find( memoryChangeList[i] );
+		if( theGate == gateList.end() ) continue;
+
+		RamChanges gateChanges;
+		gateChanges.gateID = memoryChangeList[i];
+		if( theGate->second->takeMemoryChanges( gateChanges ) ) {
+			changes.push_back( gateChanges );
+		}
+	}
+	memoryChangeList.clear();
+}
+
 ID_SET< IDType > Circuit::getGateIDs() {
 	ID_SET< IDType > idList;
 	ID_MAP< IDType, GATE_PTR >::iterator thisGate = gateList.begin();
@@ -745,8 +1380,15 @@ string Circuit::getGateParameter( IDType gateID, const string & paramName ) {
 }
 
 StateType Circuit::getWireState( IDType wireID ) {
-	if( wireList.find( wireID ) != wireList.end() ) {
-		return wireList[wireID]->getState();
+	if( useNetlist ) {
+		NetIndex wire = netlist.findWire( wireID );
+		if( wire != NET_NONE ) return netlist.getWireState( wire );
+	}
+
+	// (Gates call this from the gate threads, so only look the wire up.)
+	ID_MAP< IDType, WIRE_PTR >::iterator theWire = wireList.find( wireID );
+	if( theWire != wireList.end() ) {
+		return theWire->second->getState();
 	} else {
 		WARNING("Circuit::getWireState() - Wire does not exist.");
 		_MSGW("Wire ID: %lld\n", wireID);
@@ -760,7 +1402,28 @@ void Circuit::setJunctionState( IDType juncID, bool newState ) {
 
 	// Get the junction:
 	JUNC_PTR myJunc = juncList[juncID];
+	bool oldState = myJunc->getEnableState();
 	myJunc->setEnableState( newState );
+	if( newState != oldState ) cycleSim.clear();
+
+	// In a batch, the groups are built by commitBatch():
+	if( batchMode ) {
+		ID_SET< IDType > juncWires = myJunc->getWires();
+		batchWires.insert( juncWires.begin(), juncWires.end() );
+		return;
+	}
+
+	// Update the junction groups:
+	if( newState && !oldState ) {
+		joinJunctionGroup( myJunc );
+	} else if( oldState && !newState ) {
+		// All of the junction's wires were in one group, which may now come apart:
+		ID_SET< IDType > juncWires = myJunc->getWires();
+		if( !juncWires.empty() ) {
+			GroupIndex theGroup = wireList[*juncWires.begin()]->junctionGroup;
+			if( theGroup != GROUP_NONE ) markJunctionGroupDirty( theGroup );
+		}
+	}
 
 	// Put all of the connected wires into the "wireUpdateList" list to have their
 	// state updated during the next (or current) step() call.
@@ -768,8 +1431,7 @@ void Circuit::setJunctionState( IDType juncID, bool newState ) {
 	ID_SET< IDType > juncWires = myJunc->getWires();
 	ID_SET< IDType >::iterator juncWire = juncWires.begin();
 	while( juncWire != juncWires.end() ) {
-		ID_SET< IDType > juncGroup = getJunctionGroupIDs( *juncWire );
-		wireUpdateList.insert( juncGroup.begin(), juncGroup.end() );
+		insertJunctionGroup( *juncWire, wireUpdateList );
 		juncWire++;
 	}
 }
@@ -787,11 +1449,176 @@ TimeType Circuit::getSystemTime( void ) {
 	return systemTime;
 }
 
+unsigned long long Circuit::getEventCount( void ) {
+	return eventCount;
+}
+
 set< IDType > Circuit::getJunctionGroupIDs( IDType wireID ) {
 	// This is the wire group IDs that will be returned:
 	set< IDType > wireGroupIDs;
 
+	// (The groups that have come apart since the last step are split first.)
+	splitDirtyJunctionGroups();
+
 //TODO: Warn the user when a wire does not exist!
+	ID_MAP< IDType, WIRE_PTR >::iterator theWire = wireList.find( wireID );
+	if( theWire == wireList.end() ) return wireGroupIDs;
+
+	GroupIndex theGroup = theWire->second->junctionGroup;
+	if( theGroup == GROUP_NONE ) {
+		wireGroupIDs.insert( wireID );
+	} else {
+		wireGroupIDs.insert( junctionGroups[theGroup].wireIDs.begin(), junctionGroups[theGroup].wireIDs.end() );
+	}
+	return wireGroupIDs;
+}
+
+// Return an empty junction group:
+GroupIndex Circuit::newJunctionGroup( void ) {
+	if( freeJunctionGroups.empty() ) {
+		junctionGroups.push_back( JunctionGroup() );
+		return (GroupIndex) junctionGroups.size() - 1;
+	}
+	GroupIndex newGroup = freeJunctionGroups.back();
+	freeJunctionGroups.pop_back();
+	return newGroup;
+}
+
+// Join all of the wires on an enabled junction into one junction group:
+void Circuit::joinJunctionGroup( JUNC_PTR theJunc ) {
+	if( !theJunc->getEnableState() ) return;
+	ID_SET< IDType > juncWires = theJunc->getWires();
+
+	// Keep the largest of the wires' groups, and move everything else into it:
+	GroupIndex keepGroup = GROUP_NONE;
+	ID_SET< IDType >::iterator juncWire = juncWires.begin();
+	while( juncWire != juncWires.end() ) {
+		GroupIndex wireGroup = wireList[*juncWire]->junctionGroup;
+		if( ( wireGroup != GROUP_NONE ) && ( ( keepGroup == GROUP_NONE ) ||
+			( junctionGroups[wireGroup].wireIDs.size() > junctionGroups[keepGroup].wireIDs.size() ) ) ) {
+			keepGroup = wireGroup;
+		}
+		juncWire++;
+	}
+
+	if( keepGroup == GROUP_NONE ) {
+		// A lone wire doesn't need a group:
+		if( juncWires.size() < 2 ) return;
+		keepGroup = newJunctionGroup();
+	}
+
+	vector< IDType > &keepWires = junctionGroups[keepGroup].wireIDs;
+	juncWire = juncWires.begin();
+	while( juncWire != juncWires.end() ) {
+		WIRE_PTR myWire = wireList[*juncWire];
+		GroupIndex wireGroup = myWire->junctionGroup;
+		if( wireGroup == GROUP_NONE ) {
+			myWire->junctionGroup = keepGroup;
+			keepWires.push_back( *juncWire );
+		} else if( wireGroup != keepGroup ) {
+			// Move the whole group over, and whether it still has to be split:
+			vector< IDType > &oldWires = junctionGroups[wireGroup].wireIDs;
+			for( size_t i = 0; i < oldWires.size(); i++ ) {
+				wireList[oldWires[i]]->junctionGroup = keepGroup;
+				keepWires.push_back( oldWires[i] );
+			}
+			oldWires.clear();
+			if( junctionGroups[wireGroup].dirty ) {
+				junctionGroups[wireGroup].dirty = false;
+				markJunctionGroupDirty( keepGroup );
+			}
+			freeJunctionGroups.push_back( wireGroup );
+		}
+		juncWire++;
+	}
+}
+
+// Build all of the junction groups again from the enabled junctions:
+void Circuit::rebuildJunctionGroups( void ) {
+	for( size_t i = 0; i < junctionGroups.size(); i++ ) {
+		vector< IDType > &groupWires = junctionGroups[i].wireIDs;
+		for( size_t j = 0; j < groupWires.size(); j++ ) {
+			ID_MAP< IDType, WIRE_PTR >::iterator theWire = wireList.find( groupWires[j] );
+			if( theWire != wireList.end() ) theWire->second->junctionGroup = GROUP_NONE;
+		}
+	}
+	junctionGroups.clear();
+	freeJunctionGroups.clear();
+	dirtyJunctionGroups.clear();
+
+	ID_MAP< IDType, JUNC_PTR >::iterator theJunc = juncList.begin();
+	while( theJunc != juncList.end() ) {
+		joinJunctionGroup( theJunc->second );
+		theJunc++;
+	}
+}
+
+// Break a junction group up into the groups that are still connected,
+// after one of its junctions was disabled or lost a wire:
+void Circuit::splitJunctionGroup( GroupIndex theGroup ) {
+	vector< IDType > oldWires;
+	oldWires.swap( junctionGroups[theGroup].wireIDs );
+	junctionGroups[theGroup].dirty = false;
+	freeJunctionGroups.push_back( theGroup );
+
+	for( size_t i = 0; i < oldWires.size(); i++ ) {
+		wireList[oldWires[i]]->junctionGroup = GROUP_NONE;
+	}
+
+	// Search out the pieces that are left, and give each one a new group:
+	ID_SET< IDType > doneWires;
+	for( size_t i = 0; i < oldWires.size(); i++ ) {
+		if( doneWires.find( oldWires[i] ) != doneWires.end() ) continue;
+
+		set< IDType > piece = searchJunctionGroup( oldWires[i] );
+		doneWires.insert( piece.begin(), piece.end() );
+		if( piece.size() < 2 ) continue;
+
+		GroupIndex newGroup = newJunctionGroup();
+		junctionGroups[newGroup].wireIDs.assign( piece.begin(), piece.end() );
+		set< IDType >::iterator pieceWire = piece.begin();
+		while( pieceWire != piece.end() ) {
+			wireList[*pieceWire]->junctionGroup = newGroup;
+			pieceWire++;
+		}
+	}
+}
+
+// Mark a junction group to be split by splitDirtyJunctionGroups():
+void Circuit::markJunctionGroupDirty( GroupIndex theGroup ) {
+	if( junctionGroups[theGroup].dirty ) return;
+	junctionGroups[theGroup].dirty = true;
+	dirtyJunctionGroups.push_back( theGroup );
+}
+
+// Split the junction groups that have come apart since the last call:
+void Circuit::splitDirtyJunctionGroups( void ) {
+	for( size_t i = 0; i < dirtyJunctionGroups.size(); i++ ) {
+		// (A group that was joined into another one has passed its mark on.)
+		if( junctionGroups[dirtyJunctionGroups[i]].dirty ) splitJunctionGroup( dirtyJunctionGroups[i] );
+	}
+	dirtyJunctionGroups.clear();
+}
+
+// Add the wires of a wire's junction group to a list of wire IDs:
+void Circuit::insertJunctionGroup( IDType wireID, ID_SET< IDType > &wireIDs ) {
+	ID_MAP< IDType, WIRE_PTR >::iterator theWire = wireList.find( wireID );
+	if( theWire == wireList.end() ) return;
+
+	GroupIndex theGroup = theWire->second->junctionGroup;
+	if( theGroup == GROUP_NONE ) {
+		wireIDs.insert( wireID );
+	} else {
+		wireIDs.insert( junctionGroups[theGroup].wireIDs.begin(), junctionGroups[theGroup].wireIDs.end() );
+	}
+}
+
+// Find the wires that are connected to this one by following the
+// enabled junctions, without using the junction groups:
+set< IDType > Circuit::searchJunctionGroup( IDType wireID ) {
+	// This is the wire group IDs that will be returned:
+	set< IDType > wireGroupIDs;
+
 	if( wireList.find( wireID ) == wireList.end() ) return wireGroupIDs;
 
 	// This wire is automatically included in the group:
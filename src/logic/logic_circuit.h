@@ -15,10 +15,17 @@
 
 #include "logic_defaults.h"
 #include "logic_event.h"
+#include "logic_event_queue.h"
 #include "logic_wire.h"
 #include "logic_gate.h"
 #include "logic_junction.h"
-#include "..\gui\GUICircuit.h"
+#include "logic_netlist.h"
+#include "logic_ram_memory.h"
+#include "logic_cycle_sim.h"
+#include "logic_thread_pool.h"
+
+// The logic core only keeps a pointer to its GUI, so it builds without it:
+class GUICircuit;
 
 #include<queue>
 #include<functional>  // KAS 2016
@@ -39,6 +46,8 @@ class Circuit {
 
 	friend class Junction;
 	friend class Wire;
+	friend class PatternSim;
+	friend class CycleSim;
 
 public:
 
@@ -65,6 +74,25 @@ public:
 	// If a pointer to a set is passed, then it will
 	// return a set of all the changed wires to the calling function.
 	void step(  ID_SET< IDType > *changedWires = NULL );
+
+	// Skip over the time steps at which nothing is scheduled, without
+	// going past endTime. Those steps would not change anything, so this
+	// is the same as calling step() for each of them. Returns the number
+	// of steps that were skipped:
+	TimeType fastForward( TimeType endTime );
+
+	// Step the simulation until the system time reaches endTime,
+	// skipping over the idle steps:
+	void runUntil( TimeType endTime );
+
+	// Make a large set of edits, like loading a file or pasting a block,
+	// as one batch. Between beginBatch() and commitBatch() the junction
+	// groups are not kept up to date, and the wires that need updating
+	// are only noted. commitBatch() rebuilds the junction groups in one
+	// pass. step() commits an open batch first:
+	void beginBatch( void );
+	void commitBatch( void );
+	bool inBatch( void ) const { return batchMode; };
 	
 	// Create a new gate, and return its ID:
 	// NOTE: There should also be some way to pass
@@ -108,14 +136,49 @@ public:
 	void disconnectJunction( IDType juncID, IDType wireID );
 
 	// Create an event and put it in the event queue:
-	void createEvent( TimeType eventTime, IDType wireID, IDType gateID, const string &gateOutputID, StateType newState );
+	void createEvent( TimeType eventTime, IDType wireID, IDType gateID, PinIndex gateOutputPin, StateType newState );
 	
 	// Create an event that occurs at systemTime + delay:
-	TimeType createDelayedEvent( TimeType delay, IDType wireID, IDType gateID, const string &gateOutputID, StateType newState );
+	TimeType createDelayedEvent( TimeType delay, IDType wireID, IDType gateID, PinIndex gateOutputPin, StateType newState );
 
 	// Create Junction Event and put it in the event queue:
 	void createJunctionEvent( TimeType eventTime, IDType juncID, bool newState );
 	
+	// Select the scheduler used for the event queue. Pending events are kept,
+	// and events come out in the same order with either scheduler:
+	void setEventScheduler( EventQueue::SchedulerType newType );
+	EventQueue::SchedulerType getEventScheduler( void );
+
+	// Run step() on a compiled, array based copy of the netlist instead of
+	// on the wire and gate maps. The arrays are built on the next step(),
+	// and kept up to date as the circuit is edited. Results are the same either way:
+	void setCompiledNetlist( bool useIt );
+	bool getCompiledNetlist( void );
+
+	// Update the gates of a large time step on this many threads (1, the
+	// default, updates them on the calling thread). The gates only read
+	// the wires, and their events are put in the queue in gate ID order
+	// afterwards, so results are the same for any number of threads:
+	void setGateThreads( unsigned int numThreads );
+	unsigned int getGateThreads( void );
+
+	// Run a fully synchronous circuit a clock edge at a time (see CycleSim):
+	// each step settles the gates in level order at once, without the event
+	// queue. A circuit with T gates, tri-state outputs or combinational
+	// loops steps with the event engine instead, and so do edits and
+	// parameter changes until the events that they start have run out.
+	// getCycleFallback() says why the last step didn't use cycle mode:
+	void setCycleMode( bool useIt );
+	bool getCycleMode( void );
+	string getCycleFallback( void );
+
+	// In cycle mode, turn the combinational gates into C++ and run them
+	// compiled (see CompiledSim). getCompiledGates() says if they are, and
+	// getCompileFallback() why not:
+	void setCompiledGates( bool useIt );
+	bool getCompiledGates( void );
+	string getCompileFallback( void );
+
 	// Clear out the event queue, destroying all events,
 	// and also erase all events in the gateUpdateList and wireUpdateList.
 	// This is used if we wanted a simulation where all of the wires
@@ -138,6 +201,12 @@ public:
 
 	void clearParamUpdateList();
 
+	// The words that RAM gates wrote are sent to the GUI in blocks, rather
+	// than as parameters. A gate lists itself once it has changed words,
+	// and takeMemoryChanges() collects them from the listed gates:
+	void addMemoryChange( IDType gateID );
+	void takeMemoryChanges( vector< RamChanges > &changes );
+
 	// ************ Circuit inspection methods **************
 
 	// Get the IDs of all gates in the circuit:
@@ -156,6 +225,9 @@ public:
 	// Return the current simulation time:
 	TimeType getSystemTime( );
 
+	// Return the number of events that step() has processed so far:
+	unsigned long long getEventCount( void );
+
 	// Returns a list of all wires that are connected to this
 	// wire via junctions:
 	set< WIRE_PTR > getJunctionGroup( IDType wireID );
@@ -175,6 +247,58 @@ protected:
 	JUNC_PTR getJunction(IDType theJunc);
 
 private:
+	// The step() used when the compiled netlist is turned on:
+	void stepNetlist( ID_SET< IDType > *changedWires );
+
+	// Return true if step() can use stepCycle(), building the CycleSim
+	// first if the circuit has changed:
+	bool canStepCycle( void );
+
+	// The step() used in cycle mode:
+	void stepCycle( ID_SET< IDType > *changedWires );
+
+	// Poll the polled gates that are due at this time step, in ID order:
+	void pollGates( void );
+
+	// Poll a polled gate no later than pollTime:
+	void schedulePoll( IDType gateID, TimeType pollTime );
+
+	// Return true if the event belongs to a gate output that has been
+	// disconnected since the event was created:
+	bool isCancelled( const Event &theEvent );
+
+	// Build all of the junction groups again from the enabled junctions:
+	void rebuildJunctionGroups( void );
+
+	// Mark a wire (and the rest of its junction group) as changed during stepNetlist():
+	void netlistWireChanged( NetIndex wire );
+
+	// Update the gates in parallelGates on the gate threads, and then
+	// create their events and parameter changes in gate ID order:
+	void updateGatesInParallel( void );
+
+	// Return an empty junction group:
+	GroupIndex newJunctionGroup( void );
+
+	// Join all of the wires on an enabled junction into one junction group:
+	void joinJunctionGroup( JUNC_PTR theJunc );
+
+	// Break a junction group up into the groups that are still connected,
+	// after one of its junctions was disabled or lost a wire:
+	void splitJunctionGroup( GroupIndex theGroup );
+
+	// Mark a junction group to be split by splitDirtyJunctionGroups(), so
+	// that a junction that toggles often is only searched once per step:
+	void markJunctionGroupDirty( GroupIndex theGroup );
+	void splitDirtyJunctionGroups( void );
+
+	// Add the wires of a wire's junction group to a list of wire IDs:
+	void insertJunctionGroup( IDType wireID, ID_SET< IDType > &wireIDs );
+
+	// Find the wires that are connected to this one by following the
+	// enabled junctions, without using the junction groups:
+	set< IDType > searchJunctionGroup( IDType wireID );
+
 	// All the gates in the circuit, and the ID counter:
 	ID_MAP< IDType, GATE_PTR > gateList;
 	IDType gateIDCount;
@@ -187,14 +311,31 @@ private:
 	ID_MAP< IDType, JUNC_PTR > juncList;
 	IDType juncIDCount;
 	
+	// The junction groups, indexed by Wire::junctionGroup. These are only
+	// changed by connectJunction(), disconnectJunction() and setJunctionState(),
+	// so finding a wire's group never needs a search. The groups that have
+	// come apart are split at the next step:
+	vector< JunctionGroup > junctionGroups;
+	vector< GroupIndex > freeJunctionGroups;
+	vector< GroupIndex > dirtyJunctionGroups;
+
+	// The junction groups whose state step() has worked out this step:
+	vector< char > groupResolved;
+	vector< GroupIndex > resolvedGroups;
+
 	// This is the mapping of junction states, and how often each is used (# of gates):
 	ID_MAP< string, IDType > junctionIDs;
 	ID_MAP< string, unsigned long > junctionUseCounter;
 
-	// The gates that must be polled at each time step
-	// to allow them to create events:
-	// This is just a list of gate IDs to access from the gateList.
-	ID_SET< IDType > polledGates;
+	// The gates that must be polled to allow them to create events, and
+	// the time step at which each one is polled next (TIME_NONE if it is
+	// waiting for a parameter change):
+	ID_MAP< IDType, TimeType > polledGates;
+
+	// The polled gates to poll at each time step. A gate may be listed
+	// at a time that is no longer its next poll time, and then it is
+	// skipped:
+	ID_MAP< TimeType, ID_SET< IDType > > pollSchedule;
 
 	// This is the set of gates that needs to be forced into updating
 	// at the next call to step() due to one of their inputs being
@@ -207,12 +348,75 @@ private:
 	ID_SET< IDType > wireUpdateList;
 
 	// This is the event queue for the Circuit:
-	priority_queue< Event, vector< Event >, greater< Event > > eventQueue;
+	EventQueue eventQueue;
+
+	// The events of a disconnected gate output are left in the event queue,
+	// and skipped when they come up. They are the events of that output
+	// that were created before the creation time stored here:
+	ID_MAP< IDType, ID_MAP< PinIndex, TimeType > > cancelledOutputs;
+
+	// The latest event time in the event queue, and the time by which
+	// every cancelled event has come up, so cancelledOutputs can be cleared:
+	TimeType lastEventTime;
+	TimeType cancelledUntil;
+
+	// True during a batch of edits. The wires and junctions whose links
+	// changed, and the junctions that were deleted, are handled by
+	// commitBatch():
+	bool batchMode;
+	ID_SET< IDType > batchWires;
+	ID_SET< IDType > batchJunctions;
+	ID_SET< IDType > batchDeletedJunctions;
 	
 	// This is the current system time:
 	TimeType systemTime;
 
+	// The number of events processed by step():
+	unsigned long long eventCount;
+
+	// The compiled netlist, and whether step() uses it:
+	Netlist netlist;
+	bool useNetlist;
+
+	// The levelized copy for cycle mode, and whether step() uses it. During
+	// stepCycle(), createEvent() changes the wires through the CycleSim:
+	CycleSim cycleSim;
+	bool useCycles;
+	bool inCycleStep;
+	bool cycleStatesLoaded;
+	string cycleFallback;
+
 	vector < changedParam > paramUpdateList;
+	vector< IDType > memoryChangeList;
+
+	// An event that a gate created on a gate thread:
+	struct StagedEvent {
+		bool isJunctionEvent;
+		bool newJunctionState;
+		TimeType eventTime;
+		IDType targetID; // The wire, or the junction
+		IDType gateID;
+		PinIndex gateOutputPin;
+		StateType newState;
+	};
+
+	// The events and parameter changes of one run of gates in a parallel
+	// update. While a thread updates its gates, currentStage points to
+	// the stage that createEvent(), addUpdateParam() and addMemoryChange()
+	// fill in:
+	struct GateStage {
+		vector< StagedEvent > events;
+		vector< changedParam > params;
+		vector< IDType > memoryGates;
+	};
+	static thread_local GateStage *currentStage;
+
+	// The gates to update in parallel, in ID order, and the stages of
+	// their runs:
+	LogicThreadPool gatePool;
+	vector< IDType > parallelIDs;
+	vector< Gate * > parallelGates;
+	vector< GateStage > gateStages;
 };
 
 #endif // LOGIC_CIRCUIT_H
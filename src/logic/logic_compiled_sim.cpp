@@ -0,0 +1,205 @@
+/*****************************************************************************
+   Project: CEDAR Logic Simulator
+   Copyright 2006 Cedarville University, Benjamin Sprague,
+                     Matt Lewellyn, and David Knierim
+   All rights reserved.
+   For license information see license.txt included with distribution.
+
+   logic_compiled_sim: Turns the combinational gates of a Circuit into C++,
+   and compiles and loads it to run them
+*****************************************************************************/
+
+#include "logic_compiled_sim.h"
+#include "logic_gate.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+CompiledSim::CompiledSim()
+{
+	currentInputNets = NULL;
+	currentOutputNets = NULL;
+	library = NULL;
+	runFunction = NULL;
+}
+
+CompiledSim::~CompiledSim()
+{
+	unload();
+}
+
+bool CompiledSim::build( const vector< IDType > &gateIDs, const vector< Gate * > &gates,
+		const vector< vector< NetIndex > > &inputNets, const vector< vector< NetIndex > > &outputNets ) {
+	fallbackReason.clear();
+
+	ostringstream code;
+	code << "// Written by CEDAR Logic: the combinational gates of a circuit, in the order\n";
+	code << "// that they settle in.\n\n";
+	code << "typedef unsigned char S;\n";
+	code << "enum { ZERO = " << (int) ZERO << ", ONE = " << (int) ONE << ", HI_Z = " << (int) HI_Z
+		<< ", CONFLICT = " << (int) CONFLICT << ", UNKNOWN = " << (int) UNKNOWN << " };\n\n";
+	code << "static inline bool binary( S s ) { return ( s == ZERO ) || ( s == ONE ); }\n";
+	code << "static inline S inv( S s ) { return ( s == ZERO ) ? ONE : ( s == ONE ) ? ZERO : s; }\n";
+	code << "static inline S pullUp( S s ) { return ( binary( s ) || ( s == CONFLICT ) ) ? s : ONE; }\n";
+	code << "static inline S pullDown( S s ) { return ( binary( s ) || ( s == CONFLICT ) ) ? s : ZERO; }\n";
+	code << "static inline S pass( S s ) { return binary( s ) ? s : UNKNOWN; }\n\n";
+	code << "extern \"C\" unsigned long cedarlogic_run( S *n, unsigned long *changed ) {\n";
+	code << "\tunsigned long numChanged = 0;\n";
+	code << "\tS v;\n";
+
+	for( unsigned long g = 0; g < gates.size(); g++ ) {
+		currentInputNets = &inputNets[g];
+		currentOutputNets = &outputNets[g];
+		gateCode.str("");
+		gateCode.clear();
+
+		if( !gates[g]->updateCode( this ) ) {
+			ostringstream oss;
+			oss << "a " << gates[g]->logicType << " gate has no compiled version (gate " << gateIDs[g] << ")";
+			fallbackReason = oss.str();
+			currentInputNets = currentOutputNets = NULL;
+			source.clear();
+			return false;
+		}
+		code << "\t// Gate " << gateIDs[g] << " (" << gates[g]->logicType << "):\n" << gateCode.str();
+	}
+	currentInputNets = currentOutputNets = NULL;
+
+	code << "\treturn numChanged;\n";
+	code << "}\n";
+	source = code.str();
+	return true;
+}
+
+string CompiledSim::getInputPinCode( PinIndex pin ) const {
+	if( ( pin >= currentInputNets->size() ) || ( (*currentInputNets)[pin] == NET_NONE ) ) return "HI_Z";
+	ostringstream oss;
+	oss << "n[" << (*currentInputNets)[pin] << "]";
+	return oss.str();
+}
+
+void CompiledSim::driveOutputPin( PinIndex pin, const string &stateCode ) {
+	if( ( pin >= currentOutputNets->size() ) || ( (*currentOutputNets)[pin] == NET_NONE ) ) return;
+	NetIndex net = (*currentOutputNets)[pin];
+	gateCode << "\tv = " << stateCode << ";\n";
+	gateCode << "\tif( n[" << net << "] != v ) { n[" << net << "] = v; changed[numChanged++] = " << net << "; }\n";
+}
+
+bool CompiledSim::load( void ) {
+	if( isLoaded() ) return true;
+	unload();
+	fallbackReason.clear();
+	if( source.empty() ) {
+		fallbackReason = "there is no source to compile";
+		return false;
+	}
+
+#ifdef _WIN32
+	fallbackReason = "compiled gates are only loaded on POSIX systems";
+	return false;
+#else
+	// Write the source in a directory that only we can write to, so that
+	// nobody else can swap the library that gets loaded:
+	const char *tempDir = getenv( "TMPDIR" );
+	string dirTemplate = string( ( tempDir != NULL && *tempDir != 0 ) ? tempDir : "/tmp" ) + "/cedarlogic_XXXXXX";
+	vector< char > dirName( dirTemplate.begin(), dirTemplate.end() );
+	dirName.push_back( 0 );
+	if( mkdtemp( &dirName[0] ) == NULL ) {
+		fallbackReason = "a directory can't be made from " + dirTemplate;
+		return false;
+	}
+	string dir = &dirName[0];
+	string sourceFile = dir + "/gates.cpp";
+	string libraryFile = dir + "/gates.so";
+	string logFile = dir + "/compile.log";
+
+	ofstream out( sourceFile.c_str() );
+	out << source;
+	out.close();
+	if( !out ) {
+		fallbackReason = "the source can't be written to " + sourceFile;
+		rmdir( dir.c_str() );
+		return false;
+	}
+
+	// The compiler is run directly, without a shell. $CXX is split at the
+	// spaces, so that it can be a launcher and a compiler:
+	const char *compiler = getenv( "CXX" );
+	vector< string > args;
+	istringstream compilerWords( ( compiler != NULL && *compiler != 0 ) ? compiler : "c++" );
+	string word;
+	while( compilerWords >> word ) args.push_back( word );
+	if( args.empty() ) args.push_back( "c++" );
+	args.push_back( "-O1" );
+	args.push_back( "-shared" );
+	args.push_back( "-fPIC" );
+	args.push_back( "-o" );
+	args.push_back( libraryFile );
+	args.push_back( sourceFile );
+	vector< char * > argv;
+	for( unsigned long i = 0; i < args.size(); i++ ) argv.push_back( &args[i][0] );
+	argv.push_back( NULL );
+
+	int status = -1;
+	pid_t child = fork();
+	if( child == 0 ) {
+		// Send the compiler's messages to the log:
+		int log = open( logFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW, 0600 );
+		if( log >= 0 ) {
+			dup2( log, 1 );
+			dup2( log, 2 );
+			close( log );
+		}
+		execvp( argv[0], &argv[0] );
+		const char message[] = "the compiler can't be run\n";
+		ssize_t written = write( 2, message, sizeof( message ) - 1 );
+		(void) written;
+		_exit( 127 );
+	}
+	if( child > 0 ) {
+		while( waitpid( child, &status, 0 ) < 0 && errno == EINTR );
+	}
+	if( child < 0 || !WIFEXITED( status ) || WEXITSTATUS( status ) != 0 ) {
+		// Keep the source and the compiler's messages to look at:
+		fallbackReason = "the compiler failed (see " + logFile + ")";
+		return false;
+	}
+
+	library = dlopen( libraryFile.c_str(), RTLD_NOW | RTLD_LOCAL );
+	if( library != NULL ) {
+		runFunction = (CompiledRunFunction) dlsym( library, "cedarlogic_run" );
+	}
+	if( runFunction == NULL ) {
+		const char *error = dlerror();
+		fallbackReason = string( "the compiled gates can't be loaded: " ) + ( ( error != NULL ) ? error : libraryFile );
+		unload();
+		return false;
+	}
+
+	// (The library stays mapped after its file is removed.)
+	remove( sourceFile.c_str() );
+	remove( libraryFile.c_str() );
+	remove( logFile.c_str() );
+	rmdir( dir.c_str() );
+	loadedSource = source;
+	return true;
+#endif
+}
+
+void CompiledSim::unload( void ) {
+#ifndef _WIN32
+	if( library != NULL ) dlclose( library );
+#endif
+	library = NULL;
+	runFunction = NULL;
+	loadedSource.clear();
+}
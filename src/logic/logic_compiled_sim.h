@@ -0,0 +1,95 @@
+/*****************************************************************************
+   Project: CEDAR Logic Simulator
+   Copyright 2006 Cedarville University, Benjamin Sprague,
+                     Matt Lewellyn, and David Knierim
+   All rights reserved.
+   For license information see license.txt included with distribution.
+
+   logic_compiled_sim: Turns the combinational gates of a Circuit into C++,
+   and compiles and loads it to run them
+*****************************************************************************/
+
+#ifndef LOGIC_COMPILED_SIM_H
+#define LOGIC_COMPILED_SIM_H
+
+#include "logic_defaults.h"
+#include "logic_netlist.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+class Gate;
+
+// The function in the compiled code. It runs the gates on the net states,
+// puts the nets that change in changedNets, and returns how many there are:
+typedef unsigned long (*CompiledRunFunction)( unsigned char *netStates, unsigned long *changedNets );
+
+// A CompiledSim writes a C++ source file with a line of straight code for
+// each gate, in the order given, over a flat array of net states (one
+// StateType per net). The gates write their own code, for their type and
+// bus width (see Gate::codeProcess()), in the same way that they give a
+// pattern version for the PatternSim.
+//
+// load() compiles the file into a shared library with the system compiler
+// ($CXX, or "c++"; it may have flags after it, like "ccache g++ -m64") in a
+// private directory that it makes under $TMPDIR (or /tmp), and loads it
+// with dlopen(). A CycleSim uses it to run its combinational gates, all
+// of them at once, after the state gates.
+//
+// Each net may only have one driver, whose output is then the net's state.
+class CompiledSim
+{
+public:
+	CompiledSim();
+	~CompiledSim();
+
+	// Write the source for the gates, with the nets of their input and
+	// output pins (NET_NONE if a pin isn't connected). Returns false if a
+	// gate has no compiled version, and getFallbackReason() says why:
+	bool build( const vector< IDType > &gateIDs, const vector< Gate * > &gates,
+		const vector< vector< NetIndex > > &inputNets, const vector< vector< NetIndex > > &outputNets );
+	const string &getSource( void ) const { return source; };
+
+	// Compile and load the source. If it is the same as the source that
+	// is already loaded, that one is kept:
+	bool load( void );
+	bool isLoaded( void ) const { return ( runFunction != NULL ) && ( loadedSource == source ); };
+	const string &getFallbackReason( void ) const { return fallbackReason; };
+
+	// Run the loaded gates:
+	unsigned long run( unsigned char *netStates, unsigned long *changedNets ) {
+		return runFunction( netStates, changedNets );
+	};
+
+	// ************ Used by the gates during build() **************
+
+	// The code for the state of the wire on an input pin of the gate that
+	// is being written (HI_Z if it isn't connected):
+	string getInputPinCode( PinIndex pin ) const;
+
+	// Write the code that sets the wire of an output pin of the gate that
+	// is being written:
+	void driveOutputPin( PinIndex pin, const string &stateCode );
+
+private:
+	// Unload the library:
+	void unload( void );
+
+	string source;
+	string fallbackReason;
+
+	// The pins of the gate that is being written:
+	const vector< NetIndex > *currentInputNets;
+	const vector< NetIndex > *currentOutputNets;
+	ostringstream gateCode;
+
+	// The library, and the source that it was built from. (Each library
+	// gets a directory of its own, since dlopen() reuses a library that
+	// is already loaded from the same file.)
+	void *library;
+	CompiledRunFunction runFunction;
+	string loadedSource;
+};
+
+#endif // LOGIC_COMPILED_SIM_H
@@ -0,0 +1,406 @@
+/*****************************************************************************
+   Project: CEDAR Logic Simulator
+   Copyright 2006 Cedarville University, Benjamin Sprague,
+                     Matt Lewellyn, and David Knierim
+   All rights reserved.
+   For license information see license.txt included with distribution.
+
+   logic_cycle_sim: Runs a fully synchronous Circuit a clock edge at a
+   time, without the event queue
+*****************************************************************************/
+
+#include "logic_cycle_sim.h"
+#include "logic_circuit.h"
+#include "logic_gate.h"
+
+#include <algorithm>
+#include <sstream>
+
+CycleSim::CycleSim( Circuit *theCircuit )
+{
+	myCircuit = theCircuit;
+	built = false;
+	numPending = 0;
+	holdDrives = false;
+	compileGates = false;
+	useCompiled = false;
+	compiledPending = false;
+	applyingCompiled = false;
+}
+
+bool CycleSim::build( void ) {
+	built = true;
+	fallbackReason.clear();
+
+	wireNets.clear();
+	netWireIDs.clear();
+	netWirePtrs.clear();
+	netStates.clear();
+	netReaders.clear();
+	gateIDs.clear();
+	gatePtrs.clear();
+	isStateGate.clear();
+	gateLevels.clear();
+	gateMarked.clear();
+	pendingState.clear();
+	pendingLevels.clear();
+	numPending = 0;
+	netChanged.clear();
+	changedNets.clear();
+	useCompiled = false;
+	compileFallback.clear();
+	compiledPending = false;
+	netDriverGates.clear();
+	netDriverPins.clear();
+	netDriverWires.clear();
+
+	// Only the clock may be polled, since the gates only run when a wire
+	// changes or at the clock's edges:
+	IDType clockID = ID_NONE;
+	ID_MAP< IDType, TimeType >::iterator polled = myCircuit->polledGates.begin();
+	while( polled != myCircuit->polledGates.end() ) {
+		if( myCircuit->gateList[polled->first]->logicType != "CLOCK" ) {
+			return fallBack( "a polled gate that isn't a clock", polled->first );
+		}
+		if( clockID != ID_NONE ) return fallBack( "more than one clock", polled->first );
+		clockID = polled->first;
+		polled++;
+	}
+	if( clockID == ID_NONE ) return fallBack( "no clock", ID_NONE );
+
+	// Give every junction group a net:
+	ID_MAP< IDType, WIRE_PTR >::iterator wireWalk = myCircuit->wireList.begin();
+	while( wireWalk != myCircuit->wireList.end() ) {
+		if( findNet( wireWalk->first ) == NET_NONE ) {
+			NetIndex net = (NetIndex) netWireIDs.size();
+			set< IDType > groupWires = myCircuit->getJunctionGroupIDs( wireWalk->first );
+			netWireIDs.push_back( vector< IDType >( groupWires.begin(), groupWires.end() ) );
+			netWirePtrs.push_back( vector< Wire * >() );
+			set< IDType >::iterator groupWalk = groupWires.begin();
+			while( groupWalk != groupWires.end() ) {
+				if( wireNets.size() <= *groupWalk ) wireNets.resize( (size_t) *groupWalk + 1, NET_NONE );
+				wireNets[(size_t) *groupWalk] = net;
+				netWirePtrs[net].push_back( myCircuit->wireList[*groupWalk].get() );
+				groupWalk++;
+			}
+			netStates.push_back( wireWalk->second->getState() );
+		}
+		wireWalk++;
+	}
+	netReaders.resize( netWireIDs.size() );
+	netChanged.resize( netWireIDs.size(), 0 );
+
+	NetIndex clockNet = findNet( myCircuit->gateList[clockID]->getOutputWire( "CLK" ) );
+
+	// Find the state gates, the gates that read each net and the gate that
+	// drives it:
+	vector< unsigned long > &netDrivers = netDriverGates;
+	netDrivers.assign( netWireIDs.size(), (unsigned long) -1 );
+	netDriverPins.assign( netWireIDs.size(), PIN_NONE );
+	netDriverWires.assign( netWireIDs.size(), ID_NONE );
+	ID_MAP< IDType, GATE_PTR >::iterator gateWalk = myCircuit->gateList.begin();
+	while( gateWalk != myCircuit->gateList.end() ) {
+		unsigned long gate = (unsigned long) gateIDs.size();
+		Gate *theGate = gateWalk->second.get();
+		gateIDs.push_back( gateWalk->first );
+		gatePtrs.push_back( theGate );
+		isStateGate.push_back( false );
+
+		if( theGate->logicType == "TGATE" ) return fallBack( "a T gate switches junctions", gateWalk->first );
+
+		vector< IDType > pinWires = theGate->getInputWires();
+		for( PinIndex pin = 0; pin < pinWires.size(); pin++ ) {
+			if( theGate->isEdgeTriggered( pin ) ) {
+				isStateGate[gate] = true;
+				if( ( pinWires[pin] != ID_NONE ) && ( findNet( pinWires[pin] ) != clockNet ) ) {
+					return fallBack( "a clock input that isn't on the clock's wire", gateWalk->first );
+				}
+			}
+			NetIndex net = findNet( pinWires[pin] );
+			if( ( net != NET_NONE ) && ( netReaders[net].empty() || ( netReaders[net].back() != gate ) ) ) {
+				netReaders[net].push_back( gate );
+			}
+		}
+
+		pinWires = theGate->getOutputWires();
+		for( PinIndex pin = 0; pin < pinWires.size(); pin++ ) {
+			NetIndex net = findNet( pinWires[pin] );
+			if( net == NET_NONE ) continue;
+			if( theGate->getEnablePin( pin ) != PIN_NONE ) return fallBack( "a tri-state output", gateWalk->first );
+			if( netDrivers[net] != (unsigned long) -1 ) return fallBack( "a wire with more than one driver", gateWalk->first );
+			netDrivers[net] = gate;
+			netDriverPins[net] = pin;
+			netDriverWires[net] = pinWires[pin];
+		}
+		gateWalk++;
+	}
+
+	// Levelize the combinational gates: count the combinational gates that
+	// drive each one, and take the gates in the order that their drivers
+	// are done:
+	unsigned long numGates = (unsigned long) gateIDs.size();
+	vector< unsigned long > waitingOn( numGates, 0 );
+	vector< vector< NetIndex > > gateOutputNets( numGates );
+	for( NetIndex net = 0; net < netDrivers.size(); net++ ) {
+		unsigned long driver = netDrivers[net];
+		if( driver == (unsigned long) -1 ) continue;
+		gateOutputNets[driver].push_back( net );
+		if( isStateGate[driver] ) continue;
+		for( unsigned long r = 0; r < netReaders[net].size(); r++ ) {
+			if( !isStateGate[netReaders[net][r]] ) waitingOn[netReaders[net][r]]++;
+		}
+	}
+
+	gateLevels.assign( numGates, 0 );
+	vector< unsigned long > ready;
+	unsigned long numCombinational = 0;
+	for( unsigned long gate = 0; gate < numGates; gate++ ) {
+		if( isStateGate[gate] ) continue;
+		numCombinational++;
+		if( waitingOn[gate] == 0 ) ready.push_back( gate );
+	}
+	unsigned long numLevels = 1;
+	for( unsigned long r = 0; r < ready.size(); r++ ) {
+		unsigned long driver = ready[r];
+		for( unsigned long o = 0; o < gateOutputNets[driver].size(); o++ ) {
+			const vector< unsigned long > &readers = netReaders[gateOutputNets[driver][o]];
+			for( unsigned long i = 0; i < readers.size(); i++ ) {
+				unsigned long reader = readers[i];
+				if( isStateGate[reader] ) continue;
+				gateLevels[reader] = max( gateLevels[reader], gateLevels[driver] + 1 );
+				numLevels = max( numLevels, gateLevels[reader] + 1 );
+				if( --waitingOn[reader] == 0 ) ready.push_back( reader );
+			}
+		}
+	}
+	if( ready.size() < numCombinational ) {
+		for( unsigned long gate = 0; gate < numGates; gate++ ) {
+			if( !isStateGate[gate] && ( waitingOn[gate] != 0 ) ) return fallBack( "a loop of combinational gates", gateIDs[gate] );
+		}
+	}
+
+	gateMarked.assign( numGates, 0 );
+	pendingLevels.resize( numLevels );
+
+	if( compileGates ) {
+		useCompiled = buildCompiled();
+		if( !useCompiled ) WARNING("CycleSim::build() - The gates can't be compiled, so they are run one at a time.");
+	}
+	return true;
+}
+
+bool CycleSim::buildCompiled( void ) {
+	// The combinational gates that read a net and drive one, in the order
+	// of their levels. (The others, like the clock, only change when
+	// they're polled, or have no outputs, like the LEDs and junctions.)
+	vector< unsigned long > order;
+	for( unsigned long gate = 0; gate < gateIDs.size(); gate++ ) {
+		if( !isStateGate[gate] ) order.push_back( gate );
+	}
+	stable_sort( order.begin(), order.end(), [this]( unsigned long a, unsigned long b ) {
+		return gateLevels[a] < gateLevels[b];
+	} );
+
+	vector< IDType > orderIDs;
+	vector< Gate * > orderGates;
+	vector< vector< NetIndex > > inputNets, outputNets;
+	for( unsigned long i = 0; i < order.size(); i++ ) {
+		Gate *theGate = gatePtrs[order[i]];
+		vector< IDType > pinWires = theGate->getInputWires();
+		vector< NetIndex > pinNets( pinWires.size() );
+		bool readsNet = false;
+		for( PinIndex pin = 0; pin < pinWires.size(); pin++ ) {
+			pinNets[pin] = findNet( pinWires[pin] );
+			if( pinNets[pin] != NET_NONE ) readsNet = true;
+		}
+		if( !readsNet ) continue;
+
+		pinWires = theGate->getOutputWires();
+		vector< NetIndex > outNets( pinWires.size() );
+		bool drivesNet = false;
+		for( PinIndex pin = 0; pin < pinWires.size(); pin++ ) {
+			outNets[pin] = findNet( pinWires[pin] );
+			if( outNets[pin] != NET_NONE ) drivesNet = true;
+		}
+		if( !drivesNet ) continue;
+
+		orderIDs.push_back( gateIDs[order[i]] );
+		orderGates.push_back( theGate );
+		inputNets.push_back( pinNets );
+		outputNets.push_back( outNets );
+	}
+
+	if( !compiledSim.build( orderIDs, orderGates, inputNets, outputNets ) || !compiledSim.load() ) {
+		compileFallback = compiledSim.getFallbackReason();
+		return false;
+	}
+	compiledChanges.resize( netWireIDs.size() );
+	return true;
+}
+
+bool CycleSim::fallBack( const string &reason, IDType gateID ) {
+	ostringstream oss;
+	oss << reason;
+	if( gateID != ID_NONE ) oss << " (gate " << gateID << ")";
+	fallbackReason = oss.str();
+	return false;
+}
+
+void CycleSim::loadStates( void ) {
+	for( NetIndex net = 0; net < netWirePtrs.size(); net++ ) {
+		netStates[net] = netWirePtrs[net][0]->getState();
+	}
+}
+
+void CycleSim::driveWire( IDType wireID, IDType gateID, PinIndex gateOutputPin, StateType newState ) {
+	NetIndex net = findNet( wireID );
+	if( net == NET_NONE ) {
+		WARNING("CycleSim::driveWire() - Wire does not exist.");
+		_MSGW("Wire ID: %lld\n", wireID);
+		return;
+	}
+	if( holdDrives ) {
+		HeldDrive held;
+		held.wireID = wireID;
+		held.gateID = gateID;
+		held.gateOutputPin = gateOutputPin;
+		held.newState = newState;
+		heldDrives.push_back( held );
+		return;
+	}
+	myCircuit->wireList[wireID]->setInputState( gateID, gateOutputPin, newState );
+	updateNet( net, false );
+}
+
+void CycleSim::updateWire( IDType wireID ) {
+	NetIndex net = findNet( wireID );
+	if( net != NET_NONE ) updateNet( net, true );
+}
+
+void CycleSim::updateNet( NetIndex net, bool force ) {
+	// The same as Wire::calculateState() for the whole junction group:
+	const vector< Wire * > &wires = netWirePtrs[net];
+	unsigned int stateMask = 0;
+	for( unsigned long w = 0; w < wires.size(); w++ ) {
+		stateMask |= wires[w]->getStateMask();
+	}
+	StateType newState = STATE_MASK_TABLE.state[stateMask];
+	if( ( newState == netStates[net] ) && !force ) return;
+
+	netStates[net] = newState;
+	for( unsigned long w = 0; w < wires.size(); w++ ) {
+		wires[w]->forceState( newState );
+	}
+	if( !netChanged[net] ) {
+		netChanged[net] = 1;
+		changedNets.push_back( net );
+	}
+
+	const vector< unsigned long > &readers = netReaders[net];
+	for( unsigned long r = 0; r < readers.size(); r++ ) {
+		markGate( readers[r] );
+	}
+}
+
+void CycleSim::markGate( unsigned long gate ) {
+	// The compiled code runs all of the combinational gates, so they
+	// only need to be marked as a group. (The changes that it makes have
+	// reached all of them already.)
+	if( useCompiled && !isStateGate[gate] ) {
+		if( !applyingCompiled ) compiledPending = true;
+		return;
+	}
+	if( gateMarked[gate] ) return;
+	gateMarked[gate] = 1;
+	numPending++;
+	if( isStateGate[gate] ) {
+		pendingState.push_back( gate );
+	} else {
+		pendingLevels[gateLevels[gate]].push_back( gate );
+	}
+}
+
+void CycleSim::settle( ID_SET< IDType > *changedWires ) {
+	// Each pass updates the state gates together, so that they all see the
+	// wires from before the clock edge, the same as in the event engine.
+	// A combinational gate only changes the gates at higher levels, so a
+	// single sweep through the levels settles them. Only the state gates'
+	// other inputs (like an asynchronous CLEAR) need another pass:
+	unsigned long pass = 0;
+	while( ( numPending > 0 ) || compiledPending ) {
+		if( pass++ == MAX_SETTLE_PASSES ) {
+			WARNING("CycleSim::settle() - The state gates keep changing, so the circuit doesn't settle.");
+			runList.clear();
+			runList.swap( pendingState );
+			for( unsigned long level = 0; level < pendingLevels.size(); level++ ) {
+				runList.insert( runList.end(), pendingLevels[level].begin(), pendingLevels[level].end() );
+				pendingLevels[level].clear();
+			}
+			for( unsigned long i = 0; i < runList.size(); i++ ) gateMarked[runList[i]] = 0;
+			numPending = 0;
+			compiledPending = false;
+			break;
+		}
+
+		runPending( pendingState, true );
+		if( useCompiled ) {
+			if( compiledPending ) runCompiled();
+		} else {
+			for( unsigned long level = 0; level < pendingLevels.size(); level++ ) {
+				runPending( pendingLevels[level], false );
+			}
+		}
+	}
+
+	// Report the changed wires, and clear the flags for the next step:
+	for( unsigned long i = 0; i < changedNets.size(); i++ ) {
+		NetIndex net = changedNets[i];
+		if( changedWires != NULL ) changedWires->insert( netWireIDs[net].begin(), netWireIDs[net].end() );
+		netChanged[net] = 0;
+	}
+	changedNets.clear();
+}
+
+void CycleSim::runPending( vector< unsigned long > &pending, bool holdOutputs ) {
+	if( pending.empty() ) return;
+
+	// The gates that these gates mark go on the pending lists for later:
+	runList.clear();
+	runList.swap( pending );
+	sort( runList.begin(), runList.end() );
+	numPending -= (unsigned long) runList.size();
+	for( unsigned long i = 0; i < runList.size(); i++ ) {
+		gateMarked[runList[i]] = 0;
+	}
+	holdDrives = holdOutputs;
+	for( unsigned long i = 0; i < runList.size(); i++ ) {
+		unsigned long gate = runList[i];
+		gatePtrs[gate]->updateGate( gateIDs[gate], myCircuit, myCircuit->ourGUICircuit );
+	}
+	holdDrives = false;
+
+	for( unsigned long i = 0; i < heldDrives.size(); i++ ) {
+		const HeldDrive &held = heldDrives[i];
+		driveWire( held.wireID, held.gateID, held.gateOutputPin, held.newState );
+	}
+	heldDrives.clear();
+}
+
+void CycleSim::runCompiled( void ) {
+	compiledPending = false;
+
+	// The code sets the states of the nets that it changes itself, so the
+	// nets are updated even though their states are already set:
+	unsigned long numChanged = compiledSim.run( &netStates[0], &compiledChanges[0] );
+	applyingCompiled = true;
+	for( unsigned long i = 0; i < numChanged; i++ ) {
+		NetIndex net = compiledChanges[i];
+		Gate *theGate = gatePtrs[netDriverGates[net]];
+		PinIndex pin = netDriverPins[net];
+		StateType newState = netStates[net];
+		theGate->setLastOutputState( pin, newState, myCircuit->getSystemTime() );
+		myCircuit->wireList[netDriverWires[net]]->setInputState( gateIDs[netDriverGates[net]], pin, newState );
+		updateNet( net, true );
+	}
+	applyingCompiled = false;
+}
@@ -0,0 +1,170 @@
+/*****************************************************************************
+   Project: CEDAR Logic Simulator
+   Copyright 2006 Cedarville University, Benjamin Sprague,
+                     Matt Lewellyn, and David Knierim
+   All rights reserved.
+   For license information see license.txt included with distribution.
+
+   logic_cycle_sim: Runs a fully synchronous Circuit a clock edge at a
+   time, without the event queue
+*****************************************************************************/
+
+#ifndef LOGIC_CYCLE_SIM_H
+#define LOGIC_CYCLE_SIM_H
+
+#include "logic_defaults.h"
+#include "logic_netlist.h"
+#include "logic_compiled_sim.h"
+
+#include <string>
+#include <vector>
+
+class Circuit;
+class Gate;
+class Wire;
+
+// A CycleSim settles the gates of a synchronous Circuit in one ordered sweep
+// per time step, for Circuit::setCycleMode().
+//
+// build() checks that the circuit has a single CLOCK gate, that every
+// edge-triggered input (the clock inputs of the registers, flip-flops and
+// FSMs) is on the clock's wire, and that there are no T gates, tri-state
+// outputs, wires with more than one driver, other polled gates or loops of
+// combinational gates. It then gives each combinational gate a level, one
+// more than the gates that drive it. The gates with clock inputs hold the
+// state, so they are at the start of the order, like the inputs.
+//
+// During a cycle step, the Circuit hands the gates' output changes to
+// driveWire() instead of to the event queue. settle() then updates the gates
+// that they reach, the state gates first and then one level at a time, until
+// nothing changes. The wires end up as they are once the event engine has
+// settled, so the results are the same as long as the logic settles within
+// half of a clock cycle. (A glitch on the way there isn't seen, so it can't
+// trigger an asynchronous input like a flip-flop's CLEAR.)
+//
+// With setCompileGates(), build() also turns the combinational gates into
+// C++ with a CompiledSim. settle() then runs all of them at once with the
+// compiled code, instead of one gate at a time, and the state gates as
+// before. If they can't be compiled, getCompileFallback() says why, and
+// the gates are run one at a time.
+class CycleSim
+{
+public:
+	CycleSim( Circuit *theCircuit );
+
+	// Forget the build, after the circuit has been edited:
+	void clear( void ) { built = false; };
+	bool isBuilt( void ) const { return built; };
+
+	// Levelize the circuit. Returns false if it can't be run a cycle at a
+	// time, and getFallbackReason() says why:
+	bool build( void );
+	bool canRun( void ) const { return built && fallbackReason.empty(); };
+	const string &getFallbackReason( void ) const { return fallbackReason; };
+
+	// Compile the combinational gates in the next build():
+	void setCompileGates( bool newCompileGates ) { compileGates = newCompileGates; built = false; };
+	bool isCompiled( void ) const { return useCompiled; };
+	const string &getCompileFallback( void ) const { return compileFallback; };
+
+	// ************ Used by the Circuit during a cycle step **************
+
+	// Take the states of the wires again, after the event engine has
+	// changed them:
+	void loadStates( void );
+
+	// Change the state of a gate output's wire now, instead of with an event:
+	void driveWire( IDType wireID, IDType gateID, PinIndex gateOutputPin, StateType newState );
+
+	// Work out a wire's state again, and update the gates that it feeds
+	// even if the state didn't change (after a connection changed):
+	void updateWire( IDType wireID );
+
+	// Update the gates that the changed wires reach, until the circuit
+	// settles, and add the changed wires to changedWires:
+	void settle( ID_SET< IDType > *changedWires );
+
+	// The number of passes over the state gates before settle() gives up on
+	// a circuit whose state gates keep changing each other:
+	static const unsigned long MAX_SETTLE_PASSES = 1000;
+
+private:
+	// Record the reason that build() failed, and return false:
+	bool fallBack( const string &reason, IDType gateID );
+
+	// Return the net of a wire, or NET_NONE:
+	NetIndex findNet( IDType wireID ) const {
+		return ( wireID < wireNets.size() ) ? wireNets[(size_t) wireID] : NET_NONE;
+	};
+
+	// Resolve a net from the states driven onto its wires. If the state
+	// changed (or "force" is set), mark the net and the gates that it feeds:
+	void updateNet( NetIndex net, bool force );
+
+	// Put a gate on the list of gates to update:
+	void markGate( unsigned long gate );
+
+	// Write, compile and load the code for the combinational gates:
+	bool buildCompiled( void );
+
+	// Run the compiled gates, and update the wires that they change:
+	void runCompiled( void );
+
+	// Update the gates on a pending list, in ID order. If holdOutputs is
+	// set, the wires don't change until all of the gates have been updated:
+	void runPending( vector< unsigned long > &pending, bool holdOutputs );
+
+	Circuit *myCircuit;
+	bool built;
+	string fallbackReason;
+
+	// Every wire in a junction group shares one net:
+	vector< NetIndex > wireNets;
+	vector< vector< IDType > > netWireIDs;
+	vector< vector< Wire * > > netWirePtrs;
+	vector< StateType > netStates;
+	vector< vector< unsigned long > > netReaders;
+
+	// The gates, in ID order:
+	vector< IDType > gateIDs;
+	vector< Gate * > gatePtrs;
+	vector< bool > isStateGate;
+	vector< unsigned long > gateLevels;
+	vector< unsigned char > gateMarked;
+
+	// The gates to update in settle(): the state gates, and the
+	// combinational gates of each level:
+	vector< unsigned long > pendingState;
+	vector< vector< unsigned long > > pendingLevels;
+	unsigned long numPending;
+	vector< unsigned long > runList;
+
+	// The output changes that runPending() holds back:
+	struct HeldDrive {
+		IDType wireID;
+		IDType gateID;
+		PinIndex gateOutputPin;
+		StateType newState;
+	};
+	bool holdDrives;
+	vector< HeldDrive > heldDrives;
+
+	// The nets that changed during this step:
+	vector< unsigned char > netChanged;
+	vector< NetIndex > changedNets;
+
+	// The compiled combinational gates. The gate and output pin that drive
+	// each net give the wires the states that the code sets:
+	CompiledSim compiledSim;
+	bool compileGates;
+	bool useCompiled;
+	string compileFallback;
+	bool compiledPending;
+	bool applyingCompiled;
+	vector< unsigned long > netDriverGates;
+	vector< PinIndex > netDriverPins;
+	vector< IDType > netDriverWires;
+	vector< unsigned long > compiledChanges;
+};
+
+#endif // LOGIC_CYCLE_SIM_H
@@ -10,7 +10,7 @@ Event::Event() {
 	eventTime = TIME_NONE;
 	wireID = ID_NONE;
 	gateID = ID_NONE;
-	gateOutputID = "";
+	gateOutputPin = PIN_NONE;
 
 	// Tag the creation time, for sorting if there are two at the same simulation time:
 	myCreationTime = globalCreationTime++;
@@ -19,6 +19,10 @@ Event::Event() {
 TimeType Event::getCreationTime() const {
 	return myCreationTime;
 };
+
+TimeType Event::getNextCreationTime() {
+	return globalCreationTime;
+};
 ;
 bool Event::operator > (const Event &other) const {
 
@@ -30,12 +30,15 @@ public:
 	TimeType eventTime;  // The time at which the event will happen.
 	IDType wireID;       // The wire that the event will affect.
 	IDType gateID;       // The gate that is having a changed output.
-	string gateOutputID; // The gate output that is changing.
+	PinIndex gateOutputPin; // The gate output that is changing.
 	
 	Event();
 
 	TimeType getCreationTime() const;
 
+	// The creation time that the next event will get:
+	static TimeType getNextCreationTime();
+
 	// Sort events by time.
 	// Used in logic_circuit event queue.
 	bool operator > (const Event &other) const;
@@ -0,0 +1,181 @@
+/*****************************************************************************
+   Project: CEDAR Logic Simulator
+   Copyright 2006 Cedarville University, Benjamin Sprague,
+                     Matt Lewellyn, and David Knierim
+   All rights reserved.
+   For license information see license.txt included with distribution.
+
+   logic_event_queue: Event scheduler used by the Circuit class
+*****************************************************************************/
+
+#include "logic_event_queue.h"
+#include <algorithm>
+
+const TimeType EventQueue::WHEEL_SIZE;
+
+// Used to keep the wheel buckets sorted by creation time:
+static bool createdBefore( const Event &left, const Event &right ) {
+	return left.getCreationTime() < right.getCreationTime();
+}
+
+EventQueue::EventQueue( SchedulerType newType )
+{
+	schedType = SCHED_HEAP;
+	wheelBase = 0;
+	wheelCursor = 0;
+	wheelEvents = 0;
+	numEvents = 0;
+
+	setSchedulerType( newType );
+}
+
+// Switch scheduler. Pending events are kept.
+void EventQueue::setSchedulerType( SchedulerType newType ) {
+	if( wheel.empty() && ( newType == SCHED_TIMING_WHEEL ) ) {
+		wheel.resize( (size_t) WHEEL_SIZE );
+	}
+	if( newType == schedType ) return;
+
+	// Drain the events in order, and re-insert them into the new scheduler:
+	vector< Event > pending;
+	pending.reserve( numEvents );
+	while( !empty() ) {
+		pending.push_back( top() );
+		pop();
+	}
+	clear();
+
+	schedType = newType;
+	for( size_t i = 0; i < pending.size(); i++ ) {
+		push( pending[i] );
+	}
+}
+
+// Add an event to the queue:
+void EventQueue::push( const Event &newEvent ) {
+	numEvents++;
+	if( ( schedType == SCHED_TIMING_WHEEL ) && inWindow( newEvent.eventTime ) ) {
+		wheelInsert( newEvent );
+	} else {
+		overflow.push( newEvent );
+	}
+}
+
+// Return the earliest event (Queue must not be empty):
+const Event &EventQueue::top( void ) {
+	if( ( schedType == SCHED_HEAP ) || overflowIsFirst() ) {
+		return overflow.top();
+	}
+	return bucket( wheelCursor ).front();
+}
+
+// Remove the earliest event:
+void EventQueue::pop( void ) {
+	if( schedType == SCHED_HEAP ) {
+		overflow.pop();
+		numEvents--;
+		return;
+	}
+
+	TimeType popTime;
+	if( overflowIsFirst() ) {
+		popTime = overflow.top().eventTime;
+		overflow.pop();
+	} else {
+		popTime = wheelCursor;
+		bucket( wheelCursor ).pop_front();
+		wheelEvents--;
+	}
+	numEvents--;
+
+	// Nothing left in the queue is earlier than the event we just popped,
+	// so the window can be slid forward to start at its time:
+	if( popTime > wheelBase ) {
+		wheelBase = popTime;
+		wheelCursor = max( wheelCursor, popTime );
+	}
+	pullFromOverflow();
+}
+
+// Throw away all of the events:
+void EventQueue::clear( void ) {
+	while( !overflow.empty() ) {
+		overflow.pop();
+	}
+	for( size_t i = 0; i < wheel.size(); i++ ) {
+		wheel[i].clear();
+	}
+	wheelCursor = wheelBase;
+	wheelEvents = 0;
+	numEvents = 0;
+}
+
+// Remove every event for which removeIt( event ) returns true:
+void EventQueue::removeEvents( const std::function< bool( const Event & ) > &removeIt ) {
+	// Filter the heap by emptying it into a temporary list:
+	vector< Event > keptEvents;
+	while( !overflow.empty() ) {
+		if( !removeIt( overflow.top() ) ) {
+			keptEvents.push_back( overflow.top() );
+		}
+		overflow.pop();
+	}
+	for( size_t i = 0; i < keptEvents.size(); i++ ) {
+		overflow.push( keptEvents[i] );
+	}
+	numEvents = overflow.size();
+
+	// Filter the wheel buckets in place (they stay sorted):
+	wheelEvents = 0;
+	for( size_t i = 0; i < wheel.size(); i++ ) {
+		wheel[i].erase( remove_if( wheel[i].begin(), wheel[i].end(), removeIt ), wheel[i].end() );
+		wheelEvents += wheel[i].size();
+	}
+	numEvents += wheelEvents;
+}
+
+// Insert an event into the bucket for its time, keeping the
+// bucket sorted by creation time:
+void EventQueue::wheelInsert( const Event &newEvent ) {
+	std::deque< Event > &theBucket = bucket( newEvent.eventTime );
+
+	// Events are nearly always created in order, so this is normally just an append:
+	if( theBucket.empty() || createdBefore( theBucket.back(), newEvent ) ) {
+		theBucket.push_back( newEvent );
+	} else {
+		theBucket.insert( upper_bound( theBucket.begin(), theBucket.end(), newEvent, createdBefore ), newEvent );
+	}
+
+	wheelEvents++;
+	if( newEvent.eventTime < wheelCursor ) {
+		wheelCursor = newEvent.eventTime;
+	}
+}
+
+// Move overflow events that now fit in the window into the wheel:
+void EventQueue::pullFromOverflow( void ) {
+	while( !overflow.empty() && inWindow( overflow.top().eventTime ) ) {
+		wheelInsert( overflow.top() );
+		overflow.pop();
+	}
+}
+
+// Point wheelCursor at the earliest non-empty bucket:
+void EventQueue::findWheelTop( void ) {
+	if( wheelEvents == 0 ) return;
+
+	// Every wheel event is inside the window, so this stops within WHEEL_SIZE buckets:
+	while( bucket( wheelCursor ).empty() ) {
+		wheelCursor++;
+	}
+}
+
+// Return true if the overflow heap holds the earliest event:
+// (Also leaves wheelCursor on the earliest bucket.)
+bool EventQueue::overflowIsFirst( void ) {
+	findWheelTop();
+	if( overflow.empty() ) return false;
+	if( wheelEvents == 0 ) return true;
+
+	return bucket( wheelCursor ).front() > overflow.top();
+}
@@ -0,0 +1,115 @@
+/*****************************************************************************
+   Project: CEDAR Logic Simulator
+   Copyright 2006 Cedarville University, Benjamin Sprague,
+                     Matt Lewellyn, and David Knierim
+   All rights reserved.
+   For license information see license.txt included with distribution.
+
+   logic_event_queue: Event scheduler used by the Circuit class
+*****************************************************************************/
+
+#ifndef LOGIC_EVENT_QUEUE_H
+#define LOGIC_EVENT_QUEUE_H
+
+#include "logic_defaults.h"
+#include "logic_event.h"
+
+#include <queue>
+#include <deque>
+#include <functional>
+#include <vector>
+
+// The pending events of a Circuit, always handed out in the order
+// (eventTime, creationTime). Two schedulers are available:
+//
+// SCHED_HEAP: The original binary heap. Every push and pop is O(log n).
+//
+// SCHED_TIMING_WHEEL: A ring of WHEEL_SIZE buckets, one per time step, that
+// covers the time window [wheelBase, wheelBase + WHEEL_SIZE). Events that
+// land inside the window are appended to their bucket in O(1). Anything
+// outside of the window (far future, or re-sent events from the past) is
+// kept in an overflow heap and moved into the wheel once the window reaches it.
+// Since almost every gate delay is a handful of steps, nearly all events
+// go through the wheel.
+class EventQueue
+{
+public:
+	enum SchedulerType {
+		SCHED_HEAP = 0,
+		SCHED_TIMING_WHEEL
+	};
+
+	// Number of buckets in the timing wheel. Must be a power of two.
+	static const TimeType WHEEL_SIZE = 256;
+
+	EventQueue( SchedulerType newType = SCHED_HEAP );
+
+	// Switch scheduler. Pending events are kept.
+	void setSchedulerType( SchedulerType newType );
+	SchedulerType getSchedulerType( void ) const { return schedType; };
+
+	// Add an event to the queue:
+	void push( const Event &newEvent );
+
+	// Return the earliest event (Queue must not be empty):
+	const Event &top( void );
+
+	// Remove the earliest event:
+	void pop( void );
+
+	bool empty( void ) const { return numEvents == 0; };
+	size_t size( void ) const { return numEvents; };
+
+	// Throw away all of the events:
+	void clear( void );
+
+	// Remove every event for which removeIt( event ) returns true:
+	void removeEvents( const std::function< bool( const Event & ) > &removeIt );
+
+private:
+	// Orders events so that the earliest one is on top of a std::priority_queue:
+	typedef std::priority_queue< Event, std::vector< Event >, std::greater< Event > > EventHeap;
+
+	// Insert an event into the bucket for its time, keeping the
+	// bucket sorted by creation time:
+	void wheelInsert( const Event &newEvent );
+
+	// Move overflow events that now fit in the window into the wheel:
+	void pullFromOverflow( void );
+
+	// Point wheelCursor at the earliest non-empty bucket:
+	void findWheelTop( void );
+
+	// Return true if the overflow heap holds the earliest event:
+	// (Also leaves wheelCursor on the earliest bucket.)
+	bool overflowIsFirst( void );
+
+	bool inWindow( TimeType eventTime ) const {
+		return ( eventTime >= wheelBase ) && ( eventTime - wheelBase < WHEEL_SIZE );
+	};
+
+	std::deque< Event > &bucket( TimeType eventTime ) {
+		return wheel[eventTime & ( WHEEL_SIZE - 1 )];
+	};
+
+	SchedulerType schedType;
+
+	// Used by SCHED_HEAP for everything, and by SCHED_TIMING_WHEEL
+	// for the events that are outside of the wheel window:
+	EventHeap overflow;
+
+	// The timing wheel buckets:
+	std::vector< std::deque< Event > > wheel;
+
+	// The first time step covered by the wheel:
+	TimeType wheelBase;
+
+	// No event in the wheel is earlier than this time step:
+	TimeType wheelCursor;
+
+	// Events stored in the wheel, and in total:
+	size_t wheelEvents;
+	size_t numEvents;
+};
+
+#endif // LOGIC_EVENT_QUEUE_H
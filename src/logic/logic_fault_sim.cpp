@@ -0,0 +1,303 @@
+/*****************************************************************************
+   Project: CEDAR Logic Simulator
+   Copyright 2006 Cedarville University, Benjamin Sprague,
+                     Matt Lewellyn, and David Knierim
+   All rights reserved.
+   For license information see license.txt included with distribution.
+
+   logic_fault_sim: Stuck-at fault simulation of the combinational gates of
+   a Circuit, 63 faulty circuits at a time
+*****************************************************************************/
+
+#include "logic_fault_sim.h"
+#include "logic_gate.h"
+
+#include <atomic>
+
+FaultSim::FaultSim( Circuit *theCircuit ) : goodSim( theCircuit )
+{
+}
+
+bool FaultSim::build( const vector< IDType > &inputWires, const vector< IDType > &outputWires ) {
+	faults.clear();
+	faultSites.clear();
+	unobservableFaults.clear();
+	groups.clear();
+	if( !goodSim.build( inputWires, outputWires ) ) return false;
+
+	// The gates that read and drive each net:
+	netReaders.assign( goodSim.getNumNets(), vector< unsigned long >() );
+	netGateDrivers.assign( goodSim.getNumNets(), vector< unsigned long >() );
+	for( unsigned long gate = 0; gate < goodSim.getNumGates(); gate++ ) {
+		const vector< NetIndex > &inNets = goodSim.getGateInputNets( gate );
+		for( PinIndex pin = 0; pin < inNets.size(); pin++ ) {
+			if( inNets[pin] != NET_NONE ) netReaders[inNets[pin]].push_back( gate );
+		}
+		const vector< NetIndex > &outNets = goodSim.getGateOutputNets( gate );
+		for( PinIndex pin = 0; pin < outNets.size(); pin++ ) {
+			if( outNets[pin] != NET_NONE ) netGateDrivers[outNets[pin]].push_back( gate );
+		}
+	}
+
+	StuckFault fault;
+	FaultSite site;
+
+	// Both faults on every net:
+	fault.site = StuckFault::SITE_WIRE;
+	site.gate = 0;
+	site.pin = PIN_NONE;
+	for( NetIndex net = 0; net < goodSim.getNumNets(); net++ ) {
+		fault.wireID = goodSim.getNetWire( net );
+		site.net = net;
+		for( StateType stuckAt = ZERO; stuckAt <= ONE; stuckAt++ ) {
+			fault.stuckAt = stuckAt;
+			faults.push_back( fault );
+			faultSites.push_back( site );
+		}
+	}
+
+	// And on every connected pin of the gates. A pin whose wire isn't one
+	// of the nets (an output that only leads away from the outputs) can't
+	// be observed:
+	fault.wireID = ID_NONE;
+	site.net = NET_NONE;
+	for( unsigned long gate = 0; gate < goodSim.getNumGates(); gate++ ) {
+		Gate *theGate = goodSim.getGate( gate );
+		fault.gateID = goodSim.getGateID( gate );
+		site.gate = gate;
+
+		vector< IDType > pinWires = theGate->getInputWires();
+		const vector< NetIndex > &inNets = goodSim.getGateInputNets( gate );
+		fault.site = StuckFault::SITE_INPUT;
+		for( PinIndex pin = 0; pin < pinWires.size(); pin++ ) {
+			if( pinWires[pin] == ID_NONE ) continue;
+			fault.pinName = theGate->getInputName( pin );
+			site.pin = pin;
+			bool observable = ( pin < inNets.size() && inNets[pin] != NET_NONE );
+			for( StateType stuckAt = ZERO; stuckAt <= ONE; stuckAt++ ) {
+				fault.stuckAt = stuckAt;
+				if( observable ) {
+					faults.push_back( fault );
+					faultSites.push_back( site );
+				} else {
+					unobservableFaults.push_back( fault );
+				}
+			}
+		}
+
+		pinWires = theGate->getOutputWires();
+		const vector< NetIndex > &outNets = goodSim.getGateOutputNets( gate );
+		fault.site = StuckFault::SITE_OUTPUT;
+		for( PinIndex pin = 0; pin < pinWires.size(); pin++ ) {
+			if( pinWires[pin] == ID_NONE ) continue;
+			fault.pinName = theGate->getOutputName( pin );
+			site.pin = pin;
+			bool observable = ( pin < outNets.size() && outNets[pin] != NET_NONE );
+			for( StateType stuckAt = ZERO; stuckAt <= ONE; stuckAt++ ) {
+				fault.stuckAt = stuckAt;
+				if( observable ) {
+					faults.push_back( fault );
+					faultSites.push_back( site );
+				} else {
+					unobservableFaults.push_back( fault );
+				}
+			}
+		}
+	}
+
+	// Split the faults into groups:
+	for( unsigned long first = 0; first < faults.size(); first += FAULTS_PER_WORD ) {
+		FaultGroup group;
+		group.firstFault = first;
+		group.numFaults = min( (unsigned long) FAULTS_PER_WORD, (unsigned long) faults.size() - first );
+		group.undetected = 0;
+		groups.push_back( group );
+	}
+	return true;
+}
+
+bool FaultSim::run( const vector< vector< StateType > > &testVectors ) {
+	for( unsigned long v = 0; v < testVectors.size(); v++ ) {
+		if( testVectors[v].size() != goodSim.getNumInputs() ) {
+			WARNING("FaultSim::run() - A test vector has the wrong number of inputs.");
+			_MSGW("Vector: %lu Inputs: %lu\n", v, (unsigned long) testVectors[v].size());
+			return false;
+		}
+	}
+
+	for( unsigned long f = 0; f < faults.size(); f++ ) {
+		faults[f].detected = false;
+		faults[f].detectedBy = 0;
+	}
+	for( unsigned long g = 0; g < groups.size(); g++ ) {
+		groups[g].undetected = ( ( 1ULL << groups[g].numFaults ) - 1 ) << 1;
+	}
+
+	// Each task takes every numTasks'th group, with its own copy of the
+	// PatternSim. (A few tasks per thread, in case some groups are dropped
+	// sooner than others.)
+	size_t numTasks = min( groups.size(), (size_t) threadPool.getNumThreads() * 4 );
+	vector< PatternSim > taskSims( numTasks, goodSim );
+	vector< FaultCone > taskCones( numTasks );
+
+	for( unsigned long firstVector = 0; firstVector < testVectors.size(); firstVector += VECTORS_PER_CHUNK ) {
+		unsigned long numVectors = min( (unsigned long) VECTORS_PER_CHUNK, (unsigned long) testVectors.size() - firstVector );
+
+		// Run the good circuit on the chunk, with vector firstVector + w * 64 + b
+		// in bit b of word w:
+		unsigned long numWords = ( numVectors + PATTERNS_PER_WORD - 1 ) / PATTERNS_PER_WORD;
+		goodWords.resize( numWords );
+		for( unsigned long w = 0; w < numWords; w++ ) {
+			vector< PatternWord > inputWords( goodSim.getNumInputs() );
+			for( unsigned long b = 0; b < PATTERNS_PER_WORD && w * PATTERNS_PER_WORD + b < numVectors; b++ ) {
+				const vector< StateType > &testVector = testVectors[firstVector + w * PATTERNS_PER_WORD + b];
+				for( unsigned long i = 0; i < testVector.size(); i++ ) {
+					inputWords[i].drive( PatternWord( testVector[i] ).select( 1ULL << b ) );
+				}
+			}
+			if( !goodSim.runInputs( inputWords ) ) return false;
+
+			goodWords[w].resize( goodSim.getNumNets() );
+			for( NetIndex net = 0; net < goodSim.getNumNets(); net++ ) {
+				goodWords[w][net] = goodSim.getNetPattern( net );
+			}
+		}
+
+		atomic< bool > groupsOK( true );
+		threadPool.run( numTasks, [&]( size_t task ) {
+			for( size_t group = task; group < groups.size(); group += numTasks ) {
+				if( !runGroup( groups[group], taskSims[task], taskCones[task], firstVector, numVectors ) ) {
+					groupsOK = false;
+					return;
+				}
+			}
+		} );
+		if( !groupsOK ) return false;
+	}
+	return true;
+}
+
+void FaultSim::findCone( const FaultGroup &group, FaultCone &cone ) const {
+	cone.gates.clear();
+	cone.goodNets.clear();
+	cone.outputs.clear();
+	cone.gateMarks.assign( goodSim.getNumGates(), false );
+	cone.drivenNets.assign( goodSim.getNumNets(), false );
+	cone.faultNets.assign( goodSim.getNumNets(), false );
+
+	// Start from the faults:
+	vector< unsigned long > walk;
+	for( unsigned long f = group.firstFault; f < group.firstFault + group.numFaults; f++ ) {
+		if( faults[f].site == StuckFault::SITE_WIRE ) {
+			cone.faultNets[faultSites[f].net] = true;
+			walk.insert( walk.end(), netReaders[faultSites[f].net].begin(), netReaders[faultSites[f].net].end() );
+		} else {
+			walk.push_back( faultSites[f].gate );
+		}
+	}
+
+	// Add the gates that read the nets that the cone drives, and the other
+	// drivers of those nets:
+	while( !walk.empty() ) {
+		unsigned long gate = walk.back();
+		walk.pop_back();
+		if( cone.gateMarks[gate] ) continue;
+		cone.gateMarks[gate] = true;
+
+		const vector< NetIndex > &outNets = goodSim.getGateOutputNets( gate );
+		for( PinIndex pin = 0; pin < outNets.size(); pin++ ) {
+			NetIndex net = outNets[pin];
+			if( ( net == NET_NONE ) || goodSim.isInput( net ) || cone.drivenNets[net] ) continue;
+			cone.drivenNets[net] = true;
+			walk.insert( walk.end(), netReaders[net].begin(), netReaders[net].end() );
+			walk.insert( walk.end(), netGateDrivers[net].begin(), netGateDrivers[net].end() );
+		}
+	}
+
+	// The gates are run in order, and the nets that they read but don't
+	// drive come from the good circuit:
+	vector< bool > goodNetMarks( goodSim.getNumNets(), false );
+	for( unsigned long gate = 0; gate < goodSim.getNumGates(); gate++ ) {
+		if( !cone.gateMarks[gate] ) continue;
+		cone.gates.push_back( gate );
+
+		const vector< NetIndex > &inNets = goodSim.getGateInputNets( gate );
+		for( PinIndex pin = 0; pin < inNets.size(); pin++ ) {
+			NetIndex net = inNets[pin];
+			if( ( net == NET_NONE ) || cone.drivenNets[net] || goodNetMarks[net] ) continue;
+			goodNetMarks[net] = true;
+			cone.goodNets.push_back( net );
+		}
+	}
+
+	for( unsigned long o = 0; o < goodSim.getNumOutputs(); o++ ) {
+		NetIndex net = goodSim.getOutputNet( o );
+		if( !cone.drivenNets[net] && !cone.faultNets[net] ) continue;
+		cone.outputs.push_back( o );
+		if( !cone.drivenNets[net] && !goodNetMarks[net] ) {
+			goodNetMarks[net] = true;
+			cone.goodNets.push_back( net );
+		}
+	}
+}
+
+bool FaultSim::runGroup( FaultGroup &group, PatternSim &groupSim, FaultCone &cone, unsigned long firstVector, unsigned long numVectors ) {
+	if( group.undetected == 0 ) return true;
+	findCone( group, cone );
+	if( cone.outputs.empty() ) return true;
+
+	// Put fault f of the group in bit f + 1:
+	groupSim.clearFaults();
+	for( unsigned long f = 0; f < group.numFaults; f++ ) {
+		const StuckFault &fault = faults[group.firstFault + f];
+		const FaultSite &site = faultSites[group.firstFault + f];
+		unsigned long long mask = 1ULL << ( f + 1 );
+		switch( fault.site ) {
+		case StuckFault::SITE_WIRE:
+			groupSim.addNetFault( site.net, fault.stuckAt, mask );
+			break;
+		case StuckFault::SITE_INPUT:
+			groupSim.addInputPinFault( site.gate, site.pin, fault.stuckAt, mask );
+			break;
+		case StuckFault::SITE_OUTPUT:
+			groupSim.addOutputPinFault( site.gate, site.pin, fault.stuckAt, mask );
+			break;
+		}
+	}
+
+	for( unsigned long v = 0; v < numVectors && group.undetected != 0; v++ ) {
+		const vector< PatternWord > &good = goodWords[v / PATTERNS_PER_WORD];
+		unsigned long bit = v % PATTERNS_PER_WORD;
+		for( unsigned long n = 0; n < cone.goodNets.size(); n++ ) {
+			groupSim.setNetPattern( cone.goodNets[n], good[cone.goodNets[n]].broadcast( bit ) );
+		}
+		if( !groupSim.runGates( cone.gates ) ) return false;
+
+		// Compare each copy with the good one in bit 0:
+		unsigned long long detected = 0;
+		for( unsigned long o = 0; o < cone.outputs.size(); o++ ) {
+			PatternWord outWord = groupSim.getNetPattern( groupSim.getOutputNet( cone.outputs[o] ) );
+			unsigned long long goodZero = ( outWord.zero & 1 ) ? ~0ULL : 0;
+			unsigned long long goodOne = ( outWord.one & 1 ) ? ~0ULL : 0;
+			detected |= ( outWord.zero & goodOne ) | ( outWord.one & goodZero );
+		}
+		detected &= group.undetected;
+		group.undetected &= ~detected;
+
+		for( unsigned long f = 0; f < group.numFaults; f++ ) {
+			if( ( detected >> ( f + 1 ) ) & 1 ) {
+				faults[group.firstFault + f].detected = true;
+				faults[group.firstFault + f].detectedBy = firstVector + v;
+			}
+		}
+	}
+	return true;
+}
+
+unsigned long FaultSim::getNumDetected( void ) const {
+	unsigned long numDetected = 0;
+	for( unsigned long f = 0; f < faults.size(); f++ ) {
+		if( faults[f].detected ) numDetected++;
+	}
+	return numDetected;
+}
@@ -0,0 +1,138 @@
+/*****************************************************************************
+   Project: CEDAR Logic Simulator
+   Copyright 2006 Cedarville University, Benjamin Sprague,
+                     Matt Lewellyn, and David Knierim
+   All rights reserved.
+   For license information see license.txt included with distribution.
+
+   logic_fault_sim: Stuck-at fault simulation of the combinational gates of
+   a Circuit, 63 faulty circuits at a time
+*****************************************************************************/
+
+#ifndef LOGIC_FAULT_SIM_H
+#define LOGIC_FAULT_SIM_H
+
+#include "logic_pattern_sim.h"
+#include "logic_thread_pool.h"
+
+#include <string>
+#include <vector>
+
+// A single stuck-at fault. It is on a wire (its whole junction group), or
+// on one input or output pin of a gate:
+struct StuckFault {
+	enum SiteType { SITE_WIRE, SITE_INPUT, SITE_OUTPUT };
+
+	SiteType site;
+	IDType wireID;		// SITE_WIRE
+	IDType gateID;		// SITE_INPUT and SITE_OUTPUT
+	string pinName;
+	StateType stuckAt;	// ZERO or ONE
+
+	// Set by FaultSim::run():
+	bool detected;
+	unsigned long detectedBy; // The first vector that detects it.
+
+	StuckFault() : site(SITE_WIRE), wireID(ID_NONE), gateID(ID_NONE), stuckAt(ZERO), detected(false), detectedBy(0) {};
+};
+
+
+// A FaultSim finds every stuck-at-0 and stuck-at-1 fault between a set of
+// input wires and output wires, and runs test vectors to see which faults
+// they detect.
+//
+// It uses a PatternSim, but instead of 64 input patterns, each bit of the
+// PatternWords is a different copy of the circuit: bit 0 is the good one,
+// and bits 1 to 63 each have one fault. A fault is detected when an output
+// of its copy is ONE where the good one is ZERO, or the other way around.
+// The groups of 63 faults are shared out over the threads.
+//
+// The good circuit is run first, 64 vectors at a time. Then each group only
+// runs the gates that its faults can reach, and takes the states of the
+// other nets from the good circuit. A group stops once all of its faults
+// have been detected.
+class FaultSim
+{
+public:
+	FaultSim( Circuit *theCircuit );
+
+	// Find the faults. Returns false, with a warning, if the gates can't
+	// be run as patterns (see PatternSim::build()):
+	bool build( const vector< IDType > &inputWires, const vector< IDType > &outputWires );
+
+	// The number of threads that run the groups of faults:
+	void setNumThreads( unsigned int numThreads ) { threadPool.setNumThreads( numThreads ); };
+
+	// Run the test vectors, each with a state for every input wire, and
+	// mark the faults that they detect:
+	bool run( const vector< vector< StateType > > &testVectors );
+
+	unsigned long getNumFaults( void ) const { return (unsigned long) faults.size(); };
+	const StuckFault &getFault( unsigned long fault ) const { return faults[fault]; };
+	unsigned long getNumDetected( void ) const;
+
+	// The faults on pins whose wires don't lead to the outputs. No vector
+	// can detect them, so they are not run, and are kept out of the
+	// faults above:
+	unsigned long getNumUnobservable( void ) const { return (unsigned long) unobservableFaults.size(); };
+	const StuckFault &getUnobservableFault( unsigned long fault ) const { return unobservableFaults[fault]; };
+
+	// The faulty copies in each PatternWord (bit 0 is the good copy):
+	static const unsigned long FAULTS_PER_WORD = PATTERNS_PER_WORD - 1;
+
+	// The test vectors that the good circuit is run on at once:
+	static const unsigned long VECTORS_PER_CHUNK = PATTERNS_PER_WORD * 4;
+
+private:
+	// Where each fault is in the PatternSim:
+	struct FaultSite {
+		NetIndex net;
+		unsigned long gate;
+		PinIndex pin;
+	};
+
+	// A group of up to 63 faults, in bits 1 to 63:
+	struct FaultGroup {
+		unsigned long firstFault;
+		unsigned long numFaults;
+		unsigned long long undetected;
+	};
+
+	// The part of the circuit that a group's faults can change: the gates
+	// that they can reach (in order), the nets that those gates read from
+	// the good circuit, and the outputs that can differ. (Each thread has
+	// its own, so that the marks can be kept between groups.)
+	struct FaultCone {
+		vector< unsigned long > gates;
+		vector< NetIndex > goodNets;
+		vector< unsigned long > outputs;
+
+		vector< bool > gateMarks;
+		vector< bool > drivenNets;
+		vector< bool > faultNets;
+	};
+
+	// Find the cone of a group:
+	void findCone( const FaultGroup &group, FaultCone &cone ) const;
+
+	// Run the test vectors of the current chunk on a group:
+	bool runGroup( FaultGroup &group, PatternSim &groupSim, FaultCone &cone, unsigned long firstVector, unsigned long numVectors );
+
+	PatternSim goodSim;
+	vector< StuckFault > faults;
+	vector< FaultSite > faultSites;
+	vector< StuckFault > unobservableFaults;
+	vector< FaultGroup > groups;
+
+	// The gates that read and drive each net:
+	vector< vector< unsigned long > > netReaders;
+	vector< vector< unsigned long > > netGateDrivers;
+
+	// The good circuit's net states for the current chunk, one PatternWord
+	// per 64 vectors:
+	vector< vector< PatternWord > > goodWords;
+
+	LogicThreadPool threadPool;
+};
+
+#endif // LOGIC_FAULT_SIM_H
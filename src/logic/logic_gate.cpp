@@ -16,6 +16,7 @@
 #include <string>
 #include <cassert>
 #include <cmath>
+#include <cctype>
 using namespace std;
 #include "logic_gate.h"
 
@@ -24,6 +25,10 @@ using namespace std;
 //for the ram gate **** by Joshua Lansford**********
 #define DATA_RECORD_HEX 0x00
 #define END_OF_FILE_HEX 0x01
+#define EXT_SEGMENT_ADDRESS_HEX 0x02
+#define START_SEGMENT_ADDRESS_HEX 0x03
+#define EXT_LINEAR_ADDRESS_HEX 0x04
+#define START_LINEAR_ADDRESS_HEX 0x05
 //*************************************************
 
 // ***************************** GENERIC GATE ***********************************
@@ -34,6 +39,7 @@ Gate::Gate()
 	ourCircuit = NULL;
 	defaultDelay = DEFAULT_GATE_DELAY;
 	myID = ID_NONE;
+	pinsChanged = true;
 	
 	// Pedro Casanova (casanova@ujaen.es) 2020/04-12
 	// Only one OUTPUT_ENABLE
@@ -54,6 +60,13 @@ Gate::~Gate()
 }
 
 
+// The PatternSim that this thread is running, during updatePattern():
+thread_local PatternSim* Gate::ourPatternSim = NULL;
+
+// The CompiledSim that is being written, during updateCode():
+CompiledSim* Gate::ourCompiledSim = NULL;
+
+
 // Update the gate's outputs:
 // Pedro Casanova (casanova@ujaen.es) 2020/04-12
 // Added theGUICircuit parameter
@@ -76,29 +89,34 @@ void Gate::updateGate( IDType myID, Circuit * theCircuit, GUICircuit * theGUICir
 	changedParamWaitingList.clear();
 	//*******************************************
 	
+	// If pins were declared since the last update, then let the gate
+	// look up its busses again:
+	if( pinsChanged ) {
+		pinsChanged = false;
+		this->resolvePins();
+	}
+
 	// Call the subclassed gate's function to process the events for this gate:
 	this->gateProcess();
 
 	// Handle the enabled/disabled outputs:
-	ID_MAP< string, GateOutput >::iterator theOutput = outputList.begin();
-	while( theOutput != outputList.end() ) {
-		string enableIn = (theOutput->second).enableInput;
-		if( enableIn != "" ) {
+	for( PinIndex outPin = 0; outPin < outputPins.size(); outPin++ ) {
+		PinIndex enablePin = outputPins[outPin].enablePin;
+		if( enablePin != PIN_NONE ) {
 			// If the enable pin is NOT set to 0, then it is enabled!
 			// (Interprets HI_Z, CONFLICT, and UNKNOWN as 1.)
-			if( getInputState( enableIn ) == ZERO ) {
-				setOutputState( theOutput->first, HI_Z );
+			if( getInputState( enablePin ) == ZERO ) {
+				setOutputState( outPin, HI_Z );
 			}
 		}
-		theOutput++;
 	}
 		
 
 	// Update the last state of the edge-triggered inputs:
-	ID_SET< string >::iterator eInputs = edgeTriggeredInputs.begin();
-	while( eInputs != edgeTriggeredInputs.end() ) {
-		edgeTriggeredLastState[ *eInputs ] = getInputState( *eInputs );
-		eInputs++;
+	for( unsigned long i = 0; i < edgeTriggeredPins.size(); i++ ) {
+		GateInput &eInput = inputPins[edgeTriggeredPins[i]];
+		eInput.lastState = getInputState( edgeTriggeredPins[i] );
+		eInput.hasLastState = true;
 	}
 	
 	// Invalidate the circuit pointer, because we are done with it:
@@ -111,11 +129,13 @@ void Gate::updateGate( IDType myID, Circuit * theCircuit, GUICircuit * theGUICir
 
 // Resend the last event to a (probably newly connected) wire:	
 void Gate::resendLastEvent( IDType myID, string outputID, Circuit * theCircuit ) {
-	if( outputList.find( outputID ) != outputList.end() ) {
+	PinIndex pin = findOutput( outputID );
+	if( pin != PIN_NONE ) {
+		GateOutput &theOutput = outputPins[pin];
 		// If a wire is connected now, and there has been a previous event on this gate, then re-send it to the new wire:
-		if( ( outputList[outputID].wireID != ID_NONE ) && ( outputList[outputID].lastEventTime != TIME_NONE ) ) {
+		if( ( theOutput.wireID != ID_NONE ) && ( theOutput.lastEventTime != TIME_NONE ) ) {
 			// Re-create the event!
-			theCircuit->createEvent(outputList[outputID].lastEventTime, outputList[outputID].wireID, myID, outputID, outputList[outputID].lastEventState );
+			theCircuit->createEvent(theOutput.lastEventTime, theOutput.wireID, myID, pin, theOutput.lastEventState );
 		}
 	} else {
 		WARNING("Gate::resendLastEvent() - Invalid outputID.");
@@ -124,32 +144,90 @@ void Gate::resendLastEvent( IDType myID, string outputID, Circuit * theCircuit )
 }
 
 
+// Drive the gate's outputs for a block of 64 input patterns:
+bool Gate::updatePattern( PatternSim * thePatternSim ) {
+	ourPatternSim = thePatternSim;
+
+	// (PatternSim::build() runs every gate once on its own thread, so the
+	// pins are resolved before any other threads run them.)
+	if( pinsChanged ) {
+		pinsChanged = false;
+		this->resolvePins();
+	}
+
+	bool hasPatterns = this->patternProcess();
+
+	ourPatternSim = NULL;
+	return hasPatterns;
+}
+
+
+// Write the code for the gate's outputs into a CompiledSim:
+bool Gate::updateCode( CompiledSim * theCompiledSim ) {
+	ourCompiledSim = theCompiledSim;
+
+	if( pinsChanged ) {
+		pinsChanged = false;
+		this->resolvePins();
+	}
+
+	bool hasCode = this->codeProcess();
+
+	ourCompiledSim = NULL;
+	return hasCode;
+}
+
+
+// The wire IDs of the inputs and outputs, in pin order:
+vector< IDType > Gate::getInputWires( void ) const {
+	vector< IDType > wires( inputPins.size() );
+	for( PinIndex pin = 0; pin < inputPins.size(); pin++ ) {
+		wires[pin] = inputPins[pin].wireID;
+	}
+	return wires;
+}
+
+vector< IDType > Gate::getOutputWires( void ) const {
+	vector< IDType > wires( outputPins.size() );
+	for( PinIndex pin = 0; pin < outputPins.size(); pin++ ) {
+		wires[pin] = outputPins[pin].wireID;
+	}
+	return wires;
+}
+
+
 // Connect a wire to the input of this gate:
 void Gate::connectInput( string inputID, IDType wireID )
 {	
-	this->inputList[inputID].wireID = wireID;	
+	// (Connecting to a pin that wasn't declared creates it.)
+	PinIndex pin = findInput( inputID );
+	if( pin == PIN_NONE ) {
+		pin = declareInput( inputID );
+	}
+	this->inputPins[pin].wireID = wireID;	
 }
 
 
 // Connect a wire to the output of this gate:
 void Gate::connectOutput( string outputID, IDType wireID )
 {
-	GateOutput myOut;
 	// If there was already an output connected on this gate, then
-	// copy the old event states over to the new connection. This is because
+	// the old event states stay with the new connection. This is because
 	// the new wire will need the last event re-sent to it so that it will
 	// be activated correctly.
-	if( outputList.find( outputID ) != outputList.end() ) {
-		myOut = outputList[outputID];
+	PinIndex pin = findOutput( outputID );
+	if( pin == PIN_NONE ) {
+		// (Connecting to a pin that wasn't declared creates it.)
+		pin = outputPins.size();
+		outputPins.push_back( GateOutput() );
+		outputNames.push_back( outputID );
+		outputIndex[outputID] = pin;
+		outputBusCache.clear();
+		pinsChanged = true;
 	}
 
-
-
 	// Hook up the wire:
-	myOut.wireID = wireID;	
-
-	// Save our new output structure in the real output list:
-	this->outputList[outputID] = myOut;
+	this->outputPins[pin].wireID = wireID;
 
 }
 
@@ -161,7 +239,7 @@ IDType Gate::disconnectInput( string inputID ) {
 	if( wireID != ID_NONE ) {
 		// Disconnect the input, but don't remove the connection.
 		// (The inverted state and other info must stay.)
-		inputList[inputID].wireID = ID_NONE;
+		inputPins[findInput( inputID )].wireID = ID_NONE;
 	} else {
 		WARNING("Gate::disconnectInput() - Invalid input ID.");
 		_MSGW("Input ID: %s\n", inputID.c_str());
@@ -177,7 +255,7 @@ IDType Gate::disconnectOutput( string outputID ) {
 	if( wireID != ID_NONE ) {
 		// Leave the output there, because it has "last state" info
 		// even if a wire is not connected currently!
-		outputList[outputID].wireID = ID_NONE;
+		outputPins[findOutput( outputID )].wireID = ID_NONE;
 	} else {
 		WARNING("Gate::disconnectOutput() - Invalid output ID.");
 		_MSGW("Output ID: %s\n", outputID.c_str());
@@ -188,10 +266,10 @@ IDType Gate::disconnectOutput( string outputID ) {
 
 // Get the first input of the gate that has a wire attached to it:
 string Gate::getFirstConnectedInput( void ) {
-	if( !inputList.empty() ) {
-		ID_MAP< string, GateInput >::iterator inP = inputList.begin();
-		while(inP != inputList.end()) {
-			if((inP->second).wireID != ID_NONE) {
+	if( !inputIndex.empty() ) {
+		ID_MAP< string, PinIndex >::iterator inP = inputIndex.begin();
+		while(inP != inputIndex.end()) {
+			if(inputPins[inP->second].wireID != ID_NONE) {
 				return inP->first;
 			}
 			inP++;
@@ -204,10 +282,10 @@ string Gate::getFirstConnectedInput( void ) {
 
 // Get the first output of the gate that has a wire attached to it:
 string Gate::getFirstConnectedOutput( void ) {
-	if( !outputList.empty() ) {
-		ID_MAP< string, GateOutput >::iterator outP = outputList.begin();
-		while(outP != outputList.end()) {
-			if((outP->second).wireID != ID_NONE) {
+	if( !outputIndex.empty() ) {
+		ID_MAP< string, PinIndex >::iterator outP = outputIndex.begin();
+		while(outP != outputIndex.end()) {
+			if(outputPins[outP->second].wireID != ID_NONE) {
 				return outP->first;
 			}
 			outP++;
@@ -304,29 +382,98 @@ string Gate::getParameter( string paramName ) {
 
 // **** Gate "Entity" declaration methods:
 
-// Register an input for this gate:
+// Register an input for this gate, and return its pin index:
 // Possibly declare the input as edge triggered, which will cause it
 // to be tracked to be able to check rising and falling edges.
-void Gate::declareInput(string inputID, bool edgeTriggered) {
-	// Touch the item in the list, to make sure that it is created:
-	this->inputList[inputID].wireID = ID_NONE;
+PinIndex Gate::declareInput(string inputID, bool edgeTriggered) {
+	PinIndex pin = findInput( inputID );
+	if( pin == PIN_NONE ) {
+		pin = inputPins.size();
+		inputPins.push_back( GateInput() );
+		inputNames.push_back( inputID );
+		inputIndex[inputID] = pin;
+
+		// A new pin may extend a bus that was already looked up:
+		inputBusCache.clear();
+		pinsChanged = true;
+	} else {
+		this->inputPins[pin].wireID = ID_NONE;
+	}
 
-	if( edgeTriggered ) {
-		edgeTriggeredInputs.insert( inputID );
+	if( edgeTriggered && !inputPins[pin].edgeTriggered ) {
+		inputPins[pin].edgeTriggered = true;
+		edgeTriggeredPins.push_back( pin );
 		
 		// NOTE: We don't set a last state here, because we don't want
 		// the first event to come along to cause a rising or falling edge.
 		// The first event to come along (i.e. there is no "last state" information)
 		// will not register as either edge.
-		// Not: edgeTriggeredLastState[name] = UNKNOWN;
+		// Not: inputPins[pin].hasLastState = true;
+	}
+	return pin;
+}
+
+// Register an output for this gate, and return its pin index:
+PinIndex Gate::declareOutput( string name ) {
+	PinIndex pin = findOutput( name );
+	if( pin == PIN_NONE ) {
+		pin = outputPins.size();
+		outputPins.push_back( GateOutput() );
+		outputNames.push_back( name );
+		outputIndex[name] = pin;
+
+		// A new pin may extend a bus that was already looked up:
+		outputBusCache.clear();
+		pinsChanged = true;
 	}
+	outputPins[pin].wireID = ID_NONE;
+	outputPins[pin].lastEventState = HI_Z; // The GUI assumes HI_Z for all wires to begin with.
+	outputPins[pin].lastEventTime = TIME_NONE;
+	return pin;
 }
 
-// Register an output for this gate:
-void Gate::declareOutput( string name ) {
-	outputList[ name ].wireID = ID_NONE;
-	outputList[ name ].lastEventState = HI_Z; // The GUI assumes HI_Z for all wires to begin with.
-	outputList[ name ].lastEventTime = TIME_NONE;
+// Return the pin indexes of the bus of inputs named "busName_0"
+// through "busName_x":
+const vector< PinIndex > &Gate::getInputBus( const string &busName ) {
+	ID_MAP< string, vector< PinIndex > >::iterator cached = inputBusCache.find( busName );
+	if( cached != inputBusCache.end() ) {
+		return cached->second;
+	}
+
+	unsigned long BUS_MAX_WIDTH = 10000;
+	ostringstream pinName;
+	vector< PinIndex > &busPins = inputBusCache[busName];
+	for( unsigned long i = 0; i < BUS_MAX_WIDTH; i++ ) {
+		pinName.str("");
+		pinName.clear();
+		pinName << busName << "_" << i;
+		PinIndex pin = findInput( pinName.str() );
+		if( pin == PIN_NONE ) break;
+		busPins.push_back( pin );
+	}
+	return busPins;
+}
+
+// Return the pin indexes of the bus of outputs named "busName_0"
+// through "busName_x":
+const vector< PinIndex > &Gate::getOutputBus( const string &busName ) {
+	ID_MAP< string, vector< PinIndex > >::iterator cached = outputBusCache.find( busName );
+	if( cached != outputBusCache.end() ) {
+		return cached->second;
+	}
+
+	unsigned long BUS_MAX_WIDTH = 10000;
+	ostringstream pinName;
+	vector< PinIndex > &busPins = outputBusCache[busName];
+	for( unsigned long i = 0; i < BUS_MAX_WIDTH; i++ ) {
+		pinName.str("");
+		pinName.clear();
+		pinName << busName << "_" << i;
+		PinIndex pin = findOutput( pinName.str() );
+		if( pin == PIN_NONE ) break;
+		busPins.push_back( pin );
+	}
+	return busPins;
 }
 
 // **** Gate "Process" activity methods:
@@ -343,20 +490,27 @@ TimeType Gate::getSimTime( void ) {
 	
 // Check the state of the named input and return it.
 StateType Gate::getInputState( string inputID ) {
-	_MSGNC(ourCircuit != NULL, "Gate::getInputState() - NULL circuit. ASSERT END 2\n");	//@@@@
-	assert(ourCircuit != NULL);
-	StateType theState;
-
-	if(inputList.find(inputID) == inputList.end()) {
+	PinIndex pin = findInput( inputID );
+	if( pin == PIN_NONE ) {
 		WARNING("Gate::getInputState() - Invalid input name.");		
 		_MSGW("Input ID: %s\n", inputID.c_str());
 		_MSGNC(false, "ASSERT END 3\n");	//@@@@
 		assert( false );
 		return ZERO;
 	}
+	return getInputState( pin );
+}
+
+// Check the state of an input, by pin index, and return it.
+StateType Gate::getInputState( PinIndex pin ) {
+	_MSGNC(ourCircuit != NULL, "Gate::getInputState() - NULL circuit. ASSERT END 2\n");	//@@@@
+	assert(ourCircuit != NULL);
+	StateType theState;
+
+	const GateInput &theInput = inputPins[pin];
 	// If the input is connected, get the input value:
-	if( inputList[inputID].wireID != ID_NONE ) {
-		theState = ourCircuit->getWireState( inputList[inputID].wireID );		
+	if( theInput.wireID != ID_NONE ) {
+		theState = ourCircuit->getWireState( theInput.wireID );		
 		// Pedro Casanova (casanova@ujaen.es) 2020/04-12
 		// Pull-up and Pull-down inputs
 		if (theState != CONFLICT)
@@ -364,9 +518,9 @@ StateType Gate::getInputState( string inputID ) {
 			// Pedro Casanova (casanova@ujaen.es) 2020/04-12
 			// In case HI_Z or UNKNOWN pullup/pulldown must be considered
 			if (theState != ZERO && theState != ONE) {
-				if (inputList[inputID].pullup)
+				if (theInput.pullup)
 					theState = ONE;
-				else if (inputList[inputID].pulldown)
+				else if (theInput.pulldown)
 					theState = ZERO;
 			}
 		}
@@ -375,15 +529,15 @@ StateType Gate::getInputState( string inputID ) {
 		// high-impedance as the "value" for the input.
 		// Pedro Casanova (casanova@ujaen.es) 2020/04-12
 		// Pull-up and Pull-down inputs
-		if (inputList[inputID].pullup)
+		if (theInput.pullup)
 			theState = ONE;
-		else if (inputList[inputID].pulldown)
+		else if (theInput.pulldown)
 			theState = ZERO;
 		else
 			theState = HI_Z;
 	}
 	// Invert the input if it is set as inverted:
-	if (inputList[inputID].inverted) {
+	if (theInput.inverted) {
 		if (theState == ZERO) theState = ONE;
 		else if (theState == ONE) theState = ZERO;
 	}
@@ -393,47 +547,118 @@ StateType Gate::getInputState( string inputID ) {
 // Get the input states of a bus of inputs named "busName_0" through
 // "busName_x" and return their states as a vector.
 vector< StateType > Gate::getInputBusState( string busName ) {
-	unsigned long BUS_MAX_WIDTH = 10000;
-	ostringstream pinName;
-	vector< StateType > inStates;
-	unsigned long i = 0;
-	do {
-		pinName.str("");
-		pinName.clear();
-		pinName << busName << "_" << i;
-		if( inputExists( pinName.str() ) ) {
-			inStates.push_back( getInputState( pinName.str() ) );
-		}
-		i++;
-	} while( (inputExists( pinName.str() )) && (i < BUS_MAX_WIDTH) );
+	return getInputBusState( getInputBus( busName ) );
+}
+
+// Get the input states of a bus of input pins and return their states as a vector.
+vector< StateType > Gate::getInputBusState( const vector< PinIndex > &busPins ) {
+	vector< StateType > inStates( busPins.size() );
+	for( unsigned long i = 0; i < busPins.size(); i++ ) {
+		inStates[i] = getInputState( busPins[i] );
+	}
 	return inStates;
 }
 
+// The packed version of getInputBusState():
+BusValue Gate::getInputBusValue( const vector< PinIndex > &busPins ) {
+	BusValue theValue;
+	theValue.width = busPins.size();
+	for( unsigned long i = 0; i < busPins.size() && i < MAX_BUS_BITS; i++ ) {
+		theValue.setState( i, getInputState( busPins[i] ) );
+	}
+	return theValue;
+}
+
+// The pattern version of getInputState():
+PatternWord Gate::getInputPattern( PinIndex pin ) {
+	assert( ourPatternSim != NULL );
+	const GateInput &theInput = inputPins[pin];
+
+	PatternWord thePattern = ourPatternSim->getInputPinPattern( pin );
+
+	// Pull-up and pull-down inputs turn HI_Z and UNKNOWN into ONE or ZERO:
+	if( theInput.pullup || theInput.pulldown ) {
+		unsigned long long floating = ~( thePattern.zero | thePattern.one | thePattern.conflict );
+		if( theInput.pullup ) {
+			thePattern.one |= floating;
+		} else {
+			thePattern.zero |= floating;
+		}
+		thePattern.unknown = 0;
+	}
+	ourPatternSim->stickInputPin( pin, thePattern );
+
+	// Invert the input if it is set as inverted:
+	if( theInput.inverted ) {
+		swap( thePattern.zero, thePattern.one );
+	}
+	return thePattern;
+}
+
+// The pattern version of getInputBusState():
+vector< PatternWord > Gate::getInputBusPattern( const vector< PinIndex > &busPins ) {
+	vector< PatternWord > inPatterns( busPins.size() );
+	for( unsigned long i = 0; i < busPins.size(); i++ ) {
+		inPatterns[i] = getInputPattern( busPins[i] );
+	}
+	return inPatterns;
+}
+
+// The compiled version of getInputState():
+string Gate::getInputCode( PinIndex pin ) {
+	assert( ourCompiledSim != NULL );
+	const GateInput &theInput = inputPins[pin];
+
+	string theCode = ourCompiledSim->getInputPinCode( pin );
+
+	// Pull-up and pull-down inputs turn HI_Z and UNKNOWN into ONE or ZERO:
+	if( theInput.pullup ) {
+		theCode = "pullUp( " + theCode + " )";
+	} else if( theInput.pulldown ) {
+		theCode = "pullDown( " + theCode + " )";
+	}
+
+	// Invert the input if it is set as inverted:
+	if( theInput.inverted ) {
+		theCode = "inv( " + theCode + " )";
+	}
+	return theCode;
+}
+
 // Pedro Casanova (casanova@ujaen.es) 2020/04-12
 // To use bidirectional bus
 // Get the wire states of a bus of output named "busName_0" through
 // "busName_x" and return their states as a vector.
 vector< StateType > Gate::getOutputBusWireState(string busName) {
-	unsigned long BUS_MAX_WIDTH = 10000;
-	ostringstream pinName;
-	vector< StateType > outStates;
-	unsigned long i = 0;
-	do {
-		pinName.str("");
-		pinName.clear();
-		pinName << busName << "_" << i;		
-		if (outputExists(pinName.str())) {
-			IDType wireID = getOutputWire(pinName.str());
-			if (wireID!=ID_NONE)
-				outStates.push_back(ourCircuit->getWireState(wireID));
-			else
-				outStates.push_back(0);
-		}
-		i++;
-	} while ((outputExists(pinName.str())) && (i < BUS_MAX_WIDTH));
+	return getOutputBusWireState( getOutputBus( busName ) );
+}
+
+// Get the wire states of a bus of output pins and return their states as a vector.
+vector< StateType > Gate::getOutputBusWireState( const vector< PinIndex > &busPins ) {
+	vector< StateType > outStates( busPins.size() );
+	for( unsigned long i = 0; i < busPins.size(); i++ ) {
+		IDType wireID = outputPins[busPins[i]].wireID;
+		if (wireID!=ID_NONE)
+			outStates[i] = ourCircuit->getWireState(wireID);
+		else
+			outStates[i] = 0;
+	}
 	return outStates;
 }
 
+// The packed version of getOutputBusWireState():
+BusValue Gate::getOutputBusWireValue( const vector< PinIndex > &busPins ) {
+	BusValue theValue;
+	theValue.width = busPins.size();
+	for( unsigned long i = 0; i < busPins.size() && i < MAX_BUS_BITS; i++ ) {
+		IDType wireID = outputPins[busPins[i]].wireID;
+		if( wireID != ID_NONE ) {
+			theValue.setState( i, ourCircuit->getWireState( wireID ) );
+		}
+	}
+	return theValue;
+}
+
 // Get the types of inputs that are represented.
 vector< bool > Gate::groupInputStates( void ) {
 	_MSGNC(ourCircuit != NULL, "Gate::groupInputStates() - NULL circuit. ASSERT END 4\n");	//@@@@
@@ -441,12 +666,12 @@ vector< bool > Gate::groupInputStates( void ) {
 
 	vector< bool > groupedInputs(NUM_STATES, false);
 
-	ID_MAP< string, GateInput >::iterator inputs = inputList.begin();
-	while( inputs != inputList.end() ) {
+	for( PinIndex pin = 0; pin < inputPins.size(); pin++ ) {
+		const GateInput &theInput = inputPins[pin];
 
 		// Note: Only add the input into the tally if it is connected!
-		if( (inputs->second).wireID != ID_NONE ) {
-			StateType theState = ourCircuit->getWireState( (inputs->second).wireID );
+		if( theInput.wireID != ID_NONE ) {
+			StateType theState = ourCircuit->getWireState( theInput.wireID );
 			groupedInputs[theState] = true;
 		}
 		else
@@ -454,12 +679,11 @@ vector< bool > Gate::groupInputStates( void ) {
 			// Pedro Casanova (casanova@ujaen.es) 2020/04-12
 			// This function is never called
 			// For unconnected inputs with pullup or pulldown this must be necesary
-			if ((inputs->second).pullup == true)
+			if (theInput.pullup == true)
 				groupedInputs[ONE] = true;
-			else if ((inputs->second).pulldown == true)
+			else if (theInput.pulldown == true)
 				groupedInputs[ZERO] = true;
 		}
-		inputs++;
 	}
 	
 	return groupedInputs;
@@ -468,16 +692,25 @@ vector< bool > Gate::groupInputStates( void ) {
 	
 // Compare the "this" state with the "last" state and say if this is a rising or falling edge. 
 bool Gate::isRisingEdge( string name ) {
+	PinIndex pin = findInput( name );
+	if( ( pin == PIN_NONE ) || !inputPins[pin].edgeTriggered ) {
+		// Only edge-triggered inputs keep a last state:
+		return false;
+	}
+	return isRisingEdge( pin );
+}
+
+bool Gate::isRisingEdge( PinIndex pin ) {
 	_MSGNC(ourCircuit != NULL, "Gate::isRisingEdge() - NULL circuit. ASSERT END 5\n");	//@@@@
 	assert(ourCircuit != NULL);
 	
-	if( edgeTriggeredLastState.find( name ) == edgeTriggeredLastState.end() ) {
+	if( !inputPins[pin].hasLastState ) {
 		// There can be no rising edge on the first time that the gate is simulated!
 		return false;
 	}
 	
-	StateType last = edgeTriggeredLastState[ name ];
-	StateType now = getInputState( name );
+	StateType last = inputPins[pin].lastState;
+	StateType now = getInputState( pin );
 
 	if( ( now == ONE ) && (last != ONE) ) {
 		return true;
@@ -488,16 +721,25 @@ bool Gate::isRisingEdge( string name ) {
 
 
 bool Gate::isFallingEdge( string name ) {
+	PinIndex pin = findInput( name );
+	if( ( pin == PIN_NONE ) || !inputPins[pin].edgeTriggered ) {
+		// Only edge-triggered inputs keep a last state:
+		return false;
+	}
+	return isFallingEdge( pin );
+}
+
+bool Gate::isFallingEdge( PinIndex pin ) {
 	_MSGNC(ourCircuit != NULL, "Gate::isFallingEdge() - NULL circuit. ASSERT END 6\n");	//@@@@
 	assert(ourCircuit != NULL);
 	
-	if( edgeTriggeredLastState.find( name ) == edgeTriggeredLastState.end() ) {
+	if( !inputPins[pin].hasLastState ) {
 		// There can be no rising edge on the first time that the gate is simulated!
 		return false;
 	}
 	
-	StateType last = edgeTriggeredLastState[ name ];
-	StateType now = getInputState( name );
+	StateType last = inputPins[pin].lastState;
+	StateType now = getInputState( pin );
 
 	if( ( now == ZERO ) && (last != ZERO) ) {
 		return true;
@@ -511,16 +753,22 @@ bool Gate::isFallingEdge( string name ) {
 // really send the event. Also, log the last sent event so that it can be 
 // repeated later if necessary. 
 void Gate::setOutputState( string outID, StateType newState, TimeType delay ) {
-	_MSGNC(ourCircuit != NULL, "Gate::setOutputState() - NULL circuit. ASSERT END 7\n");	//@@@@
-	assert( ourCircuit != NULL );
-
-	if(outputList.find(outID) == outputList.end()) {
+	PinIndex pin = findOutput( outID );
+	if( pin == PIN_NONE ) {
 		WARNING("Gate::setOutputState() - Invalid output name.");
 		_MSGW("Output ID: %s\n", outID.c_str());
 		_MSGNC(false, "ASSERT END 8\n");	//@@@@
 		assert( false );
 		return;
 	}
+	setOutputState( pin, newState, delay );
+}
+
+void Gate::setOutputState( PinIndex pin, StateType newState, TimeType delay ) {
+	_MSGNC(ourCircuit != NULL, "Gate::setOutputState() - NULL circuit. ASSERT END 7\n");	//@@@@
+	assert( ourCircuit != NULL );
+
+	GateOutput &theOutput = outputPins[pin];
 	
 	if( delay == TIME_NONE ) {
 		delay = defaultDelay;
@@ -528,11 +776,11 @@ void Gate::setOutputState( string outID, StateType newState, TimeType delay ) {
 
 	// The event variables for the event to be thrown:
 	TimeType eTime = getSimTime() + delay;
-	IDType eWire = outputList[outID].wireID;
+	IDType eWire = theOutput.wireID;
 
 	// Set the output state (if the output is inverted, then invert it first):
 	StateType eState;
-	if( outputList[outID].inverted ) {
+	if( theOutput.inverted ) {
 		if( newState == ONE ) {
 			eState = ZERO;
 		} else if( newState == ZERO ) {
@@ -544,34 +792,78 @@ void Gate::setOutputState( string outID, StateType newState, TimeType delay ) {
 		eState = newState;
 	}
 
-	if( outputList[outID].enableInput != "" ) {
+	if( theOutput.enablePin != PIN_NONE ) {
 		// If the enable pin is NOT set to 0, then it is enabled!
 		// (Interprets HI_Z, CONFLICT, and UNKNOWN as 1.)
-		if( getInputState( outputList[outID].enableInput ) == ZERO ) {
+		if( getInputState( theOutput.enablePin ) == ZERO ) {
 			eState = HI_Z;
 		}
 	}
 
 	// If the state has changed, then we are interested in this event:
-	if( eState != outputList[outID].lastEventState ) {
+	if( eState != theOutput.lastEventState ) {
 
 		// If we have a wire connected, then send the event:
 		if( eWire != ID_NONE ) {
-			ourCircuit->createEvent( eTime, eWire, myID, outID, eState );
+			ourCircuit->createEvent( eTime, eWire, myID, pin, eState );
 		}
 		
 		// Store the last-state information to prevent duplicate events,
 		// and in case a wire is connected to this output and the event
 		// needs to be re-sent:
-		outputList[outID].lastEventState = eState;
-		outputList[outID].lastEventTime = eTime;
+		theOutput.lastEventState = eState;
+		theOutput.lastEventTime = eTime;
 	}
 }
 
 	
+// The pattern version of setOutputState():
+void Gate::setOutputPattern( PinIndex pin, PatternWord newPattern ) {
+	assert( ourPatternSim != NULL );
+	const GateOutput &theOutput = outputPins[pin];
+
+	if( theOutput.inverted ) {
+		swap( newPattern.zero, newPattern.one );
+	}
+	ourPatternSim->stickOutputPin( pin, newPattern );
+
+	// The output is HI_Z where the enable pin is ZERO:
+	if( theOutput.enablePin != PIN_NONE ) {
+		newPattern = newPattern.select( ~getInputPattern( theOutput.enablePin ).zero );
+	}
+
+	ourPatternSim->driveOutputPin( pin, newPattern );
+}
+
+// The compiled version of setOutputState():
+void Gate::setOutputCode( PinIndex pin, const string &stateCode ) {
+	assert( ourCompiledSim != NULL );
+	const GateOutput &theOutput = outputPins[pin];
+
+	string theCode = stateCode;
+	if( theOutput.inverted ) {
+		theCode = "inv( " + theCode + " )";
+	}
+
+	// The output is HI_Z when the enable pin is ZERO:
+	if( theOutput.enablePin != PIN_NONE ) {
+		theCode = "( " + getInputCode( theOutput.enablePin ) + " == ZERO ) ? (S) HI_Z : " + theCode;
+	}
+
+	ourCompiledSim->driveOutputPin( pin, theCode );
+}
+
 // Set the output states of a bus of outputs named "busName_0" through
 // "busName_x" using a vector of states:
 void Gate::setOutputBusState( string outID, vector< StateType > newState, TimeType delay ) {
+	const vector< PinIndex > &busPins = getOutputBus( outID );
+	if( busPins.size() >= newState.size() ) {
+		setOutputBusState( busPins, newState, delay );
+		return;
+	}
+
+	// The bus is narrower than the new state, so go pin by pin and let
+	// setOutputState() complain about the missing ones:
 	ostringstream pinName;
 	for( unsigned long i = 0; i < newState.size(); i++ ) {
 		pinName.str("");
@@ -581,6 +873,24 @@ void Gate::setOutputBusState( string outID, vector< StateType > newState, TimeTy
 	}
 }
 
+// Set the output states of a bus of output pins using a vector of states:
+// (States past the end of the bus are dropped.)
+void Gate::setOutputBusState( const vector< PinIndex > &busPins, const vector< StateType > &newState, TimeType delay ) {
+	unsigned long width = min( busPins.size(), newState.size() );
+	for( unsigned long i = 0; i < width; i++ ) {
+		setOutputState( busPins[i], newState[i], delay );
+	}
+}
+
+// Set the output states of a bus of output pins from a packed value:
+// (Bits past the end of the bus are dropped.)
+void Gate::setOutputBusValue( const vector< PinIndex > &busPins, const BusValue &newValue, TimeType delay ) {
+	unsigned long width = min( (unsigned long) busPins.size(), newValue.width );
+	for( unsigned long i = 0; i < width; i++ ) {
+		setOutputState( busPins[i], newValue.getState( i ), delay );
+	}
+}
+
 
 // List a parameter in the Circuit as having been changed:
 void Gate::listChangedParam( string paramName ) {
@@ -646,6 +956,19 @@ vector< StateType > Gate::ulong_to_bus( unsigned long number, unsigned long numB
 }
 
 
+// The patterns in which a bus reads as "number", the way bus_to_ulong()
+// reads it (a bit that isn't ONE is a 0):
+static unsigned long long busPatternsEqual( const vector< PatternWord > &busPatterns, unsigned long long number ) {
+	if( ( busPatterns.size() < 64 ) && ( ( number >> busPatterns.size() ) != 0 ) ) return 0;
+
+	unsigned long long equal = ~0ULL;
+	for( unsigned long i = 0; i < busPatterns.size(); i++ ) {
+		bool bitSet = ( i < 64 ) && ( ( number >> i ) & 1 );
+		equal &= bitSet ? busPatterns[i].one : ~busPatterns[i].one;
+	}
+	return equal;
+}
+
 // ************************* END GENERIC GATE ***********************************
 
 
@@ -694,6 +1017,12 @@ string Gate_N_INPUT::getParameter( string paramName ) {
 }
 
 
+// Look up the input bus:
+void Gate_N_INPUT::resolvePins( void ) {
+	inPins = getInputBus( "IN" );
+}
+
+
 // **************************** END Gate_N_INPUT GATE ***********************************
 
 // ******************************** PASS GATE ***********************************
@@ -712,7 +1041,7 @@ Gate_PASS::Gate_PASS() : Gate_N_INPUT() {
 // Handle gate events:
 void Gate_PASS::gateProcess( void ) {
 	// Get the status of all of the inputs:
-	vector< StateType > inputStates = getInputBusState("IN");
+	vector< StateType > inputStates = getInputBusState(inPins);
 	vector< StateType > outputStates(inBits, UNKNOWN);
 	
 	for( unsigned long i = 0; i < inBits; i++ ) {
@@ -722,10 +1051,34 @@ void Gate_PASS::gateProcess( void ) {
 		}
 	}
 
-	setOutputBusState("OUT", outputStates);
+	setOutputBusState(outPins, outputStates);
 	// Pedro Casanova (casanova@ujaen.es) 2020/04-12
 	// To manage dual outputs
-	setOutputBusState("OUTINV", outputStates);
+	setOutputBusState(outInvPins, outputStates);
+}
+
+// The pattern version of gateProcess():
+bool Gate_PASS::patternProcess( void ) {
+	for( unsigned long i = 0; i < inPins.size(); i++ ) {
+		// Pass the ONEs and ZEROs through, and the rest are UNKNOWN:
+		PatternWord outPattern = getInputPattern(inPins[i]);
+		outPattern.unknown = outPattern.notBinary();
+		outPattern.conflict = 0;
+
+		if( i < outPins.size() ) setOutputPattern(outPins[i], outPattern);
+		if( i < outInvPins.size() ) setOutputPattern(outInvPins[i], outPattern);
+	}
+	return true;
+}
+
+// The compiled version of gateProcess():
+bool Gate_PASS::codeProcess( void ) {
+	for( unsigned long i = 0; i < inPins.size(); i++ ) {
+		string outCode = "pass( " + getInputCode(inPins[i]) + " )";
+		if( i < outPins.size() ) setOutputCode(outPins[i], outCode);
+		if( i < outInvPins.size() ) setOutputCode(outInvPins[i], outCode);
+	}
+	return true;
 }
 
 
@@ -760,6 +1113,14 @@ bool Gate_PASS::setParameter( string paramName, string value ) {
 }
 
 
+// Look up the input and output busses:
+void Gate_PASS::resolvePins( void ) {
+	Gate_N_INPUT::resolvePins();
+	outPins = getOutputBus( "OUT" );
+	outInvPins = getOutputBus( "OUTINV" );
+}
+
+
 // **************************** END PASS GATE ***********************************
 
 
@@ -770,13 +1131,13 @@ Gate_OR::Gate_OR() : Gate_N_INPUT() {
 	//NOTE: Inputs are declared by Gate_N_INPUT()
 
 	// Declare the output:
-	declareOutput("OUT");
+	outPin = declareOutput("OUT");
 }
 
 // Handle gate events:
 void Gate_OR::gateProcess( void ) {
 	// Get the status of all of the inputs:
-	vector< StateType > inputStates = getInputBusState("IN");
+	vector< StateType > inputStates = getInputBusState(inPins);
 	
 	StateType outState = ZERO; // Assume that the output is ZERO first of all.
 	for( unsigned long i = 0; i < inBits; i++ ) {
@@ -790,7 +1151,39 @@ void Gate_OR::gateProcess( void ) {
 		}
 	}
 
-	setOutputState("OUT", outState);
+	setOutputState(outPin, outState);
+}
+
+// The pattern version of gateProcess():
+bool Gate_OR::patternProcess( void ) {
+	// A single ONE makes the output ONE, or else anything but ZERO makes it UNKNOWN:
+	unsigned long long anyOne = 0, allZero = ~0ULL;
+	for( unsigned long i = 0; i < inPins.size(); i++ ) {
+		PatternWord inPattern = getInputPattern(inPins[i]);
+		anyOne |= inPattern.one;
+		allZero &= inPattern.zero;
+	}
+
+	PatternWord outPattern;
+	outPattern.one = anyOne;
+	outPattern.zero = allZero & ~anyOne;
+	outPattern.unknown = outPattern.notBinary();
+	setOutputPattern(outPin, outPattern);
+	return true;
+}
+
+// The compiled version of gateProcess():
+bool Gate_OR::codeProcess( void ) {
+	// A single ONE makes the output ONE, or else anything but ZERO makes it UNKNOWN:
+	string anyOne = "false", allZero = "true";
+	for( unsigned long i = 0; i < inPins.size(); i++ ) {
+		string inCode = getInputCode(inPins[i]);
+		anyOne += " || ( " + inCode + " == ONE )";
+		allZero += " && ( " + inCode + " == ZERO )";
+	}
+
+	setOutputCode(outPin, "( " + anyOne + " ) ? (S) ONE : ( " + allZero + " ) ? (S) ZERO : (S) UNKNOWN");
+	return true;
 }
 
 // **************************** END OR GATE ***********************************
@@ -803,14 +1196,14 @@ Gate_AND::Gate_AND() : Gate_N_INPUT() {
 	//NOTE: Inputs are declared by Gate_N_INPUT()
 
 	// Declare the output:
-	declareOutput("OUT");
+	outPin = declareOutput("OUT");
 
 }
 
 // Handle gate events:
 void Gate_AND::gateProcess( void ) {
 	// Get the status of all of the inputs:
-	vector< StateType > inputStates = getInputBusState("IN");
+	vector< StateType > inputStates = getInputBusState(inPins);
 	
 	StateType outState = ONE; // Assume that the output is ONE first of all.
 	for( unsigned long i = 0; i < inBits; i++ ) {
@@ -824,7 +1217,39 @@ void Gate_AND::gateProcess( void ) {
 		}
 	}
 
-	setOutputState("OUT", outState);
+	setOutputState(outPin, outState);
+}
+
+// The pattern version of gateProcess():
+bool Gate_AND::patternProcess( void ) {
+	// A single ZERO makes the output ZERO, or else anything but ONE makes it UNKNOWN:
+	unsigned long long anyZero = 0, allOne = ~0ULL;
+	for( unsigned long i = 0; i < inPins.size(); i++ ) {
+		PatternWord inPattern = getInputPattern(inPins[i]);
+		anyZero |= inPattern.zero;
+		allOne &= inPattern.one;
+	}
+
+	PatternWord outPattern;
+	outPattern.zero = anyZero;
+	outPattern.one = allOne & ~anyZero;
+	outPattern.unknown = outPattern.notBinary();
+	setOutputPattern(outPin, outPattern);
+	return true;
+}
+
+// The compiled version of gateProcess():
+bool Gate_AND::codeProcess( void ) {
+	// A single ZERO makes the output ZERO, or else anything but ONE makes it UNKNOWN:
+	string anyZero = "false", allOne = "true";
+	for( unsigned long i = 0; i < inPins.size(); i++ ) {
+		string inCode = getInputCode(inPins[i]);
+		anyZero += " || ( " + inCode + " == ZERO )";
+		allOne += " && ( " + inCode + " == ONE )";
+	}
+
+	setOutputCode(outPin, "( " + anyZero + " ) ? (S) ZERO : ( " + allOne + " ) ? (S) ONE : (S) UNKNOWN");
+	return true;
 }
 
 // **************************** END AND GATE ***********************************
@@ -842,7 +1267,7 @@ Gate_PLD_AND::Gate_PLD_AND() : Gate_AND() {
 // Handle gate events:
 void Gate_PLD_AND::gateProcess(void) {
 	// Get the status of all of the inputs:
-	vector< StateType > inputStates = getInputBusState("IN");
+	vector< StateType > inputStates = getInputBusState(inPins);
 
 	StateType outState = ONE; // Assume that the output is ONE first of all.
 	for (unsigned long i = 0; i < inBits; i++) {
@@ -863,7 +1288,25 @@ void Gate_PLD_AND::gateProcess(void) {
 	if(forceZero)
 		outState = ZERO;
 
-	setOutputState("OUT", outState);
+	setOutputState(outPin, outState);
+}
+
+// The pattern version of gateProcess():
+bool Gate_PLD_AND::patternProcess(void) {
+	if (forceZero) {
+		setOutputPattern(outPin, PatternWord(ZERO));
+		return true;
+	}
+	return Gate_AND::patternProcess();
+}
+
+// The compiled version of gateProcess():
+bool Gate_PLD_AND::codeProcess(void) {
+	if (forceZero) {
+		setOutputCode(outPin, "(S) ZERO");
+		return true;
+	}
+	return Gate_AND::codeProcess();
 }
 
 // Set the parameters:
@@ -907,7 +1350,7 @@ Gate_PLD_OR::Gate_PLD_OR() : Gate_OR() {
 // Handle gate events:
 void Gate_PLD_OR::gateProcess(void) {
 	// Get the status of all of the inputs:
-	vector< StateType > inputStates = getInputBusState("IN");
+	vector< StateType > inputStates = getInputBusState(inPins);
 
 	StateType outState = ZERO; // Assume that the output is ZERO first of all.
 	for (unsigned long i = 0; i < inBits; i++) {
@@ -928,7 +1371,25 @@ void Gate_PLD_OR::gateProcess(void) {
 	if (forceOne)
 		outState = ONE;
 
-	setOutputState("OUT", outState);
+	setOutputState(outPin, outState);
+}
+
+// The pattern version of gateProcess():
+bool Gate_PLD_OR::patternProcess(void) {
+	if (forceOne) {
+		setOutputPattern(outPin, PatternWord(ONE));
+		return true;
+	}
+	return Gate_OR::patternProcess();
+}
+
+// The compiled version of gateProcess():
+bool Gate_PLD_OR::codeProcess(void) {
+	if (forceOne) {
+		setOutputCode(outPin, "(S) ONE");
+		return true;
+	}
+	return Gate_OR::codeProcess();
 }
 
 // Set the parameters:
@@ -968,14 +1429,14 @@ Gate_EQUIVALENCE::Gate_EQUIVALENCE() : Gate_N_INPUT() {
 	//NOTE: Inputs are declared by Gate_N_INPUT()
 
 	// Declare the output:
-	declareOutput("OUT");
+	outPin = declareOutput("OUT");
 }
 
 // Handle gate events:
 // This is a 2-inputs XNOR gate
 void Gate_EQUIVALENCE::gateProcess( void ) {
 	// Get the status of all of the inputs:
-	vector< StateType > inputStates = getInputBusState("IN");
+	vector< StateType > inputStates = getInputBusState(inPins);
 	
 	StateType outState;
 	
@@ -989,7 +1450,34 @@ void Gate_EQUIVALENCE::gateProcess( void ) {
 		outState = UNKNOWN;
 	}
 
-	setOutputState("OUT", outState);
+	setOutputState(outPin, outState);
+}
+
+// The pattern version of gateProcess():
+bool Gate_EQUIVALENCE::patternProcess( void ) {
+	if( inPins.size() < 2 ) return false;
+	PatternWord inA = getInputPattern(inPins[0]);
+	PatternWord inB = getInputPattern(inPins[1]);
+
+	unsigned long long notBinary = inA.notBinary() | inB.notBinary();
+	unsigned long long equal = ~( inA.one ^ inB.one );
+
+	PatternWord outPattern;
+	outPattern.one = equal & ~notBinary;
+	outPattern.zero = ~equal & ~notBinary;
+	outPattern.unknown = notBinary;
+	setOutputPattern(outPin, outPattern);
+	return true;
+}
+
+// The compiled version of gateProcess():
+bool Gate_EQUIVALENCE::codeProcess( void ) {
+	if( inPins.size() < 2 ) return false;
+	string inA = getInputCode(inPins[0]);
+	string inB = getInputCode(inPins[1]);
+
+	setOutputCode(outPin, "( binary( " + inA + " ) && binary( " + inB + " ) ) ? ( ( " + inA + " == " + inB + " ) ? (S) ONE : (S) ZERO ) : (S) UNKNOWN");
+	return true;
 }
 
 // ************************ END EQUIVALENCE GATE *******************************
@@ -1002,13 +1490,13 @@ Gate_XOR::Gate_XOR() : Gate_N_INPUT() {
 	//NOTE: Inputs are declared by Gate_N_INPUT()
 
 	// Declare the output:
-	declareOutput("OUT");
+	outPin = declareOutput("OUT");
 }
 
 // Handle gate events:
 void Gate_XOR::gateProcess( void ) {
 	// Get the status of all of the inputs:
-	vector< StateType > inputStates = getInputBusState("IN");
+	vector< StateType > inputStates = getInputBusState(inPins);
 
 	// The XOR operation is basically a parity check.
 	// XOR returns TRUE if there are an odd number of 1's.
@@ -1032,7 +1520,39 @@ void Gate_XOR::gateProcess( void ) {
 		}
 	}
 
-	setOutputState("OUT", outState);
+	setOutputState(outPin, outState);
+}
+
+// The pattern version of gateProcess():
+bool Gate_XOR::patternProcess( void ) {
+	// The parity of the ONEs, unless an input is not ONE or ZERO:
+	unsigned long long notBinary = 0, parity = 0;
+	for( unsigned long i = 0; i < inPins.size(); i++ ) {
+		PatternWord inPattern = getInputPattern(inPins[i]);
+		notBinary |= inPattern.notBinary();
+		parity ^= inPattern.one;
+	}
+
+	PatternWord outPattern;
+	outPattern.one = parity & ~notBinary;
+	outPattern.zero = ~parity & ~notBinary;
+	outPattern.unknown = notBinary;
+	setOutputPattern(outPin, outPattern);
+	return true;
+}
+
+// The compiled version of gateProcess():
+bool Gate_XOR::codeProcess( void ) {
+	// The parity of the ONEs, unless an input is not ONE or ZERO:
+	string allBinary = "true", parity = "false";
+	for( unsigned long i = 0; i < inPins.size(); i++ ) {
+		string inCode = getInputCode(inPins[i]);
+		allBinary += " && binary( " + inCode + " )";
+		parity += " ^ ( " + inCode + " == ONE )";
+	}
+
+	setOutputCode(outPin, "( " + allBinary + " ) ? ( ( " + parity + " ) ? (S) ONE : (S) ZERO ) : (S) UNKNOWN");
+	return true;
 }
 
 // **************************** END XOR GATE ***********************************
@@ -1042,32 +1562,32 @@ void Gate_XOR::gateProcess( void ) {
 
 Gate_REGISTER::Gate_REGISTER() : Gate_PASS() {
 	// Declare the inputs:
-	declareInput("CLOCK", true);
-	declareInput("CLOCK_ENABLE");
-	declareInput("CLEAR");
-	declareInput("SET");
-	declareInput("LOAD");
+	clockPin = declareInput("CLOCK", true);
+	clockEnablePin = declareInput("CLOCK_ENABLE");
+	clearPin = declareInput("CLEAR");
+	setPin = declareInput("SET");
+	loadPin = declareInput("LOAD");
 
 	// Pedro Casanova (casanova@ujaen.es) 2020/04-12
 	// Control Set - Clear
-	declareInput("CONTROL"); // Favors "yes" if not connected!
+	controlPin = declareInput("CONTROL"); // Favors "yes" if not connected!
 
 	// For count reg:
-	declareInput("COUNT_ENABLE");
-	declareInput("COUNT_UP"); // Favors "up" if not connected!
+	countEnablePin = declareInput("COUNT_ENABLE");
+	countUpPin = declareInput("COUNT_UP"); // Favors "up" if not connected!
 
 	// For shift reg:
-	declareInput("SHIFT_ENABLE");
-	declareInput("SHIFT_LEFT"); // Favors "left" if not connected!
-	declareInput("CARRY_IN");
+	shiftEnablePin = declareInput("SHIFT_ENABLE");
+	shiftLeftPin = declareInput("SHIFT_LEFT"); // Favors "left" if not connected!
+	carryInPin = declareInput("CARRY_IN");
 
 	// Pedro Casanova (casanova@ujaen.es) 2020/04-12
 	// For shift and count
-	declareInput("COUNT_UP_SHIFT_LEFT"); // Favors "up and "left" if not connected!
+	countUpShiftLeftPin = declareInput("COUNT_UP_SHIFT_LEFT"); // Favors "up and "left" if not connected!
 
 
 	// (Load input bus and the output bus are declared by Gate_PASS):
-	declareOutput("CARRY_OUT"); 
+	carryOutPin = declareOutput("CARRY_OUT"); 
 
 // The input state priority goes like this:
 // clear, set, load, count_enable, shift_enable, hold
@@ -1105,68 +1625,57 @@ Gate_REGISTER::Gate_REGISTER() : Gate_PASS() {
 
 // Handle gate events:
 void Gate_REGISTER::gateProcess( void ) {
-	vector< StateType > outBus;
-	
-	// If this is the first time this gate has been simulated,
-	// then output the currentValue to the pins:
-	if( firstGateProcess ) {
-		firstGateProcess = false;
-		outBus = ulong_to_bus( currentValue, inBits );
-	}
+	// (The currentValue is sent to the pins every time, including the
+	// first time that this gate is simulated.)
+	firstGateProcess = false;
 
 	// Track to see if the current value changes, to know if to send
 	// an update message to the GUI:
-	unsigned long oldCurrentValue = currentValue;
+	BusWord oldCurrentValue = currentValue;
+
+	// The bits of the register, and its most significant bit:
+	BusWord mask = BusValue::mask( inBits );
+	BusWord topBit = ( ( inBits > 0 ) && ( inBits <= MAX_BUS_BITS ) ) ? ( 1ULL << ( inBits - 1 ) ) : 0;
 
 	// Pedro Casanova (casanova@ujaen.es) 2020/04-12
 	// Register functions managed by opcode
 	// 000: NOP, 001: CLR, 010: INC, 011: DEC
 	// 100: SLL, 101: SRL, 110: ROL, 111:ROR
-	vector< StateType > opBus = getInputBusState("OP");
-	for (unsigned long i = 0; i < opBus.size(); i++)
-		if (opBus[i] != ONE) opBus[i] = ZERO;
-	unsigned long OPcode = bus_to_ulong(opBus);
+	BusWord OPcode = getInputBusValue(opPins).value;
 
 	// Update outBus and currentValue based on the input states.
-	if( getInputState("CLEAR") == ONE ) {
-		if (getInputState("CONTROL") != ZERO)	// Pedro Casanova (casanova@ujaen.es) 2020/04-12
+	if( getInputState(clearPin) == ONE ) {
+		if (getInputState(controlPin) != ZERO)	// Pedro Casanova (casanova@ujaen.es) 2020/04-12
 			if (hasClockEdge(syncClear)) {		// Control Set - Clear and async Clear
 				// Clear.
 				currentValue = 0;
 				carryOut = ZERO;
 			}
-	} else if( getInputState("SET") == ONE ) {
-		if (getInputState("CONTROL") != ZERO)	// Pedro Casanova (casanova@ujaen.es) 2020/04-12
+	} else if( getInputState(setPin) == ONE ) {
+		if (getInputState(controlPin) != ZERO)	// Pedro Casanova (casanova@ujaen.es) 2020/04-12
 			if (hasClockEdge(syncSet)) {		// Control Set - Clear and async Set
 				// Set.
-				vector< StateType > allOnes( inBits, ONE );
-				currentValue = bus_to_ulong(allOnes);
+				currentValue = mask;
 				carryOut = ZERO;
 			}
-	} else if( getInputState("LOAD") == ONE) {
+	} else if( getInputState(loadPin) == ONE) {
 		if (hasClockEdge(syncLoad)) {			// Pedro Casanova (casanova@ujaen.es) 2020/04-12
-			// Load.
-			vector< StateType > inputBus = getInputBusState("IN");
-			for( unsigned long i = 0; i < inputBus.size(); i++ ) {
-				if( (inputBus[i] == CONFLICT) || (inputBus[i] == HI_Z) ) {
-					inputBus[i] = UNKNOWN;
-				}
-			}
-			currentValue = bus_to_ulong( inputBus );
+			// Load. (An input bit that isn't ONE loads as 0.)
+			currentValue = getInputBusValue(inPins).value;
 			carryOut = ZERO;
 		}
 	} else if (OPcode == 1) {
-		if (isRisingEdge("CLOCK")) {
+		if (isRisingEdge(clockPin)) {
 			// Sync Clear
 			currentValue = 0;
 			carryOut = ZERO;
 		}
-	} else if( getInputState("COUNT_ENABLE") == ONE || OPcode == 2 || OPcode == 3) {
+	} else if( getInputState(countEnablePin) == ONE || OPcode == 2 || OPcode == 3) {
 		// Count.
-		if( isRisingEdge("CLOCK") ) {
+		if( isRisingEdge(clockPin) ) {
 			// Only count down if count_up is ZERO. This allows
 			// HI_Z, CONFLICT, and UNKNOWN to favor counting upwards.
-			if (getInputState("COUNT_UP") == ZERO || getInputState("COUNT_UP_SHIFT_LEFT") == ZERO || OPcode == 3) {  // Favors "up" if not connected!
+			if (getInputState(countUpPin) == ZERO || getInputState(countUpShiftLeftPin) == ZERO || OPcode == 3) {  // Favors "up" if not connected!
 				// Decrement the counter:
 				if( (currentValue == 0) || (currentValue > maxCount) ) {
 					currentValue = maxCount;
@@ -1188,7 +1697,7 @@ void Gate_REGISTER::gateProcess( void ) {
 		// if CO_ON_OVERFLOW Carry out when count pass fom max to zero or zero to max
 		// if not CO_ON_OVERFLOW Carry out when count is zero or max
 		// Set the carry out bit, regardless of the clock edge:
-		if (getInputState("COUNT_UP") == ZERO || getInputState("COUNT_UP_SHIFT_LEFT") == ZERO || OPcode == 3) {  // Favors "up" if not connected!
+		if (getInputState(countUpPin) == ZERO || getInputState(countUpShiftLeftPin) == ZERO || OPcode == 3) {  // Favors "up" if not connected!
 			if (!CoOnOverflow) {
 				carryOut = ZERO;
 				if (currentValue == 0) carryOut = ONE; // Carry out on ZERO count when downcounting and carry out on min/max.
@@ -1201,19 +1710,16 @@ void Gate_REGISTER::gateProcess( void ) {
 			}
 		}
 
-	} else if( getInputState("SHIFT_ENABLE") == ONE || OPcode == 4 || OPcode == 5) {
+	} else if( getInputState(shiftEnablePin) == ONE || OPcode == 4 || OPcode == 5) {
 		// Shift.
-		if (isRisingEdge("CLOCK")) {
-			if (getInputState("SHIFT_LEFT") == ZERO || getInputState("COUNT_UP_SHIFT_LEFT") == ZERO || OPcode == 5) { // Favors "left" if not connected!
+		if (isRisingEdge(clockPin)) {
+			if (getInputState(shiftLeftPin) == ZERO || getInputState(countUpShiftLeftPin) == ZERO || OPcode == 5) { // Favors "left" if not connected!
 				// Shift right.
 				currentValue >>= 1;
 
-				outBus = ulong_to_bus(currentValue, inBits);
-
 				// Add the input carry if needed:
-				if (getInputState("CARRY_IN") == ONE) {
-					outBus[inBits - 1] = ONE;
-					currentValue = bus_to_ulong(outBus);
+				if (getInputState(carryInPin) == ONE) {
+					currentValue |= topBit;
 				}
 			}
 			else {
@@ -1221,54 +1727,41 @@ void Gate_REGISTER::gateProcess( void ) {
 				currentValue <<= 1;
 
 				// Add the input carry if needed:
-				if (getInputState("CARRY_IN") == ONE) {
+				if (getInputState(carryInPin) == ONE) {
 					currentValue++;
 				}
 
 				// Throw away the extra bits that aren't part of the register,
 				// so that when you switch to "right-shift", it doesn't remember
 				// more than it should!
-				unsigned long mask = 0;
-				for (unsigned long i = 0; i < inBits; i++) {
-					mask <<= 1;
-					mask += 1;
-				}
 				currentValue = currentValue & mask;
 				}
 		}
 
 		// Set the carry out bit, regardless of the clock edge:		
-		vector< StateType > tempBus = ulong_to_bus(currentValue, inBits);
-		if (getInputState("SHIFT_LEFT") == ZERO || getInputState("COUNT_UP_SHIFT_LEFT") == ZERO || OPcode == 5) { // Favors "left" if not connected!
+		if (getInputState(shiftLeftPin) == ZERO || getInputState(countUpShiftLeftPin) == ZERO || OPcode == 5) { // Favors "left" if not connected!
 			// Shift right.
-			carryOut = tempBus[0];
+			carryOut = (currentValue & 1) ? ONE : ZERO;
 		}
 		else {
 			// Shift left.
-			carryOut = tempBus[tempBus.size() - 1];
+			carryOut = (currentValue & topBit) ? ONE : ZERO;
 		}
 	} 	else if (OPcode == 6 || OPcode == 7) {
 		// Rotate.
-		if (isRisingEdge("CLOCK")) {
+		if (isRisingEdge(clockPin)) {
 			if (OPcode == 6) {
 				// Rotate left.				
-				currentValue <<= 1;
-				if (currentValue & (1 << inBits)) currentValue++;
+				currentValue = (currentValue << 1) | ((currentValue & topBit) ? 1 : 0);
 			}
 			else {
 				// Rotate right.
-				if (currentValue & 1) currentValue+= (1 << inBits);
-				currentValue >>= 1;
+				currentValue = (currentValue >> 1) | ((currentValue & 1) ? topBit : 0);
 			}
 
 			// Throw away the extra bits that aren't part of the register,
 			// so that when you switch to "right-shift", it doesn't remember
 			// more than it should!
-			unsigned long mask = 0;
-			for (unsigned long i = 0; i < inBits; i++) {
-				mask <<= 1;
-				mask += 1;
-			}
 			currentValue = currentValue & mask;
 			carryOut = ZERO;
 		}
@@ -1282,14 +1775,8 @@ void Gate_REGISTER::gateProcess( void ) {
 		if( disableHold ) {
 			// Otherwise, load in what is on the input pins:
 			if (hasClockEdge(syncLoad)) {		// Pedro Casanova (casanova@ujaen.es) 2020/04-12
-				// Load.
-				vector< StateType > inputBus = getInputBusState("IN");
-				for (unsigned long i = 0; i < inputBus.size(); i++) {
-					if ((inputBus[i] == CONFLICT) || (inputBus[i] == HI_Z)) {
-						inputBus[i] = UNKNOWN;
-					}
-				}
-				currentValue = bus_to_ulong(inputBus);
+				// Load. (An input bit that isn't ONE loads as 0.)
+				currentValue = getInputBusValue(inPins).value;
 			}
 		}
 		carryOut = ZERO;
@@ -1299,10 +1786,10 @@ void Gate_REGISTER::gateProcess( void ) {
 	// Only one time is better than in each case how it was
 	// It is necesary to permit asynchronous ENABLE
 	// Send the value to the bus:
-	outBus = ulong_to_bus(currentValue, inBits);
+	BusValue outBus( currentValue, inBits );
 
 	// Set the output values:
-	setOutputState("CARRY_OUT", carryOut);
+	setOutputState(carryOutPin, carryOut);
 	
 	//********************************
 	//Edit by Joshua Lansford 3/15/07
@@ -1315,28 +1802,19 @@ void Gate_REGISTER::gateProcess( void ) {
 	//machine, it is a nusence if
 	//the whole thing is in an infinite
 	//state of unknowingness
-	for( vector< StateType >::iterator I = outBus.begin(); I != outBus.end(); ++I ){
-		if( *I != ONE ){
-			*I = ZERO;
-		}
-	}		
+	//(The value is a number, so its bits are all ONE or ZERO.)
 	//End of edit**********************
 	
-	if( outBus.size() != 0 ) {
-		setOutputBusState("OUT", outBus);
-		setOutputBusState("OUTINV", outBus);
+	if( outBus.width != 0 ) {
+		setOutputBusValue(outPins, outBus);
+		setOutputBusValue(outInvPins, outBus);
 
 		// Pedro Casanova (casanova@ujaen.es) 2021/01-03
 		// This do nothting
 		// Check if any of the outputs are "unknown" state, and send that info on
 		// to the GUI:
 		bool oldUO = unknownOutputs;
-		unknownOutputs = false;
-		for( unsigned int i = 0; i < outBus.size(); i++ ) {
-			if( outBus[i] == UNKNOWN ) {
-				unknownOutputs = true;
-			}
-		}
+		unknownOutputs = ( outBus.unknown != 0 );
 		// Update the GUI's knowledge of our unknown outputs state, if it has changed:
 		if (oldUO != unknownOutputs) {
 			listChangedParam("UNKNOWN_OUTPUTS");
@@ -1448,7 +1926,14 @@ string Gate_REGISTER::getParameter( string paramName ) {
 // Pedro Casanova (casanova@ujaen.es) 2020/04-12
 // syncSignal added to permit set and clear
 bool Gate_REGISTER::hasClockEdge(bool syncSignal) {
-	return isRisingEdge("CLOCK") && getInputState("CLOCK_ENABLE") != ZERO || !syncSignal;	// Pedro Casanova (casanova@ujaen.es) 2020/04-12
+	return (isRisingEdge(clockPin) && getInputState(clockEnablePin) != ZERO) || !syncSignal;	// Pedro Casanova (casanova@ujaen.es) 2020/04-12
+}
+
+// Look up the input and output busses:
+// (The "OP" pins are only created when the library connects them.)
+void Gate_REGISTER::resolvePins( void ) {
+	Gate_PASS::resolvePins();
+	opPins = getInputBus( "OP" );
 }
 
 // **************************** END Register GATE ***********************************
@@ -1462,7 +1947,7 @@ Gate_CLOCK::Gate_CLOCK( TimeType newHalfCycle ) : Gate(), halfCycle(newHalfCycle
 	theState = ZERO;
 	
 	// Declare the output:
-	declareOutput("CLK");
+	clkPin = declareOutput("CLK");
 }
 
 
@@ -1476,7 +1961,7 @@ void Gate_CLOCK::gateProcess( void ) {
 		else theState = ZERO;
 	}
 
-	setOutputState( "CLK", theState, 0 );
+	setOutputState( clkPin, theState, 0 );
 }
 
 
@@ -1504,6 +1989,14 @@ string Gate_CLOCK::getParameter( string paramName ) {
 }
 
 
+// The clock only toggles at multiples of the half cycle, so those
+// are the only steps that it has to be polled at:
+TimeType Gate_CLOCK::getNextPollTime( TimeType now ) {
+	if( halfCycle == 0 ) return TIME_NONE;
+	return ( now / halfCycle + 1 ) * halfCycle;
+}
+
+
 // **************************** END CLOCK GATE ***********************************
 
 
@@ -1514,17 +2007,18 @@ string Gate_CLOCK::getParameter( string paramName ) {
 // output will return to 0. If a pulse is still going when another
 // PULSE parameter is sent, then the pulse is extended to the normal
 // end time of the last pulse.
-// NOTE: This is a "polled" gate, so it will always be checked, just
-// like Gate_CLOCK.
+// NOTE: This is a "polled" gate, so it will be checked at each step
+// while the pulse is running, and once more to end it.
 
 Gate_PULSE::Gate_PULSE() : Gate() {
 	pulseRemaining = 0;
+	outState = UNKNOWN;
 	// Pedro Casanova (casanova@ujaen.es) 2020/04-12	Set the PULSE_WIDTH parameter:
 	High_Z = false;
 	setParameter("PULSE_WIDTH", "1");
 	
 	// Declare the output:
-	declareOutput("OUT_0");
+	outPin = declareOutput("OUT_0");
 }
 
 
@@ -1532,12 +2026,20 @@ Gate_PULSE::Gate_PULSE() : Gate() {
 void Gate_PULSE::gateProcess( void ) {
 	// The output is ONE if there is pulse remaining, and ZERO otherwise:
 	// Pedro Casanova (casanova@ujaen.es) 2020/04-12			Normally Z if High_Z is true
-	setOutputState("OUT_0", (pulseRemaining > 0) ? ONE : (High_Z ? HI_Z : ZERO) , 0);
+	outState = (pulseRemaining > 0) ? ONE : (High_Z ? HI_Z : ZERO);
+	setOutputState(outPin, outState, 0);
 
 	if( pulseRemaining != 0 ) pulseRemaining--;
 }
 
 
+// Poll at each step while the pulse runs, and once more to end it:
+TimeType Gate_PULSE::getNextPollTime( TimeType now ) {
+	if( ( pulseRemaining > 0 ) || ( outState == ONE ) ) return now + 1;
+	return TIME_NONE;
+}
+
+
 // Set the parameters:
 bool Gate_PULSE::setParameter( string paramName, string value ) {
 	istringstream iss(value);
@@ -1592,19 +2094,17 @@ Gate_MUX::Gate_MUX() : Gate_N_INPUT() {
 	setParameter("INPUT_BITS", "0");
 
 	// One output:
-	declareOutput("OUT");
+	outPin = declareOutput("OUT");
 }
 
 
 // Handle gate events:
 void Gate_MUX::gateProcess( void ) {
-	vector< StateType > selBus = getInputBusState("SEL");
-	unsigned long sel = bus_to_ulong( selBus ); //NOTE: The MUX assumes 0 on non-specified input lines (Not UNKNOWN)!
-	vector< StateType > inputs = getInputBusState("IN");
+	BusWord sel = getInputBusValue(selPins).value; //NOTE: The MUX assumes 0 on non-specified input lines (Not UNKNOWN)!
 
 	StateType outState = UNKNOWN; // Assume UNKNOWN, in case we select an invalid number.
-	if( sel < inputs.size() ) {
-		outState = inputs[sel];
+	if( sel < inPins.size() ) {
+		outState = getInputState(inPins[(size_t) sel]);
 	}
 
 	// Muxes can't output HI_Z or CONFLICT!
@@ -1612,7 +2112,26 @@ void Gate_MUX::gateProcess( void ) {
 		outState = UNKNOWN;
 	}
 
-	setOutputState("OUT", outState);
+	setOutputState(outPin, outState);
+}
+
+// The pattern version of gateProcess():
+bool Gate_MUX::patternProcess( void ) {
+	vector< PatternWord > selPatterns = getInputBusPattern(selPins);
+	vector< PatternWord > inPatterns = getInputBusPattern(inPins);
+
+	// Like bus_to_ulong(), a SEL bit that isn't ONE counts as ZERO:
+	PatternWord outPattern;
+	for( unsigned long sel = 0; sel < inPatterns.size(); sel++ ) {
+		unsigned long long selected = busPatternsEqual( selPatterns, sel );
+		outPattern.one |= selected & inPatterns[sel].one;
+		outPattern.zero |= selected & inPatterns[sel].zero;
+	}
+
+	// Muxes can't output HI_Z or CONFLICT!
+	outPattern.unknown = outPattern.notBinary();
+	setOutputPattern(outPin, outPattern);
+	return true;
 }
 
 
@@ -1644,6 +2163,13 @@ bool Gate_MUX::setParameter( string paramName, string value ) {
 }
 
 
+// Look up the input busses:
+void Gate_MUX::resolvePins( void ) {
+	Gate_N_INPUT::resolvePins();
+	selPins = getInputBus( "SEL" );
+}
+
+
 // **************************** END MUX GATE ***********************************
 
 
@@ -1658,7 +2184,7 @@ Gate_DECODER::Gate_DECODER() : Gate_N_INPUT() {
 	setParameter("INPUT_BITS", "0");
 
 	//Josh Edit 4/6/2007
-	declareInput("ENABLE");
+	enablePin = declareInput("ENABLE");
 	
 	// Pedro Casanova (casanova@ujaen.es) 2020/04-12       chip 74138 is deprecated
 
@@ -1673,10 +2199,7 @@ Gate_DECODER::Gate_DECODER() : Gate_N_INPUT() {
 
 // Handle gate events:
 void Gate_DECODER::gateProcess( void ) {
-	vector< StateType > inBus = getInputBusState("IN");
-	unsigned long inNum = bus_to_ulong( inBus ); //NOTE: The DECODER assumes 0 on non-specified input lines (Not UNKNOWN)!
-
-	vector< StateType > outBus( outBits, ZERO ); // All bits are 0, except for the active
+	BusWord inNum = getInputBusValue(inPins).value; //NOTE: The DECODER assumes 0 on non-specified input lines (Not UNKNOWN)!
 
 	//********************************
 	//Edit by Joshua Lansford 6/4/2007
@@ -1716,18 +2239,34 @@ void Gate_DECODER::gateProcess( void ) {
 	// ENABLE_B y ENABLE_C for chip 74138
 	//if( getInputState("ENABLE") == ZERO || getInputState("ENABLE_B") == ZERO || getInputState("ENABLE_C") == ZERO ){
 
-	if (getInputState("ENABLE") == ZERO) {
+	if (getInputState(enablePin) == ZERO) {
 	    	enabled = false;
 	}
 	
-	if( enabled && inNum < outBus.size() ) {
-	
 	//End of edit *********************
-	
-		outBus[inNum] = ONE;
+
+	// All bits are 0, except for the active one:
+	// (The outputs can be wider than a BusValue, so they are set one at a time.)
+	for( unsigned long i = 0; i < outPins.size(); i++ ) {
+		setOutputState(outPins[i], ( enabled && ( inNum == i ) ) ? ONE : ZERO);
 	}
+}
+
+// The pattern version of gateProcess():
+bool Gate_DECODER::patternProcess( void ) {
+	vector< PatternWord > inPatterns = getInputBusPattern(inPins);
 
-	setOutputBusState("OUT", outBus);
+	// A floating enable is enabling, and an input bit that isn't ONE counts as ZERO:
+	unsigned long long enabled = ~getInputPattern(enablePin).zero;
+	for( unsigned long out = 0; out < outPins.size(); out++ ) {
+		unsigned long long selected = enabled & busPatternsEqual( inPatterns, out );
+
+		PatternWord outPattern;
+		outPattern.one = selected;
+		outPattern.zero = ~selected;
+		setOutputPattern(outPins[out], outPattern);
+	}
+	return true;
 }
 
 
@@ -1762,6 +2301,13 @@ bool Gate_DECODER::setParameter( string paramName, string value ) {
 }
 
 
+// Look up the input and output busses:
+void Gate_DECODER::resolvePins( void ) {
+	Gate_N_INPUT::resolvePins();
+	outPins = getOutputBus( "OUT" );
+}
+
+
 // **************************** END DECODER GATE ***********************************
 
 
@@ -1774,11 +2320,11 @@ Gate_ENCODER::Gate_ENCODER() : Gate_N_INPUT() {
 	// (Must be set before using this method!)
 	setParameter("INPUT_BITS", "0");
 
-	declareInput("ENABLE");
+	enablePin = declareInput("ENABLE");
 
 	// One output:
 	declareOutput("OUT");
-	declareOutput("VALID");
+	validPin = declareOutput("VALID");
 
 	// Pedro Casanova (casanova@ujan.es) 2020/04-12
 	// Set Params, by default high for compatibility with PRI_ENCODER
@@ -1792,79 +2338,78 @@ Gate_ENCODER::Gate_ENCODER() : Gate_N_INPUT() {
 // Now permit none. low and high priority
 // Handle gate events:
 void Gate_ENCODER::gateProcess(void) {
-	vector< StateType > inBus = getInputBusState("IN");
-	unsigned long inNum = bus_to_ulong(inBus); //NOTE: The ENCODER assumes 0 on non-specified input lines (Not UNKNOWN)!
-
-	vector< StateType > outBus(outBits, ZERO); // All bits are 0
+	// The lowest and highest input bits that are ONE, if there are any:
+	//NOTE: The ENCODER assumes 0 on non-specified input lines (Not UNKNOWN)!
+	bool anyOne = false;
+	unsigned long lowBit = 0, highBit = 0;
+	if (inPins.size() <= MAX_BUS_BITS) {
+		BusWord inNum = getInputBusValue(inPins).value;
+		if (inNum != 0) {
+			anyOne = true;
+			highBit = MAX_BUS_BITS - 1;
+			while (!((inNum >> lowBit) & 1)) lowBit++;
+			while (!((inNum >> highBit) & 1)) highBit--;
+		}
+	}
+	else {
+		// Too wide for a BusWord, so look at each input:
+		for (unsigned long i = 0; i < inPins.size(); i++) {
+			if (getInputState(inPins[i]) == ONE) {
+				if (!anyOne) lowBit = i;
+				highBit = i;
+				anyOne = true;
+			}
+		}
+	}
 
-	int outBusSize = (unsigned long)ceil(log((double)inBits) / log(2.0)); // The size of output will be lg of input size
+	unsigned long outBusSize = (unsigned long)ceil(log((double)inBits) / log(2.0)); // The size of output will be lg of input size
+	BusValue outBus(0, outBusSize); // All bits are 0
 
 	bool enabled = true;
 	bool isValid = false;
 
 	//by testing for ZERO instead of one, we let a floating enable
 	//be enabling.
-	if ( getInputState("ENABLE") == ZERO ) {
+	if ( getInputState(enablePin) == ZERO ) {
 		enabled = false;
 	}
 
-	if (enabled) {
+	if (enabled && anyOne) {
 		if (Priority=="none")
 		{
-			int nHigh = 0;
-			for (unsigned long i = 0; i < inBus.size(); i++)
-				if (inBus[i] == ONE) nHigh++;
-			if (nHigh == 1) {
+			// Only valid if exactly one input is ONE:
+			if (lowBit == highBit) {
 				isValid = true;
-				for (unsigned long i = 0; i < inBus.size(); i++) {
-					if (inBus[i] == ONE) {
-						outBus = ulong_to_bus(i, outBusSize);
-						break;
-					}
-				}
+				outBus = BusValue(lowBit, outBusSize);
 			}
 		}
 		else
 		{
 			if (Priority=="high")
 			{
-				// Loop through input bits from MSB to LSB to find active
-				for (long i = inBus.size() - 1; i >= 0; i--) {
-					if (inBus[i] == ONE) {
-						// If this bit is one, then we found MSB for output
-						outBus = ulong_to_bus(i, outBusSize);
-						break;
-					}
-				}
+				// The MSB that is ONE wins:
+				outBus = BusValue(highBit, outBusSize);
 			}
 			else
 			{
-				// Loop through input bits from LSB to MSB to find active
-				for (unsigned long i = 0; i < inBus.size(); i++) {
-					if (inBus[i] == ONE) {
-						// If this bit is one, then we found MSB for output
-						outBus = ulong_to_bus(i, outBusSize);
-						break;
-					}
-				}
+				// The LSB that is ONE wins:
+				outBus = BusValue(lowBit, outBusSize);
 			}
 			// If input other than zero is recieved, then it's valid
-			if (inNum != 0) {
-				isValid = true;
-			}
+			isValid = true;
 		}
 	}
 
 
 	if (isValid) {
-		setOutputState("VALID", ONE);
+		setOutputState(validPin, ONE);
 	}
 	else {
-		setOutputState("VALID", ZERO);
-		outBus = ulong_to_bus(invalidValue, outBusSize);
+		setOutputState(validPin, ZERO);
+		outBus = BusValue(invalidValue, outBusSize);
 	}
 
-	setOutputBusState("OUT", outBus);
+	setOutputBusValue(outPins, outBus);
 }
 
 // Pedro Casanova (casanova@ujaen.es) 2020/04-07
@@ -1918,6 +2463,12 @@ string Gate_ENCODER::getParameter(string paramName) {
 	}
 }
 
+// Look up the input and output busses:
+void Gate_ENCODER::resolvePins( void ) {
+	Gate_N_INPUT::resolvePins();
+	outPins = getOutputBus( "OUT" );
+}
+
 
 // **************************** END PRIORITY ENCODER GATE ***********************************//
 
@@ -1939,7 +2490,16 @@ Gate_DRIVER::Gate_DRIVER() : Gate() {
 void Gate_DRIVER::gateProcess( void ) {
 	// All the driver gate does is throw events IMMEDIATELY
 	// whenever the gate has changed state:
-	setOutputBusState( "OUT", ulong_to_bus(output_num, outBits), 0 );
+	setOutputBusValue( outPins, BusValue(output_num, outBits), 0 );
+}
+
+// The pattern version of gateProcess():
+bool Gate_DRIVER::patternProcess( void ) {
+	BusValue outBus(output_num, outBits);
+	for( unsigned long i = 0; i < outPins.size() && i < outBits; i++ ) {
+		setOutputPattern(outPins[i], PatternWord(outBus.getState(i)));
+	}
+	return true;
 }
 
 
@@ -1982,6 +2542,12 @@ string Gate_DRIVER::getParameter( string paramName ) {
 }
 
 
+// Look up the output bus:
+void Gate_DRIVER::resolvePins( void ) {
+	outPins = getOutputBus( "OUT" );
+}
+
+
 // **************************** END Driver GATE ***********************************
 
 
@@ -1992,68 +2558,50 @@ string Gate_DRIVER::getParameter( string paramName ) {
 
 Gate_ADDER::Gate_ADDER() : Gate_PASS() {
 	// Declare the inputs:
-	declareInput("CARRY_IN");
+	carryInPin = declareInput("CARRY_IN");
 
 	// (Load input bus and the output bus are declared by Gate_PASS and in setParams.):
 	setParameter("INPUT_BITS", "0");
 
 	// The outputs:
-	declareOutput("CARRY_OUT");
-	declareOutput("OVERFLOW");
+	carryOutPin = declareOutput("CARRY_OUT");
+	overflowPin = declareOutput("OVERFLOW");
 }
 
 
 // Handle gate events:
 void Gate_ADDER::gateProcess( void ) {
-	vector< StateType > inBusA = getInputBusState("IN");
-	unsigned long inA = bus_to_ulong( inBusA );
-
-	vector< StateType > inBusB = getInputBusState("IN_B");
-	unsigned long inB = bus_to_ulong( inBusB );
-	
-	// Do the addition:
-	unsigned long sum = inA + inB;
+	if( inBits == 0 ) return;
 
-	// Add in the carry bit:
-	if( getInputState("CARRY_IN") == ONE ) sum++;
+	BusWord inA = getInputBusValue(inPins).value;
+	BusWord inB = getInputBusValue(inBPins).value;
 
-	// Convert the sum back to binary (with an extra bit):
-	vector< StateType > preOutBus = ulong_to_bus( sum, inBits + 1 );
-	vector< StateType > outBus = ulong_to_bus( sum, inBits );
+	// Do the addition, and add in the carry bit. (A carry out of the
+	// 64-bit word is kept separately, for the widest busses.)
+	BusWord sum = inA + inB;
+	bool wordCarry = ( sum < inA );
+	if( getInputState(carryInPin) == ONE ) {
+		sum++;
+		if( sum == 0 ) wordCarry = true;
+	}
 
 	// Decide if there was a carry output:
-	StateType carryOut = preOutBus[inBits];
-	if( inBits >= 32 ) {
-		// Fix the carry out if we are using 32-bit arithmetic:
-		unsigned long long longA = inA;
-		unsigned long long longB = inB;
-		unsigned long long sum = longA + longB;
-		if( sum > 0xFFFFFFFF ) {
-			carryOut = ONE;
-		}
-	}
-
-	// Determine overflow:
-	StateType overflow = UNKNOWN;
-	StateType lastBitA = (inBusA[inBits-1] == ONE) ? ONE : ZERO;
-	StateType lastBitB = (inBusB[inBits-1] == ONE) ? ONE : ZERO;
-	StateType lastBitSum = (preOutBus[inBits-1] == ONE) ? ONE : ZERO;
-	if( lastBitA != lastBitB ) {
-		// Differing input signs. No overflow:
-		overflow = ZERO;
+	StateType carryOut;
+	if( inBits < MAX_BUS_BITS ) {
+		carryOut = ( ( sum >> inBits ) & 1 ) ? ONE : ZERO;
 	} else {
-		if(lastBitSum != lastBitA) {
-			// Same input signs, yet different output sign. Overflow!
-			overflow = ONE;
-		} else {
-			overflow = ZERO;
-		}
+		carryOut = wordCarry ? ONE : ZERO;
 	}
 
+	// Determine overflow: Same input signs, yet different output sign.
+	// (Differing input signs never overflow.)
+	BusWord signBit = 1ULL << ( min( inBits, MAX_BUS_BITS ) - 1 );
+	StateType overflow = ( ~( inA ^ inB ) & ( inA ^ sum ) & signBit ) ? ONE : ZERO;
+
 	// Set the output values:
-	setOutputState("CARRY_OUT", carryOut);
-	setOutputState("OVERFLOW", overflow);
-	setOutputBusState("OUT", outBus);
+	setOutputState(carryOutPin, carryOut);
+	setOutputState(overflowPin, overflow);
+	setOutputBusValue(outPins, BusValue( sum, inBits ));
 }
 
 
@@ -2080,6 +2628,13 @@ bool Gate_ADDER::setParameter( string paramName, string value ) {
 }
 
 
+// Look up the input and output busses:
+void Gate_ADDER::resolvePins( void ) {
+	Gate_PASS::resolvePins();
+	inBPins = getInputBus( "IN_B" );
+}
+
+
 // **************************** END Adder GATE ***********************************
 
 
@@ -2091,35 +2646,35 @@ bool Gate_ADDER::setParameter( string paramName, string value ) {
 
 Gate_COMPARE::Gate_COMPARE() : Gate_N_INPUT() {
 	// Declare the inputs:
-	declareInput("IN_A_EQUAL_B");
-	declareInput("IN_A_GREATER_B");
-	declareInput("IN_A_LESS_B");
+	inEqualPin = declareInput("IN_A_EQUAL_B");
+	inGreaterPin = declareInput("IN_A_GREATER_B");
+	inLessPin = declareInput("IN_A_LESS_B");
 
 	// Input busses are declared by Gate_N_INPUT and in setParams():
 	setParameter("INPUT_BITS", "0");
 
 	// The outputs:
-	declareOutput("A_EQUAL_B");
-	declareOutput("A_GREATER_B");
-	declareOutput("A_LESS_B");
+	equalPin = declareOutput("A_EQUAL_B");
+	greaterPin = declareOutput("A_GREATER_B");
+	lessPin = declareOutput("A_LESS_B");
 }
 
 
 // Handle gate events:
 void Gate_COMPARE::gateProcess( void ) {
-	unsigned long inA = bus_to_ulong( getInputBusState("IN") );
-	unsigned long inB = bus_to_ulong( getInputBusState("IN_B") );
+	BusWord inA = getInputBusValue(inPins).value;
+	BusWord inB = getInputBusValue(inBPins).value;
 
 	StateType equal = ZERO;
 	StateType less = ZERO;
 	StateType greater = ZERO;
 
 	if( inA == inB ) {
-		if( getInputState("IN_A_GREATER_B") == ONE ) {
+		if( getInputState(inGreaterPin) == ONE ) {
 			greater = ONE;
-		} else if( getInputState("IN_A_LESS_B") == ONE ) {
+		} else if( getInputState(inLessPin) == ONE ) {
 			less = ONE;
-		} else if( getInputState("IN_A_EQUAL_B") != ZERO ) {
+		} else if( getInputState(inEqualPin) != ZERO ) {
 			equal = ONE;
 		}
 	} else if( inA < inB ) {
@@ -2129,9 +2684,9 @@ void Gate_COMPARE::gateProcess( void ) {
 	}
 	
 	// Set the output values:
-	setOutputState("A_EQUAL_B", equal);
-	setOutputState("A_LESS_B", less);
-	setOutputState("A_GREATER_B", greater);
+	setOutputState(equalPin, equal);
+	setOutputState(lessPin, less);
+	setOutputState(greaterPin, greater);
 }
 
 
@@ -2158,6 +2713,13 @@ bool Gate_COMPARE::setParameter( string paramName, string value ) {
 }
 
 
+// Look up the input busses:
+void Gate_COMPARE::resolvePins( void ) {
+	Gate_N_INPUT::resolvePins();
+	inBPins = getInputBus( "IN_B" );
+}
+
+
 // **************************** END Comparator GATE ***********************************
 
 
@@ -2165,16 +2727,16 @@ bool Gate_COMPARE::setParameter( string paramName, string value ) {
 
 Gate_JKFF::Gate_JKFF() : Gate() {
 	// Declare the inputs:
-	declareInput("CLOCK", true);
-	declareInput("J");
-	declareInput("K");
+	clockPin = declareInput("CLOCK", true);
+	jPin = declareInput("J");
+	kPin = declareInput("K");
 
-	declareInput("SET");
-	declareInput("CLEAR");
+	setPin = declareInput("SET");
+	clearPin = declareInput("CLEAR");
 
 	// The outputs:
-	declareOutput("Q");
-	declareOutput("NQ");
+	qPin = declareOutput("Q");
+	nqPin = declareOutput("NQ");
 
 	// The default state:
 	currentState = ZERO;
@@ -2188,20 +2750,20 @@ Gate_JKFF::Gate_JKFF() : Gate() {
 // Handle gate events:
 void Gate_JKFF::gateProcess( void ) {
 	// Get the input values (Unknown types are assumed as ZERO!):
-	bool J = (getInputState("J") == ONE);
-	bool K = (getInputState("K") == ONE);
-	bool set = (getInputState("SET") == ONE);
-	bool clear = (getInputState("CLEAR") == ONE);
+	bool J = (getInputState(jPin) == ONE);
+	bool K = (getInputState(kPin) == ONE);
+	bool set = (getInputState(setPin) == ONE);
+	bool clear = (getInputState(clearPin) == ONE);
 
 	if( clear ) {
-		if( (syncClear && isRisingEdge("CLOCK")) || !syncClear ) {
+		if( (syncClear && isRisingEdge(clockPin)) || !syncClear ) {
 			currentState = ZERO;
 		}
 	} else if( set ) {
-		if( (syncSet && isRisingEdge("CLOCK")) || !syncSet ) {
+		if( (syncSet && isRisingEdge(clockPin)) || !syncSet ) {
 			currentState = ONE;
 		}
-	} else if( isRisingEdge("CLOCK") ) {
+	} else if( isRisingEdge(clockPin) ) {
 		if( !J && !K ) {
 			currentState = currentState; // Hold
 		} else if( !J && K ) {
@@ -2213,8 +2775,8 @@ void Gate_JKFF::gateProcess( void ) {
 		}
 	}
 	// Set the output values:
-	setOutputState("Q", currentState);
-	setOutputState("NQ", (currentState == ONE) ? ZERO : ONE);
+	setOutputState(qPin, currentState);
+	setOutputState(nqPin, (currentState == ONE) ? ZERO : ONE);
 }
 
 
@@ -2264,15 +2826,15 @@ string Gate_JKFF::getParameter( string paramName ) {
 
 Gate_TFF::Gate_TFF() : Gate() {
 	// Declare the inputs:
-	declareInput("CLOCK", true);
-	declareInput("T");
+	clockPin = declareInput("CLOCK", true);
+	tPin = declareInput("T");
 
-	declareInput("SET");
-	declareInput("CLEAR");
+	setPin = declareInput("SET");
+	clearPin = declareInput("CLEAR");
 
 	// The outputs:
-	declareOutput("Q");
-	declareOutput("NQ");
+	qPin = declareOutput("Q");
+	nqPin = declareOutput("NQ");
 
 	// The default state:
 	currentState = ZERO;
@@ -2286,20 +2848,20 @@ Gate_TFF::Gate_TFF() : Gate() {
 // Handle gate events:
 void Gate_TFF::gateProcess(void) {
 	// Get the input values (Unknown types are assumed as ZERO!):
-	bool T = (getInputState("T") == ONE);
-	bool set = (getInputState("SET") == ONE);
-	bool clear = (getInputState("CLEAR") == ONE);
+	bool T = (getInputState(tPin) == ONE);
+	bool set = (getInputState(setPin) == ONE);
+	bool clear = (getInputState(clearPin) == ONE);
 
 	if (clear) {
-		if ((syncClear && isRisingEdge("CLOCK")) || !syncClear) {
+		if ((syncClear && isRisingEdge(clockPin)) || !syncClear) {
 			currentState = ZERO;
 		}
 	}
 	else if (set) {
-		if ((syncSet && isRisingEdge("CLOCK")) || !syncSet) {
+		if ((syncSet && isRisingEdge(clockPin)) || !syncSet) {
 			currentState = ONE;
 		}
-	} else if (isRisingEdge("CLOCK")) {
+	} else if (isRisingEdge(clockPin)) {
 		if ( !T ) {
 			currentState = currentState; // Hold
 		} else if ( T ) {
@@ -2307,8 +2869,8 @@ void Gate_TFF::gateProcess(void) {
 		}
 	}
 	// Set the output values:
-	setOutputState("Q", currentState);
-	setOutputState("NQ", (currentState == ONE) ? ZERO : ONE);
+	setOutputState(qPin, currentState);
+	setOutputState(nqPin, (currentState == ONE) ? ZERO : ONE);
 }
 
 
@@ -2361,17 +2923,19 @@ Gate_RAM::Gate_RAM( ) : Gate() {
 	// Declare the stationary pins:
 	// Pedro Casanova (casanova@ujaen.es) 2020/04-12
 	// Uppercase
-	declareInput( "WRITE_CLOCK", true );
-	declareInput( "WRITE_ENABLE" );
+	writeClockPin = declareInput( "WRITE_CLOCK", true );
+	writeEnablePin = declareInput( "WRITE_ENABLE" );
 
 	// Pedro Casanova (casanova@ujaen.es) 2021/01-03
 	// Added ENABLE input
-	declareInput("ENABLE");
+	enablePin = declareInput("ENABLE");
+	outputEnablePin = findInput("OUTPUT_ENABLE");
 	
 	// NOTE: None of the other pins are declared in advance!
 	// They are created in setParameter, because they depend on the RAM's size!
 
 	// Set the RAM's default size:	
+	addressBits = dataBits = 0;
 	setParameter( "ADDRESS_BITS", "0" );
 	setParameter( "DATA_BITS", "0" );
 	
@@ -2383,7 +2947,9 @@ Gate_RAM::Gate_RAM( ) : Gate() {
 	// Bidirectional data lines	
 	bidirectionalDATA = false;
 
-	lastRead = (unsigned long)-1;
+	lastRead = (BusWord)-1;
+	lastWritten = (BusWord)-1;
+	memoryChangeListed = false;
 }
 
 
@@ -2393,14 +2959,14 @@ void Gate_RAM::gateProcess(void) {
 	// Don't do the process unless there are address and data lines declared!
 	if ((addressBits == 0) || (dataBits == 0)) return;
 
-	unsigned long address = bus_to_ulong(getInputBusState("ADDRESS"));
+	BusWord address = getInputBusValue(addressPins).value;
 	// Pedro Casanova (casanova@ujaen.es) 2020/04-12
 	// Bidirectional BUS, no DATA_IN pins nedeed
-	unsigned long dataIn;
+	BusWord dataIn;
 	if (bidirectionalDATA)
-		dataIn = bus_to_ulong(getOutputBusWireState("DATA_OUT"));
+		dataIn = getOutputBusWireValue(dataOutPins).value;
 	else
-		dataIn = bus_to_ulong(getInputBusState("DATA_IN"));
+		dataIn = getInputBusValue(dataInPins).value;
 
 	//***********************************************************************
 	//Edit by Joshua Lansford 12/31/06
@@ -2409,14 +2975,10 @@ void Gate_RAM::gateProcess(void) {
 	//   data.  Thus instead a flag is set and we update the gui now
 	if (flushGuiMemory) {
 		flushGuiMemory = false;
-		listChangedParam("MemoryReset");
-		for (map< unsigned long, unsigned long >::iterator I = memory.begin();
-			I != memory.end();  ++I) {
-			ostringstream virtualPropertyName;
-			virtualPropertyName << "Address:";
-			virtualPropertyName << I->first; //we just list the address
-			listChangedParam(virtualPropertyName.str());
-		}
+		// (The whole memory goes in one parameter, rather than one per
+		// address, and takes the place of the blocks written so far.)
+		listChangedParam("MemoryReloaded");
+		memory.clearDirty();
 	}
 	//End of Edit************************************************************
 
@@ -2424,54 +2986,44 @@ void Gate_RAM::gateProcess(void) {
 		// WRITE_ENABLE Now uppercase
 		// Pedro Casanova (casanova@ujaen.es) 2021/01-03
 		// Added ENABLE input
-	if ((getInputState("WRITE_ENABLE") == ONE) && (getInputState("ENABLE") != ZERO)) {
+	if ((getInputState(writeEnablePin) == ONE) && (getInputState(enablePin) != ZERO)) {
 		// HI_Z all of the data outputs:
-		vector< StateType > allHI_Z(dataBits, HI_Z);
-		setOutputBusState("DATA_OUT", allHI_Z);
+		setDataHI_Z();
 		// Pedro Casanova (casanova@ujaen.es) 2020/04-12
 		// WRITE_CLOCK Now Uppercase
-		if ((isRisingEdge("WRITE_CLOCK") && syncWR) || !syncWR) {
-			// Write to the RAM.
-			memory[address] = dataIn;
-			ostringstream oss;
-			oss << "Wroted to the memory thing: Address = " << address << ", data = " << dataIn;
-			WARNING(oss.str().c_str());
-			//***********************************************************************
-			//Edit by Joshua Lansford 12/31/06
-			//Purpose of edit:  The Cedar-logic ram gate is being expanded to
-			//have a popup that shows the contents of the memory
-			//therefore it is necisary for the logic gate to tell the gui gate
-			//every time data changes in it.
-			ostringstream virtualPropertyName;
-			virtualPropertyName << "Address:";
-			virtualPropertyName << address;
-			listChangedParam(virtualPropertyName.str());
-			//End of edit************************************************************
+		if (((isRisingEdge(writeClockPin) && syncWR) || !syncWR) && memory.write(address, dataIn)) {
+			// Write to the RAM. (The GUI gets the changed words in blocks,
+			// once the steps are done; see takeMemoryChanges().)
+			lastWritten = address;
 		}
 	}
 	else {
 		// Pedro Casanova (casanova@ujaen.es) 2021/01-03
 		// Added ENABLE input
-		if (getInputState("ENABLE") != ZERO) {
+		if (getInputState(enablePin) != ZERO) {
 			// Read from the RAM, and write the data to the outputs.
-			vector< StateType > ramReadData = ulong_to_bus(memory[address], dataBits);
-			setOutputBusState("DATA_OUT", ramReadData);
+			setOutputBusValue(dataOutPins, BusValue(memory.read(address), dataBits));
 		} else {
 			// HI_Z all of the data outputs:
-			vector< StateType > allHI_Z(dataBits, HI_Z);
-			setOutputBusState("DATA_OUT", allHI_Z);
+			setDataHI_Z();
 		}
 		//***********************************************************************
 		//Edit by Joshua Lansford 4/22/06
 		//Purpose of edit:  This allerts the pop-up when ever an address has changed
 		// Pedro Casanova (casanova@ujaen.es) 2020/04-12
 		// To permit ENABLE without BUS, ENABLE_0 now is OUTPUT_ENABLE
-		if ((getInputState("OUTPUT_ENABLE") == ONE) && (getInputState("ENABLE") != ZERO)) {
+		if ((getInputState(outputEnablePin) == ONE) && (getInputState(enablePin) != ZERO)) {
 			lastRead = address;
 			listChangedParam("lastRead");
 		}
 		//End of edit******************************************************
 	}
+
+	// Let the Circuit know that there are words for the GUI:
+	if (memory.isDirty() && !memoryChangeListed) {
+		memoryChangeListed = true;
+		ourCircuit->addMemoryChange(myID);
+	}
 }
 
 // Set the parameters:
@@ -2491,6 +3043,8 @@ bool Gate_RAM::setParameter( string paramName, string value ) {
 		return true;
 	} else if( paramName == "ADDRESS_BITS" ) {
 		iss >> addressBits;
+		memory.setSize( addressBits, dataBits );
+		writePendingWords();
 
 		// Declare the address pins!		
 		if( addressBits > 0 ) {
@@ -2502,6 +3056,8 @@ bool Gate_RAM::setParameter( string paramName, string value ) {
 		// anything is connected anyhow!
 	} else if( paramName == "DATA_BITS" ) {
 		iss >> dataBits;
+		memory.setSize( addressBits, dataBits );
+		writePendingWords();
 
 		// Declare the data input and output pins!
 		if( dataBits > 0 ) {
@@ -2512,6 +3068,17 @@ bool Gate_RAM::setParameter( string paramName, string value ) {
 		// Pedro Casanova (casanova@ujaen.es) 2020/04-12
 		// Added Clear Button
 		memory.clear();
+		pendingWords.clear();
+		flushGuiMemory = true;
+		return true;
+	} else if( paramName == "IMAGE_FILE" ) {
+		// Keep the memory in a memory-mapped image file, or stop if
+		// there is no file name:
+		if( value.empty() ) {
+			memory.unmapImage();
+		} else if( !memory.mapImage( value ) ) {
+			WARNING( ( "Gate_RAM::setParameter() - " + memory.getImageError() ).c_str() );
+		}
 		flushGuiMemory = true;
 		return true;
 	} else if( paramName == "WRITE_FILE" ) {
@@ -2538,18 +3105,21 @@ bool Gate_RAM::setParameter( string paramName, string value ) {
 	//down to the core by editing cells
 	} else if( paramName.substr( 0, 8 ) == "Address:" ){
 		istringstream addressExtractor( paramName.substr( 8 ) );
-		unsigned long addressOfNewData = 0;
+		BusWord addressOfNewData = 0;
 		addressExtractor >> addressOfNewData;
 		
-		unsigned long newData;
+		BusWord newData;
 		iss >> newData;
 		
-		if( memory[ addressOfNewData ] != newData ){
-			memory[ addressOfNewData ] = newData;
-			//now we will re list the param so
-			//that the change will bounce back up into
-			//the pop-up.
-			listChangedParam( paramName );
+		if( ( addressBits == 0 ) || ( dataBits == 0 ) || ( addressOfNewData > memory.getAddressMask() ) ) {
+			pendingWords[addressOfNewData] = newData;
+			return true;
+		}
+
+		// (The change bounces back up into the pop-up with the
+		// memory changes, once the gate has been updated.)
+		if( memory.write( addressOfNewData, newData ) ){
+			lastWritten = addressOfNewData;
 		}
 		return true;
 	//********************************************
@@ -2591,9 +3161,9 @@ string Gate_RAM::getParameter(string paramName) {
 //every time data changes in it.
 	} else if( paramName.substr( 0, 8 ) == "Address:" ){
 		istringstream iss( paramName.substr( 8 ) );
-		unsigned long addressOfDataToReturn = 0;
+		BusWord addressOfDataToReturn = 0;
 		iss >> addressOfDataToReturn;
-		unsigned long dataToReturn = memory[ addressOfDataToReturn ];
+		BusWord dataToReturn = memory.read( addressOfDataToReturn );
 		ostringstream oss;
 		oss << dataToReturn;
 		
@@ -2601,6 +3171,23 @@ string Gate_RAM::getParameter(string paramName) {
 		return oss.str();
 	}else if( paramName == "MemoryReset" ){
 		return "true";
+	} else if( paramName == "MemoryReloaded" ) {
+		// All of the words that aren't 0, as "count address data address
+		// data ..." in hex. (The GUI takes the rest to be 0.)
+		ostringstream words;
+		words << hex;
+		unsigned long count = 0;
+		BusWord address = 0;
+		while( memory.findNonZero( address ) ) {
+			words << ' ' << address << ' ' << memory.read( address );
+			count++;
+			if( address == memory.getAddressMask() ) break;
+			address++;
+		}
+		oss << hex << count << words.str();
+		return oss.str();
+	} else if( paramName == "IMAGE_FILE" ) {
+		return memory.getImageFile();
 //End of edit************************************************************
 	//********************************
 	//Edit by Joshua Lansford 4/22/07
@@ -2615,6 +3202,41 @@ string Gate_RAM::getParameter(string paramName) {
 	}
 }
 
+// Write the "Address:" words that now fit in the RAM:
+void Gate_RAM::writePendingWords( void ) {
+	if( ( addressBits == 0 ) || ( dataBits == 0 ) ) return;
+
+	map< BusWord, BusWord >::iterator word = pendingWords.begin();
+	while( word != pendingWords.end() && word->first <= memory.getAddressMask() ) {
+		memory.write( word->first, word->second );
+		pendingWords.erase( word++ );
+	}
+}
+
+// Give the GUI the words that were written:
+bool Gate_RAM::takeMemoryChanges( RamChanges &changes ) {
+	memoryChangeListed = false;
+	if( !memory.isDirty() ) return false;
+
+	changes.lastWritten = lastWritten;
+	memory.takeDirtyBlocks( changes.blocks );
+	return true;
+}
+
+// Look up the address and data busses:
+void Gate_RAM::resolvePins( void ) {
+	addressPins = getInputBus( "ADDRESS" );
+	dataInPins = getInputBus( "DATA_IN" );
+	dataOutPins = getOutputBus( "DATA_OUT" );
+}
+
+// HI_Z all of the data outputs:
+void Gate_RAM::setDataHI_Z( void ) {
+	for( unsigned long i = 0; i < dataBits; i++ ) {
+		setOutputState( dataOutPins[i], HI_Z );
+	}
+}
+
 // Write a file containing the memory data:
 void Gate_RAM::outputMemoryFile( string fName ) {
 	ofstream oFile( fName.c_str() );
@@ -2633,24 +3255,82 @@ void Gate_RAM::outputMemoryFile( string fName ) {
 	oFile << "# Note that if a memory location is not represented here," << endl;
 	oFile << "# then it is assumed to contain the data value \"0\"" << endl << endl;
 	
-	// Loop through all of the memory locations that have been written or read and dump the memory data:
-	map< unsigned long, unsigned long >::iterator memLoc = memory.begin();
-	while( memLoc != memory.end() ) {
+	// Loop through all of the memory locations that aren't 0 and dump the memory data:
+	BusWord address = 0;
+	while( memory.findNonZero( address ) ) {
 		// Format: "hex_address : hex_data"
 		// (Do uppercase hex characters.)
 		oFile.setf(ios::hex, ios::basefield);
 		oFile.setf(ios::uppercase);
-		oFile << hex << (memLoc->first) << " : " << hex << (memLoc->second) << endl;
-		memLoc++;
+		oFile << hex << address << " : " << hex << memory.read( address ) << endl;
+		if( address == memory.getAddressMask() ) break;
+		address++;
 	}
 	
 	oFile.close();
 }
 
+// Read all of a file into "contents" in one go:
+static bool readWholeFile( const string &fName, string &contents ) {
+	ifstream iFile( fName.c_str(), ios::in | ios::binary );
+	if( !iFile ) return false;
+
+	iFile.seekg( 0, ios::end );
+	streamoff fileSize = iFile.tellg();
+	iFile.seekg( 0, ios::beg );
+	if( fileSize < 0 ) return false;
+
+	contents.resize( (size_t) fileSize );
+	if( fileSize > 0 ) iFile.read( &contents[0], fileSize );
+	return !iFile.fail();
+}
+
+// The value of each character as a hex digit, or NOT_HEX:
+static const unsigned char NOT_HEX = 0xFF;
+static struct HexDigitTable {
+	unsigned char value[256];
+
+	HexDigitTable() {
+		for( int c = 0; c < 256; c++ ) value[c] = NOT_HEX;
+		for( int c = '0'; c <= '9'; c++ ) value[c] = c - '0';
+		for( int c = 'A'; c <= 'F'; c++ ) value[c] = c - 'A' + 10;
+		for( int c = 'a'; c <= 'f'; c++ ) value[c] = c - 'a' + 10;
+	};
+} hexDigits;
+
+// Read exactly "numDigits" hex digits from "text" at "pos". Returns false
+// if there aren't that many:
+static bool readHexDigits( const string &text, size_t &pos, int numDigits, unsigned long &number ) {
+	if( pos + numDigits > text.size() ) return false;
+	number = 0;
+	for( int i = 0; i < numDigits; i++ ) {
+		unsigned char digit = hexDigits.value[(unsigned char) text[pos + i]];
+		if( digit == NOT_HEX ) return false;
+		number = ( number << 4 ) | digit;
+	}
+	pos += numDigits;
+	return true;
+}
+
+// Read a hex number (with an optional "0x") from "text" at "pos", before
+// "end", after any spaces. Returns false if there isn't one:
+static bool readHexNumber( const string &text, size_t &pos, size_t end, BusWord &number ) {
+	while( pos < end && ( text[pos] == ' ' || text[pos] == '\t' ) ) pos++;
+	if( pos + 1 < end && text[pos] == '0' && ( text[pos + 1] == 'x' || text[pos + 1] == 'X' ) ) pos += 2;
+
+	size_t start = pos;
+	number = 0;
+	while( pos < end && hexDigits.value[(unsigned char) text[pos]] != NOT_HEX ) {
+		number = ( number << 4 ) | hexDigits.value[(unsigned char) text[pos]];
+		pos++;
+	}
+	return pos > start;
+}
+
 // Read a file and load the memory data:
 void Gate_RAM::inputMemoryFile( string fName ) {
-	ifstream iFile( fName.c_str() );
-	if(!iFile) {
+	string contents;
+	if( !readWholeFile( fName, contents ) ) {
 		WARNING("Gate_RAM::inputMemoryFile() - Couldn't open the memory file for reading.");
 		return;
 	}
@@ -2666,27 +3346,27 @@ void Gate_RAM::inputMemoryFile( string fName ) {
 	flushGuiMemory = true;
 //End of edit*********************************************
 
-	string temp;
-	istringstream theLine;
-	unsigned long address = 0, data = 0;
-	char dump;
-	while (!iFile.eof()) {
-	    getline(iFile, temp, '\n');
-	    if (temp[0] != '#') {
-	    	// This line is a legitimate parseable line - not a comment line.
-	    	
-	    	// Try to parse the line:
-	    	theLine.clear();
-
-	    	
-	    	theLine.str(temp);
-			theLine.setf(ios::hex, ios::basefield); // The input data is in hex format
-	    	theLine >> address >> dump >> data;
-	    	if(!theLine.fail()) {
-	    		// If the line parsed correctly, then set the memory value:
-	    		memory[address] = data & ((int)pow((float)2, (int)dataBits) - 1);
-	    	}
-	    }
+	size_t lineStart = 0;
+	while( lineStart < contents.size() ) {
+		size_t lineEnd = contents.find( '\n', lineStart );
+		if( lineEnd == string::npos ) lineEnd = contents.size();
+
+		if( contents[lineStart] != '#' ) {
+			// This line is a legitimate parseable line - not a comment line.
+			// Its format is "hex_address : hex_data" (with any character
+			// between the numbers):
+			size_t pos = lineStart;
+			BusWord address = 0, data = 0;
+			if( readHexNumber( contents, pos, lineEnd, address ) ) {
+				while( pos < lineEnd && isspace( (unsigned char) contents[pos] ) ) pos++;
+				pos++;
+				if( pos < lineEnd && readHexNumber( contents, pos, lineEnd, data ) ) {
+					// If the line parsed correctly, then set the memory value:
+					memory.write( address, data );
+				}
+			}
+		}
+		lineStart = lineEnd + 1;
 	}
 }
 
@@ -2696,88 +3376,100 @@ void Gate_RAM::inputMemoryFile( string fName ) {
 //also load Intel Hex files.  This is a format
 //which is exported by the zad assembler.
 void Gate_RAM::inputMemoryFileFromIntelHex( string fName ){
-	ifstream fin( fName.c_str(), ios::in );
-	
-	bool endOfFile = false;
-	char temp = '0';
-	int byteCount = 0;
-	int nextByte = 0;
-	int addressPointer = 0;
-	int recordType = 0;
-	
-	if( fin ){
+	string contents;
+	if( !readWholeFile( fName, contents ) ) {
 		//check to make sure the file actually exists before
 		//we blow our last data
-		memory.clear();
-		flushGuiMemory = true;
-	}else{
-		//TODO: This needs to be able to become visible to the
-		//user somehow.  An idea would be to make an error property
-		//that gets displayed in an allert box when it changes.
-		cout << "Error reading file.  Empty or non-existant?" << endl;
+		WARNING("Gate_RAM::inputMemoryFileFromIntelHex() - Couldn't open the memory file for reading.");
+		return;
 	}
-	
-	while( !endOfFile && fin ){
+	memory.clear();
+	flushGuiMemory = true;
+
+	// The address that the record addresses are added to, from the
+	// extended address records:
+	BusWord baseAddress = 0;
+	bool checksumsGood = true;
+
+	// The data bytes of a record, decoded while its checksum is added up:
+	vector< unsigned long > recordBytes;
+
+	size_t pos = 0;
+	bool endOfFile = false;
+	while( !endOfFile ){
+		// Skip the line breaks between records:
+		while( pos < contents.size() && isspace( (unsigned char) contents[pos] ) ) pos++;
+		if( pos >= contents.size() ) break;
+
 		//here we will process a record
 		//first we make sure that the first character is a ":"
-		fin >> temp;
-		if( temp == ':' ){
-			byteCount = readInHex( &fin, 2 );
-			addressPointer = readInHex( &fin, 4 );
-			recordType = readInHex( &fin, 2 );
-			
-			switch( recordType ){
-				case DATA_RECORD_HEX:
-					for( int byteNum = 0; byteNum < byteCount; ++byteNum ){
-						nextByte = readInHex( &fin, 2 );
-						memory[addressPointer + byteNum] = nextByte & ((int)pow((float)2, (int)dataBits) - 1);
-					}
-				
-					break;
-				case END_OF_FILE_HEX:
-					endOfFile = true;
-					break;
-				default:
-					//TODO: cout doesn't cut the cheeze
-					cout << "Unexpected record type: " << recordType << endl;
-					endOfFile = true;
-					break;
+		if( contents[pos] != ':' ){
+			WARNING("Gate_RAM::inputMemoryFileFromIntelHex() - Expected ':'");
+			break;
+		}
+		pos++;
+
+		unsigned long byteCount, addressPointer, recordType, nextByte, checksum;
+		if( !readHexDigits( contents, pos, 2, byteCount ) || !readHexDigits( contents, pos, 4, addressPointer )
+			|| !readHexDigits( contents, pos, 2, recordType ) ){
+			WARNING("Gate_RAM::inputMemoryFileFromIntelHex() - Non hex character in a record.");
+			break;
+		}
+		unsigned long sum = byteCount + ( addressPointer >> 8 ) + addressPointer + recordType;
+
+		// The data bytes, as a number for the address records:
+		BusWord recordValue = 0;
+		bool recordGood = true;
+		recordBytes.clear();
+		for( unsigned long byteNum = 0; byteNum < byteCount; ++byteNum ){
+			if( !readHexDigits( contents, pos, 2, nextByte ) ){
+				recordGood = false;
+				break;
 			}
-			
-			//dump checksum
-			readInHex( &fin, 2 );
-		}else{
-			//TODO: cout doesn't cut the cheeze
-			cout << "Error reading file: Expected ':'" << endl;
-			endOfFile = true;
+			sum += nextByte;
+			recordValue = ( recordValue << 8 ) | nextByte;
+			recordBytes.push_back( nextByte );
 		}
-	}
-	
-	fin.close();
-}
-
-//helper function that allows reading in hex files
-int Gate_RAM::readInHex( ifstream* fin, int numChars ){
-	int result = 0;
-	char nextChar = '0';
-	int charValue = 0;
-	for( int i = 0; i < numChars; ++i ){
-		(*fin) >> nextChar;
-		if( nextChar >= '0' && nextChar <= '9' ){
-			charValue = nextChar - '0';
-		}else if( nextChar >= 'A' && nextChar <= 'F' ){
-			charValue = nextChar - 'A' + 10;
-		}else if( nextChar >= 'a' && nextChar <= 'f' ){
-			charValue = nextChar - 'a' + 10;
-		}else{
-			//TODO: cout doesn't cut the cheeze
-			cout << "non hex character in stream: " << nextChar << endl;
-			charValue = 0;
+		if( !recordGood || !readHexDigits( contents, pos, 2, checksum ) ){
+			WARNING("Gate_RAM::inputMemoryFileFromIntelHex() - Non hex character in a record.");
+			break;
+		}
+		if( ( ( sum + checksum ) & 0xFF ) != 0 ){
+			checksumsGood = false;
+		}
+
+		switch( recordType ){
+			case DATA_RECORD_HEX:
+				for( unsigned long byteNum = 0; byteNum < byteCount; ++byteNum ){
+					memory.write( baseAddress + addressPointer + byteNum, recordBytes[byteNum] );
+				}
+				break;
+			case END_OF_FILE_HEX:
+				endOfFile = true;
+				break;
+			case EXT_SEGMENT_ADDRESS_HEX:
+				baseAddress = recordValue << 4;
+				break;
+			case EXT_LINEAR_ADDRESS_HEX:
+				baseAddress = recordValue << 16;
+				break;
+			case START_SEGMENT_ADDRESS_HEX:
+			case START_LINEAR_ADDRESS_HEX:
+				// (A RAM has no start address.)
+				break;
+			default: {
+				ostringstream oss;
+				oss << "Gate_RAM::inputMemoryFileFromIntelHex() - Unexpected record type: " << recordType;
+				WARNING(oss.str().c_str());
+				endOfFile = true;
+				break;
+			}
 		}
-		result <<= 4;
-		result |= charValue;
 	}
-	return result;
+
+	if( !checksumsGood ){
+		WARNING("Gate_RAM::inputMemoryFileFromIntelHex() - The file has records with bad checksums.");
+	}
 }
 	
 //End of edit**************************************
@@ -3000,7 +3692,7 @@ Gate_T::Gate_T( Circuit *newCircuit ) : Gate() {
 	// Declare the gate inputs and output:
 	declareInput( "T_IN" );
 	declareInput( "T_IN2" );
-	declareInput( "T_CTRL" );
+	ctrlPin = declareInput( "T_CTRL" );
 }
 
 
@@ -3021,7 +3713,7 @@ void Gate_T::gateProcess( void ) {
 	bool juncNewState = false;
 
 	// Check the control input to determine the output:
-	StateType ctrlValue = getInputState("T_CTRL");
+	StateType ctrlValue = getInputState(ctrlPin);
 	if( ctrlValue == ONE ) {
 		juncNewState = true;
 	}
@@ -3259,11 +3951,11 @@ string Gate_BUSEND::getParameter(string paramName) {
 //gate goes high, then it will pause the simulation.  This takes
 //avantage of the pauseing hooks that I had to create for the Z80.
 Gate_pauseulator::Gate_pauseulator() : Gate(){
-	declareInput( "SIGNAL", true );	
+	signalPin = declareInput( "SIGNAL", true );	
 }
 
 void Gate_pauseulator::gateProcess( void ) {
-	if( isRisingEdge( "SIGNAL" ) ){
+	if( isRisingEdge( signalPin ) ){
 		listChangedParam( "PAUSE_SIM" );
 	}
 }
@@ -3289,67 +3981,50 @@ string Gate_pauseulator::getParameter( string paramName ) {
 // ******************************** FSM GATE ***********************************
 // Pedro Casanova (casanova@ujaen.es) 2021/01-03
 // Implement Finite State Machines
+const unsigned long Gate_FSM_SYNC::STATE_NONE;
+const unsigned long Gate_FSM_SYNC::MAX_TABLE_BITS;
+
 Gate_FSM_SYNC::Gate_FSM_SYNC() : Gate() {
 	definedIO = 0;
 
 	// Declare the inputs:
-	declareInput("CLOCK", true);
-	declareInput("CLEAR");
+	clockPin = declareInput("CLOCK", true);
+	clearPin = declareInput("CLEAR");
 
 	// Set the default settings:
+	inBits = outBits = 0;
+	tableBits = 0;
+	resetState = STATE_NONE;
 	setParameter("CURRENT_STATE", "");
 	asyncrhonous = false;
-	resetState = "";
-	currentOutput = "";
 	return;
 }
 
 // Handle gate events:
 void Gate_FSM_SYNC::gateProcess(void) {
-	vector< StateType > outBus;
-	vector< StateType > inputBus = getInputBusState("IN");
-	string oldCurrentState = currentState;
-
-	string oldOutputValue = currentOutput;
+	unsigned long oldCurrentState = currentState;
 
-	if (currentState == "")
+	// A state that isn't defined (or no state yet) starts from the reset state:
+	if (!isDefined(currentState) && isDefined(resetState))
 		currentState = resetState;
-	for (unsigned long i = 0; i < inputBus.size(); i++)
-		if ((inputBus[i] == CONFLICT) || (inputBus[i] == HI_Z))	inputBus[i] = UNKNOWN;
-	unsigned long currentInputs = 0;
-	if (inBits>0)
-		currentInputs = bus_to_ulong(inputBus);
-	unsigned long outputVal = 0;
-	if (states.size()>0) {
-		if (getInputState("CLEAR") == ONE)				// Reset
+
+	if (isDefined(currentState)) {
+		// (The inputs that aren't ONE read as 0.)
+		BusWord currentInputs = getInputBusValue(inPins).value & BusValue::mask(tableBits);
+		unsigned long newState;
+		BusWord outputWord;
+		if (getInputState(clearPin) == ONE)				// Reset
 			currentState = resetState;
-		else {
-			string newState;
-			if (asyncrhonous)											// Asynchronous
-				newState = nextState[currentState][currentInputs];
-			else if (isRisingEdge("CLOCK"))								// Synchronous
-				newState = nextState[currentState][currentInputs];
-
-			for(unsigned long i=0;i<states.size();i++)
-				if (states[i] == newState) {
-					currentState = newState;
-					break;
-				}
+		else if (asyncrhonous || isRisingEdge(clockPin)) {	// Asynchronous or Synchronous
+			// (A transition to a state that isn't defined is ignored.)
+			lookUp(currentState, currentInputs, newState, outputWord);
+			if (isDefined(newState))
+				currentState = newState;
+		}
+		if (isDefined(currentState)) {
+			lookUp(currentState, currentInputs, newState, outputWord);
+			setOutputBusValue(outPins, BusValue(outputWord, outBits));
 		}
-		currentOutput = outputs[currentState][currentInputs];
-		for (unsigned long i = 0; i < currentOutput.length(); i++)
-			if (i<outBits)
-				if (currentOutput.c_str()[currentOutput.length() - i - 1] == '1')
-					outputVal += pow(2, i);
-		outBus = ulong_to_bus(outputVal, outBits);
-	} else {
-		for (unsigned long i = 0; i < outBus.size(); i++)
-			outBus[i] = UNKNOWN;
-	}
-
-	if (currentOutput != oldOutputValue) {
-		currentOutput = oldOutputValue;
-		if (outBus.size() != 0) setOutputBusState("OUT", outBus);
 	}
 
 	if (currentState != oldCurrentState) listChangedParam("CURRENT_STATE");
@@ -3360,17 +4035,21 @@ bool Gate_FSM_SYNC::setParameter(string paramName, string value) {
 	istringstream iss(value);
 	_MSG("%s %s",paramName.c_str(),value.c_str())
 	if (paramName == "CLEAR_FSM") {
-		states.clear();
-		outputs.clear();
-		nextState.clear();
+		stateNames.clear();
+		stateNumbers.clear();
+		stateDefined.clear();
+		nextStates.clear();
+		outputWords.clear();
+		transitionLists.clear();
 		paramStates.clear();
-		resetState = "";
-		currentState = "";
-		currentOutput = "";
+		resetState = STATE_NONE;
+		currentState = STATE_NONE;
 		return true;
 	}
 	if (paramName == "CURRENT_STATE") {
-		iss >> currentState;
+		string stateName;
+		iss >> stateName;
+		currentState = stateNumber(stateName);
 		return true;
 	}
 	if (paramName == "OUTPUT_BITS") {
@@ -3412,7 +4091,7 @@ bool Gate_FSM_SYNC::setParameter(string paramName, string value) {
 string Gate_FSM_SYNC::getParameter(string paramName) {
 	ostringstream oss;
 	if (paramName == "CURRENT_STATE") {
-		oss << currentState;
+		if (currentState != STATE_NONE) oss << stateNames[currentState];
 		return oss.str();
 	}
 	if (paramName == "OUTPUT_BITS") {
@@ -3426,6 +4105,12 @@ string Gate_FSM_SYNC::getParameter(string paramName) {
 	return Gate::getParameter(paramName);
 }
 
+// Look up the input and output busses:
+void Gate_FSM_SYNC::resolvePins( void ) {
+	inPins = getInputBus( "IN" );
+	outPins = getOutputBus( "OUT" );
+}
+
 void Gate_FSM_SYNC::procPendingStates() {
 	map <string,string>::iterator statesWalk = paramStates.begin();
 	while (statesWalk != paramStates.end()) {
@@ -3436,6 +4121,27 @@ void Gate_FSM_SYNC::procPendingStates() {
 	definedIO = 7;
 }
 
+unsigned long Gate_FSM_SYNC::stateNumber(const string &name) {
+	if (name == "") return STATE_NONE;
+	map< string, unsigned long >::iterator found = stateNumbers.find(name);
+	if (found != stateNumbers.end()) return found->second;
+
+	unsigned long number = stateNames.size();
+	stateNames.push_back(name);
+	stateNumbers[name] = number;
+	stateDefined.push_back(false);
+	return number;
+}
+
+// The word of an output string, with its last character as bit 0:
+static BusWord fsmOutputWord(const string &output) {
+	BusWord word = 0;
+	for (unsigned long i = 0; (i < output.length()) && (i < MAX_BUS_BITS); i++)
+		if (output[output.length() - i - 1] == '1')
+			word |= 1ULL << i;
+	return word;
+}
+
 // Process state param string
 void Gate_FSM_SYNC::procState(string paramName, string value) {
 	int pSlash;
@@ -3468,19 +4174,34 @@ void Gate_FSM_SYNC::procState(string paramName, string value) {
 		state = state.substr(0, pSlash);
 	}
 
-	if (nState=="0") resetState = state;
-
-	states.push_back(state);
-
-	vector<string> vect;
-	string ceros = "";
-
-	for (unsigned long i=0;i<pow(2,inBits);i++)
-		vect.push_back(defOutputs);
-	outputs[state] = vect;
-	for (unsigned long i = 0; i < pow(2, inBits); i++)
-		vect[i]= defNextState;
-	nextState[state] = vect;
+	unsigned long number = stateNumber(state);
+	if (number == STATE_NONE) return;
+	if (nState=="0") resetState = number;
+	stateDefined[number] = true;
+
+	// Make room for the state's row of the tables, and fill it with the
+	// defaults:
+	if (nextStates.empty() && transitionLists.empty()) tableBits = inBits;
+	bool inTable = (tableBits <= MAX_TABLE_BITS);
+	size_t rowSize = (size_t) 1 << (inTable ? tableBits : 0);
+	size_t row = inTable ? ((size_t) number << tableBits) : 0;
+	unsigned long defNext = stateNumber(defNextState);
+	BusWord defOutputWord = fsmOutputWord(defOutputs);
+	if (inTable) {
+		if (nextStates.size() < row + rowSize) {
+			nextStates.resize(row + rowSize, STATE_NONE);
+			outputWords.resize(row + rowSize, 0);
+		}
+		for (size_t i = 0; i < rowSize; i++) {
+			nextStates[row + i] = defNext;
+			outputWords[row + i] = defOutputWord;
+		}
+	} else {
+		if (transitionLists.size() <= number) transitionLists.resize(number + 1);
+		transitionLists[number].defNext = defNext;
+		transitionLists[number].defOutputWord = defOutputWord;
+		transitionLists[number].transitions.clear();
+	}
 
 	if (!noInputs)
 		while (!iss.eof()) {
@@ -3489,34 +4210,77 @@ void Gate_FSM_SYNC::procState(string paramName, string value) {
 			pArrow = trans.find('-');
 			pSlash = trans.find('/');
 			string inputValue = trans.substr(0, pArrow);
-			for (unsigned long inputVal = 0; inputVal < pow(2, inputValue.length()); inputVal++)
-			{
-				string binValue="";
-				unsigned long val= inputVal;
-				for (long i = inputValue.length() - 1; i >= 0; i--)
-				{
-					if (val >= pow(2, i)) {
-						val -= pow(2, i);
-						binValue = binValue+ "1";
-					}
-					else
-						binValue = binValue + "0";
-					if (inputValue[inputValue.length()-i-1] == 'X')
-						binValue[binValue.length()-1] = 'X';
-				}
-				if (binValue == inputValue) {
-					if (Moore) {
-						nextState[state][inputVal] = trans.substr(pArrow + 1);
-					}
-					else {
-						outputs[state][inputVal] = trans.substr(pSlash + 1);
-						nextState[state][inputVal] = trans.substr(pArrow + 1, pSlash - pArrow - 1);
-					}
+
+			// The input words that the value matches, MSB first, with X for
+			// either bit. (A value with any other character matches none.)
+			BusWord care = 0, value = 0;
+			bool valid = true;
+			for (unsigned long i = 0; i < inputValue.length(); i++) {
+				unsigned long bit = inputValue.length() - i - 1;
+				char c = inputValue[i];
+				if (c == 'X') continue;
+				if ((c != '0') && (c != '1')) valid = false;
+				else if (bit >= tableBits) valid = valid && (c == '0');
+				else {
+					care |= 1ULL << bit;
+					if (c == '1') value |= 1ULL << bit;
 				}
 			}
+			if (!valid) continue;
+
+			unsigned long next;
+			BusWord outputWord = 0;
+			if (Moore) {
+				next = stateNumber(trans.substr(pArrow + 1));
+			} else {
+				outputWord = fsmOutputWord(trans.substr(pSlash + 1));
+				next = stateNumber(trans.substr(pArrow + 1, pSlash - pArrow - 1));
+			}
+
+			// (The bits past the value's length are 0.)
+			BusWord dontCare = BusValue::mask(min(inputValue.length(), (size_t) tableBits)) & ~care;
+			if (!inTable) {
+				Transition transition;
+				transition.care = BusValue::mask(tableBits) & ~dontCare;
+				transition.value = value;
+				transition.next = next;
+				transition.outputWord = Moore ? defOutputWord : outputWord;
+				transitionLists[number].transitions.push_back(transition);
+				continue;
+			}
+
+			// Walk through the don't care bits:
+			BusWord free = dontCare;
+			while (true) {
+				nextStates[row + (size_t) (value | free)] = next;
+				if (!Moore) outputWords[row + (size_t) (value | free)] = outputWord;
+				if (free == 0) break;
+				free = (free - 1) & dontCare;
+			}
 		}
 }
 
+void Gate_FSM_SYNC::lookUp(unsigned long state, BusWord inputs, unsigned long &next, BusWord &outputWord) const {
+	if (tableBits <= MAX_TABLE_BITS) {
+		size_t entry = ((size_t) state << tableBits) | (size_t) inputs;
+		next = nextStates[entry];
+		outputWord = outputWords[entry];
+		return;
+	}
+
+	const TransitionList &list = transitionLists[state];
+	for (size_t i = list.transitions.size(); i > 0; i--) {
+		const Transition &transition = list.transitions[i - 1];
+		if ((inputs & transition.care) == transition.value) {
+			next = transition.next;
+			outputWord = transition.outputWord;
+			return;
+		}
+	}
+	next = list.defNext;
+	outputWord = list.defOutputWord;
+}
+
 // **************************** END FSM GATE ***********************************
 
 // ******************************** CMB GATE ***********************************
@@ -3525,20 +4289,79 @@ void Gate_FSM_SYNC::procState(string paramName, string value) {
 Gate_CMB::Gate_CMB() : Gate() {
 
 	definedIO = 0;
+	inBits = outBits = 0;
 
 	return;
 }
 
 // Handle gate events:
 void Gate_CMB::gateProcess(void) {
-	vector< StateType > outBus;
-	vector< StateType > inputBus = getInputBusState("IN");
+	// An input that isn't ONE or ZERO could be either, so an output is
+	// only UNKNOWN if the rows that the inputs could select differ:
+	BusValue inputs = getInputBusValue(inPins);
+	BusWord unknownOutputs;
+	BusValue outputs(lookUp(inputs.value, inputs.notBinary(), unknownOutputs), outBits);
+	outputs.unknown = unknownOutputs & BusValue::mask(outBits);
+	outputs.value &= ~outputs.unknown;
+	setOutputBusValue(outPins, outputs);
+}
+
+// The pattern version of gateProcess():
+bool Gate_CMB::patternProcess(void) {
+	if (outPins.size() == 0) return true;
+	vector< PatternWord > inPatterns = getInputBusPattern(inPins);
+
+	// Look up the row of each pattern, the same way as gateProcess():
+	vector< PatternWord > outPatterns(outPins.size());
+	for (unsigned long p = 0; p < 64; p++) {
+		BusWord inputs = 0, unknownInputs = 0;
+		for (unsigned long b = 0; b < inPatterns.size() && b < MAX_BUS_BITS; b++) {
+			if ((inPatterns[b].one >> p) & 1) inputs |= 1ULL << b;
+			else if (!((inPatterns[b].zero >> p) & 1)) unknownInputs |= 1ULL << b;
+		}
+		BusWord unknownOutputs;
+		BusWord outputs = lookUp(inputs, unknownInputs, unknownOutputs);
+
+		for (unsigned long b = 0; b < outPins.size() && b < MAX_BUS_BITS; b++) {
+			if ((unknownOutputs >> b) & 1) outPatterns[b].unknown |= 1ULL << p;
+			else if ((outputs >> b) & 1) outPatterns[b].one |= 1ULL << p;
+			else outPatterns[b].zero |= 1ULL << p;
+		}
+	}
+
+	for (unsigned long b = 0; b < outPins.size(); b++) {
+		setOutputPattern(outPins[b], outPatterns[b]);
+	}
+	return true;
+}
 
+// Look up the outputs for an input word, where the "unknownInputs" bits may
+// be either 0 or 1:
+BusWord Gate_CMB::lookUp(BusWord inputs, BusWord unknownInputs, BusWord &unknownOutputs) const {
+	unknownOutputs = 0;
+	if (truthTable.empty()) return 0;
 
-	unsigned long inputValue = bus_to_ulong(inputBus);
-	unsigned long outputValue = outputs[inputValue];
-	outBus = ulong_to_bus(outputValue, outBits);
-	if (outBus.size() != 0) setOutputBusState("OUT", outBus);
+	// (The inputs past the table's rows are ignored.)
+	BusWord rowMask = truthTable.size() - 1;
+	inputs &= rowMask & ~unknownInputs;
+	unknownInputs &= rowMask;
+	if (unknownInputs == 0) return truthTable[(size_t) inputs];
+
+	// Walk through the rows that the unknown inputs could select, until
+	// every output has been both 0 and 1:
+	BusWord outMask = BusValue::mask(outBits);
+	BusWord ones = 0, zeros = 0;
+	BusWord sub = unknownInputs;
+	while (true) {
+		BusWord row = truthTable[(size_t) (inputs | sub)];
+		ones |= row;
+		zeros |= ~row;
+		if ((ones & zeros & outMask) == outMask) break;
+		if (sub == 0) break;
+		sub = (sub - 1) & unknownInputs;
+	}
+	unknownOutputs = ones & zeros;
+	return ones & ~zeros;
 }
 
 // Set the parameters:
@@ -3562,6 +4385,11 @@ bool Gate_CMB::setParameter(string paramName, string value) {
 		if (inBits > 0) {
 			declareInputBus("IN", inBits);
 		}
+
+		// Make a row for each input word. (The rows that are there
+		// already are kept.)
+		truthTable.resize((size_t) 1 << inBits, 0);
+
 		definedIO |= 2;
 		if (definedIO == 3) procPendingFunctions();
 		return true;
@@ -3592,6 +4420,12 @@ string Gate_CMB::getParameter(string paramName) {
 	return Gate::getParameter(paramName);
 }
 
+// Look up the input and output busses:
+void Gate_CMB::resolvePins( void ) {
+	inPins = getInputBus( "IN" );
+	outPins = getOutputBus( "OUT" );
+}
+
 void Gate_CMB::procPendingFunctions() {
 	map <string, string>::iterator functionsWalk = paramFunctions.begin();
 	while (functionsWalk != paramFunctions.end()) {
@@ -3608,33 +4442,40 @@ void Gate_CMB::procFunction(string paramName, string value) {
 	unsigned long nFunction = atoi(value.substr(1,pEqual-1).c_str());
 	value = value.substr(pEqual + 1);
 
+	// The function is a column of the truth table:
+	if (nFunction >= MAX_BUS_BITS) return;
+	BusWord column = 1ULL << nFunction;
+
 	bool sum = true;
 	if (value.substr(0) == "0") {
-		for (unsigned long i = 0; i < pow(2, inBits); i++)
-			outputs[i] = outputs[i] & ~((unsigned int)pow(2, nFunction));
+		for (size_t i = 0; i < truthTable.size(); i++)
+			truthTable[i] &= ~column;
 		return;
 	} else if (value.substr(0, 1) == "S") {
-			for (unsigned long i = 0; i < pow(2, inBits); i++)
-				outputs[i] = outputs[i] & ~((unsigned int)pow(2, nFunction));
+			for (size_t i = 0; i < truthTable.size(); i++)
+				truthTable[i] &= ~column;
 	} else if (value.substr(0, 1) == "P") {
 		sum = false;
-		for (unsigned long i = 0; i < pow(2, inBits); i++)
-			outputs[i] = outputs[i] | (unsigned long)pow(2, nFunction);
+		for (size_t i = 0; i < truthTable.size(); i++)
+			truthTable[i] |= column;
 	} else {
+			// Hex digits, four rows each, with row 0 in the last digit:
 			for (unsigned long i = 0; i < value.length(); i++) {
-				char valHex;
-				valHex = value[value.length() - i - 1];
-				if (chkDigits(value.substr(value.length()-i-1, 1)))
-					valHex = value[value.length() - i - 1] - '0';
+				char digit = value[value.length() - i - 1];
+				int valHex;
+				if (isdigit((unsigned char) digit))
+					valHex = digit - '0';
 				else
-					valHex = value[value.length() - i - 1] - 'A' + 10;
+					valHex = digit - 'A' + 10;
 				for (long j = 3; j >= 0; j--) {
-					if (valHex >= pow(2, j)) {
-						valHex -= pow(2, j);
-						outputs[4 * i + j] = outputs[4 * i + j] | (unsigned long)pow(2, nFunction);
-					} else {
-						outputs[4 * i + j] = outputs[4 * i + j] & ~(unsigned long)pow(2, nFunction);
-					}
+					bool bitSet = (valHex >= (1 << j));
+					if (bitSet) valHex -= 1 << j;
+					size_t row = 4 * i + j;
+					if (row >= truthTable.size()) continue;
+					if (bitSet)
+						truthTable[row] |= column;
+					else
+						truthTable[row] &= ~column;
 				}
 			}
 			return;
@@ -3646,12 +4487,13 @@ void Gate_CMB::procFunction(string paramName, string value) {
 	while (!iss.eof()) {
 		unsigned long term;
 		char dump;
-		iss >> term >> dump;		
+		if (!(iss >> term)) break;
+		iss >> dump;
+		if (term >= truthTable.size()) continue;
 		if (sum)
-			outputs[term] = outputs[term] | (unsigned long)pow(2, nFunction);
+			truthTable[term] |= column;
 		else
-			outputs[term] = outputs[term] & ~((unsigned long)pow(2, nFunction));
-
+			truthTable[term] &= ~column;
 	}
 
 }
@@ -13,9 +13,13 @@
 #include "logic_event.h"
 #include "logic_wire.h"
 #include "logic_circuit.h"
-#include "..\gui\guiGate.h"
+#include "logic_pattern_sim.h"
+#include "logic_compiled_sim.h"
+#include "logic_bus_value.h"
+#include "logic_ram_memory.h"
 
 class Circuit;
+class GUICircuit;
 
 #include <cassert>  // KAS 2016
 #include <string>
@@ -33,7 +37,14 @@ struct GateInput {
 	bool pulldown;
 	bool forcejunction;		// Pedro Casanova (casanova@ujaen.es) 2020/04-12
 
-	GateInput() : wireID(ID_NONE), inverted(false), pullup(false), pulldown(false), forcejunction(false) {};
+	// Edge-triggered inputs keep the state that they had at the end
+	// of the last update. (hasLastState is false until the first update.)
+	bool edgeTriggered;
+	bool hasLastState;
+	StateType lastState;
+
+	GateInput() : wireID(ID_NONE), inverted(false), pullup(false), pulldown(false), forcejunction(false),
+		edgeTriggered(false), hasLastState(false), lastState(UNKNOWN) {};
 };
 
 struct GateOutput {
@@ -42,9 +53,9 @@ struct GateOutput {
 	TimeType lastEventTime;
 	bool inverted;
 
-	string enableInput; // An input pin which is mapped as the enable pin for this output.
+	PinIndex enablePin; // An input pin which is mapped as the enable pin for this output.
 
-	GateOutput() : wireID(ID_NONE), lastEventState(UNKNOWN), lastEventTime(TIME_NONE), inverted(false), enableInput("") {};
+	GateOutput() : wireID(ID_NONE), lastEventState(UNKNOWN), lastEventTime(TIME_NONE), inverted(false), enablePin(PIN_NONE) {};
 };
 
 
@@ -60,6 +71,46 @@ public:
 	// Resend the last event to a (probably newly connected) wire:	
 	void resendLastEvent( IDType myID, string outputID, Circuit * theCircuit );
 
+	// Drive the gate's outputs for a block of 64 input patterns (see
+	// PatternSim). Returns false if the gate has no pattern version.
+	// This doesn't change the gate, so several PatternSims can run the
+	// same gates on different threads:
+	bool updatePattern( PatternSim * thePatternSim );
+
+	// Write the code for the gate's outputs into a CompiledSim. Returns
+	// false if the gate has no compiled version:
+	bool updateCode( CompiledSim * theCompiledSim );
+
+	// The wire IDs of the inputs and outputs, in pin order:
+	vector< IDType > getInputWires( void ) const;
+	vector< IDType > getOutputWires( void ) const;
+
+	// The names of the pins:
+	const string &getInputName( PinIndex pin ) const { return inputNames[pin]; };
+	const string &getOutputName( PinIndex pin ) const { return outputNames[pin]; };
+
+	// The pin index of a declared output, or PIN_NONE:
+	PinIndex getOutputPin( const string &outputID ) const { return findOutput( outputID ); };
+
+	// Return true if an input is edge-triggered (a clock input):
+	bool isEdgeTriggered( PinIndex pin ) const { return inputPins[pin].edgeTriggered; };
+
+	// Return the input pin that enables an output, or PIN_NONE if the
+	// output is always driven:
+	PinIndex getEnablePin( PinIndex pin ) const { return outputPins[pin].enablePin; };
+
+	// Record an output state that was set by the gate's compiled code, as
+	// if setOutputState() had sent it:
+	void setLastOutputState( PinIndex pin, StateType newState, TimeType newTime ) {
+		outputPins[pin].lastEventState = newState;
+		outputPins[pin].lastEventTime = newTime;
+	};
+
+	// For polled gates: the time step at which this gate must be polled
+	// again, asked right after it was polled at time step "now". Return
+	// TIME_NONE to wait for a parameter change. By default, every step:
+	virtual TimeType getNextPollTime( TimeType now ) { return now + 1; };
+
 	// Set a gate parameter:
 	// (If the parameter change requires the gate to be updated to change its
 	// output state, then return "true".)
@@ -70,6 +121,10 @@ public:
 	// Get the value of a gate parameter:
 	virtual string getParameter( string paramName );
 
+	// For gates with a memory: fill in the blocks of words that changed
+	// since the last call, for the GUI. Returns false if there are none:
+	virtual bool takeMemoryChanges( RamChanges &/*changes*/ ) { return false; };
+
 	// ********* Standard Gate mutator functions ************
 
 	// Connect a wire to the input of this gate:
@@ -80,10 +135,12 @@ public:
 
 	// Return the wire ID of a connected wire, or ID_NONE:
 	virtual IDType getInputWire( string inputID ) {
-		return (inputList.find( inputID ) == inputList.end()) ? ID_NONE : inputList[inputID].wireID;
+		PinIndex pin = findInput( inputID );
+		return (pin == PIN_NONE) ? ID_NONE : inputPins[pin].wireID;
 	};
 	virtual IDType getOutputWire( string outputID ) {
-		return (outputList.find( outputID ) == outputList.end()) ? ID_NONE : outputList[outputID].wireID;
+		PinIndex pin = findOutput( outputID );
+		return (pin == PIN_NONE) ? ID_NONE : outputPins[pin].wireID;
 	};
 
 	// Disconnect a wire from the input of this gate:
@@ -110,14 +167,15 @@ public:
 protected:
 	// Gate "Entity" declaration methods:
 
-	// Register an input for this gate:
+	// Register an input for this gate, and return its pin index:
 	// Possibly declare the input as edge triggered, which will cause it
 	// to be tracked to be able to check rising and falling edges.
-	void declareInput( string inputID, bool edgeTriggered = false);
+	// (Declaring an input twice returns the index that it already has.)
+	PinIndex declareInput( string inputID, bool edgeTriggered = false);
 
 	// Return true if an input has been declared. False otherwise.
 	bool inputExists( string inputID ) {
-		return (inputList.find(inputID) != inputList.end());
+		return (findInput( inputID ) != PIN_NONE);
 	};
 
 	// Register a bus of inputs for this gate. They will be named
@@ -133,12 +191,12 @@ protected:
 		}
 	};
 
-	// Register an output for this gate :
-	void declareOutput( string name );
+	// Register an output for this gate, and return its pin index:
+	PinIndex declareOutput( string name );
 
 	// Return true if an input has been declared. False otherwise.
 	bool outputExists( string outputID ) {
-		return (outputList.find(outputID) != outputList.end());
+		return (findOutput( outputID ) != PIN_NONE);
 	};
 
 	// Register a bus of outputs for this gate. They will be named
@@ -154,9 +212,27 @@ protected:
 		}
 	};
 
+	// Return the pin index of a declared input or output, or PIN_NONE:
+	PinIndex findInput( const string &inputID ) const {
+		ID_MAP< string, PinIndex >::const_iterator thePin = inputIndex.find( inputID );
+		return (thePin == inputIndex.end()) ? PIN_NONE : thePin->second;
+	};
+	PinIndex findOutput( const string &outputID ) const {
+		ID_MAP< string, PinIndex >::const_iterator thePin = outputIndex.find( outputID );
+		return (thePin == outputIndex.end()) ? PIN_NONE : thePin->second;
+	};
+
+	// Return the pin indexes of the bus of inputs (or outputs) named "busName_0"
+	// through "busName_x". Gates should look their busses up once, when
+	// the pins are declared, and keep the result to use in gateProcess().
+	// (The returned reference is only good until the next pin is declared.)
+	const vector< PinIndex > &getInputBus( const string &busName );
+	const vector< PinIndex > &getOutputBus( const string &busName );
+
 	// Set the input to be automatically inverted:
 	void  setInputInverted( string inputID, bool newInv = true ) {
-		if(inputList.find(inputID) == inputList.end()) {
+		PinIndex pin = findInput( inputID );
+		if( pin == PIN_NONE ) {
 			WARNING("Gate::setInputInverted() - Invalid input name.");
 			_MSGW("Input ID: %s\n", inputID.c_str());
 			_MSGNC(false, "ASSERT END 1.h\n");	//@@@@
@@ -165,12 +241,13 @@ protected:
 		}
 
 		// Set the inverted state:
-		this->inputList[inputID].inverted = newInv;
+		this->inputPins[pin].inverted = newInv;
 	};
 
 	// Set the input to be pull-up:
 	void  setInputPullUp(string inputID, bool newPU = true) {
-		if (inputList.find(inputID) == inputList.end()) {
+		PinIndex pin = findInput( inputID );
+		if (pin == PIN_NONE) {
 			WARNING("Gate::setInputPullUp() - Invalid input name.");
 			_MSG("Input ID: %s\n", inputID.c_str());
 			_MSGNC(false, "ASSERT END 2.h\n");	//@@@@
@@ -179,12 +256,13 @@ protected:
 		}
 
 		// Set the pullup state:
-		this->inputList[inputID].pullup = newPU;
+		this->inputPins[pin].pullup = newPU;
 	};
 
 	// Set the input to be pull-down:
 	void  setInputPullDown(string inputID, bool newPD = true) {
-		if (inputList.find(inputID) == inputList.end()) {
+		PinIndex pin = findInput( inputID );
+		if (pin == PIN_NONE) {
 			WARNING("Gate::setInputPullDown() - Invalid input name.");
 			_MSG("Input ID: %s\n", inputID.c_str());
 			_MSGNC(false, "ASSERT END 3.h\n");	//@@@@
@@ -193,12 +271,13 @@ protected:
 		}
 
 		// Set the pulldown state:
-		this->inputList[inputID].pulldown = newPD;
+		this->inputPins[pin].pulldown = newPD;
 	};
 
 	// Set the output to be automatically inverted:
 	void  setOutputInverted( string outputID, bool newInv = true ) {
-		if(outputList.find(outputID) == outputList.end()) {
+		PinIndex pin = findOutput( outputID );
+		if( pin == PIN_NONE ) {
 			WARNING("Gate::setOutputInverted() - Invalid output name.");
 			_MSG("Output ID: %s\n", outputID.c_str());
 			_MSGNC(false, "ASSERT END 4.h\n");	//@@@@
@@ -207,22 +286,24 @@ protected:
 		}
 
 		// Set the inverted state:
-		this->outputList[outputID].inverted = newInv;
+		this->outputPins[pin].inverted = newInv;
 	};
 
 	// Pedro Casanova (casanova@ujaen.es) 2020/04-12
 	// Force the junction in input:
 	void  setInputForceJunction(string inputID, bool newPU = false) {
-		if (inputList.find(inputID) == inputList.end()) {
+		PinIndex pin = findInput( inputID );
+		if (pin == PIN_NONE) {
 			return;
 		}
 		// Set the forcejunction state:
-		this->inputList[inputID].forcejunction = newPU;
+		this->inputPins[pin].forcejunction = newPU;
 	};
 
 	// Set the output Enable Pin:
 	void  setOutputEnablePin( string outputID, string inputID ) {
-		if(outputList.find(outputID) == outputList.end()) {
+		PinIndex outPin = findOutput( outputID );
+		if( outPin == PIN_NONE ) {
 			WARNING("Gate::setOutputEnablePin() - Invalid output name.");
 			_MSG("Output ID: %s\n", outputID.c_str());
 			_MSGNC(false, "ASSERT END 5.h\n");	//@@@@
@@ -230,7 +311,8 @@ protected:
 			return;
 		}
 
-		if(inputList.find(inputID) == inputList.end()) {
+		PinIndex inPin = findInput( inputID );
+		if( inPin == PIN_NONE ) {
 			WARNING("Gate::setOutputEnablePin() - Invalid input name.");
 			_MSG("Input ID: %s\n", inputID.c_str());
 			_MSGNC(false, "ASSERT END 6.h\n");	//@@@@
@@ -239,7 +321,7 @@ protected:
 		}
 
 		// Set the enable state:
-		this->outputList[outputID].enableInput = inputID;
+		this->outputPins[outPin].enablePin = inPin;
 	};
 
 	// A helper function that allows you to convert a bus into a unsigned long:
@@ -254,38 +336,78 @@ protected:
 	// class "Gate" must be subclassed and gateProcess() defined for a proper
 	// gate to be created.
 	virtual void gateProcess( void ) = 0;
+
+	// Look up the pin indexes of the busses that gateProcess() uses.
+	// This is called before the first update, and again after any new
+	// pins have been declared, so subclasses that keep bus pin indexes
+	// should override it (and call their parent's version).
+	virtual void resolvePins( void ) {};
+
+	// The pattern version of gateProcess(), used by updatePattern(). Only
+	// stateless gates can have one, so by default there isn't:
+	virtual bool patternProcess( void ) { return false; };
+
+	// The pattern versions of getInputState(), getInputBusState() and
+	// setOutputState(), for use in patternProcess():
+	PatternWord getInputPattern( PinIndex pin );
+	vector< PatternWord > getInputBusPattern( const vector< PinIndex > &busPins );
+	void setOutputPattern( PinIndex pin, PatternWord newPattern );
+
+	// The compiled version of gateProcess(), used by updateCode(). It
+	// writes a C++ expression for each output, of type StateType, from the
+	// expressions that getInputCode() gives for the inputs. Only stateless
+	// gates can have one, so by default there isn't:
+	virtual bool codeProcess( void ) { return false; };
+	string getInputCode( PinIndex pin );
+	void setOutputCode( PinIndex pin, const string &stateCode );
 	
 	// Get the current time in the simulation:
 	TimeType getSimTime( void );
 	
 	// Check the state of the named input and return it.
 	StateType getInputState( string name );
+	StateType getInputState( PinIndex pin );
 	
 	// Get the input states of a bus of inputs named "busName_0" through
 	// "busName_x" and return their states as a vector.
 	vector< StateType > getInputBusState( string busName );
+	vector< StateType > getInputBusState( const vector< PinIndex > &busPins );
 
 	// Pedro Casanova (casanova@ujaen.es) 2020/04-12
 	// Get the wire states of a bus of output named "busName_0" through
 	// "busName_x" and return their states as a vector.
-	vector< StateType > Gate::getOutputBusWireState(string busName);
+	vector< StateType > getOutputBusWireState(string busName);
+	vector< StateType > getOutputBusWireState( const vector< PinIndex > &busPins );
+
+	// The packed versions of getInputBusState() and getOutputBusWireState(),
+	// for the gates that treat a bus as a number:
+	BusValue getInputBusValue( const vector< PinIndex > &busPins );
+	BusValue getOutputBusWireValue( const vector< PinIndex > &busPins );
 
 	// Get the types of inputs that are represented.
 	vector< bool > groupInputStates( void );
 	
 	// Compare the "this" state with the "last" state and say if this is a rising or falling edge. 
 	bool isRisingEdge( string name ); 
+	bool isRisingEdge( PinIndex pin ); 
 	bool isFallingEdge( string name ); 
+	bool isFallingEdge( PinIndex pin ); 
 
 	// Send an output event to one of the outputs of this gate. 
 	// Compare the last sent event with the newState and decide whether or not to 
 	// really send the event. Also, log the last sent event so that it can be 
 	// repeated later if necessary. 
 	void setOutputState( string outID, StateType newState, TimeType delay = TIME_NONE );
+	void setOutputState( PinIndex pin, StateType newState, TimeType delay = TIME_NONE );
 	
 	// Set the output states of a bus of outputs named "busName_0" through
 	// "busName_x" using a vector of states:
 	void setOutputBusState( string outID, vector< StateType > newState, TimeType delay = TIME_NONE );
+	void setOutputBusState( const vector< PinIndex > &busPins, const vector< StateType > &newState, TimeType delay = TIME_NONE );
+
+	// Set the output states of a bus of output pins from a packed value,
+	// newValue.width bits wide:
+	void setOutputBusValue( const vector< PinIndex > &busPins, const BusValue &newValue, TimeType delay = TIME_NONE );
 
 	// List a parameter in the Circuit as having been changed:
 	void listChangedParam( string paramName );
@@ -295,22 +417,37 @@ protected:
 	// not specified in the call to setOutputState:
 	TimeType defaultDelay;
 
-	// A mapping of gate input IDs to circuit wire IDs, to define
-	// the inputs into this gate, along with other input information:
-	ID_MAP< string, GateInput > inputList;
-
-	// A mapping of gate output IDs to circuit wire ID and wire input ID pairs, along
-	// with the storage of the "last state" information for the gate to avoid sending
-	// duplicate events:
-	ID_MAP< string, GateOutput > outputList;
-	
-	// Edge-triggered inputs and state data for them:
-	ID_SET< string > edgeTriggeredInputs;
-	ID_MAP< string, StateType > edgeTriggeredLastState;
+	// The declared inputs of this gate, indexed by PinIndex, along with the
+	// circuit wire IDs that feed them and the other input information:
+	vector< GateInput > inputPins;
+	vector< string > inputNames;
+	ID_MAP< string, PinIndex > inputIndex;
+
+	// The declared outputs of this gate, indexed by PinIndex, along with the
+	// circuit wire IDs that they drive and the storage of the "last state"
+	// information for the gate to avoid sending duplicate events:
+	vector< GateOutput > outputPins;
+	vector< string > outputNames;
+	ID_MAP< string, PinIndex > outputIndex;
+
+	// The edge-triggered inputs, whose last state is kept for isRisingEdge():
+	vector< PinIndex > edgeTriggeredPins;
+
+	// Busses that have been looked up by getInputBus() or getOutputBus():
+	// (Cleared whenever a new pin is declared.)
+	ID_MAP< string, vector< PinIndex > > inputBusCache;
+	ID_MAP< string, vector< PinIndex > > outputBusCache;
+
+	// Set when a new pin is declared, so resolvePins() gets called:
+	bool pinsChanged;
 	
 	// A temporary pointer to the Circuit object, used for getting wire states, time info,
 	// and for sending events from gate outputs:
 	Circuit* ourCircuit = NULL;
+	// The same, for the PatternSim during updatePattern(). (One per thread.)
+	static thread_local PatternSim* ourPatternSim;
+	// The same, for the CompiledSim during updateCode():
+	static CompiledSim* ourCompiledSim;
 	// Pedro Casanova (casanova@ujaen.es) 2020/04-12
 	GUICircuit* ourGUICircuit = NULL;
 	
@@ -351,8 +488,14 @@ public:
 	string getParameter( string paramName );
 
 protected:
+	// Look up the input bus:
+	void resolvePins( void );
+
 	// The number of input bits:
 	unsigned long inBits;
+
+	// The "IN" bus pins:
+	vector< PinIndex > inPins;
 };
 
 
@@ -366,9 +509,19 @@ public:
 	
 	// Handle gate events:
 	void gateProcess( void );
+	bool patternProcess( void );
+	bool codeProcess( void );
 
 	// Set the parameters:
 	bool setParameter( string paramName, string value );
+
+protected:
+	// Look up the input and output busses:
+	void resolvePins( void );
+
+	// The "OUT" and "OUTINV" bus pins:
+	vector< PinIndex > outPins;
+	vector< PinIndex > outInvPins;
 };
 
 
@@ -381,6 +534,11 @@ public:
 	
 	// Handle gate events:
 	void gateProcess( void );
+	bool patternProcess( void );
+	bool codeProcess( void );
+
+protected:
+	PinIndex outPin;
 };
 
 // ******************* PLD_OR Gate *****************
@@ -393,6 +551,8 @@ public:
 
 	// Handle gate events:
 	void gateProcess(void);
+	bool patternProcess(void);
+	bool codeProcess(void);
 
 	// Set the parameters:
 	bool setParameter(string paramName, string value);
@@ -414,6 +574,11 @@ public:
 
 	// Handle gate events:
 	void gateProcess( void );
+	bool patternProcess( void );
+	bool codeProcess( void );
+
+protected:
+	PinIndex outPin;
 };
 
 // ******************* PLD_AND Gate *****************
@@ -426,6 +591,8 @@ public:
 
 	// Handle gate events:
 	void gateProcess(void);
+	bool patternProcess(void);
+	bool codeProcess(void);
 
 	// Set the parameters:
 	bool setParameter(string paramName, string value);
@@ -446,6 +613,11 @@ public:
 	
 	// Handle gate events:
 	void gateProcess( void );
+	bool patternProcess( void );
+	bool codeProcess( void );
+
+protected:
+	PinIndex outPin;
 };
 	
 
@@ -458,6 +630,11 @@ public:
 	
 	// Handle gate events:
 	void gateProcess( void );
+	bool patternProcess( void );
+	bool codeProcess( void );
+
+protected:
+	PinIndex outPin;
 };
 
 
@@ -469,6 +646,9 @@ public:
 
 	// Handle gate events:
 	void gateProcess( void );
+	// (A register keeps state, so it has no pattern or compiled version.)
+	bool patternProcess( void ) { return false; };
+	bool codeProcess( void ) { return false; };
 
 	// Set the parameters:
 	bool setParameter( string paramName, string value );
@@ -481,9 +661,9 @@ protected:
 
 	// The maximum count of this counter (maximum value).
 	// (BCD is 9, 4-bit binary is 15.)
-	unsigned long maxCount;
+	BusWord maxCount;
 
-	unsigned long currentValue;
+	BusWord currentValue;
 
 	// Pedro Casanova (casanova@ujaen.es) 2021/01-03
 	// To implement CO_ON_OVERFLOW must remember carryOut
@@ -507,6 +687,16 @@ protected:
 	// Carry out on overflow, not in min/max
 	bool CoOnOverflow;
 
+	// Look up the input and output busses:
+	void resolvePins( void );
+
+	// The control pins:
+	PinIndex clockPin, clockEnablePin, clearPin, setPin, loadPin, controlPin;
+	PinIndex countEnablePin, countUpPin, shiftEnablePin, shiftLeftPin, carryInPin;
+	PinIndex countUpShiftLeftPin, carryOutPin;
+
+	// The "OP" bus pins:
+	vector< PinIndex > opPins;
 };
 
 
@@ -526,9 +716,13 @@ public:
 	// Get the clock rate:
 	string getParameter( string paramName );
 
+	// The clock only needs polling when it toggles:
+	TimeType getNextPollTime( TimeType now );
+
 private:
 	TimeType halfCycle;
 	StateType theState;
+	PinIndex clkPin;
 };
 
 
@@ -549,11 +743,18 @@ public:
 	// Get the parameters
 	string getParameter(string paramName);
 
+	// The pulse only needs polling while it is running:
+	TimeType getNextPollTime( TimeType now );
+
 private:
 	TimeType pulseRemaining;
 	// Pedro Casanova (casanova@ujaen.es) 2020/04-12
 	TimeType pulseWidth;
 	bool High_Z;
+	PinIndex outPin;
+
+	// The output state set by the last gateProcess():
+	StateType outState;
 };
 
 
@@ -565,12 +766,18 @@ public:
 
 	// Handle gate events:
 	void gateProcess( void );
+	bool patternProcess( void );
 
 	// Set the parameters:
 	bool setParameter( string paramName, string value );
 
 protected:
+	// Look up the input busses:
+	void resolvePins( void );
+
 	unsigned long selBits;
+	vector< PinIndex > selPins;
+	PinIndex outPin;
 };
 
 
@@ -582,12 +789,18 @@ public:
 
 	// Handle gate events:
 	void gateProcess( void );
+	bool patternProcess( void );
 
 	// Set the parameters:
 	bool setParameter( string paramName, string value );
 
 protected:
+	// Look up the input and output busses:
+	void resolvePins( void );
+
 	unsigned long outBits;
+	vector< PinIndex > outPins;
+	PinIndex enablePin;
 };
 
 // ******************* Encoder Gate *********************
@@ -614,6 +827,12 @@ protected:
 	// Pedro Casanova (casanova@ujan.es) 2020/04-12
 	string Priority;
 	unsigned long invalidValue;
+
+	// Look up the input and output busses:
+	void resolvePins( void );
+
+	vector< PinIndex > outPins;
+	PinIndex enablePin, validPin;
 };
 
 
@@ -628,6 +847,7 @@ public:
 
 	// Handle gate events:
 	void gateProcess( void );
+	bool patternProcess( void );
 
 	// Set the current state:
 	bool setParameter( string paramName, string value );
@@ -636,8 +856,12 @@ public:
 	string getParameter( string paramName );
 
 private:
-	unsigned long output_num;
+	// Look up the output bus:
+	void resolvePins( void );
+
+	BusWord output_num;
 	unsigned long outBits;
+	vector< PinIndex > outPins;
 };
 
 
@@ -654,9 +878,19 @@ public:
 	
 	// Handle gate events:
 	void gateProcess( void );
+	// (Not the PASS gate's pattern or compiled version.)
+	bool patternProcess( void ) { return false; };
+	bool codeProcess( void ) { return false; };
 
 	// Set the parameters:
 	bool setParameter( string paramName, string value );
+
+protected:
+	// Look up the input and output busses:
+	void resolvePins( void );
+
+	vector< PinIndex > inBPins;
+	PinIndex carryInPin, carryOutPin, overflowPin;
 };
 
 
@@ -677,6 +911,14 @@ public:
 
 	// Set the parameters:
 	bool setParameter( string paramName, string value );
+
+protected:
+	// Look up the input busses:
+	void resolvePins( void );
+
+	vector< PinIndex > inBPins;
+	PinIndex inEqualPin, inGreaterPin, inLessPin;
+	PinIndex equalPin, greaterPin, lessPin;
 };
 
 
@@ -701,6 +943,7 @@ public:
 protected:
 	StateType currentState;
 	bool syncSet, syncClear;
+	PinIndex clockPin, jPin, kPin, setPin, clearPin, qPin, nqPin;
 };
 
 // Pedro Casanova (casanova@ujaen.es) 2020/04-12
@@ -726,6 +969,7 @@ public:
 protected:
 	StateType currentState;
 	bool syncSet, syncClear;
+	PinIndex clockPin, tPin, setPin, clearPin, qPin, nqPin;
 };
 
 // ***************** n-bit by n-bit RAM Gate *******************
@@ -744,6 +988,9 @@ public:
 	// Get the parameters:
 	string getParameter( string paramName );
 
+	// Give the GUI the words that were written:
+	bool takeMemoryChanges( RamChanges &changes );
+
 	// Write a file containing the memory data:
 	void outputMemoryFile( string fName );
 
@@ -756,9 +1003,6 @@ public:
 //also load Intel Hex files.  This is a format
 //which is exported by the zad assembler.
 	void inputMemoryFileFromIntelHex( string fName );
-	
-	//a helper function
-	int readInHex( ifstream* fin, int numChars );
 //End of edit**************************************
 
 protected:
@@ -772,11 +1016,32 @@ protected:
 	// Bidirectional data lines
 	bool bidirectionalDATA;
 
-	map< unsigned long, unsigned long > memory;
+	// The words of the RAM, sized from ADDRESS_BITS and DATA_BITS:
+	RamMemory memory;
+
+	// The "Address:" words that were set before the RAM was sized to hold
+	// them, as a file's parameters can come before its size. They are
+	// written once ADDRESS_BITS and DATA_BITS make room for them:
+	map< BusWord, BusWord > pendingWords;
+	void writePendingWords( void );
 	
 	//This is the last location that a read has
 	//taken place from.
-	unsigned long lastRead;
+	BusWord lastRead;
+
+	// The last location that was written, and whether the gate is in the
+	// Circuit's list of memory changes:
+	BusWord lastWritten;
+	bool memoryChangeListed;
+
+	// Look up the address and data busses:
+	void resolvePins( void );
+
+	// HI_Z all of the data outputs:
+	void setDataHI_Z( void );
+
+	vector< PinIndex > addressPins, dataInPins, dataOutPins;
+	PinIndex writeClockPin, writeEnablePin, enablePin, outputEnablePin;
 };
 
 
@@ -868,6 +1133,8 @@ private:
 
 	// The last state of the junction:
 	bool juncLastState;
+
+	PinIndex ctrlPin;
 };
 
 
@@ -967,6 +1234,9 @@ public:
 	bool setParameter( string paramName, string value );
 
 	string getParameter( string paramName );
+
+private:
+	PinIndex signalPin;
 };
 //End of edit****************************************************
 
@@ -996,17 +1266,63 @@ private:
 	unsigned long definedIO;
 	map <string, string> paramStates;
 
+	// Return the number of a state name, giving it the next number if it
+	// hasn't been named before (STATE_NONE for ""):
+	unsigned long stateNumber(const string &name);
+
+	// Whether a state number has been defined by a "State:" param:
+	bool isDefined(unsigned long state) const {
+		return (state < stateDefined.size()) && stateDefined[state];
+	};
+
 protected:
-	string currentOutput;
-	string currentState;	
-	string resetState;
+	static const unsigned long STATE_NONE = ULONG_MAX;
+
+	unsigned long currentState;
+	unsigned long resetState;
 	unsigned long outBits;
 	unsigned long inBits;
 	bool asyncrhonous;
-	
-	vector< string > states;
-	map< string, vector< string > > nextState;
-	map< string, vector< string > > outputs;
+
+	// The states are numbered in the order that they are named (by a
+	// "State:" param, a transition or CURRENT_STATE), and only their
+	// names are kept as strings:
+	vector< string > stateNames;
+	map< string, unsigned long > stateNumbers;
+	vector< bool > stateDefined;
+
+	// The next state and the output word of each state for each input
+	// word, at ( state << tableBits ) | input. They are filled in as the
+	// "State:" params are set, with tableBits = INPUT_BITS:
+	unsigned long tableBits;
+	vector< unsigned long > nextStates;
+	vector< BusWord > outputWords;
+
+	// With more than MAX_TABLE_BITS inputs, the rows would be too big, so
+	// each state keeps its transitions instead, in the order given (a later
+	// one wins), after its defaults:
+	static const unsigned long MAX_TABLE_BITS = 12;
+	struct Transition {
+		BusWord care, value;
+		unsigned long next;
+		BusWord outputWord;
+	};
+	struct TransitionList {
+		unsigned long defNext;
+		BusWord defOutputWord;
+		vector< Transition > transitions;
+	};
+	vector< TransitionList > transitionLists;
+
+	// Look up the next state and the output word of a state for an input
+	// word:
+	void lookUp(unsigned long state, BusWord inputs, unsigned long &next, BusWord &outputWord) const;
+
+	// Look up the input and output busses:
+	void resolvePins( void );
+
+	vector< PinIndex > inPins, outPins;
+	PinIndex clockPin, clearPin;
 };
 
 // ******************* FSM Gate *********************
@@ -1029,6 +1345,7 @@ public:
 
 	// Handle gate events:
 	void gateProcess(void);
+	bool patternProcess(void);
 
 	// Set the parameters:
 	bool setParameter(string paramName, string value);
@@ -1048,8 +1365,19 @@ protected:
 	unsigned long outBits;
 	unsigned long inBits;
 
-	map< unsigned long, unsigned long > outputs;
+	// The truth table, with all of the outputs of a row in one word (the
+	// "Function:n" param sets bit n), and a row for each input word:
+	vector< BusWord > truthTable;
+
+	// Look up the outputs for an input word, where the "unknownInputs"
+	// bits may be either 0 or 1. The outputs that differ between those
+	// rows are set in "unknownOutputs":
+	BusWord lookUp( BusWord inputs, BusWord unknownInputs, BusWord &unknownOutputs ) const;
+
+	// Look up the input and output busses:
+	void resolvePins( void );
 
+	vector< PinIndex > inPins, outPins;
 };
 
 
@@ -15,6 +15,16 @@
 
 class Wire;
 
+// A set of wires that are joined together by enabled junctions. A group
+// is "dirty" after one of its junctions was disabled or lost a wire, until
+// it is split up into the pieces that are still connected:
+struct JunctionGroup {
+	vector< IDType > wireIDs;
+	bool dirty;
+
+	JunctionGroup() : dirty(false) {};
+};
+
 class Junction  
 {
 public:
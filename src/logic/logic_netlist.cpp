@@ -0,0 +1,220 @@
+/*****************************************************************************
+   Project: CEDAR Logic Simulator
+   Copyright 2006 Cedarville University, Benjamin Sprague,
+                     Matt Lewellyn, and David Knierim
+   All rights reserved.
+   For license information see license.txt included with distribution.
+
+   logic_netlist: Compiled (flat array) copy of a Circuit's connectivity
+*****************************************************************************/
+
+#include "logic_netlist.h"
+#include <algorithm>
+
+const IDType Netlist::DENSE_ID_LIMIT;
+
+Netlist::Netlist()
+{
+	built = false;
+	garbage = 0;
+	deadEntries = 0;
+}
+
+// Throw away the arrays and stop tracking edits until the next sync():
+void Netlist::clear( void ) {
+	built = false;
+	garbage = 0;
+	deadEntries = 0;
+
+	denseWireIndex.clear();
+	sparseWireIndex.clear();
+	wireIDs.clear();
+	wirePtrs.clear();
+	wireStates.clear();
+	driverStart.clear();
+	driverCount.clear();
+	fanoutStart.clear();
+	fanoutCount.clear();
+	drivers.clear();
+	fanout.clear();
+	gateIndex.clear();
+	gateIDs.clear();
+	gatePtrs.clear();
+	dirtyWires.clear();
+	wireChanged.clear();
+	wireDone.clear();
+	gateChanged.clear();
+}
+
+// A wire was created, or its drivers, fan-out or junctions changed:
+void Netlist::markWire( IDType wireID ) {
+	// Before the first build everything gets loaded anyway:
+	if( !built ) return;
+	dirtyWires.insert( wireID );
+}
+
+// A wire was removed from the Circuit:
+void Netlist::removeWire( IDType wireID ) {
+	if( !built ) return;
+	dirtyWires.erase( wireID );
+
+	NetIndex wire = findWire( wireID );
+	if( wire == NET_NONE ) return;
+
+	garbage += driverCount[wire] + fanoutCount[wire];
+	driverCount[wire] = 0;
+	fanoutCount[wire] = 0;
+	wirePtrs[wire] = NULL;
+	setWireIndex( wireID, NET_NONE );
+	deadEntries++;
+}
+
+// A gate was removed from the Circuit:
+// (Its wires have already been reported by the disconnects.)
+void Netlist::removeGate( IDType gateID ) {
+	if( !built ) return;
+
+	NetIndex gate = findGate( gateID );
+	if( gate == NET_NONE ) return;
+
+	gatePtrs[gate] = NULL;
+	gateIndex.erase( gateID );
+	deadEntries++;
+}
+
+// Bring the arrays up to date with the Circuit's wires and gates:
+void Netlist::sync( ID_MAP< IDType, WIRE_PTR > &wireList, ID_MAP< IDType, GATE_PTR > &gateList ) {
+	// Once the garbage outweighs the live entries, compact everything:
+	if( !built || ( garbage > drivers.size() / 2 + 1024 ) || ( deadEntries > wireIDs.size() / 2 + 1024 ) ) {
+		rebuild( wireList, gateList );
+	} else {
+		ID_SET< IDType >::iterator dirtyWire = dirtyWires.begin();
+		while( dirtyWire != dirtyWires.end() ) {
+			ID_MAP< IDType, WIRE_PTR >::iterator theWire = wireList.find( *dirtyWire );
+			if( theWire != wireList.end() ) {
+				NetIndex wire = findWire( *dirtyWire );
+				if( wire == NET_NONE ) {
+					wire = addWire( *dirtyWire );
+				}
+				loadWire( wire, theWire->second.get(), gateList );
+			}
+			dirtyWire++;
+		}
+	}
+	dirtyWires.clear();
+}
+
+// Set the state of one of a wire's drivers. Return false if the driver isn't found:
+bool Netlist::setDriverState( NetIndex wire, IDType gateID, PinIndex gateOutputPin, StateType newState ) {
+	NetIndex last = driverStart[wire] + driverCount[wire];
+	for( NetIndex i = driverStart[wire]; i < last; i++ ) {
+		if( ( drivers[i]->gateID == gateID ) && ( drivers[i]->gateOutputPin == gateOutputPin ) ) {
+			wirePtrs[wire]->changeInputState( *drivers[i], newState );
+			return true;
+		}
+	}
+	return false;
+}
+
+// Add a wire to the end of the arrays:
+NetIndex Netlist::addWire( IDType wireID ) {
+	NetIndex wire = (NetIndex) wireIDs.size();
+	wireIDs.push_back( wireID );
+	wirePtrs.push_back( NULL );
+	wireStates.push_back( HI_Z );
+	driverStart.push_back( 0 );
+	driverCount.push_back( 0 );
+	fanoutStart.push_back( 0 );
+	fanoutCount.push_back( 0 );
+	wireChanged.push_back( 0 );
+	wireDone.push_back( 0 );
+	setWireIndex( wireID, wire );
+	return wire;
+}
+
+// Add a gate to the end of the arrays:
+// (Returns NET_NONE if the gate doesn't exist.)
+NetIndex Netlist::addGate( IDType gateID, ID_MAP< IDType, GATE_PTR > &gateList ) {
+	ID_MAP< IDType, GATE_PTR >::iterator theGate = gateList.find( gateID );
+	if( ( theGate == gateList.end() ) || !theGate->second ) return NET_NONE;
+
+	NetIndex gate = (NetIndex) gateIDs.size();
+	gateIDs.push_back( gateID );
+	gatePtrs.push_back( theGate->second.get() );
+	gateChanged.push_back( 0 );
+	gateIndex[gateID] = gate;
+	return gate;
+}
+
+// Set the index of a wire ID in the lookup table:
+void Netlist::setWireIndex( IDType wireID, NetIndex wire ) {
+	if( wireID < DENSE_ID_LIMIT ) {
+		if( wireID >= denseWireIndex.size() ) {
+			if( wire == NET_NONE ) return;
+			denseWireIndex.resize( (size_t) min( max( wireID + 1, (IDType) denseWireIndex.size() * 2 ), DENSE_ID_LIMIT ), NET_NONE );
+		}
+		denseWireIndex[(size_t) wireID] = wire;
+	} else if( wire == NET_NONE ) {
+		sparseWireIndex.erase( wireID );
+	} else {
+		sparseWireIndex[wireID] = wire;
+	}
+}
+
+// Copy a Wire's drivers and fan-out into the arrays:
+void Netlist::loadWire( NetIndex wire, Wire *theWire, ID_MAP< IDType, GATE_PTR > &gateList ) {
+	garbage += driverCount[wire] + fanoutCount[wire];
+
+	wirePtrs[wire] = theWire;
+	wireStates[wire] = theWire->wireState;
+
+	driverStart[wire] = (NetIndex) drivers.size();
+	ID_SET< WireInput >::iterator thisInput = theWire->inputList.begin();
+	while( thisInput != theWire->inputList.end() ) {
+		drivers.push_back( &(*thisInput) );
+		thisInput++;
+	}
+	driverCount[wire] = (NetIndex) drivers.size() - driverStart[wire];
+
+	// The outputs are sorted by gate ID, so duplicate gates are next to each other:
+	fanoutStart[wire] = (NetIndex) fanout.size();
+	IDType lastGateID = ID_NONE;
+	ID_SET< WireOutput >::iterator thisOutput = theWire->outputList.begin();
+	while( thisOutput != theWire->outputList.end() ) {
+		if( thisOutput->gateID != lastGateID ) {
+			lastGateID = thisOutput->gateID;
+			NetIndex gate = findGate( lastGateID );
+			if( gate == NET_NONE ) {
+				gate = addGate( lastGateID, gateList );
+			}
+			if( gate != NET_NONE ) {
+				fanout.push_back( gate );
+			}
+		}
+		thisOutput++;
+	}
+	fanoutCount[wire] = (NetIndex) fanout.size() - fanoutStart[wire];
+}
+
+// Rebuild all of the arrays from scratch:
+void Netlist::rebuild( ID_MAP< IDType, WIRE_PTR > &wireList, ID_MAP< IDType, GATE_PTR > &gateList ) {
+	clear();
+
+	size_t numDrivers = 0;
+	ID_MAP< IDType, WIRE_PTR >::iterator theWire = wireList.begin();
+	while( theWire != wireList.end() ) {
+		numDrivers += theWire->second->inputList.size();
+		theWire++;
+	}
+	drivers.reserve( numDrivers );
+	wireIDs.reserve( wireList.size() );
+
+	theWire = wireList.begin();
+	while( theWire != wireList.end() ) {
+		loadWire( addWire( theWire->first ), theWire->second.get(), gateList );
+		theWire++;
+	}
+
+	garbage = 0;
+	built = true;
+}
@@ -0,0 +1,155 @@
+/*****************************************************************************
+   Project: CEDAR Logic Simulator
+   Copyright 2006 Cedarville University, Benjamin Sprague,
+                     Matt Lewellyn, and David Knierim
+   All rights reserved.
+   For license information see license.txt included with distribution.
+
+   logic_netlist: Compiled (flat array) copy of a Circuit's connectivity
+*****************************************************************************/
+
+#ifndef LOGIC_NETLIST_H
+#define LOGIC_NETLIST_H
+
+#include "logic_defaults.h"
+#include "logic_wire.h"
+
+#include <vector>
+
+// Dense index of a wire or gate inside of a Netlist:
+typedef unsigned long NetIndex;
+const NetIndex NET_NONE = (NetIndex) -1;
+
+// The Netlist holds the parts of a Circuit that Circuit::step() needs every
+// time step, packed into arrays that are addressed by a dense index instead
+// of by ID:
+//
+// Wires: ID, Wire object and current state.
+// Each wire owns a run of the "drivers" array (pointers to its WireInputs) and
+// a run of the "fanout" array (the indexes of the gates that it feeds).
+//
+// Gates: ID and Gate object.
+//
+// The Wire and Gate objects stay the master copy. Driver states are written
+// straight into the WireInputs, and wire states are written to both places,
+// so nothing needs to be copied back when the netlist is thrown away.
+//
+// Edits are handled incrementally: the Circuit reports every wire whose
+// connections changed, and sync() reloads only those wires by appending new
+// runs to the drivers and fanout arrays. The old runs are left as garbage
+// until there is enough of it to be worth a full rebuild.
+class Netlist
+{
+	friend class Circuit;
+public:
+	Netlist();
+
+	// Throw away the arrays and stop tracking edits until the next sync():
+	void clear( void );
+
+	// Return true if the arrays have been built by sync():
+	bool isBuilt( void ) const { return built; };
+
+	// ************ Edit notifications from the Circuit **************
+
+	// A wire was created, or its drivers, fan-out or junctions changed:
+	void markWire( IDType wireID );
+
+	// A wire or gate was removed from the Circuit:
+	void removeWire( IDType wireID );
+	void removeGate( IDType gateID );
+
+	// Bring the arrays up to date with the Circuit's wires and gates:
+	void sync( ID_MAP< IDType, WIRE_PTR > &wireList, ID_MAP< IDType, GATE_PTR > &gateList );
+
+	// ************ Lookups **************
+
+	// Return the index of a wire, or NET_NONE if it isn't in the netlist:
+	NetIndex findWire( IDType wireID ) const {
+		if( wireID < denseWireIndex.size() ) return denseWireIndex[(size_t) wireID];
+		ID_MAP< IDType, NetIndex >::const_iterator found = sparseWireIndex.find( wireID );
+		return ( found == sparseWireIndex.end() ) ? NET_NONE : found->second;
+	};
+
+	// Return the index of a gate, or NET_NONE if it isn't in the netlist:
+	NetIndex findGate( IDType gateID ) const {
+		ID_MAP< IDType, NetIndex >::const_iterator found = gateIndex.find( gateID );
+		return ( found == gateIndex.end() ) ? NET_NONE : found->second;
+	};
+
+	StateType getWireState( NetIndex wire ) const { return wireStates[wire]; };
+
+	// Return the junction group of a wire (GROUP_NONE if it stands alone):
+	GroupIndex getJunctionGroup( NetIndex wire ) const { return wirePtrs[wire]->junctionGroup; };
+
+	// Set the state of a wire (and of its Wire object):
+	void setWireState( NetIndex wire, StateType newState ) {
+		wireStates[wire] = newState;
+		wirePtrs[wire]->wireState = newState;
+	};
+
+	// Set the state of one of a wire's drivers. Return false if the driver isn't found:
+	bool setDriverState( NetIndex wire, IDType gateID, PinIndex gateOutputPin, StateType newState );
+
+	// Return the mask of the states driven onto a wire (see resolveStateMask()):
+	unsigned int getStateMask( NetIndex wire ) const { return wirePtrs[wire]->getStateMask(); };
+
+private:
+	// Add a wire or gate to the end of the arrays:
+	NetIndex addWire( IDType wireID );
+	NetIndex addGate( IDType gateID, ID_MAP< IDType, GATE_PTR > &gateList );
+
+	// Set the index of a wire ID in the lookup table:
+	void setWireIndex( IDType wireID, NetIndex wire );
+
+	// Copy a Wire's drivers and fan-out into the arrays:
+	void loadWire( NetIndex wire, Wire *theWire, ID_MAP< IDType, GATE_PTR > &gateList );
+
+	// Rebuild all of the arrays from scratch:
+	void rebuild( ID_MAP< IDType, WIRE_PTR > &wireList, ID_MAP< IDType, GATE_PTR > &gateList );
+
+	// Wire IDs below this limit are looked up in a direct table, the rest in a map:
+	static const IDType DENSE_ID_LIMIT = 1 << 22;
+
+	bool built;
+
+	// Wire ID -> index tables:
+	vector< NetIndex > denseWireIndex;
+	ID_MAP< IDType, NetIndex > sparseWireIndex;
+
+	// The wire arrays (wirePtrs is NULL for a deleted wire):
+	vector< IDType > wireIDs;
+	vector< Wire * > wirePtrs;
+	vector< StateType > wireStates;
+	vector< NetIndex > driverStart;
+	vector< NetIndex > driverCount;
+	vector< NetIndex > fanoutStart;
+	vector< NetIndex > fanoutCount;
+
+	// The runs of drivers and fan-out gates for each wire:
+	vector< const WireInput * > drivers;
+	vector< NetIndex > fanout;
+
+	// The gate arrays (gatePtrs is NULL for a deleted gate):
+	ID_MAP< IDType, NetIndex > gateIndex;
+	vector< IDType > gateIDs;
+	vector< Gate * > gatePtrs;
+
+	// Wires that need to be reloaded by the next sync():
+	ID_SET< IDType > dirtyWires;
+
+	// Unused array entries left behind by reloads and deletes:
+	size_t garbage;
+	size_t deadEntries;
+
+	// Scratch space for Circuit::step(). The flags are always clear between steps:
+	vector< unsigned char > wireChanged;
+	vector< unsigned char > wireDone;
+	vector< unsigned char > gateChanged;
+	vector< NetIndex > changedList;
+	vector< NetIndex > doneList;
+	vector< NetIndex > gateUpdates;
+	vector< NetIndex > groupList;
+};
+
+#endif // LOGIC_NETLIST_H
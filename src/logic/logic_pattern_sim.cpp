@@ -0,0 +1,360 @@
+/*****************************************************************************
+   Project: CEDAR Logic Simulator
+   Copyright 2006 Cedarville University, Benjamin Sprague,
+                     Matt Lewellyn, and David Knierim
+   All rights reserved.
+   For license information see license.txt included with distribution.
+
+   logic_pattern_sim: Runs 64 input patterns at once through the
+   combinational gates of a Circuit, to build truth tables
+*****************************************************************************/
+
+#include "logic_pattern_sim.h"
+#include "logic_circuit.h"
+#include "logic_gate.h"
+
+// The first six inputs change within a block of 64 patterns. Bit i of the
+// pattern number is set in these patterns:
+static const unsigned long long INPUT_PATTERN_BITS[6] = {
+	0xAAAAAAAAAAAAAAAAULL,
+	0xCCCCCCCCCCCCCCCCULL,
+	0xF0F0F0F0F0F0F0F0ULL,
+	0xFF00FF00FF00FF00ULL,
+	0xFFFF0000FFFF0000ULL,
+	0xFFFFFFFF00000000ULL
+};
+
+
+// ******************************** PatternWord ***********************************
+
+PatternWord::PatternWord( StateType theState ) : zero(0), one(0), unknown(0), conflict(0) {
+	switch( theState ) {
+	case ZERO: zero = ~0ULL; break;
+	case ONE: one = ~0ULL; break;
+	case CONFLICT: conflict = ~0ULL; break;
+	case UNKNOWN: unknown = ~0ULL; break;
+	default: break; // HI_Z
+	}
+}
+
+// The same rules as resolveStateMask(): A conflict, or both ZERO and ONE,
+// is a CONFLICT. Otherwise ONE or ZERO win, then UNKNOWN, then HI_Z:
+PatternWord PatternWord::resolve( void ) const {
+	PatternWord resolved;
+	resolved.conflict = conflict | ( zero & one );
+	resolved.one = one & ~resolved.conflict;
+	resolved.zero = zero & ~resolved.conflict;
+	resolved.unknown = unknown & ~( zero | one | conflict );
+	return resolved;
+}
+
+PatternWord PatternWord::select( unsigned long long mask ) const {
+	PatternWord selected;
+	selected.zero = zero & mask;
+	selected.one = one & mask;
+	selected.unknown = unknown & mask;
+	selected.conflict = conflict & mask;
+	return selected;
+}
+
+StateType PatternWord::getState( unsigned long bit ) const {
+	unsigned long long mask = 1ULL << bit;
+	if( zero & mask ) return ZERO;
+	if( one & mask ) return ONE;
+	if( conflict & mask ) return CONFLICT;
+	if( unknown & mask ) return UNKNOWN;
+	return HI_Z;
+}
+
+
+// ******************************** PatternSim ***********************************
+
+PatternSim::PatternSim( Circuit *theCircuit )
+{
+	myCircuit = theCircuit;
+	currentGate = 0;
+}
+
+bool PatternSim::build( const vector< IDType > &inputWires, const vector< IDType > &outputWires ) {
+	// The junction groups must be up to date, and the batch belongs to
+	// whoever opened it:
+	if( myCircuit->inBatch() ) {
+		WARNING("PatternSim::build() - The circuit has a batch of edits open.");
+		return false;
+	}
+
+	wireNets.clear();
+	netWires.clear();
+	netDrivers.clear();
+	isInputNet.clear();
+	inputNets.clear();
+	outputNets.clear();
+	orderIDs.clear();
+	orderGates.clear();
+	gateInputNets.clear();
+	gateOutputNets.clear();
+	outputWords.clear();
+	outputTable.clear();
+	clearFaults();
+
+	for( unsigned long i = 0; i < inputWires.size(); i++ ) {
+		NetIndex net = addNet( inputWires[i] );
+		if( net == NET_NONE ) {
+			WARNING("PatternSim::build() - Input wire does not exist.");
+			_MSGW("Wire ID: %lld\n", inputWires[i]);
+			return false;
+		}
+		isInputNet[net] = true;
+		inputNets.push_back( net );
+	}
+	for( unsigned long i = 0; i < outputWires.size(); i++ ) {
+		NetIndex net = addNet( outputWires[i] );
+		if( net == NET_NONE ) {
+			WARNING("PatternSim::build() - Output wire does not exist.");
+			_MSGW("Wire ID: %lld\n", outputWires[i]);
+			return false;
+		}
+		outputNets.push_back( net );
+	}
+	outputWords.resize( outputNets.size() );
+
+	// Find the gates that drive each wire, and the wires that the T gates
+	// switch in and out of their junctions:
+	ID_MAP< IDType, vector< IDType > > wireDrivers;
+	ID_SET< IDType > switchedWires;
+	ID_MAP< IDType, GATE_PTR >::iterator gateWalk = myCircuit->gateList.begin();
+	while( gateWalk != myCircuit->gateList.end() ) {
+		vector< IDType > gateWires = gateWalk->second->getOutputWires();
+		for( unsigned long i = 0; i < gateWires.size(); i++ ) {
+			if( gateWires[i] != ID_NONE ) wireDrivers[gateWires[i]].push_back( gateWalk->first );
+		}
+		if( gateWalk->second->logicType == "TGATE" ) {
+			gateWires = gateWalk->second->getInputWires();
+			switchedWires.insert( gateWires.begin(), gateWires.end() );
+		}
+		gateWalk++;
+	}
+
+	// Walk back from the outputs to the inputs, and put each gate in the
+	// order after the gates that drive it. A gate that is still being
+	// walked (1) when it is reached again is part of a loop:
+	ID_MAP< IDType, int > gateMarks;
+	vector< pair< IDType, bool > > walk;
+	for( unsigned long i = 0; i < outputNets.size(); i++ ) {
+		if( isInputNet[outputNets[i]] ) continue;
+		const vector< IDType > &outWires = netWires[outputNets[i]];
+		for( unsigned long w = 0; w < outWires.size(); w++ ) {
+			const vector< IDType > &drivers = wireDrivers[outWires[w]];
+			for( unsigned long d = 0; d < drivers.size(); d++ ) walk.push_back( make_pair( drivers[d], false ) );
+		}
+	}
+
+	while( !walk.empty() ) {
+		IDType gateID = walk.back().first;
+		bool driversDone = walk.back().second;
+		walk.pop_back();
+
+		int &mark = gateMarks[gateID];
+		if( driversDone ) {
+			mark = 2;
+			orderIDs.push_back( gateID );
+			orderGates.push_back( myCircuit->gateList[gateID].get() );
+			continue;
+		}
+		if( mark == 2 ) continue;
+		if( mark == 1 ) {
+			WARNING("PatternSim::build() - The gates form a loop, so they are not combinational.");
+			_MSGW("Gate ID: %lld\n", gateID);
+			return false;
+		}
+		mark = 1;
+		walk.push_back( make_pair( gateID, true ) );
+
+		vector< IDType > inWires = myCircuit->gateList[gateID]->getInputWires();
+		for( unsigned long i = 0; i < inWires.size(); i++ ) {
+			if( inWires[i] == ID_NONE ) continue;
+			NetIndex net = findNet( inWires[i] );
+			if( net == NET_NONE ) {
+				net = addNet( inWires[i] );
+			} else if( isInputNet[net] ) {
+				continue;
+			}
+			const vector< IDType > &inNetWires = netWires[net];
+			for( unsigned long w = 0; w < inNetWires.size(); w++ ) {
+				const vector< IDType > &drivers = wireDrivers[inNetWires[w]];
+				for( unsigned long d = 0; d < drivers.size(); d++ ) {
+					if( gateMarks[drivers[d]] == 1 ) {
+						WARNING("PatternSim::build() - The gates form a loop, so they are not combinational.");
+						_MSGW("Gate ID: %lld\n", drivers[d]);
+						return false;
+					}
+					if( gateMarks[drivers[d]] == 0 ) walk.push_back( make_pair( drivers[d], false ) );
+				}
+			}
+		}
+	}
+
+	// A T gate can change the junction groups while it runs:
+	ID_SET< IDType >::iterator switched = switchedWires.begin();
+	while( switched != switchedWires.end() ) {
+		if( findNet( *switched ) != NET_NONE ) {
+			WARNING("PatternSim::build() - A T gate switches a wire that the outputs depend on.");
+			_MSGW("Wire ID: %lld\n", *switched);
+			return false;
+		}
+		switched++;
+	}
+
+	// Look up the nets of the gates' pins:
+	gateInputNets.resize( orderGates.size() );
+	gateOutputNets.resize( orderGates.size() );
+	for( unsigned long g = 0; g < orderGates.size(); g++ ) {
+		vector< IDType > pinWires = orderGates[g]->getInputWires();
+		for( PinIndex pin = 0; pin < pinWires.size(); pin++ ) {
+			gateInputNets[g].push_back( findNet( pinWires[pin] ) );
+		}
+		pinWires = orderGates[g]->getOutputWires();
+		for( PinIndex pin = 0; pin < pinWires.size(); pin++ ) {
+			gateOutputNets[g].push_back( findNet( pinWires[pin] ) );
+		}
+	}
+
+	// Try the first block, so that a gate without a pattern version is
+	// found now:
+	return runBlock( 0 );
+}
+
+bool PatternSim::runBlock( unsigned long long block ) {
+	vector< PatternWord > inputWords( inputNets.size() );
+	for( unsigned long i = 0; i < inputNets.size(); i++ ) {
+		if( i < 6 ) {
+			inputWords[i].one = INPUT_PATTERN_BITS[i];
+		} else {
+			inputWords[i].one = ( ( block >> ( i - 6 ) ) & 1 ) ? ~0ULL : 0;
+		}
+		inputWords[i].zero = ~inputWords[i].one;
+	}
+	return runInputs( inputWords );
+}
+
+bool PatternSim::runInputs( const vector< PatternWord > &inputWords ) {
+	for( NetIndex net = 0; net < netDrivers.size(); net++ ) {
+		netDrivers[net] = PatternWord();
+	}
+
+	for( unsigned long i = 0; i < inputNets.size() && i < inputWords.size(); i++ ) {
+		netDrivers[inputNets[i]].drive( inputWords[i] );
+	}
+
+	for( unsigned long g = 0; g < orderGates.size(); g++ ) {
+		if( !runGate( g ) ) return false;
+	}
+
+	for( unsigned long i = 0; i < outputNets.size(); i++ ) {
+		outputWords[i] = getNetPattern( outputNets[i] );
+	}
+	return true;
+}
+
+bool PatternSim::runGates( const vector< unsigned long > &gates ) {
+	for( unsigned long g = 0; g < gates.size(); g++ ) {
+		const vector< NetIndex > &outNets = gateOutputNets[gates[g]];
+		for( PinIndex pin = 0; pin < outNets.size(); pin++ ) {
+			if( ( outNets[pin] != NET_NONE ) && !isInputNet[outNets[pin]] ) netDrivers[outNets[pin]] = PatternWord();
+		}
+	}
+
+	for( unsigned long g = 0; g < gates.size(); g++ ) {
+		if( !runGate( gates[g] ) ) return false;
+	}
+	return true;
+}
+
+bool PatternSim::runGate( unsigned long gate ) {
+	currentGate = gate;
+	if( !orderGates[gate]->updatePattern( this ) ) {
+		WARNING("PatternSim::runGate() - This type of gate can't be run as patterns.");
+		_MSGW("Gate ID: %lld Type: %s\n", orderIDs[gate], orderGates[gate]->logicType.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool PatternSim::runAllPatterns( void ) {
+	if( inputNets.size() > MAX_TABLE_INPUTS ) {
+		WARNING("PatternSim::runAllPatterns() - Too many inputs for a truth table.");
+		_MSGW("Inputs: %lu\n", (unsigned long) inputNets.size());
+		return false;
+	}
+
+	unsigned long long numBlocks = ( getNumPatterns() + PATTERNS_PER_WORD - 1 ) / PATTERNS_PER_WORD;
+	outputTable.assign( outputNets.size(), vector< PatternWord >( (size_t) numBlocks ) );
+	for( unsigned long long block = 0; block < numBlocks; block++ ) {
+		if( !runBlock( block ) ) return false;
+		for( unsigned long i = 0; i < outputNets.size(); i++ ) {
+			outputTable[i][(size_t) block] = outputWords[i];
+		}
+	}
+	return true;
+}
+
+StateType PatternSim::getOutputState( unsigned long output, unsigned long long pattern ) const {
+	return outputTable[output][(size_t) ( pattern / PATTERNS_PER_WORD )].getState( (unsigned long) ( pattern % PATTERNS_PER_WORD ) );
+}
+
+void PatternSim::addNetFault( NetIndex net, StateType stuckAt, unsigned long long mask ) {
+	if( netFaults.empty() ) netFaults.resize( netWires.size() );
+	addFault( netFaults[net], stuckAt, mask );
+}
+
+void PatternSim::addInputPinFault( unsigned long gate, PinIndex pin, StateType stuckAt, unsigned long long mask ) {
+	if( inputPinFaults.empty() ) inputPinFaults.resize( orderGates.size() );
+	if( inputPinFaults[gate].size() <= pin ) inputPinFaults[gate].resize( pin + 1 );
+	addFault( inputPinFaults[gate][pin], stuckAt, mask );
+}
+
+void PatternSim::addOutputPinFault( unsigned long gate, PinIndex pin, StateType stuckAt, unsigned long long mask ) {
+	if( outputPinFaults.empty() ) outputPinFaults.resize( orderGates.size() );
+	if( outputPinFaults[gate].size() <= pin ) outputPinFaults[gate].resize( pin + 1 );
+	addFault( outputPinFaults[gate][pin], stuckAt, mask );
+}
+
+void PatternSim::clearFaults( void ) {
+	netFaults.clear();
+	inputPinFaults.clear();
+	outputPinFaults.clear();
+}
+
+void PatternSim::addFault( StuckMask &fault, StateType stuckAt, unsigned long long mask ) {
+	if( stuckAt == ZERO ) {
+		fault.stuckZero |= mask;
+		fault.stuckOne &= ~mask;
+	} else {
+		fault.stuckOne |= mask;
+		fault.stuckZero &= ~mask;
+	}
+}
+
+NetIndex PatternSim::findNet( IDType wireID ) const {
+	ID_MAP< IDType, NetIndex >::const_iterator found = wireNets.find( wireID );
+	return ( found == wireNets.end() ) ? NET_NONE : found->second;
+}
+
+NetIndex PatternSim::addNet( IDType wireID ) {
+	NetIndex net = findNet( wireID );
+	if( net != NET_NONE ) return net;
+
+	set< IDType > groupWires = myCircuit->getJunctionGroupIDs( wireID );
+	if( groupWires.empty() ) return NET_NONE;
+
+	net = (NetIndex) netWires.size();
+	netWires.push_back( vector< IDType >( groupWires.begin(), groupWires.end() ) );
+	netDrivers.push_back( PatternWord() );
+	isInputNet.push_back( false );
+	set< IDType >::iterator groupWalk = groupWires.begin();
+	while( groupWalk != groupWires.end() ) {
+		wireNets[*groupWalk] = net;
+		groupWalk++;
+	}
+	return net;
+}
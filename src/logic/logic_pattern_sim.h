@@ -0,0 +1,255 @@
+/*****************************************************************************
+   Project: CEDAR Logic Simulator
+   Copyright 2006 Cedarville University, Benjamin Sprague,
+                     Matt Lewellyn, and David Knierim
+   All rights reserved.
+   For license information see license.txt included with distribution.
+
+   logic_pattern_sim: Runs 64 input patterns at once through the
+   combinational gates of a Circuit, to build truth tables
+*****************************************************************************/
+
+#ifndef LOGIC_PATTERN_SIM_H
+#define LOGIC_PATTERN_SIM_H
+
+#include "logic_defaults.h"
+#include "logic_netlist.h"
+
+#include <vector>
+
+class Circuit;
+class Gate;
+
+// The number of patterns in a PatternWord:
+const unsigned long PATTERNS_PER_WORD = 64;
+
+// The states of a wire (or a gate pin) for 64 patterns. Bit i of each
+// plane is pattern i, and each bit is set in at most one plane. A bit that
+// is in none of them is HI_Z.
+//
+// The same struct also collects the drivers of a wire, as a state mask per
+// pattern: then a bit can be in several planes, and resolve() turns them
+// into one state the same way that the wires do (see resolveStateMask()).
+struct PatternWord {
+	unsigned long long zero;
+	unsigned long long one;
+	unsigned long long unknown;
+	unsigned long long conflict;
+
+	PatternWord() : zero(0), one(0), unknown(0), conflict(0) {};
+
+	// The same state for all of the patterns:
+	explicit PatternWord( StateType theState );
+
+	// The bits that are not ONE or ZERO:
+	unsigned long long notBinary( void ) const {
+		return ~( zero | one );
+	};
+
+	// Add another driver's states:
+	void drive( const PatternWord &other ) {
+		zero |= other.zero;
+		one |= other.one;
+		unknown |= other.unknown;
+		conflict |= other.conflict;
+	};
+
+	// Turn a mask of driver states into one state per pattern:
+	PatternWord resolve( void ) const;
+
+	// Keep only the patterns in "mask", and make the rest HI_Z:
+	PatternWord select( unsigned long long mask ) const;
+
+	// Return the state of one pattern:
+	StateType getState( unsigned long bit ) const;
+
+	// The state of one pattern, for all of the patterns:
+	PatternWord broadcast( unsigned long bit ) const {
+		PatternWord all;
+		all.zero = 0 - ( ( zero >> bit ) & 1 );
+		all.one = 0 - ( ( one >> bit ) & 1 );
+		all.unknown = 0 - ( ( unknown >> bit ) & 1 );
+		all.conflict = 0 - ( ( conflict >> bit ) & 1 );
+		return all;
+	};
+
+	// Force the patterns in "stuckZero" to ZERO and those in "stuckOne" to ONE:
+	void stick( unsigned long long stuckZero, unsigned long long stuckOne ) {
+		unsigned long long keep = ~( stuckZero | stuckOne );
+		zero = ( zero & keep ) | stuckZero;
+		one = ( one & keep ) | stuckOne;
+		unknown &= keep;
+		conflict &= keep;
+	};
+};
+
+
+// The patterns in which a wire or pin is stuck at ZERO or ONE (see
+// PatternSim::addNetFault()):
+struct StuckMask {
+	unsigned long long stuckZero;
+	unsigned long long stuckOne;
+
+	StuckMask() : stuckZero(0), stuckOne(0) {};
+};
+
+
+// A PatternSim takes a Circuit, a list of input wires and a list of output
+// wires. It finds the gates that the outputs depend on, sorts them so that
+// each gate comes after the gates that drive it, and then evaluates them
+// with bitwise operations on PatternWords, 64 input patterns at a time.
+//
+// The gates that drive the input wires are left out, and input i is bit i of
+// the pattern number. The junctions are taken as they are when build() is
+// called, so T gates and loops of gates are not allowed, and the gates must
+// have a pattern version (see Gate::patternProcess()).
+class PatternSim
+{
+public:
+	PatternSim( Circuit *theCircuit );
+
+	// Set up the inputs and outputs. Returns false, with a warning, if the
+	// gates between them can't be run as patterns, or if the circuit is in
+	// the middle of a batch of edits:
+	bool build( const vector< IDType > &inputWires, const vector< IDType > &outputWires );
+
+	// Run the patterns block * 64 to block * 64 + 63. Returns false if a gate
+	// has no pattern version:
+	bool runBlock( unsigned long long block );
+
+	// Run one PatternWord per input, instead of the pattern numbers:
+	bool runInputs( const vector< PatternWord > &inputWords );
+
+	unsigned long getNumInputs( void ) const { return (unsigned long) inputNets.size(); };
+	unsigned long getNumOutputs( void ) const { return (unsigned long) outputNets.size(); };
+
+	// The states of an output for the last runBlock():
+	const PatternWord &getOutputWord( unsigned long output ) const {
+		return outputWords[output];
+	};
+
+	// Run every input pattern, and keep the states of the outputs for
+	// getOutputState(). Up to MAX_TABLE_INPUTS inputs are allowed:
+	bool runAllPatterns( void );
+	static const unsigned long MAX_TABLE_INPUTS = 24;
+
+	// The number of patterns in the table (2 to the number of inputs):
+	unsigned long long getNumPatterns( void ) const {
+		return 1ULL << inputNets.size();
+	};
+
+	// The state of an output for one pattern, after runAllPatterns():
+	StateType getOutputState( unsigned long output, unsigned long long pattern ) const;
+
+	// The nets and gates that build() found. The first wire of a net stands
+	// for all of the wires in its junction group:
+	unsigned long getNumNets( void ) const { return (unsigned long) netWires.size(); };
+	IDType getNetWire( NetIndex net ) const { return netWires[net][0]; };
+	bool isInput( NetIndex net ) const { return isInputNet[net]; };
+	NetIndex getOutputNet( unsigned long output ) const { return outputNets[output]; };
+	unsigned long getNumGates( void ) const { return (unsigned long) orderGates.size(); };
+	IDType getGateID( unsigned long gate ) const { return orderIDs[gate]; };
+	Gate *getGate( unsigned long gate ) const { return orderGates[gate]; };
+	const vector< NetIndex > &getGateInputNets( unsigned long gate ) const { return gateInputNets[gate]; };
+	const vector< NetIndex > &getGateOutputNets( unsigned long gate ) const { return gateOutputNets[gate]; };
+
+	// The resolved states of a net (with its faults) after a run:
+	PatternWord getNetPattern( NetIndex net ) const {
+		PatternWord resolved = netDrivers[net].resolve();
+		if( !netFaults.empty() ) resolved.stick( netFaults[net].stuckZero, netFaults[net].stuckOne );
+		return resolved;
+	};
+
+	// Run only some of the gates, by index, in order. The nets that they
+	// drive are cleared first, and the other nets keep the states that were
+	// given to them by setNetPattern(). (The outputs are not updated.)
+	bool runGates( const vector< unsigned long > &gates );
+	void setNetPattern( NetIndex net, const PatternWord &word ) { netDrivers[net] = word; };
+
+	// Stuck-at faults, for the patterns in "mask". A net fault sticks the
+	// whole junction group, and a pin fault sticks only what one pin of a
+	// gate (by its index from getGate()) reads or drives:
+	void addNetFault( NetIndex net, StateType stuckAt, unsigned long long mask );
+	void addInputPinFault( unsigned long gate, PinIndex pin, StateType stuckAt, unsigned long long mask );
+	void addOutputPinFault( unsigned long gate, PinIndex pin, StateType stuckAt, unsigned long long mask );
+	void clearFaults( void );
+
+	// ************ Used by the gates during runBlock() **************
+
+	// The resolved states of the wire on an input pin of the gate that is
+	// being run (HI_Z if it isn't connected):
+	PatternWord getInputPinPattern( PinIndex pin ) const {
+		const vector< NetIndex > &pinNets = gateInputNets[currentGate];
+		if( ( pin >= pinNets.size() ) || ( pinNets[pin] == NET_NONE ) ) return PatternWord();
+		return getNetPattern( pinNets[pin] );
+	};
+
+	// Add the states of an output pin of the gate that is being run to the
+	// drivers of its wire:
+	void driveOutputPin( PinIndex pin, const PatternWord &word ) {
+		const vector< NetIndex > &pinNets = gateOutputNets[currentGate];
+		// (The inputs are only driven by the patterns.)
+		if( ( pin >= pinNets.size() ) || ( pinNets[pin] == NET_NONE ) || isInputNet[pinNets[pin]] ) return;
+		netDrivers[pinNets[pin]].drive( word );
+	};
+
+	// Apply the faults on a pin of the gate that is being run:
+	void stickInputPin( PinIndex pin, PatternWord &word ) const {
+		if( !inputPinFaults.empty() ) stickPin( inputPinFaults[currentGate], pin, word );
+	};
+	void stickOutputPin( PinIndex pin, PatternWord &word ) const {
+		if( !outputPinFaults.empty() ) stickPin( outputPinFaults[currentGate], pin, word );
+	};
+
+private:
+	// Return the net of a wire, or NET_NONE:
+	NetIndex findNet( IDType wireID ) const;
+
+	// Give a wire (and the rest of its junction group) a net:
+	NetIndex addNet( IDType wireID );
+
+	// Run the gate orderGates[gate]:
+	bool runGate( unsigned long gate );
+
+	static void stickPin( const vector< StuckMask > &pinFaults, PinIndex pin, PatternWord &word ) {
+		if( pin < pinFaults.size() ) word.stick( pinFaults[pin].stuckZero, pinFaults[pin].stuckOne );
+	};
+	static void addFault( StuckMask &fault, StateType stuckAt, unsigned long long mask );
+
+	Circuit *myCircuit;
+
+	// Every wire in a junction group shares one net. netDrivers collects
+	// the states that the gates drive onto each net during runBlock():
+	ID_MAP< IDType, NetIndex > wireNets;
+	vector< vector< IDType > > netWires;
+	vector< PatternWord > netDrivers;
+	vector< bool > isInputNet;
+	vector< NetIndex > inputNets;
+	vector< NetIndex > outputNets;
+
+	// The gates to evaluate, with each gate after the gates that drive it:
+	vector< IDType > orderIDs;
+	vector< Gate * > orderGates;
+
+	// The nets of the pins of each gate in orderGates, so that the gates
+	// don't have to look up their wires. (NET_NONE for the wires that the
+	// outputs don't depend on.)
+	vector< vector< NetIndex > > gateInputNets;
+	vector< vector< NetIndex > > gateOutputNets;
+
+	// The index in orderGates of the gate that is being run:
+	unsigned long currentGate;
+
+	// The faults, if there are any. The pin faults are indexed by the
+	// gate's index in orderGates, then by pin:
+	vector< StuckMask > netFaults;
+	vector< vector< StuckMask > > inputPinFaults;
+	vector< vector< StuckMask > > outputPinFaults;
+
+	vector< PatternWord > outputWords;
+
+	// The table from runAllPatterns(), one word per block for each output:
+	vector< vector< PatternWord > > outputTable;
+};
+
+#endif // LOGIC_PATTERN_SIM_H
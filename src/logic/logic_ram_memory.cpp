@@ -0,0 +1,329 @@
+/*****************************************************************************
+   Project: CEDAR Logic Simulator
+   Copyright 2006 Cedarville University, Benjamin Sprague,
+                     Matt Lewellyn, and David Knierim
+   All rights reserved.
+   For license information see license.txt included with distribution.
+
+   logic_ram_memory: The storage of a RAM gate, in pages of words that are
+   allocated when they are first written, or in a memory-mapped image file
+*****************************************************************************/
+
+#include "logic_ram_memory.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+RamMemory::RamMemory()
+{
+	addressBits = dataBits = 0;
+	addressMask = dataMask = 0;
+	wordBytes = 1;
+	pages.assign( 1, (unsigned char *) NULL );
+	image = NULL;
+	imageBytes = 0;
+}
+
+RamMemory::~RamMemory()
+{
+	// (Leave the words in the image file, rather than copying them out.)
+#ifndef _WIN32
+	if( image != NULL ) munmap( image, imageBytes );
+#endif
+	image = NULL;
+	freePages();
+}
+
+void RamMemory::setSize( unsigned long newAddressBits, unsigned long newDataBits ) {
+	unmapImage();
+
+	// Keep the words that still fit:
+	vector< pair< BusWord, BusWord > > oldWords;
+	BusWord address = 0;
+	while( findNonZero( address ) ) {
+		oldWords.push_back( make_pair( address, read( address ) ) );
+		if( address == addressMask ) break;
+		address++;
+	}
+	freePages();
+	clearDirty();
+	dirtyBitmap.clear();
+
+	addressBits = ( newAddressBits < MAX_BUS_BITS ) ? newAddressBits : MAX_BUS_BITS;
+	dataBits = newDataBits;
+	addressMask = BusValue::mask( addressBits );
+	dataMask = BusValue::mask( dataBits );
+	if( dataBits <= 8 ) wordBytes = 1;
+	else if( dataBits <= 16 ) wordBytes = 2;
+	else if( dataBits <= 32 ) wordBytes = 4;
+	else wordBytes = 8;
+
+	if( addressBits <= PAGE_BITS + FLAT_PAGE_BITS ) {
+		pages.assign( (size_t) ( ( addressMask >> PAGE_BITS ) + 1 ), (unsigned char *) NULL );
+	} else {
+		pages.clear();
+	}
+
+	for( unsigned long i = 0; i < oldWords.size(); i++ ) {
+		if( oldWords[i].first <= addressMask ) {
+			write( oldWords[i].first, oldWords[i].second );
+		}
+	}
+}
+
+bool RamMemory::write( BusWord address, BusWord data ) {
+	if( address > addressMask ) return false;
+	data &= dataMask;
+
+	unsigned char *word;
+	if( image != NULL ) {
+		word = image + address * wordBytes;
+	} else {
+		BusWord pageNumber = address >> PAGE_BITS;
+		unsigned char *page = findPage( pageNumber );
+		if( page == NULL ) {
+			// Nothing to do if a word that reads as 0 is set to 0:
+			if( data == 0 ) return false;
+
+			// (A RAM smaller than a page only gets the words that it has.)
+			size_t pageBytes = (size_t) ( ( addressMask < PAGE_WORDS ) ? ( addressMask + 1 ) : PAGE_WORDS ) * wordBytes;
+			page = new unsigned char[pageBytes];
+			memset( page, 0, pageBytes );
+			if( pageNumber < pages.size() ) pages[(size_t) pageNumber] = page;
+			else sparsePages[pageNumber] = page;
+		}
+		word = page + ( address & ( PAGE_WORDS - 1 ) ) * wordBytes;
+	}
+
+	if( readWord( word ) == data ) return false;
+	writeWord( word, data );
+	markDirty( address );
+	return true;
+}
+
+void RamMemory::markDirty( BusWord address ) {
+	BusWord block = address >> DIRTY_BLOCK_BITS;
+	if( pages.empty() ) {
+		if( dirtyBlocks.empty() || dirtyBlocks.back() != block ) dirtyBlocks.push_back( block );
+		return;
+	}
+	if( dirtyBitmap.empty() ) {
+		dirtyBitmap.assign( (size_t) ( ( addressMask >> DIRTY_BLOCK_BITS ) / 64 + 1 ), 0 );
+	}
+	unsigned long long &bits = dirtyBitmap[(size_t) ( block / 64 )];
+	unsigned long long bit = 1ULL << ( block % 64 );
+	if( bits & bit ) return;
+	bits |= bit;
+	dirtyBlocks.push_back( block );
+}
+
+void RamMemory::takeDirtyBlocks( vector< RamBlock > &blocks ) {
+	sort( dirtyBlocks.begin(), dirtyBlocks.end() );
+	dirtyBlocks.erase( unique( dirtyBlocks.begin(), dirtyBlocks.end() ), dirtyBlocks.end() );
+
+	size_t first = 0;
+	while( first < dirtyBlocks.size() ) {
+		// Find the end of this run of blocks:
+		size_t last = first;
+		while( last + 1 < dirtyBlocks.size() && dirtyBlocks[last + 1] == dirtyBlocks[last] + 1 ) last++;
+
+		RamBlock theBlock;
+		theBlock.address = dirtyBlocks[first] << DIRTY_BLOCK_BITS;
+		BusWord lastAddress = ( dirtyBlocks[last] << DIRTY_BLOCK_BITS ) + ( DIRTY_BLOCK_WORDS - 1 );
+		if( lastAddress > addressMask ) lastAddress = addressMask;
+		theBlock.words.reserve( (size_t) ( lastAddress - theBlock.address + 1 ) );
+		for( BusWord address = theBlock.address; ; address++ ) {
+			theBlock.words.push_back( read( address ) );
+			if( address == lastAddress ) break;
+		}
+		blocks.push_back( theBlock );
+		first = last + 1;
+	}
+	clearDirty();
+}
+
+void RamMemory::clearDirty( void ) {
+	for( size_t i = 0; i < dirtyBlocks.size() && !dirtyBitmap.empty(); i++ ) {
+		dirtyBitmap[(size_t) ( dirtyBlocks[i] / 64 )] &= ~( 1ULL << ( dirtyBlocks[i] % 64 ) );
+	}
+	dirtyBlocks.clear();
+}
+
+void RamMemory::clear( void ) {
+	if( image != NULL ) {
+		memset( image, 0, imageBytes );
+	} else {
+		freePages();
+	}
+}
+
+bool RamMemory::findNonZero( BusWord &address ) const {
+	while( address <= addressMask ) {
+		if( image == NULL ) {
+			// Skip to the next page that has been written:
+			BusWord pageNumber = address >> PAGE_BITS;
+			if( !findWrittenPage( pageNumber ) ) return false;
+			if( pageNumber != address >> PAGE_BITS ) address = pageNumber << PAGE_BITS;
+		}
+		if( read( address ) != 0 ) return true;
+		if( address == addressMask ) break;
+		address++;
+	}
+	return false;
+}
+
+bool RamMemory::findWrittenPage( BusWord &pageNumber ) const {
+	while( pageNumber < pages.size() ) {
+		if( pages[(size_t) pageNumber] != NULL ) return true;
+		pageNumber++;
+	}
+	map< BusWord, unsigned char * >::const_iterator next = sparsePages.lower_bound( pageNumber );
+	if( next == sparsePages.end() ) return false;
+	pageNumber = next->first;
+	return true;
+}
+
+bool RamMemory::mapImage( const string &fileName ) {
+	imageError.clear();
+#ifdef _WIN32
+	imageError = "RAM image files are only mapped on POSIX systems";
+	return false;
+#else
+	unmapImage();
+
+	// (Every word has a place in the file, so it has to fit in memory.)
+	if( addressBits + 3 >= sizeof( size_t ) * 8 ) {
+		imageError = "the RAM is too big to map into memory";
+		return false;
+	}
+	size_t newImageBytes = (size_t) ( addressMask + 1 ) * wordBytes;
+	int fd = open( fileName.c_str(), O_RDWR | O_CREAT, 0644 );
+	if( fd < 0 ) {
+		imageError = "the RAM image file " + fileName + " can't be opened";
+		return false;
+	}
+
+	// A new (or empty) file gets the words that are in the memory now, and
+	// a short one is padded with 0 words:
+	struct stat fileStat;
+	bool newFile = ( fstat( fd, &fileStat ) != 0 ) || ( fileStat.st_size == 0 );
+	if( newFile || ( (size_t) fileStat.st_size < newImageBytes ) ) {
+		if( ftruncate( fd, (off_t) newImageBytes ) != 0 ) {
+			close( fd );
+			imageError = "the RAM image file " + fileName + " can't be resized";
+			return false;
+		}
+	}
+
+	void *newImage = mmap( NULL, newImageBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+	close( fd );
+	if( newImage == MAP_FAILED ) {
+		imageError = "the RAM image file " + fileName + " can't be mapped";
+		return false;
+	}
+
+	if( newFile ) {
+		size_t pageBytes = (size_t) ( ( addressMask < PAGE_WORDS ) ? ( addressMask + 1 ) : PAGE_WORDS ) * wordBytes;
+		BusWord pageNumber = 0;
+		while( findWrittenPage( pageNumber ) ) {
+			memcpy( (unsigned char *) newImage + (size_t) pageNumber * PAGE_WORDS * wordBytes, findPage( pageNumber ), pageBytes );
+			pageNumber++;
+		}
+	}
+	freePages();
+
+	image = (unsigned char *) newImage;
+	imageBytes = newImageBytes;
+	imageFile = fileName;
+	return true;
+#endif
+}
+
+void RamMemory::unmapImage( void ) {
+	if( image == NULL ) return;
+
+	// Copy the words back into pages:
+	unsigned char *oldImage = image;
+	size_t oldImageBytes = imageBytes;
+	BusWord address = 0;
+	vector< pair< BusWord, BusWord > > words;
+	while( findNonZero( address ) ) {
+		words.push_back( make_pair( address, read( address ) ) );
+		if( address == addressMask ) break;
+		address++;
+	}
+	image = NULL;
+	imageBytes = 0;
+	imageFile.clear();
+	for( unsigned long i = 0; i < words.size(); i++ ) {
+		write( words[i].first, words[i].second );
+	}
+
+#ifndef _WIN32
+	munmap( oldImage, oldImageBytes );
+#endif
+}
+
+BusWord RamMemory::readWord( const unsigned char *word ) const {
+	switch( wordBytes ) {
+	case 1:
+		return *word;
+	case 2: {
+		unsigned short theWord;
+		memcpy( &theWord, word, sizeof( theWord ) );
+		return theWord;
+	}
+	case 4: {
+		unsigned int theWord;
+		memcpy( &theWord, word, sizeof( theWord ) );
+		return theWord;
+	}
+	default: {
+		BusWord theWord;
+		memcpy( &theWord, word, sizeof( theWord ) );
+		return theWord;
+	}
+	}
+}
+
+void RamMemory::writeWord( unsigned char *word, BusWord data ) const {
+	switch( wordBytes ) {
+	case 1:
+		*word = (unsigned char) data;
+		break;
+	case 2: {
+		unsigned short theWord = (unsigned short) data;
+		memcpy( word, &theWord, sizeof( theWord ) );
+		break;
+	}
+	case 4: {
+		unsigned int theWord = (unsigned int) data;
+		memcpy( word, &theWord, sizeof( theWord ) );
+		break;
+	}
+	default:
+		memcpy( word, &data, sizeof( data ) );
+		break;
+	}
+}
+
+void RamMemory::freePages( void ) {
+	for( size_t i = 0; i < pages.size(); i++ ) {
+		delete [] pages[i];
+		pages[i] = NULL;
+	}
+	map< BusWord, unsigned char * >::iterator page = sparsePages.begin();
+	while( page != sparsePages.end() ) {
+		delete [] page->second;
+		page++;
+	}
+	sparsePages.clear();
+}
@@ -0,0 +1,170 @@
+/*****************************************************************************
+   Project: CEDAR Logic Simulator
+   Copyright 2006 Cedarville University, Benjamin Sprague,
+                     Matt Lewellyn, and David Knierim
+   All rights reserved.
+   For license information see license.txt included with distribution.
+
+   logic_ram_memory: The storage of a RAM gate, in pages of words that are
+   allocated when they are first written, or in a memory-mapped image file
+*****************************************************************************/
+
+#ifndef LOGIC_RAM_MEMORY_H
+#define LOGIC_RAM_MEMORY_H
+
+#include "logic_bus_value.h"
+
+#include <map>
+#include <string>
+#include <vector>
+using namespace std;
+
+// A run of words of a RAM, from "address" on:
+struct RamBlock {
+	BusWord address;
+	vector< BusWord > words;
+};
+
+// The words of a RAM gate that changed, for the GUI's copy of them:
+struct RamChanges {
+	IDType gateID;
+	BusWord lastWritten;
+	vector< RamBlock > blocks;
+};
+
+// A RamMemory holds one word per address of a RAM with "addressBits" address
+// lines, in as few bytes as "dataBits" need (1, 2, 4 or 8). A word that has
+// never been written reads as 0, and so does an address past the end of
+// the RAM, which can't be written.
+//
+// The words are kept in pages of PAGE_WORDS. A page is only allocated when a
+// word in it is first written, so reading a word never allocates anything,
+// and a RAM that is mostly unused takes little space. The pages are found in
+// a table by page number, or for a RAM of more than FLAT_PAGE_BITS pages'
+// worth of address bits, in a map of just the pages that have been written.
+//
+// With mapImage(), the words are kept in a file instead, mapped into memory.
+// The file holds every word of the RAM in address order, in the machine's
+// byte order, so it is read or written by the operating system as the
+// words are used rather than all at once. This is meant for large RAMs
+// (20 or more address bits), whose memory files take a long time to parse.
+// Images are only mapped on POSIX systems.
+//
+// The memory also notes which blocks of DIRTY_BLOCK_WORDS have changed, so
+// that takeDirtyBlocks() can give just those words to the GUI, in runs.
+class RamMemory
+{
+public:
+	RamMemory();
+	~RamMemory();
+
+	// The number of words in a page, and its log base 2:
+	static const unsigned long PAGE_BITS = 12;
+	static const unsigned long PAGE_WORDS = 1 << PAGE_BITS;
+
+	// The widest page number that is kept in a table:
+	static const unsigned long FLAT_PAGE_BITS = 20;
+
+	// The number of words in a dirty block, and its log base 2:
+	static const unsigned long DIRTY_BLOCK_BITS = 6;
+	static const unsigned long DIRTY_BLOCK_WORDS = 1 << DIRTY_BLOCK_BITS;
+
+	// Change the size of the memory. The words that still fit are kept,
+	// cut down to the new data width. (An image file is unmapped first.)
+	void setSize( unsigned long newAddressBits, unsigned long newDataBits );
+
+	// Return the word at an address:
+	BusWord read( BusWord address ) const {
+		if( address > addressMask ) return 0;
+		const unsigned char *page;
+		if( image != NULL ) {
+			page = image;
+		} else {
+			page = findPage( address >> PAGE_BITS );
+			if( page == NULL ) return 0;
+			address &= PAGE_WORDS - 1;
+		}
+		return readWord( page + address * wordBytes );
+	};
+
+	// Write a word, cut down to the data width. Returns true if the word
+	// changed (and then its block is dirty), and false for an address past
+	// the end of the RAM:
+	bool write( BusWord address, BusWord data );
+
+	BusWord getAddressMask( void ) const { return addressMask; };
+
+	// Add the words of the dirty blocks to "blocks", with each run of
+	// dirty blocks as one RamBlock, and make them clean:
+	bool isDirty( void ) const { return !dirtyBlocks.empty(); };
+	void takeDirtyBlocks( vector< RamBlock > &blocks );
+	void clearDirty( void );
+
+	// Set every word to 0:
+	void clear( void );
+
+	// Find the first word that isn't 0 at or after "address", and set
+	// "address" to it. Returns false if there isn't one:
+	bool findNonZero( BusWord &address ) const;
+
+	// Keep the words in an image file from now on. If the file is new or
+	// empty, it starts with the words that are in the memory now; otherwise
+	// its words replace them. Returns false if the file can't be mapped,
+	// and getImageError() says why:
+	bool mapImage( const string &fileName );
+
+	// Stop using the image file, and keep its words in pages again:
+	void unmapImage( void );
+
+	const string &getImageFile( void ) const { return imageFile; };
+	const string &getImageError( void ) const { return imageError; };
+
+private:
+	// (A RamMemory owns its pages, so it isn't copied.)
+	RamMemory( const RamMemory &other );
+	RamMemory &operator=( const RamMemory &other );
+
+	BusWord readWord( const unsigned char *word ) const;
+	void writeWord( unsigned char *word, BusWord data ) const;
+
+	// Return a page, or NULL if it hasn't been written:
+	unsigned char *findPage( BusWord pageNumber ) const {
+		if( pageNumber < pages.size() ) return pages[(size_t) pageNumber];
+		map< BusWord, unsigned char * >::const_iterator found = sparsePages.find( pageNumber );
+		return ( found != sparsePages.end() ) ? found->second : NULL;
+	};
+
+	// Move "pageNumber" on to the first page at or after it that has been
+	// written. Returns false if there isn't one:
+	bool findWrittenPage( BusWord &pageNumber ) const;
+
+	// Free all of the pages:
+	void freePages( void );
+
+	// Note that the block of a word is dirty:
+	void markDirty( BusWord address );
+
+	unsigned long addressBits, dataBits;
+	BusWord addressMask, dataMask;
+	unsigned long wordBytes;
+
+	// The pages, by address / PAGE_WORDS (NULL until they are written), in
+	// a table or (if the table is empty) a map:
+	vector< unsigned char * > pages;
+	map< BusWord, unsigned char * > sparsePages;
+
+	// The dirty blocks, as a bitmap by address / DIRTY_BLOCK_WORDS (which
+	// is allocated when it is first needed), and in the order that they
+	// were made dirty. (The RAMs with a map of pages have no bitmap, and
+	// their list is sorted out when the blocks are taken.)
+	vector< unsigned long long > dirtyBitmap;
+	vector< BusWord > dirtyBlocks;
+
+	// The mapped image file, if there is one:
+	unsigned char *image;
+	size_t imageBytes;
+	string imageFile;
+	string imageError;
+};
+
+#endif // LOGIC_RAM_MEMORY_H
@@ -0,0 +1,114 @@
+/*****************************************************************************
+   Project: CEDAR Logic Simulator
+   Copyright 2006 Cedarville University, Benjamin Sprague,
+                     Matt Lewellyn, and David Knierim
+   All rights reserved.
+   For license information see license.txt included with distribution.
+
+   logic_thread_pool: Worker threads that share the gate updates of a step
+*****************************************************************************/
+
+#include "logic_thread_pool.h"
+
+LogicThreadPool::LogicThreadPool()
+{
+	jobTask = NULL;
+	jobTasks = 0;
+	nextTask = 0;
+	jobNumber = 0;
+	busyWorkers = 0;
+	stopping = false;
+}
+
+LogicThreadPool::~LogicThreadPool()
+{
+	setNumThreads( 1 );
+}
+
+void LogicThreadPool::setNumThreads( unsigned int numThreads ) {
+	if( numThreads < 1 ) numThreads = 1;
+	if( numThreads == getNumThreads() ) return;
+
+	// Stop all of the workers, and start the right number again:
+	{
+		std::lock_guard< std::mutex > lock( poolMutex );
+		stopping = true;
+	}
+	startJob.notify_all();
+	for( size_t i = 0; i < workers.size(); i++ ) {
+		workers[i].join();
+	}
+	workers.clear();
+
+	// (No job is running, so the workers all start out waiting for the
+	// one after jobNumber.)
+	stopping = false;
+	for( unsigned int i = 1; i < numThreads; i++ ) {
+		workers.push_back( std::thread( &LogicThreadPool::workerLoop, this, jobNumber ) );
+	}
+}
+
+void LogicThreadPool::run( size_t numTasks, const std::function< void( size_t ) > &task ) {
+	if( workers.empty() || numTasks < 2 ) {
+		for( size_t i = 0; i < numTasks; i++ ) task( i );
+		return;
+	}
+
+	{
+		std::lock_guard< std::mutex > lock( poolMutex );
+		jobTask = &task;
+		jobTasks = numTasks;
+		nextTask = 0;
+		busyWorkers = (unsigned int) workers.size();
+		jobError = nullptr;
+		jobNumber++;
+	}
+	startJob.notify_all();
+
+	// Help out, then wait for the workers to finish their last tasks:
+	runTasks();
+
+	std::unique_lock< std::mutex > lock( poolMutex );
+	jobDone.wait( lock, [this]() { return busyWorkers == 0; } );
+	jobTask = NULL;
+	if( jobError ) {
+		std::exception_ptr error = jobError;
+		jobError = nullptr;
+		std::rethrow_exception( error );
+	}
+}
+
+void LogicThreadPool::workerLoop( unsigned long long lastJob ) {
+	while( true ) {
+		{
+			std::unique_lock< std::mutex > lock( poolMutex );
+			startJob.wait( lock, [this, lastJob]() { return stopping || jobNumber != lastJob; } );
+			if( stopping ) return;
+			lastJob = jobNumber;
+		}
+
+		runTasks();
+
+		{
+			std::lock_guard< std::mutex > lock( poolMutex );
+			busyWorkers--;
+			if( busyWorkers == 0 ) jobDone.notify_one();
+		}
+	}
+}
+
+void LogicThreadPool::runTasks( void ) {
+	while( true ) {
+		size_t task = nextTask.fetch_add( 1 );
+		if( task >= jobTasks ) return;
+		try {
+			(*jobTask)( task );
+		} catch( ... ) {
+			// Keep the first error and hand out no more tasks:
+			std::lock_guard< std::mutex > lock( poolMutex );
+			if( !jobError ) jobError = std::current_exception();
+			nextTask = jobTasks;
+			return;
+		}
+	}
+}
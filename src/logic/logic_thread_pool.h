@@ -0,0 +1,69 @@
+/*****************************************************************************
+   Project: CEDAR Logic Simulator
+   Copyright 2006 Cedarville University, Benjamin Sprague,
+                     Matt Lewellyn, and David Knierim
+   All rights reserved.
+   For license information see license.txt included with distribution.
+
+   logic_thread_pool: Worker threads that share the gate updates of a step
+*****************************************************************************/
+
+#ifndef LOGIC_THREAD_POOL_H
+#define LOGIC_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A LogicThreadPool runs one job on several threads at once, and waits for
+// all of them to finish. The calling thread is one of the threads, so a pool
+// of one thread just calls the job.
+//
+// The workers sleep between jobs. A job hands out its work through
+// nextTask(), so a slow piece of work doesn't hold up the rest.
+class LogicThreadPool
+{
+public:
+	LogicThreadPool();
+	~LogicThreadPool();
+
+	// Set the number of threads, counting the calling thread. The workers
+	// are started and stopped as needed:
+	void setNumThreads( unsigned int numThreads );
+	unsigned int getNumThreads( void ) const { return (unsigned int) workers.size() + 1; };
+
+	// Call task( i ) for every i from 0 to numTasks - 1, spread over the
+	// threads, and return when all of them are done. If a task throws, no
+	// more tasks are started, and the first exception is thrown again here
+	// once the threads are done:
+	void run( size_t numTasks, const std::function< void( size_t ) > &task );
+
+private:
+	void workerLoop( unsigned long long lastJob );
+
+	// Take tasks from the current job until there are none left. An
+	// exception is kept in jobError instead of leaving the thread:
+	void runTasks( void );
+
+	std::vector< std::thread > workers;
+
+	std::mutex poolMutex;
+	std::condition_variable startJob;
+	std::condition_variable jobDone;
+
+	// The current job. jobNumber counts the jobs, so that a worker
+	// knows when a new one has started:
+	const std::function< void( size_t ) > *jobTask;
+	size_t jobTasks;
+	std::atomic< size_t > nextTask;
+	unsigned long long jobNumber;
+	unsigned int busyWorkers;
+	std::exception_ptr jobError;
+	bool stopping;
+};
+
+#endif // LOGIC_THREAD_POOL_H
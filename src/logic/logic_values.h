@@ -28,6 +28,11 @@ typedef unsigned long long TimeType;
 // Exception: loaded files may have values near the end of this range.
 typedef unsigned long long IDType;
 
+// The index of a declared gate pin. Pins are numbered in the order
+// that they are declared, starting from 0, and are never removed,
+// so an index stays good for the life of the gate:
+typedef unsigned long PinIndex;
+
 
 // The number of states in the simulator:
 const int NUM_STATES = 5;
@@ -49,4 +54,7 @@ const TimeType DEFAULT_GATE_DELAY = 1;
 // The ID that represents an unconnected wire or gate:
 const IDType ID_NONE = ULLONG_MAX;
 
+// The index that represents an undeclared gate pin:
+const PinIndex PIN_NONE = (PinIndex) -1;
+
 #endif
\ No newline at end of file
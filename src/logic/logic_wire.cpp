@@ -23,7 +23,7 @@ bool operator < (const WireInput &left, const WireInput &right) {
 		return true;
 	} else if( left.gateID > right.gateID ) {
 		return false;
-	} else if( left.gateOutputID < right.gateOutputID ) {
+	} else if( left.gateOutputPin < right.gateOutputPin ) {
 		return true;
 	} else return false;
 }
@@ -56,6 +56,13 @@ Wire::Wire()
 	// Always initialize new wires to high-impedance since they are floating
 	// until they are connected to a gate:
 	wireState = HI_Z;
+
+	junctionGroup = GROUP_NONE;
+
+	for( int i = 0; i < NUM_STATES; i++ ) {
+		stateCount[i] = 0;
+	}
+	stateMask = 0;
 }
 
 
@@ -66,75 +73,26 @@ Wire::~Wire()
 
 
 // Change the state of one of the wires' inputs. Don't update the internal state yet.
-void Wire::setInputState(IDType gateID, string gateOutputID, StateType newState)
+void Wire::setInputState(IDType gateID, PinIndex gateOutputPin, StateType newState)
 {
-	WireInput theInput( gateID, gateOutputID, newState );
-	if( inputList.find( theInput ) == inputList.end() ) {
+	ID_SET< WireInput >::iterator thisInput = inputList.find( WireInput( gateID, gateOutputPin ) );
+	if( thisInput == inputList.end() ) {
 		WARNING("Wire::setInputState() - Invalid input ID.");
-		_MSG("Wire Input ID: %lld %s", theInput.gateID, theInput.gateOutputID.c_str());
+		_MSG("Wire Input ID: %lld pin %lu", gateID, gateOutputPin);
 	} else {
 		// Set the new state of the WireInput:
-		// (Erase the old one, and re-create the new one.)
-		inputList.erase( inputList.find( theInput ) );
-		inputList.insert( theInput );
+		// (Done in place, so that pointers to it in the Netlist stay good.)
+		changeInputState( *thisInput, newState );
 	}
 }
 
 
 // Update the internal state of the wire.
 // Return the new state.
-StateType Wire::calculateState( set< WIRE_PTR > wireGroup )
+StateType Wire::calculateState( unsigned int groupMask )
 {
-	// The boolean map to tell which states are input into this wire:
-	vector<bool> stateMap( NUM_STATES, false );
-
-	// Loop through each wire in the list:
-	set< WIRE_PTR >::iterator thisWire = wireGroup.begin();
-	while( thisWire != wireGroup.end() ) {
-
-		// Tally up all of the input states into this wire:
-		if( (*thisWire)->inputList.empty() ) {
-			// The wire isn't connected to any inputs, so it is in the HI-Z state by default!
-			stateMap[HI_Z] = true;
-		} else {
-			ID_SET< WireInput >::iterator thisInput = (*thisWire)->inputList.begin();
-			StateType thisState;
-			while( thisInput != (*thisWire)->inputList.end() ) {
-				thisState = thisInput->inputState;
-				thisInput++;
-	
-				// Assign this state map position the value of "true" because
-				// we found an input with that state type:
-				stateMap[thisState] = true;
-			}
-		}
-
-		thisWire++;
-	}
-
-	// Calculate the state based on the types of input states that exist:
-	if( (stateMap[ZERO] && stateMap[ONE]) || stateMap[CONFLICT] ) {
-		// There are conflicting inputs, so the output is "CONFLICT":
-		wireState = CONFLICT;
-	} else if( stateMap[ONE] ) {
-		// No conflict or unknowns and ONE is true, so the output is ONE:
-		wireState = ONE;
-	} else if( stateMap[ZERO] ) {
-		// No conflict or unknowns and ZERO is true, so the output is ZERO:
-		wireState = ZERO;
-	} else if( stateMap[UNKNOWN] ) {
-		// There is an unknown input, but no conflict, so the output is unknown:
-		wireState = UNKNOWN;
-//TODO: Add an option to automatically set UNKNOWN to ONE or ZERO, to allow
-// memory circuits to function correctly.
-	} else if( stateMap[HI_Z] ) {
-		// No conflict or unknowns or values except HI_Z, so the output is HI_Z:
-		wireState = HI_Z;
-	} else {
-		wireState = UNKNOWN;
-		WARNING("Wire::calculateState() - No valid input states!");
-	}
-
+	// Look up the state that wins:
+	wireState = STATE_MASK_TABLE.state[groupMask];
 	return wireState;
 }
 
@@ -168,29 +126,33 @@ StateType Wire::getState( void )
 
 	
 // Connect a gate output to this wire:
-void Wire::connectInput( IDType gateID, string gateOutputID )
+void Wire::connectInput( IDType gateID, PinIndex gateOutputPin, const string &gateOutputID )
 {
 	// Only one wire input per gate & gateOutput is allowed.
 	// (The input's state is initialized to "unknown".)
-	WireInput newInput( gateID, gateOutputID, UNKNOWN );
+	WireInput newInput( gateID, gateOutputPin, gateOutputID, UNKNOWN );
 
 	// Add it into the input list:
-	inputList.insert( newInput );
+	if( inputList.insert( newInput ).second ) {
+		addInputState( newInput.inputState );
+	}
 }
 
 
 // Disconnect a gate output from this wire's input.
-void Wire::disconnectInput( IDType gateID, string gateOutputID ) {
+void Wire::disconnectInput( IDType gateID, PinIndex gateOutputPin, const string &gateOutputID ) {
 
 	// Verify that the input exists:
-	if( inputList.find( WireInput( gateID, gateOutputID ) ) == inputList.end() ) {
+	ID_SET< WireInput >::iterator thisInput = inputList.find( WireInput( gateID, gateOutputPin, gateOutputID ) );
+	if( thisInput == inputList.end() ) {
 		WARNING("Wire::disconnectInput() - Input does not exist.");
 		_MSG("Input wire ID: %lld %s", gateID, gateOutputID.c_str());
 		return;
 	}
 
 	// Remove that input from the wire's list:
-	inputList.erase( WireInput( gateID, gateOutputID ) );
+	removeInputState( thisInput->inputState );
+	inputList.erase( thisInput );
 }
 
 
@@ -232,7 +194,7 @@ WireInput Wire::getFirstInput( void ) {
 		inP++;
 	}
 
-	WireInput junk( ID_NONE, "" );
+	WireInput junk( ID_NONE, PIN_NONE );
 	return junk;
 }
 
@@ -23,22 +23,32 @@ class Wire;
 class Junction;
 class Circuit;
 
+// Index of a wire's junction group in the Circuit, or GROUP_NONE if
+// the wire isn't joined to any other wires:
+typedef unsigned long GroupIndex;
+const GroupIndex GROUP_NONE = (GroupIndex) -1;
+
 
 // An input to a wire:
 // This allows the wires to never have duplicate inputs from a gate, as well as
 // enabling disconnecting wires to work correctly.
 class WireInput {
 public:
-	WireInput( IDType gateID, string gateOutputID, StateType inputState = UNKNOWN ) {
+	WireInput( IDType gateID, PinIndex gateOutputPin, const string &gateOutputID = "", StateType inputState = UNKNOWN ) {
 		this->gateID = gateID;
+		this->gateOutputPin = gateOutputPin;
 		this->gateOutputID = gateOutputID;
 		this->inputState = inputState;
 	}
 	
 	IDType gateID;
+	// The inputs are found by the output's pin index, so that events
+	// don't have to carry the output's name:
+	PinIndex gateOutputPin;
 	string gateOutputID;
 
-	StateType inputState;
+	// (Not part of the ordering, so it can be changed in place inside of a set.)
+	mutable StateType inputState;
 };
 
 // Operator for WireInput (Allows it to be stored in maps).
@@ -64,17 +74,53 @@ bool operator < (const WireOutput &left, const WireOutput &right);
 bool operator < (const WIRE_PTR &left, const WIRE_PTR &right);
 
 
+// A state mask has bit (1 << state) set for every state that is driven onto a wire:
+const unsigned int NUM_STATE_MASKS = 1 << NUM_STATES;
+
+// Return the state of a wire, given the mask of its input states:
+// A conflict, or both ZERO and ONE, is a CONFLICT. Otherwise ONE or ZERO win,
+// then UNKNOWN, then HI_Z.
+constexpr StateType resolveStateMask( unsigned int stateMask ) {
+	return ( ( ( stateMask & ( 1 << ZERO ) ) && ( stateMask & ( 1 << ONE ) ) ) || ( stateMask & ( 1 << CONFLICT ) ) ) ? CONFLICT :
+		( stateMask & ( 1 << ONE ) ) ? ONE :
+		( stateMask & ( 1 << ZERO ) ) ? ZERO :
+		( stateMask & ( 1 << UNKNOWN ) ) ? UNKNOWN :
+		( stateMask & ( 1 << HI_Z ) ) ? HI_Z :
+		UNKNOWN;
+}
+
+// resolveStateMask() for every possible mask, built at compile time:
+struct StateMaskTable {
+	StateType state[NUM_STATE_MASKS];
+};
+
+#define RESOLVE_MASKS_4( m ) resolveStateMask( m ), resolveStateMask( m + 1 ), resolveStateMask( m + 2 ), resolveStateMask( m + 3 )
+#define RESOLVE_MASKS_16( m ) RESOLVE_MASKS_4( m ), RESOLVE_MASKS_4( m + 4 ), RESOLVE_MASKS_4( m + 8 ), RESOLVE_MASKS_4( m + 12 )
+static_assert( NUM_STATE_MASKS == 32, "STATE_MASK_TABLE is written out for 5 states" );
+constexpr StateMaskTable STATE_MASK_TABLE = { { RESOLVE_MASKS_16( 0 ), RESOLVE_MASKS_16( 16 ) } };
+#undef RESOLVE_MASKS_16
+#undef RESOLVE_MASKS_4
+
+
 class Wire  
 {
 friend class Junction;
 friend class Circuit;
+friend class Netlist;
 public:
 	// Change the state of one of the wires' inputs. Don't update the internal state yet.
-	void setInputState(IDType gateID, string gateOutputID, StateType newState);
+	void setInputState(IDType gateID, PinIndex gateOutputPin, StateType newState);
 
-	// Update the internal state of the wire.
+	// Update the internal state of the wire, from the state masks of all
+	// the wires in its junction group OR'ed together.
 	// Return the new state.
-	StateType calculateState( set< WIRE_PTR > wireGroup );
+	StateType calculateState( unsigned int groupMask );
+
+	// Return the mask of this wire's input states:
+	// (A wire with no inputs is floating, so it counts as HI_Z.)
+	unsigned int getStateMask( void ) const {
+		return ( stateMask != 0 ) ? stateMask : ( 1 << HI_Z );
+	};
 	
 	// Force the wire to change state (used when a wire is in a junction group):
 	void forceState( StateType newState );
@@ -86,13 +132,13 @@ public:
 	StateType getState( void );
 
 	// Connect a gate output to this wire:
-	void connectInput( IDType gateID, string gateOutputID );
+	void connectInput( IDType gateID, PinIndex gateOutputPin, const string &gateOutputID );
 
 	// Connect this wire to a gate input:
 	void connectOutput( IDType gateID, string gateInputID );
 
 	// Disconnect a gate output from this wire's input.
-	void disconnectInput( IDType gateID, string gateOutputID );
+	void disconnectInput( IDType gateID, PinIndex gateOutputPin, const string &gateOutputID );
 
 	// Disconnect a gate input from this wire's output:
 	void disconnectOutput( IDType gateID, string gateInputID );
@@ -128,6 +174,21 @@ protected:
 		junctionList.erase( theJunction );
 	};
 
+	// Change the state of an input in inputList, keeping the state counts up to date:
+	void changeInputState( const WireInput &theInput, StateType newState ) {
+		removeInputState( theInput.inputState );
+		theInput.inputState = newState;
+		addInputState( newState );
+	};
+
+	// Count an input state in or out of stateCount and stateMask:
+	void addInputState( StateType theState ) {
+		if( stateCount[theState]++ == 0 ) stateMask |= ( 1 << theState );
+	};
+	void removeInputState( StateType theState ) {
+		if( --stateCount[theState] == 0 ) stateMask &= ~( 1 << theState );
+	};
+
 protected:
 	StateType wireState; // The current state of this wire.
 
@@ -141,6 +202,15 @@ protected:
 	
 	// A list of junctions that this wire connects to.
 	ID_SET< IDType > junctionList;
+
+	// The number of inputs in each state, and the mask of the states
+	// with a count above zero:
+	unsigned long stateCount[NUM_STATES];
+	unsigned int stateMask;
+
+	// The group of wires that this wire is joined to by enabled junctions:
+	// (Maintained by the Circuit.)
+	GroupIndex junctionGroup;
 };
 
 #endif // LOGIC_WIRE_H
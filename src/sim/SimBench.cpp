@@ -0,0 +1,419 @@
+/*****************************************************************************
+   Project: CEDAR Logic Simulator
+   Copyright 2006 Cedarville University, Benjamin Sprague,
+                     Matt Lewellyn, and David Knierim
+   All rights reserved.
+   For license information see license.txt included with distribution.
+
+   SimBench: cedarlogic-bench, times the logic core on synthetic circuits
+*****************************************************************************/
+
+#include "../logic/logic_circuit.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Every allocation made by the program goes through these, so the
+// allocations of the timed steps can be counted. (The gate threads
+// allocate too, so the count is atomic.)
+static atomic< unsigned long long > allocCount( 0 );
+
+void* operator new(size_t size) {
+	allocCount++;
+	void* p = malloc(size ? size : 1);
+	if (p == NULL) throw bad_alloc();
+	return p;
+}
+
+void operator delete(void* p) noexcept {
+	free(p);
+}
+
+void operator delete[](void* p) noexcept {
+	free(p);
+}
+
+// C++14 compilers may call the sized versions instead, so they are
+// replaced too, to always pair with the operator new() above:
+void operator delete(void* p, size_t) noexcept {
+	free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+	free(p);
+}
+
+// The peak resident set size of the process so far, in kB:
+static unsigned long long peakRSS() {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return 0;
+	return pmc.PeakWorkingSetSize / 1024;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+	return usage.ru_maxrss / 1024; // bytes on macOS
+#else
+	return usage.ru_maxrss;
+#endif
+#endif
+}
+
+// Pin names of busses, like "IN_3":
+static string pin(const string &name, unsigned long bit) {
+	ostringstream oss;
+	oss << name << "_" << bit;
+	return oss.str();
+}
+
+static string toString(unsigned long value) {
+	ostringstream oss;
+	oss << value;
+	return oss.str();
+}
+
+// Makes the gates of a synthetic circuit. Only the Circuit calls are used,
+// the same way that SimCircuitParse::buildCircuit() builds a circuit file.
+class BenchBuilder {
+public:
+	BenchBuilder(Circuit* cir) : cir(cir), numGates(0), numWires(0) {};
+
+	IDType gate(const string &type, unsigned long inputBits = 0) {
+		IDType id = cir->newGate(type);
+		numGates++;
+		if (inputBits) cir->setGateParameter(id, "INPUT_BITS", toString(inputBits));
+		return id;
+	};
+
+	IDType wire() {
+		numWires++;
+		return cir->newWire();
+	};
+
+	void in(IDType gateID, const string &pinName, IDType wireID) { cir->connectGateInput(gateID, pinName, wireID); };
+	void out(IDType gateID, const string &pinName, IDType wireID) { cir->connectGateOutput(gateID, pinName, wireID); };
+
+	// An unconnected input that is held at ONE:
+	void pullUp(IDType gateID, const string &pinName) { cir->setGateInputParameter(gateID, pinName, "PULL_UP", "TRUE"); };
+
+	// A CLOCK gate and its output wire:
+	IDType clock(unsigned long halfCycle) {
+		IDType clk = gate("CLOCK");
+		cir->setGateParameter(clk, "HALF_CYCLE", toString(halfCycle));
+		IDType w = wire();
+		out(clk, "CLK", w);
+		return w;
+	};
+
+	// Clocks with different half cycles, so their edges don't line up:
+	vector< IDType > clocks(unsigned long count) {
+		static const unsigned long halfCycles[] = { 2, 3, 5, 7, 11, 13, 17, 19 };
+		vector< IDType > wires;
+		for (unsigned long i = 0; i < count; i++) {
+			wires.push_back(clock(halfCycles[i % 8] + 20 * (i / 8)));
+		}
+		return wires;
+	};
+
+	// A counter REGISTER clocked by clk, returns its output wires:
+	vector< IDType > counter(IDType clk, unsigned long bits, unsigned long maxCount) {
+		IDType reg = gate("REGISTER", bits);
+		cir->setGateParameter(reg, "MAX_COUNT", toString(maxCount));
+		in(reg, "CLOCK", clk);
+		pullUp(reg, "COUNT_ENABLE");
+		vector< IDType > outs;
+		for (unsigned long i = 0; i < bits; i++) {
+			outs.push_back(wire());
+			out(reg, pin("OUT", i), outs[i]);
+		}
+		return outs;
+	};
+
+	Circuit* cir;
+	unsigned long numGates, numWires;
+};
+
+// A ripple-carry chain of 4-bit ADDERs. The A and B inputs come from clocks,
+// and every carry out feeds the carry in of the next adder:
+static void buildAdder(BenchBuilder &b, unsigned long size) {
+	vector< IDType > clk = b.clocks(4);
+	IDType carry = clk[0];
+	for (unsigned long k = 0; k < size; k++) {
+		IDType adder = b.gate("ADDER", 4);
+		for (unsigned long i = 0; i < 4; i++) {
+			b.in(adder, pin("IN", i), clk[i]);
+			b.in(adder, pin("IN_B", i), clk[(i + k + 1) % 4]);
+			b.out(adder, pin("OUT", i), b.wire());
+		}
+		b.in(adder, "CARRY_IN", carry);
+		carry = b.wire();
+		b.out(adder, "CARRY_OUT", carry);
+	}
+}
+
+// A ring of 16-bit shift REGISTERs. Every register shifts its carry out into
+// the carry in of the next one on each clock:
+static void buildRegister(BenchBuilder &b, unsigned long size) {
+	const unsigned long bits = 16;
+	IDType clk = b.clock(2);
+	vector< IDType > ring;
+	for (unsigned long k = 0; k < size; k++) {
+		ring.push_back(b.wire());
+	}
+	for (unsigned long k = 0; k < size; k++) {
+		IDType reg = b.gate("REGISTER", bits);
+		b.cir->setGateParameter(reg, "MAX_COUNT", toString((1UL << bits) - 1));
+		b.cir->setGateParameter(reg, "CURRENT_VALUE", toString((k * 40503 + 1) & 0xFFFF));
+		b.in(reg, "CLOCK", clk);
+		b.pullUp(reg, "SHIFT_ENABLE");
+		b.in(reg, "CARRY_IN", ring[k]);
+		b.out(reg, "CARRY_OUT", ring[(k + 1) % size]);
+		for (unsigned long i = 0; i < bits; i++) {
+			b.out(reg, pin("OUT", i), b.wire());
+		}
+	}
+}
+
+// 16x8 RAMs that take turns writing and reading. While WRITE_ENABLE is high
+// a data counter is written on each WRITE_CLOCK edge, and otherwise the RAMs
+// drive their outputs into BUFFERs. An address counter walks the addresses
+// that all of the RAMs share:
+static void buildRAM(BenchBuilder &b, unsigned long size) {
+	const unsigned long addressBits = 4, dataBits = 8;
+	IDType writeClk = b.clock(1);
+	IDType writeEnable = b.clock(3);
+	vector< IDType > address = b.counter(b.clock(7), addressBits, (1UL << addressBits) - 1);
+	vector< IDType > data = b.counter(b.clock(2), dataBits, (1UL << dataBits) - 1);
+	for (unsigned long k = 0; k < size; k++) {
+		IDType ram = b.gate("RAM");
+		b.cir->setGateParameter(ram, "ADDRESS_BITS", toString(addressBits));
+		b.cir->setGateParameter(ram, "DATA_BITS", toString(dataBits));
+		IDType reader = b.gate("BUFFER", dataBits);
+		for (unsigned long i = 0; i < addressBits; i++) {
+			b.in(ram, pin("ADDRESS", i), address[i]);
+		}
+		for (unsigned long i = 0; i < dataBits; i++) {
+			IDType dataOut = b.wire();
+			b.in(ram, pin("DATA_IN", i), data[(i + k) % dataBits]);
+			b.out(ram, pin("DATA_OUT", i), dataOut);
+			b.in(reader, pin("IN", i), dataOut);
+			b.out(reader, pin("OUT", i), b.wire());
+		}
+		b.in(ram, "WRITE_CLOCK", writeClk);
+		b.in(ram, "WRITE_ENABLE", writeEnable);
+		b.pullUp(ram, "ENABLE");
+	}
+}
+
+// An 8-bit bus with size drivers. Each driver bit is a TGATE between its own
+// buffered data wire and a TO junction of the bus line. A counter and a
+// DECODER turn on one driver at a time, and FROM junctions read the bus:
+static void buildBus(BenchBuilder &b, unsigned long size) {
+	const unsigned long bits = 8;
+	unsigned long selBits = 1;
+	while ((1UL << selBits) < size) selBits++;
+
+	vector< IDType > clk = b.clocks(4);
+	vector< IDType > select = b.counter(b.clock(23), selBits, size - 1);
+	IDType decoder = b.gate("DECODER", selBits);
+	b.pullUp(decoder, "ENABLE");
+	vector< IDType > enable;
+	for (unsigned long i = 0; i < selBits; i++) {
+		b.in(decoder, pin("IN", i), select[i]);
+	}
+	for (unsigned long k = 0; k < size; k++) {
+		enable.push_back(b.wire());
+		b.out(decoder, pin("OUT", k), enable[k]);
+	}
+
+	for (unsigned long k = 0; k < size; k++) {
+		IDType driver = b.gate("BUFFER", bits);
+		for (unsigned long i = 0; i < bits; i++) {
+			IDType data = b.wire(), stub = b.wire();
+			b.in(driver, pin("IN", i), clk[(i + k) % 4]);
+			b.out(driver, pin("OUT", i), data);
+
+			IDType tgate = b.gate("TGATE");
+			b.in(tgate, "T_IN", data);
+			b.in(tgate, "T_IN2", stub);
+			b.in(tgate, "T_CTRL", enable[k]);
+
+			IDType to = b.gate("TO");
+			b.cir->setGateParameter(to, "JUNCTION_ID", pin("BUS", i));
+			b.in(to, "IN_0", stub);
+		}
+	}
+
+	IDType reader = b.gate("BUFFER", bits);
+	for (unsigned long i = 0; i < bits; i++) {
+		IDType line = b.wire();
+		IDType from = b.gate("FROM");
+		b.cir->setGateParameter(from, "JUNCTION_ID", pin("BUS", i));
+		b.in(from, "IN_0", line);
+		b.in(reader, pin("IN", i), line);
+		b.out(reader, pin("OUT", i), b.wire());
+	}
+}
+
+// CLOCKs that each drive a tree of BUFFERs, three levels deep with a fan out of 4:
+static void buildClock(BenchBuilder &b, unsigned long size) {
+	const unsigned long depth = 3, fanOut = 4;
+	for (unsigned long k = 0; k < size; k++) {
+		vector< IDType > level(1, b.clock(k % 7 + 1));
+		for (unsigned long d = 0; d < depth; d++) {
+			vector< IDType > nextLevel;
+			for (unsigned long w = 0; w < level.size(); w++) {
+				IDType buffer = b.gate("BUFFER", fanOut);
+				for (unsigned long i = 0; i < fanOut; i++) {
+					nextLevel.push_back(b.wire());
+					b.in(buffer, pin("IN", i), level[w]);
+					b.out(buffer, pin("OUT", i), nextLevel.back());
+				}
+			}
+			level = nextLevel;
+		}
+	}
+}
+
+struct benchmark {
+	string name;
+	void (*build)(BenchBuilder &b, unsigned long size);
+	unsigned long size; // at scale 1
+};
+
+static const benchmark benchmarks[] = {
+	{ "adder", buildAdder, 256 },
+	{ "register", buildRegister, 64 },
+	{ "ram", buildRAM, 32 },
+	{ "bus", buildBus, 16 },
+	{ "clock", buildClock, 32 },
+};
+static const unsigned long numBenchmarks = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+static void usage() {
+	cerr << "Usage: cedarlogic-bench [options]" << endl
+		<< "  -b <name>       Only run one benchmark: adder, register, ram, bus or clock" << endl
+		<< "  -x <scale>      Multiply the circuit sizes (default 1)" << endl
+		<< "  -n <steps>      Number of timed steps (default 10000)" << endl
+		<< "  -W <steps>      Number of steps to run before timing (default 100)" << endl
+		<< "  -s heap|wheel   Event scheduler (default wheel)" << endl
+		<< "  -m              Step on the wire and gate maps instead of the compiled netlist" << endl
+		<< "  -t <threads>    Number of threads that update the gates (default 1)" << endl
+		<< "Prints one CSV line per benchmark. peak_rss_kb is the peak of the whole" << endl
+		<< "process so far, so use -b to measure one benchmark alone." << endl;
+}
+
+int main(int argc, char* argv[]) {
+	string only = "";
+	unsigned long scale = 1;
+	unsigned long numSteps = 10000;
+	unsigned long warmSteps = 100;
+	EventQueue::SchedulerType scheduler = EventQueue::SCHED_TIMING_WHEEL;
+	bool useNetlist = true;
+	unsigned int numThreads = 1;
+
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (arg == "-b" && i + 1 < argc) {
+			only = argv[++i];
+		} else if (arg == "-x" && i + 1 < argc) {
+			scale = strtoul(argv[++i], NULL, 10);
+		} else if (arg == "-n" && i + 1 < argc) {
+			numSteps = strtoul(argv[++i], NULL, 10);
+		} else if (arg == "-W" && i + 1 < argc) {
+			warmSteps = strtoul(argv[++i], NULL, 10);
+		} else if (arg == "-s" && i + 1 < argc) {
+			string sched = argv[++i];
+			if (sched == "heap") scheduler = EventQueue::SCHED_HEAP;
+			else if (sched == "wheel") scheduler = EventQueue::SCHED_TIMING_WHEEL;
+			else {
+				usage();
+				return 2;
+			}
+		} else if (arg == "-m") {
+			useNetlist = false;
+		} else if (arg == "-t" && i + 1 < argc) {
+			numThreads = strtoul(argv[++i], NULL, 10);
+		} else {
+			usage();
+			return 2;
+		}
+	}
+	if (scale == 0 || numSteps == 0 || numThreads == 0) {
+		usage();
+		return 2;
+	}
+
+	bool found = (only == "");
+	for (unsigned long n = 0; n < numBenchmarks; n++) {
+		if (benchmarks[n].name == only) found = true;
+	}
+	if (!found) {
+		usage();
+		return 2;
+	}
+
+	cout << "benchmark,size,gates,wires,scheduler,netlist,threads,steps,events,events_per_step,ns_per_event,ns_per_step,allocs_per_step,peak_rss_kb" << endl;
+	for (unsigned long n = 0; n < numBenchmarks; n++) {
+		const benchmark &bench = benchmarks[n];
+		if (only != "" && bench.name != only) continue;
+
+		Circuit cir(NULL);
+		cir.setEventScheduler(scheduler);
+		cir.setCompiledNetlist(useNetlist);
+		cir.setGateThreads(numThreads);
+		BenchBuilder builder(&cir);
+		unsigned long size = bench.size * scale;
+		bench.build(builder, size);
+
+		// Settle the circuit, and build the netlist, before timing:
+		for (unsigned long i = 0; i < warmSteps; i++) {
+			ID_SET< IDType > changedWires;
+			cir.step(&changedWires);
+		}
+
+		// The changed wires are collected each step, like the logic thread does:
+		unsigned long long startEvents = cir.getEventCount();
+		unsigned long long startAllocs = allocCount;
+		chrono::steady_clock::time_point runStart = chrono::steady_clock::now();
+		for (unsigned long i = 0; i < numSteps; i++) {
+			ID_SET< IDType > changedWires;
+			cir.step(&changedWires);
+		}
+		chrono::steady_clock::time_point runEnd = chrono::steady_clock::now();
+		unsigned long long numAllocs = allocCount - startAllocs;
+		unsigned long long numEvents = cir.getEventCount() - startEvents;
+		double runNanoseconds = chrono::duration< double, nano >(runEnd - runStart).count();
+
+		cout << bench.name << ","
+			<< size << ","
+			<< builder.numGates << ","
+			<< builder.numWires << ","
+			<< (scheduler == EventQueue::SCHED_HEAP ? "heap" : "wheel") << ","
+			<< (useNetlist ? "netlist" : "map") << ","
+			<< numThreads << ","
+			<< numSteps << ","
+			<< numEvents << ","
+			<< (double) numEvents / numSteps << ","
+			<< (numEvents ? runNanoseconds / numEvents : 0) << ","
+			<< runNanoseconds / numSteps << ","
+			<< (double) numAllocs / numSteps << ","
+			<< peakRSS() << endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,215 @@
+/*****************************************************************************
+   Project: CEDAR Logic Simulator
+   Copyright 2006 Cedarville University, Benjamin Sprague,
+                     Matt Lewellyn, and David Knierim
+   All rights reserved.
+   For license information see license.txt included with distribution.
+
+   SimCircuitParse: Loads a user circuit file straight into a logic Circuit
+*****************************************************************************/
+
+#include "SimCircuitParse.h"
+#include "../gui/XMLParser.h"
+#include "../logic/logic_circuit.h"
+
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+SimCircuitParse::SimCircuitParse(SimLibraryParse* library) {
+	mParse = nullptr;
+	this->library = library;
+}
+
+SimCircuitParse::~SimCircuitParse() {
+}
+
+bool SimCircuitParse::loadFile(string fileName) {
+	fstream x(fileName.c_str(), ios::in);
+	if (!x.is_open()) return false;
+	mParse = new XMLParser(&x, false);
+	gates.clear();
+	notFoundTypes.clear();
+	bool isCircuit = parseFile();
+	delete mParse;
+	mParse = nullptr;
+	return isCircuit;
+}
+
+// Same structure as CircuitParse::parseFile():
+bool SimCircuitParse::parseFile() {
+	string firstTag = mParse->readTag();
+
+	// The version is only used to warn about newer files:
+	if (firstTag == "version") {
+		mParse->readTagValue("version");
+		mParse->readCloseTag();
+		firstTag = mParse->readTag();
+	}
+
+	if (firstTag != "circuit") return false;
+
+	if (mParse->readTag() == "CurrentPage") {
+		mParse->readTagValue("CurrentPage");
+		mParse->readCloseTag();
+	}
+
+	do { // while next tag is not close circuit
+		string pageTag = mParse->readTag();
+		if (pageTag == "") break;
+
+		// while next tag is not close page
+		while (!mParse->isCloseTag(mParse->getCurrentIndex()) && !mParse->isEOF()) {
+			string temp = mParse->readTag();
+			if (temp == "gate") {
+				parseGate();
+			} else if (temp != "") {
+				// Viewports and wire shapes are only needed by the GUI:
+				mParse->skipTag();
+			}
+		}
+		mParse->readTagValue(pageTag);
+		mParse->readCloseTag();
+	} while (!mParse->isCloseTag(mParse->getCurrentIndex()) && !mParse->isEOF());
+
+	if (mParse->isEOF()) return true;
+	mParse->readCloseTag();
+
+	// Files are saved with a dummy circuit for old versions first, followed
+	// by a "throw_away" tag and the real circuit (see CircuitParse::saveCircuit()):
+	if (mParse->readTag() == "throw_away") {
+		mParse->readCloseTag();
+		gates.clear();
+		notFoundTypes.clear();
+		return parseFile();
+	}
+	return true;
+}
+
+// Same as the gate part of CircuitParse::parseFile():
+void SimCircuitParse::parseGate() {
+	simGate newGate;
+	string temp;
+	do { // get full gate structure
+		temp = mParse->readTag(); // get tag
+		if (temp == "ID") { // get ID
+			istringstream iss(mParse->readTagValue(temp));
+			iss >> newGate.id;
+		} else if (temp == "type") { // get type
+			newGate.type = mParse->readTagValue(temp);
+			// Renamed gate types, see CircuitParse::parseFile():
+			if (newGate.type == "AM_RAM_16x16_Single_Port") newGate.type = "AM_RAM_16x16";
+			else if (newGate.type == "CA_SMALL_TGATE") newGate.type = "TA_TGATE";
+			else if (newGate.type == "CB_PRI_ENCODER_4x2") newGate.type = "CB_ENCODER_4x2_EN";
+			else if (newGate.type == "CC_PRI_ENCODER_8x3") newGate.type = "CC_ENCODER_8x3_EN";
+			else if (newGate.type == "CD_PRI_ENCODER_16x4") newGate.type = "CD_ENCODER_16x4_EN";
+		} else if (temp == "input" || temp == "output") { // get input or output
+			bool isInput = (temp == "input");
+			temp = mParse->readTag(); // get connection ID
+			gateConnector gc;
+			gc.connectionID = mParse->readTagValue(temp);
+			for (unsigned long cnt = 0; cnt < gc.connectionID.length(); cnt++)
+				gc.connectionID[cnt] = toupper(gc.connectionID[cnt]);
+			if (isInput && gc.connectionID == "ENABLE_0")
+				gc.connectionID = "OUTPUT_ENABLE";
+			mParse->readCloseTag();
+			istringstream iss(mParse->readTagValue(isInput ? "input" : "output"));
+			IDType tempId;
+			while (iss >> tempId) {
+				gc.wireIds.push_back(tempId);
+			}
+			if (isInput) newGate.inputs.push_back(gc);
+			else newGate.outputs.push_back(gc);
+		} else if (temp == "lparam" || temp == "gparam") { // get parameter
+			string x, y;
+			istringstream iss(mParse->readTagValue(temp));
+			iss >> x;
+			getline(iss, y, '\n');
+			// PULSE_WIDTH used to be a gui param:
+			if (x == "PULSE_WIDTH") temp = "lparam";
+			if (temp == "lparam") {
+				newGate.params.push_back(parameter(x, y.substr(y.empty() ? 0 : 1), false));
+			}
+		}
+		mParse->readCloseTag(); // </>
+	} while (!mParse->isCloseTag(mParse->getCurrentIndex()) && !mParse->isEOF());
+	mParse->readCloseTag(); // >gate
+
+	if (!library->getGate(newGate.type, newGate.libGate)) {
+		// Like CircuitParse, a gate that is not in the library is left unconnected:
+		notFoundTypes.push_back(newGate.type);
+		return;
+	}
+	gates.push_back(newGate);
+}
+
+// Sends the same requests to the Circuit as CircuitParse::parseGateToSend()
+// sends to the logic thread. The whole file is one batch:
+void SimCircuitParse::buildCircuit(Circuit* cir) {
+	cir->beginBatch();
+	for (unsigned long g = 0; g < gates.size(); g++) {
+		simGate &gate = gates[g];
+		simLibraryGate &libGate = gate.libGate;
+		if (libGate.logicType.size() == 0) continue;
+
+		cir->newGate(libGate.logicType, gate.id);
+
+		// Library default logic params that the file did not have:
+		vector < parameter > params = gate.params;
+		map < string, string >::iterator lpwalk = libGate.logicParams.begin();
+		while (lpwalk != libGate.logicParams.end()) {
+			bool found = false;
+			for (unsigned long i = 0; i < params.size(); i++)
+				if (params[i].paramName == lpwalk->first) {
+					found = true;
+					break;
+				}
+			if (!found) {
+				params.push_back(parameter(lpwalk->first, lpwalk->second, false));
+			}
+			lpwalk++;
+		}
+		for (unsigned long i = 0; i < params.size(); i++) {
+			cir->setGateParameter(gate.id, params[i].paramName, params[i].paramValue);
+		}
+
+		// Hotspot settings:
+		for (unsigned long i = 0; i < libGate.hotspots.size(); i++) {
+			simHotspot &hs = libGate.hotspots[i];
+			if (hs.isInverted) {
+				if (hs.isInput) {
+					cir->setGateInputParameter(gate.id, hs.name, "INVERTED", "TRUE");
+				} else {
+					cir->setGateOutputParameter(gate.id, hs.name, "INVERTED", "TRUE");
+				}
+			}
+			if (hs.isInput) {
+				if (hs.isPullUp) cir->setGateInputParameter(gate.id, hs.name, "PULL_UP", "TRUE");
+				if (hs.isPullDown) cir->setGateInputParameter(gate.id, hs.name, "PULL_DOWN", "TRUE");
+				if (hs.ForceJunction) cir->setGateInputParameter(gate.id, hs.name, "FORCE_JUNCTION", "TRUE");
+			} else if (hs.logicEInput != "") {
+				cir->setGateOutputParameter(gate.id, hs.name, "E_INPUT", hs.logicEInput);
+			}
+		}
+
+		// Connect inputs and outputs. Bus-lines have their bit appended,
+		// see cmdConnectWire::sendMessagesToConnect():
+		for (unsigned long i = 0; i < gate.inputs.size(); i++) {
+			gateConnector &gc = gate.inputs[i];
+			for (unsigned long b = 0; b < gc.wireIds.size(); b++) {
+				string hotspot = gc.connectionID;
+				if (gc.wireIds.size() > 1) hotspot += "_" + to_string(b);
+				cir->connectGateInput(gate.id, hotspot, gc.wireIds[b]);
+			}
+		}
+		for (unsigned long i = 0; i < gate.outputs.size(); i++) {
+			gateConnector &gc = gate.outputs[i];
+			for (unsigned long b = 0; b < gc.wireIds.size(); b++) {
+				string hotspot = gc.connectionID;
+				if (gc.wireIds.size() > 1) hotspot += "_" + to_string(b);
+				cir->connectGateOutput(gate.id, hotspot, gc.wireIds[b]);
+			}
+		}
+	}
+	cir->commitBatch();
+}
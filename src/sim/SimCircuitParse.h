@@ -0,0 +1,64 @@
+/*****************************************************************************
+   Project: CEDAR Logic Simulator
+   Copyright 2006 Cedarville University, Benjamin Sprague,
+                     Matt Lewellyn, and David Knierim
+   All rights reserved.
+   For license information see license.txt included with distribution.
+
+   SimCircuitParse: Loads a user circuit file straight into a logic Circuit
+*****************************************************************************/
+
+#ifndef SIMCIRCUITPARSE_H_
+#define SIMCIRCUITPARSE_H_
+
+#include <string>
+#include <vector>
+#include "../gui/CircuitParse.h"
+#include "SimLibraryParse.h"
+using namespace std;
+
+class Circuit;
+class XMLParser;
+
+// A gate as it was read from the circuit file:
+struct simGate {
+	IDType id;
+	string type;
+	simLibraryGate libGate;
+	vector < gateConnector > inputs, outputs;
+	vector < parameter > params;
+};
+
+// Class SimCircuitParse:
+//	Reads circuit files the same way that CircuitParse does, and sends the
+//	gates and connections to a Circuit by calling it directly instead of
+//	through the GUI and the logic thread. Wire shapes and gui params are skipped.
+class SimCircuitParse {
+public:
+	SimCircuitParse(SimLibraryParse* library);
+	virtual ~SimCircuitParse();
+
+	// Read a circuit file. Returns false if it can't be opened or is not a circuit:
+	bool loadFile(string fileName);
+
+	// Create the gates that were read, with their params and connections:
+	void buildCircuit(Circuit* cir);
+
+	// The gates that were read:
+	vector < simGate >& getGates() { return gates; };
+
+	// The types of the gates that were not found in the library:
+	vector < string >& getNotFound() { return notFoundTypes; };
+
+private:
+	bool parseFile();
+	void parseGate();
+
+	XMLParser* mParse;
+	SimLibraryParse* library;
+
+	vector < simGate > gates;
+	vector < string > notFoundTypes;
+};
+
+#endif /*SIMCIRCUITPARSE_H_*/
@@ -0,0 +1,197 @@
+/*****************************************************************************
+   Project: CEDAR Logic Simulator
+   Copyright 2006 Cedarville University, Benjamin Sprague,
+                     Matt Lewellyn, and David Knierim
+   All rights reserved.
+   For license information see license.txt included with distribution.
+
+   SimLibraryParse: Reads the logic half of the gate libraries, without wx
+*****************************************************************************/
+
+#include "SimLibraryParse.h"
+#include "../gui/XMLParser.h"
+
+#include <cstdlib>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+// Return true if the string is a non-empty run of decimal digits:
+static bool isNumber(const string &number) {
+	if (number.empty()) return false;
+	for (unsigned int i = 0; i < number.size(); i++)
+		if (!isdigit((unsigned char)number[i])) return false;
+	return true;
+}
+
+SimLibraryParse::SimLibraryParse() {
+	mParse = nullptr;
+}
+
+SimLibraryParse::~SimLibraryParse() {
+}
+
+bool SimLibraryParse::loadFile(string fileName) {
+	fstream x(fileName.c_str(), ios::in);
+	if (!x.is_open()) return false;
+	mParse = new XMLParser(&x, false);
+	parseFile();
+	delete mParse;
+	mParse = nullptr;
+	return true;
+}
+
+bool SimLibraryParse::getGate(string gateName, simLibraryGate &libGate) {
+	map < string, simLibraryGate >::iterator found = gates.find(gateName);
+	if (found == gates.end()) {
+		if (gateName.substr(0, 3) != "@@_" || !createDynamicGate(gateName)) return false;
+		found = gates.find(gateName);
+	}
+	libGate = found->second;
+	return true;
+}
+
+// Same structure as LibraryParse::parseFile():
+void SimLibraryParse::parseFile() {
+	do { // Outer loop to parse all libraries
+		if (mParse->readTag() != "library") return;
+		mParse->readTag();
+		mParse->readTagValue("name");
+		mParse->readCloseTag();
+
+		do {
+			if (mParse->readTag() != "gate") break;
+			simLibraryGate newGate;
+			string temp = mParse->readTag();
+			newGate.gateName = mParse->readTagValue(temp);
+			mParse->readCloseTag();
+			do {
+				temp = mParse->readTag();
+				if (temp == "") break;
+				if ((temp == "input") || (temp == "output")) {
+					newGate.hotspots.push_back(parseHotspot(temp == "input"));
+				} else if (temp == "logic_type") {
+					newGate.logicType = mParse->readTagValue("logic_type");
+					mParse->readCloseTag();
+				} else if (temp == "logic_param") {
+					// Values may contain spaces, see LibraryParse:
+					string paramName, paramVal;
+					istringstream iss(mParse->readTagValue("logic_param"));
+					iss >> paramName;
+					while (true) {
+						string temp;
+						iss >> temp;
+						paramVal = paramVal + temp;
+						if (iss.eof()) break;
+						paramVal = paramVal + " ";
+					}
+					newGate.logicParams[paramName] = paramVal;
+					mParse->readCloseTag();
+				} else {
+					// Shapes, captions, dialogs and gui params are not needed here:
+					mParse->skipTag();
+				}
+			} while (!mParse->isCloseTag(mParse->getCurrentIndex())); // end gate
+			gates[newGate.gateName] = newGate;
+			mParse->readCloseTag(); //gate
+		} while (!mParse->isCloseTag(mParse->getCurrentIndex())); // end library
+		if (mParse->isEOF()) return;
+		mParse->readCloseTag(); // clear the close tag
+	} while (true); // end file
+}
+
+simHotspot SimLibraryParse::parseHotspot(bool isInput) {
+	simHotspot newHotspot(isInput);
+	do {
+		string temp = mParse->readTag();
+		if (temp == "") break;
+		if (temp == "name") {
+			newHotspot.name = mParse->readTagValue("name");
+			for (unsigned long cnt = 0; cnt < newHotspot.name.length(); cnt++)
+				newHotspot.name[cnt] = toupper(newHotspot.name[cnt]);
+			if (newHotspot.name == "ENABLE_0")
+				newHotspot.name = "OUTPUT_ENABLE";
+		} else if (temp == "inverted") {
+			newHotspot.isInverted = (mParse->readTagValue("inverted") == "true");
+		} else if (temp == "pull_up") {
+			// Only inputs can have <pull_up>, <pull_down> and <force_junction> tags:
+			newHotspot.isPullUp = isInput && (mParse->readTagValue("pull_up") == "true");
+		} else if (temp == "pull_down") {
+			newHotspot.isPullDown = isInput && (mParse->readTagValue("pull_down") == "true");
+		} else if (temp == "force_junction") {
+			newHotspot.ForceJunction = isInput && (mParse->readTagValue("force_junction") == "true");
+		} else if (temp == "enable_input") {
+			// Only outputs can have <enable_input> tags:
+			if (!isInput) newHotspot.logicEInput = mParse->readTagValue("enable_input");
+		}
+		mParse->readCloseTag();
+	} while (!mParse->isCloseTag(mParse->getCurrentIndex())); // end input/output
+	mParse->readCloseTag(); //input or output
+	return newHotspot;
+}
+
+// Only the logic type, logic params and pin settings of LibraryParse::CreateDynamicGate()
+// are made here. The gate files save every logic param anyway.
+bool SimLibraryParse::createDynamicGate(string type) {
+	simLibraryGate newGate;
+	newGate.gateName = type;
+
+	if (type.substr(0, 8) == "@@_WIRE_") {				// @@_WIRE_L
+		if (!isNumber(type.substr(8))) return false;
+		newGate.logicType = "NODE";
+	} else if (type.substr(0, 10) == "@@_NOWIRE_") {		// @@_NOWIRE_WXH
+		newGate.logicType = "NODE";
+	} else if (type.substr(0, 10) == "@@_BUSEND_" || type.substr(0, 11) == "@@_BUSENDN_") {		// @@_BUSEND_N    @@_BUSENDN_N
+		string nInputs = type.substr(type.find('_', 3) + 1);
+		if (!isNumber(nInputs)) return false;
+		newGate.logicType = "BUSEND";
+		newGate.logicParams["INPUT_BITS"] = nInputs;
+	} else if (type.substr(0, 7) == "@@_BLQ_") {			// @@_BLQ_WXH
+		// Just a drawing, there is no logic gate.
+	} else if (type.substr(0, 7) == "@@_CMB_") {			// @@_CMB_IXO
+		string inBits = type.substr(7, type.find("X") - 7);
+		string outBits = type.substr(type.find("X") + 1);
+		if (!isNumber(inBits) || !isNumber(outBits)) return false;
+		newGate.logicType = "CMB";
+		newGate.logicParams["INPUT_BITS"] = inBits;
+		newGate.logicParams["OUTPUT_BITS"] = outBits;
+		for (int i = 0; i < atoi(outBits.c_str()); i++) {
+			ostringstream oss;
+			oss << i;
+			newGate.logicParams["Function:" + oss.str()] = "O" + oss.str() + "=0";
+		}
+	} else if (type.substr(0, 7) == "@@_FSM_") {			// @@_FSM_T_IXO
+		if (type.substr(7, 1) != "A" && type.substr(7, 1) != "S") return false;
+		string inBits = type.substr(9, type.find("X") - 9);
+		string outBits = type.substr(type.find("X") + 1);
+		if (!isNumber(inBits) || !isNumber(outBits)) return false;
+		newGate.logicType = (type.substr(7, 1) == "A") ? "FSM_ASYNC" : "FSM_SYNC";
+		newGate.logicParams["INPUT_BITS"] = inBits;
+		newGate.logicParams["OUTPUT_BITS"] = outBits;
+		string state = "Q0/" + string(atoi(outBits.c_str()), '0');
+		if (atoi(inBits.c_str())) state += " " + string(atoi(inBits.c_str()), 'X');
+		newGate.logicParams["State:0"] = state + "-Q0";
+	} else if (type.substr(0, 8) == "@@_LAND_" || type.substr(0, 7) == "@@_LOR_") {		// @@_LAND_N    @@_LOR_N
+		bool isAnd = (type.substr(0, 8) == "@@_LAND_");
+		string nInputs = type.substr(isAnd ? 8 : 7);
+		if (!isNumber(nInputs)) return false;
+		newGate.logicType = isAnd ? "PLD_AND" : "PLD_OR";
+		newGate.logicParams["INPUT_BITS"] = nInputs;
+		newGate.logicParams[isAnd ? "FORCE_ZERO" : "FORCE_ONE"] = "false";
+		// Unconnected AND inputs float high, and OR inputs low:
+		for (int i = 0; i < atoi(nInputs.c_str()); i++) {
+			ostringstream oss;
+			oss << "IN_" << i;
+			simHotspot newHotspot(true);
+			newHotspot.name = oss.str();
+			newHotspot.isPullUp = isAnd;
+			newHotspot.isPullDown = !isAnd;
+			newGate.hotspots.push_back(newHotspot);
+		}
+	} else {
+		return false;
+	}
+
+	gates[type] = newGate;
+	return true;
+}
@@ -0,0 +1,68 @@
+/*****************************************************************************
+   Project: CEDAR Logic Simulator
+   Copyright 2006 Cedarville University, Benjamin Sprague,
+                     Matt Lewellyn, and David Knierim
+   All rights reserved.
+   For license information see license.txt included with distribution.
+
+   SimLibraryParse: Reads the logic half of the gate libraries, without wx
+*****************************************************************************/
+
+#ifndef SIMLIBRARYPARSE_H_
+#define SIMLIBRARYPARSE_H_
+
+#include <map>
+#include <string>
+#include <vector>
+using namespace std;
+
+class XMLParser;
+
+// A gate input or output, with the settings that are sent to the logic core:
+struct simHotspot {
+	simHotspot( bool nIsInput = true ) : isInput(nIsInput), isInverted(false), isPullUp(false), isPullDown(false), ForceJunction(false) {};
+	string name;
+	bool isInput;
+	bool isInverted;
+	bool isPullUp;
+	bool isPullDown;
+	bool ForceJunction;
+	string logicEInput;
+};
+
+// The parts of a LibraryGate that the logic core uses:
+struct simLibraryGate {
+	string gateName;
+	string logicType;
+	map < string, string > logicParams;
+	vector < simHotspot > hotspots;
+};
+
+// Class SimLibraryParse:
+//	Reads library files the same way that LibraryParse does, but skips the
+//	shapes, dialogs and gui params, so that it does not need wxWidgets.
+class SimLibraryParse {
+public:
+	SimLibraryParse();
+	virtual ~SimLibraryParse();
+
+	// Add the gates of a library file. Returns false if the file can't be opened:
+	bool loadFile(string fileName);
+
+	// Look up a gate by name. Dynamic ("@@_") gates are made the first time they are asked for:
+	bool getGate(string gateName, simLibraryGate &libGate);
+
+	unsigned long getNumGates() { return gates.size(); };
+
+private:
+	void parseFile();
+	simHotspot parseHotspot(bool isInput);
+
+	// Builds the logic side of the gates that LibraryParse::CreateDynamicGate makes:
+	bool createDynamicGate(string type);
+
+	XMLParser* mParse;
+	map < string, simLibraryGate > gates;
+};
+
+#endif /*SIMLIBRARYPARSE_H_*/
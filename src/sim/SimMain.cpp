@@ -0,0 +1,343 @@
+/*****************************************************************************
+   Project: CEDAR Logic Simulator
+   Copyright 2006 Cedarville University, Benjamin Sprague,
+                     Matt Lewellyn, and David Knierim
+   All rights reserved.
+   For license information see license.txt included with distribution.
+
+   SimMain: cedarlogic-sim, runs a circuit file without the GUI
+*****************************************************************************/
+
+#include "SimLibraryParse.h"
+#include "SimCircuitParse.h"
+#include "../logic/logic_circuit.h"
+#include "../logic/logic_fault_sim.h"
+#include "../logic/logic_pattern_sim.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+
+static void usage() {
+	cerr << "Usage: cedarlogic-sim [options] circuit.cdl" << endl
+		<< "  -n <steps>      Number of time steps to run (default 1000)" << endl
+		<< "  -l <library>    Gate library (default res/cl_gatedefs.xml)" << endl
+		<< "  -u <library>    Extra user library, like UserLib.xml" << endl
+		<< "  -s heap|wheel   Event scheduler (default wheel)" << endl
+		<< "  -m              Step on the wire and gate maps instead of the compiled netlist" << endl
+		<< "  -t <threads>    Number of threads that update the gates (default 1)" << endl
+		<< "  -c              Run a synchronous circuit a clock edge at a time, without events" << endl
+		<< "  -C              Like -c, with the gates compiled into C++ first" << endl
+		<< "  -T              Print the truth table from the toggles and keypads to the LEDs" << endl
+		<< "  -f <stimulus>   Run the test vectors in a file on every stuck-at fault" << endl
+		<< "  -w              Print the final state of every wire" << endl;
+}
+
+static char stateChar(StateType state) {
+	switch (state) {
+	case ZERO: return '0';
+	case ONE: return '1';
+	case HI_Z: return 'Z';
+	case CONFLICT: return 'C';
+	default: return 'X';
+	}
+}
+
+// The number of a bus pin, like 3 for "OUT_3":
+static unsigned long pinNumber(const string& connectionID) {
+	string::size_type under = connectionID.rfind('_');
+	return (under == string::npos) ? 0 : strtoul(connectionID.c_str() + under + 1, NULL, 10);
+}
+
+// The inputs of a combinational circuit are the wires driven by the toggles
+// and keypads (DRIVER gates), and the outputs are the wires of the LEDs:
+static void findTableWires(vector < simGate >& gates, vector < IDType >& inputWires, vector < IDType >& outputList) {
+	set < IDType > outputWires;
+	for (unsigned long g = 0; g < gates.size(); g++) {
+		if (gates[g].libGate.logicType == "DRIVER") {
+			map < unsigned long, IDType > outWires;
+			for (unsigned long i = 0; i < gates[g].outputs.size(); i++) {
+				if (!gates[g].outputs[i].wireIds.empty()) {
+					outWires[pinNumber(gates[g].outputs[i].connectionID)] = gates[g].outputs[i].wireIds[0];
+				}
+			}
+			map < unsigned long, IDType >::iterator outWire = outWires.begin();
+			while (outWire != outWires.end()) {
+				inputWires.push_back(outWire->second);
+				outWire++;
+			}
+		} else if (gates[g].libGate.logicType == "NODE" && gates[g].type.find("LED") != string::npos) {
+			for (unsigned long i = 0; i < gates[g].inputs.size(); i++) {
+				outputWires.insert(gates[g].inputs[i].wireIds.begin(), gates[g].inputs[i].wireIds.end());
+			}
+		}
+	}
+	outputList.assign(outputWires.begin(), outputWires.end());
+}
+
+// Print the inputs, most significant first, and the outputs:
+static void printTableWires(const vector < IDType >& inputWires, const vector < IDType >& outputList) {
+	cout << "inputs";
+	for (unsigned long i = inputWires.size(); i > 0; i--) cout << " " << inputWires[i - 1];
+	cout << endl << "outputs";
+	for (unsigned long o = 0; o < outputList.size(); o++) cout << " " << outputList[o];
+	cout << endl;
+}
+
+// Run every input pattern through the combinational gates:
+static int printTruthTable(Circuit& cir, vector < simGate >& gates) {
+	vector < IDType > inputWires, outputList;
+	findTableWires(gates, inputWires, outputList);
+
+	PatternSim patterns(&cir);
+	if (!patterns.build(inputWires, outputList) || !patterns.runAllPatterns()) {
+		cerr << "Error: can't make a truth table for this circuit" << endl;
+		return 1;
+	}
+
+	printTableWires(inputWires, outputList);
+	for (unsigned long long pattern = 0; pattern < patterns.getNumPatterns(); pattern++) {
+		for (unsigned long i = inputWires.size(); i > 0; i--) {
+			cout << (((pattern >> (i - 1)) & 1) ? '1' : '0');
+		}
+		cout << " ";
+		for (unsigned long o = 0; o < outputList.size(); o++) {
+			cout << stateChar(patterns.getOutputState(o, pattern));
+		}
+		cout << endl;
+	}
+	return 0;
+}
+
+// Print where a fault is and what it is stuck at:
+static void printFault(const StuckFault& fault) {
+	cout << "fault ";
+	if (fault.site == StuckFault::SITE_WIRE) cout << "wire " << fault.wireID;
+	else cout << "gate " << fault.gateID << " " << fault.pinName;
+	cout << " sa" << stateChar(fault.stuckAt);
+}
+
+// Run the test vectors in a stimulus file on every stuck-at fault of the
+// combinational gates. Each line of the file is a vector of 0, 1 or X for
+// each input, most significant first (as -T prints them). Blank lines and
+// lines starting with # are skipped:
+static int printFaultCoverage(Circuit& cir, vector < simGate >& gates, const string& stimulusFile, unsigned int numThreads) {
+	vector < IDType > inputWires, outputList;
+	findTableWires(gates, inputWires, outputList);
+
+	vector < vector < StateType > > testVectors;
+	ifstream stimulus(stimulusFile.c_str());
+	if (!stimulus) {
+		cerr << "Error: can't read stimulus " << stimulusFile << endl;
+		return 1;
+	}
+	string line;
+	unsigned long lineNumber = 0;
+	while (getline(stimulus, line)) {
+		lineNumber++;
+		string::size_type comment = line.find('#');
+		if (comment != string::npos) line.erase(comment);
+
+		vector < StateType > testVector;
+		bool badChar = false;
+		for (unsigned long c = 0; c < line.size(); c++) {
+			if (line[c] == '0') testVector.insert(testVector.begin(), ZERO);
+			else if (line[c] == '1') testVector.insert(testVector.begin(), ONE);
+			else if (line[c] == 'X' || line[c] == 'x') testVector.insert(testVector.begin(), UNKNOWN);
+			else if (!isspace((unsigned char)line[c])) badChar = true;
+		}
+		if (testVector.empty() && !badChar) continue;
+		if (badChar || testVector.size() != inputWires.size()) {
+			cerr << "Error: line " << lineNumber << " is not a vector of " << inputWires.size() << " inputs" << endl;
+			return 1;
+		}
+		testVectors.push_back(testVector);
+	}
+
+	FaultSim faultSim(&cir);
+	faultSim.setNumThreads(numThreads);
+	chrono::steady_clock::time_point runStart = chrono::steady_clock::now();
+	if (!faultSim.build(inputWires, outputList) || !faultSim.run(testVectors)) {
+		cerr << "Error: can't run the faults of this circuit" << endl;
+		return 1;
+	}
+	double runSeconds = chrono::duration< double >(chrono::steady_clock::now() - runStart).count();
+
+	unsigned long numFaults = faultSim.getNumFaults();
+	unsigned long numDetected = faultSim.getNumDetected();
+	printTableWires(inputWires, outputList);
+	cout << "vectors " << testVectors.size() << endl;
+	cout << "faults " << numFaults << endl;
+	cout << "detected " << numDetected << endl;
+	cout << "unobservable " << faultSim.getNumUnobservable() << endl;
+	cout << "coverage " << (numFaults > 0 ? 100.0 * numDetected / numFaults : 100.0) << "%" << endl;
+	cout << "run_seconds " << runSeconds << endl;
+	for (unsigned long f = 0; f < numFaults; f++) {
+		const StuckFault& fault = faultSim.getFault(f);
+		printFault(fault);
+		if (fault.detected) cout << " detected " << fault.detectedBy << endl;
+		else cout << " undetected" << endl;
+	}
+	for (unsigned long f = 0; f < faultSim.getNumUnobservable(); f++) {
+		printFault(faultSim.getUnobservableFault(f));
+		cout << " unobservable" << endl;
+	}
+	return 0;
+}
+
+int main(int argc, char* argv[]) {
+	unsigned long numSteps = 1000;
+	string libFile = "res/cl_gatedefs.xml";
+	string userLibFile = "";
+	string cdlFile = "";
+	EventQueue::SchedulerType scheduler = EventQueue::SCHED_TIMING_WHEEL;
+	bool useNetlist = true;
+	bool printWires = false;
+	bool truthTable = false;
+	string stimulusFile = "";
+	unsigned int numThreads = 1;
+	bool cycleMode = false;
+	bool compiledGates = false;
+
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (arg == "-n" && i + 1 < argc) {
+			numSteps = strtoul(argv[++i], NULL, 10);
+		} else if (arg == "-l" && i + 1 < argc) {
+			libFile = argv[++i];
+		} else if (arg == "-u" && i + 1 < argc) {
+			userLibFile = argv[++i];
+		} else if (arg == "-s" && i + 1 < argc) {
+			string sched = argv[++i];
+			if (sched == "heap") scheduler = EventQueue::SCHED_HEAP;
+			else if (sched == "wheel") scheduler = EventQueue::SCHED_TIMING_WHEEL;
+			else {
+				usage();
+				return 2;
+			}
+		} else if (arg == "-m") {
+			useNetlist = false;
+		} else if (arg == "-w") {
+			printWires = true;
+		} else if (arg == "-c") {
+			cycleMode = true;
+		} else if (arg == "-C") {
+			cycleMode = true;
+			compiledGates = true;
+		} else if (arg == "-T") {
+			truthTable = true;
+		} else if (arg == "-f" && i + 1 < argc) {
+			stimulusFile = argv[++i];
+		} else if (arg == "-t" && i + 1 < argc) {
+			numThreads = strtoul(argv[++i], NULL, 10);
+			if (numThreads == 0) {
+				usage();
+				return 2;
+			}
+		} else if (arg[0] != '-' && cdlFile == "") {
+			cdlFile = arg;
+		} else {
+			usage();
+			return 2;
+		}
+	}
+	if (cdlFile == "") {
+		usage();
+		return 2;
+	}
+
+	SimLibraryParse library;
+	if (!library.loadFile(libFile)) {
+		cerr << "Error: can't read library " << libFile << endl;
+		return 1;
+	}
+	if (userLibFile != "" && !library.loadFile(userLibFile)) {
+		cerr << "Error: can't read library " << userLibFile << endl;
+		return 1;
+	}
+
+	SimCircuitParse parser(&library);
+	if (!parser.loadFile(cdlFile)) {
+		cerr << "Error: can't read circuit " << cdlFile << endl;
+		return 1;
+	}
+	for (unsigned long i = 0; i < parser.getNotFound().size(); i++) {
+		cerr << "Warning: gate type " << parser.getNotFound()[i] << " is not in the library" << endl;
+	}
+
+	Circuit cir(NULL);
+	cir.setEventScheduler(scheduler);
+	cir.setCompiledNetlist(useNetlist);
+	cir.setGateThreads(numThreads);
+	cir.setCycleMode(cycleMode);
+	cir.setCompiledGates(compiledGates);
+
+	chrono::steady_clock::time_point loadStart = chrono::steady_clock::now();
+	parser.buildCircuit(&cir);
+	if (truthTable) return printTruthTable(cir, parser.getGates());
+	if (stimulusFile != "") return printFaultCoverage(cir, parser.getGates(), stimulusFile, numThreads);
+	chrono::steady_clock::time_point runStart = chrono::steady_clock::now();
+	cir.runUntil(cir.getSystemTime() + numSteps);
+	chrono::steady_clock::time_point runEnd = chrono::steady_clock::now();
+
+	double loadSeconds = chrono::duration< double >(runStart - loadStart).count();
+	double runSeconds = chrono::duration< double >(runEnd - runStart).count();
+	unsigned long long numEvents = cir.getEventCount();
+
+	// The wires, and the junction name of every TO and FROM gate:
+	set < IDType > wireIDs;
+	map < string, IDType > junctionWires;
+	vector < simGate >& gates = parser.getGates();
+	for (unsigned long g = 0; g < gates.size(); g++) {
+		vector < gateConnector > connectors = gates[g].inputs;
+		connectors.insert(connectors.end(), gates[g].outputs.begin(), gates[g].outputs.end());
+		for (unsigned long i = 0; i < connectors.size(); i++) {
+			wireIDs.insert(connectors[i].wireIds.begin(), connectors[i].wireIds.end());
+		}
+		string logicType = gates[g].libGate.logicType;
+		if ((logicType == "TO" || logicType == "FROM") && !connectors.empty() && !connectors[0].wireIds.empty()) {
+			string juncName = cir.getGateParameter(gates[g].id, "JUNCTION_ID");
+			if (junctionWires.find(juncName) == junctionWires.end() || logicType == "TO") {
+				junctionWires[juncName] = connectors[0].wireIds[0];
+			}
+		}
+	}
+
+	cout << "circuit " << cdlFile << endl;
+	cout << "gates " << gates.size() << endl;
+	cout << "wires " << wireIDs.size() << endl;
+	cout << "load_seconds " << loadSeconds << endl;
+	cout << "steps " << numSteps << endl;
+	cout << "events " << numEvents << endl;
+	cout << "run_seconds " << runSeconds << endl;
+	cout << "steps_per_sec " << (runSeconds > 0 ? numSteps / runSeconds : 0) << endl;
+	cout << "events_per_sec " << (runSeconds > 0 ? numEvents / runSeconds : 0) << endl;
+	if (cycleMode) {
+		string fallback = cir.getCycleFallback();
+		if (fallback == "") cout << "cycle_mode on" << endl;
+		else cout << "cycle_mode off: " << fallback << endl;
+	}
+	if (compiledGates) {
+		if (cir.getCompiledGates()) cout << "compiled_gates on" << endl;
+		else cout << "compiled_gates off: " << cir.getCompileFallback() << endl;
+	}
+
+	map < string, IDType >::iterator junc = junctionWires.begin();
+	while (junc != junctionWires.end()) {
+		cout << "junction " << junc->first << " " << stateChar(cir.getWireState(junc->second)) << endl;
+		junc++;
+	}
+	if (printWires) {
+		set < IDType >::iterator wire = wireIDs.begin();
+		while (wire != wireIDs.end()) {
+			cout << "wire " << *wire << " " << stateChar(cir.getWireState(*wire)) << endl;
+			wire++;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,957 @@
+/*****************************************************************************
+   Project: CEDAR Logic Simulator
+   Copyright 2006 Cedarville University, Benjamin Sprague,
+                     Matt Lewellyn, and David Knierim
+   All rights reserved.
+   For license information see license.txt included with distribution.
+
+   SimTests: cedarlogic-tests, regression tests of the logic core
+*****************************************************************************/
+
+#include "../logic/logic_circuit.h"
+#include "../logic/logic_fault_sim.h"
+#include "../logic/logic_pattern_sim.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Pin names of busses, like "IN_3":
+static string pin(const string &name, unsigned long bit) {
+	ostringstream oss;
+	oss << name << "_" << bit;
+	return oss.str();
+}
+
+static string toString(unsigned long long value) {
+	ostringstream oss;
+	oss << value;
+	return oss.str();
+}
+
+// Each failed check prints what was expected, and fails the test:
+static bool testPassed;
+
+static void check(bool ok, const string &what) {
+	if (!ok) {
+		cout << "  failed: " << what << endl;
+		testPassed = false;
+	}
+}
+
+static void checkEqual(const string &found, const string &expected, const string &what) {
+	check(found == expected, what + " is \"" + found + "\", expected \"" + expected + "\"");
+}
+
+// A test that can't run here (like one that needs a compiler) says why, and
+// is counted as skipped:
+static string skipReason;
+
+static void skip(const string &why) {
+	skipReason = why;
+}
+
+// Makes the gates of a test circuit with the Circuit calls, the same way
+// that SimCircuitParse::buildCircuit() builds a circuit file:
+class TestBuilder {
+public:
+	TestBuilder(Circuit* cir) : cir(cir) {};
+
+	IDType gate(const string &type) { return cir->newGate(type); };
+	IDType wire() { return cir->newWire(); };
+	void param(IDType gateID, const string &name, const string &value) { cir->setGateParameter(gateID, name, value); };
+	void in(IDType gateID, const string &pinName, IDType wireID) { cir->connectGateInput(gateID, pinName, wireID); };
+	void out(IDType gateID, const string &pinName, IDType wireID) { cir->connectGateOutput(gateID, pinName, wireID); };
+
+	// A gate's output bus, on new wires:
+	vector< IDType > outs(IDType gateID, const string &busName, unsigned long bits) {
+		vector< IDType > wires;
+		for (unsigned long i = 0; i < bits; i++) {
+			wires.push_back(wire());
+			out(gateID, pin(busName, i), wires[i]);
+		}
+		return wires;
+	};
+
+	// A DRIVER gate (like a toggle or a keypad) and its output wires:
+	vector< IDType > driver(unsigned long bits, IDType &driverID) {
+		driverID = gate("DRIVER");
+		param(driverID, "OUTPUT_BITS", toString(bits));
+		return outs(driverID, "OUT", bits);
+	};
+
+	// A gate with two inputs (and, for a BUFFER, one), returns its output wire:
+	IDType gate2(const string &type, IDType in0, IDType in1, IDType *gateID = NULL) {
+		IDType newGate = gate(type);
+		param(newGate, "INPUT_BITS", (in1 == ID_NONE) ? "1" : "2");
+		in(newGate, "IN_0", in0);
+		if (in1 != ID_NONE) in(newGate, "IN_1", in1);
+		IDType outWire = wire();
+		out(newGate, (type == "BUFFER") ? "OUT_0" : "OUT", outWire);
+		if (gateID != NULL) *gateID = newGate;
+		return outWire;
+	};
+
+	void step(unsigned long numSteps) {
+		for (unsigned long i = 0; i < numSteps; i++) {
+			cir->step(NULL);
+		}
+	};
+
+	// The value of a bus of wires, as a number (-1 if a wire isn't 0 or 1):
+	long long busValue(const vector< IDType > &wires) {
+		long long value = 0;
+		for (unsigned long i = 0; i < wires.size(); i++) {
+			StateType state = cir->getWireState(wires[i]);
+			if (state == ONE) value |= 1LL << i;
+			else if (state != ZERO) return -1;
+		}
+		return value;
+	};
+
+	// The same, for a bus of up to 64 wires. Returns false if a wire isn't 0 or 1:
+	bool busWord(const vector< IDType > &wires, unsigned long long &value) {
+		value = 0;
+		for (unsigned long i = 0; i < wires.size(); i++) {
+			StateType state = cir->getWireState(wires[i]);
+			if (state == ONE) value |= 1ULL << i;
+			else if (state != ZERO) return false;
+		}
+		return true;
+	};
+
+	Circuit* cir;
+};
+
+// A RAM's words survive being saved and loaded again, and "Address:" params
+// that come before the RAM's size (as they do from a circuit file) are kept:
+static void testRamRoundTrip() {
+	Circuit cir(NULL);
+	TestBuilder b(&cir);
+
+	IDType ram = b.gate("RAM");
+	b.param(ram, "Address:5", "10");
+	b.param(ram, "Address:200", "7");
+	b.param(ram, "Address:300", "9");
+	b.param(ram, "ADDRESS_BITS", "8");
+	b.param(ram, "DATA_BITS", "8");
+	checkEqual(cir.getGateParameter(ram, "Address:5"), "10", "word 5 set before the size");
+	checkEqual(cir.getGateParameter(ram, "Address:200"), "7", "word 200 set before the size");
+	checkEqual(cir.getGateParameter(ram, "Address:300"), "0", "word 300 of a 256 word RAM");
+
+	// The word past the end is written once the RAM is big enough:
+	b.param(ram, "ADDRESS_BITS", "9");
+	checkEqual(cir.getGateParameter(ram, "Address:300"), "9", "word 300 after growing the RAM");
+
+	b.param(ram, "WRITE_FILE", "test_ram_round_trip.cdm");
+	b.param(ram, "CLEAR_MEMORY", "");
+	checkEqual(cir.getGateParameter(ram, "Address:5"), "0", "word 5 after clearing");
+	b.param(ram, "READ_FILE", "test_ram_round_trip.cdm");
+	checkEqual(cir.getGateParameter(ram, "Address:5"), "10", "word 5 after loading");
+	checkEqual(cir.getGateParameter(ram, "Address:200"), "7", "word 200 after loading");
+	checkEqual(cir.getGateParameter(ram, "Address:300"), "9", "word 300 after loading");
+	checkEqual(cir.getGateParameter(ram, "Address:6"), "0", "word 6 after loading");
+	remove("test_ram_round_trip.cdm");
+
+	// A RAM wider than 32 address bits keeps its last word:
+	IDType wide = b.gate("RAM");
+	b.param(wide, "ADDRESS_BITS", "40");
+	b.param(wide, "DATA_BITS", "16");
+	b.param(wide, "Address:1099511627775", "4660");
+	b.param(wide, "Address:4294967296", "17");
+	b.param(wide, "WRITE_FILE", "test_ram_round_trip_wide.cdm");
+	b.param(wide, "CLEAR_MEMORY", "");
+	b.param(wide, "READ_FILE", "test_ram_round_trip_wide.cdm");
+	checkEqual(cir.getGateParameter(wide, "Address:1099511627775"), "4660", "the last word of a 40-bit RAM");
+	checkEqual(cir.getGateParameter(wide, "Address:4294967296"), "17", "word 2^32 of a 40-bit RAM");
+	checkEqual(cir.getGateParameter(wide, "Address:0"), "0", "word 0 of a 40-bit RAM");
+	remove("test_ram_round_trip_wide.cdm");
+}
+
+// An Intel HEX file with data, extended linear and extended segment address
+// records (each with a good checksum) loads at the right addresses:
+static void testIntelHex() {
+	{
+		ofstream hexFile("test_intel_hex.hex");
+		hexFile << ":03001000010203E7" << endl
+			<< ":020000040001F9" << endl		// Base 0x10000
+			<< ":02002000AABB79" << endl
+			<< ":020000022000DC" << endl		// Base 0x2000 * 16
+			<< ":01FFFF005CA5" << endl
+			<< ":00000001FF" << endl
+			<< ":0100000077" << endl;		// (After the end)
+	}
+
+	Circuit cir(NULL);
+	TestBuilder b(&cir);
+	IDType ram = b.gate("RAM");
+	b.param(ram, "ADDRESS_BITS", "20");
+	b.param(ram, "DATA_BITS", "8");
+	b.param(ram, "READ_FILE", "test_intel_hex.hex");
+	remove("test_intel_hex.hex");
+
+	checkEqual(cir.getGateParameter(ram, "Address:16"), "1", "word 0x10");
+	checkEqual(cir.getGateParameter(ram, "Address:17"), "2", "word 0x11");
+	checkEqual(cir.getGateParameter(ram, "Address:18"), "3", "word 0x12");
+	checkEqual(cir.getGateParameter(ram, "Address:32"), "0", "word 0x20");
+	checkEqual(cir.getGateParameter(ram, "Address:65568"), "170", "word 0x10020");
+	checkEqual(cir.getGateParameter(ram, "Address:65569"), "187", "word 0x10021");
+	checkEqual(cir.getGateParameter(ram, "Address:196607"), "92", "word 0x2FFFF");
+	checkEqual(cir.getGateParameter(ram, "Address:0"), "0", "word 0, after the end of file record");
+}
+
+// The clock of testCycleMixedSteps():
+static const unsigned long halfCycle = 7;
+
+// Builds the synchronous circuit of testCycleMixedSteps(): a counter, some
+// gates on its outputs, a CMB and an FSM, all on one clock. Returns all of
+// its wires, and the counter:
+static vector< IDType > buildSyncCircuit(TestBuilder &b, IDType &counter) {
+	vector< IDType > wires;
+
+	IDType clock = b.gate("CLOCK");
+	b.param(clock, "HALF_CYCLE", toString(halfCycle));
+	IDType clk = b.wire();
+	b.out(clock, "CLK", clk);
+	wires.push_back(clk);
+
+	counter = b.gate("REGISTER");
+	b.param(counter, "INPUT_BITS", "4");
+	b.param(counter, "MAX_COUNT", "15");
+	b.in(counter, "CLOCK", clk);
+	b.cir->setGateInputParameter(counter, "COUNT_ENABLE", "PULL_UP", "TRUE");
+	vector< IDType > count = b.outs(counter, "OUT", 4);
+	wires.insert(wires.end(), count.begin(), count.end());
+
+	IDType andGate = b.gate("AND");
+	b.param(andGate, "INPUT_BITS", "2");
+	b.in(andGate, "IN_0", count[0]);
+	b.in(andGate, "IN_1", count[1]);
+	IDType andOut = b.wire();
+	b.out(andGate, "OUT", andOut);
+	wires.push_back(andOut);
+
+	IDType xorGate = b.gate("XOR");
+	b.param(xorGate, "INPUT_BITS", "2");
+	b.in(xorGate, "IN_0", count[2]);
+	b.in(xorGate, "IN_1", count[3]);
+	IDType xorOut = b.wire();
+	b.out(xorGate, "OUT", xorOut);
+	wires.push_back(xorOut);
+
+	IDType cmb = b.gate("CMB");
+	b.param(cmb, "OUTPUT_BITS", "2");
+	b.param(cmb, "INPUT_BITS", "3");
+	b.param(cmb, "Function:0", "f0=S(1,2,4,7)");
+	b.param(cmb, "Function:1", "f1=P(0,5)");
+	b.in(cmb, "IN_0", andOut);
+	b.in(cmb, "IN_1", xorOut);
+	b.in(cmb, "IN_2", count[1]);
+	vector< IDType > cmbOut = b.outs(cmb, "OUT", 2);
+	wires.insert(wires.end(), cmbOut.begin(), cmbOut.end());
+
+	IDType fsm = b.gate("FSM_SYNC");
+	b.param(fsm, "OUTPUT_BITS", "2");
+	b.param(fsm, "INPUT_BITS", "2");
+	b.param(fsm, "State:0", "A/01 1X-B 01-C");
+	b.param(fsm, "State:1", "B/10 X0-A 11-C");
+	b.param(fsm, "State:2", "C/11 00-A");
+	b.in(fsm, "CLOCK", clk);
+	b.in(fsm, "IN_0", cmbOut[0]);
+	b.in(fsm, "IN_1", cmbOut[1]);
+	vector< IDType > fsmOut = b.outs(fsm, "OUT", 2);
+	wires.insert(wires.end(), fsmOut.begin(), fsmOut.end());
+
+	return wires;
+}
+
+// A circuit that steps a cycle at a time for some of the steps, with an
+// edit in between, ends up the same as one that only uses events. (A cycle
+// step changes the wires at the clock edge, and the event engine a few gate
+// delays later, so they are compared once the events have settled, just
+// before each edge.)
+static void testCycleMixedSteps() {
+	Circuit eventCir(NULL), mixedCir(NULL);
+	TestBuilder eventBuilder(&eventCir), mixedBuilder(&mixedCir);
+	IDType eventCounter, mixedCounter;
+	vector< IDType > eventWires = buildSyncCircuit(eventBuilder, eventCounter);
+	vector< IDType > mixedWires = buildSyncCircuit(mixedBuilder, mixedCounter);
+
+	bool usedCycles = false;
+	for (unsigned long step = 0; step < 600; step++) {
+		// Cycles, events, and cycles again after the edit:
+		mixedCir.setCycleMode((step >= 100 && step < 250) || step >= 320);
+
+		if (step == 300) {
+			eventCir.setGateParameter(eventCounter, "CURRENT_VALUE", "9");
+			mixedCir.setGateParameter(mixedCounter, "CURRENT_VALUE", "9");
+		}
+
+		eventCir.step(NULL);
+		mixedCir.step(NULL);
+		if (mixedCir.getCycleMode() && mixedCir.getCycleFallback() == "") usedCycles = true;
+
+		if ((step + 1) % halfCycle != 0) continue;
+		for (unsigned long w = 0; w < eventWires.size(); w++) {
+			if (eventCir.getWireState(eventWires[w]) != mixedCir.getWireState(mixedWires[w])) {
+				check(false, "wire " + toString(mixedWires[w]) + " differs after step " + toString(step));
+				return;
+			}
+		}
+	}
+	check(usedCycles, "the circuit stepped a cycle at a time (" + mixedCir.getCycleFallback() + ")");
+}
+
+// A CMB gate gives its functions for every binary input word:
+static void testCmbOutputs() {
+	Circuit cir(NULL);
+	TestBuilder b(&cir);
+
+	IDType inputs;
+	vector< IDType > inWires = b.driver(3, inputs);
+	IDType cmb = b.gate("CMB");
+	b.param(cmb, "OUTPUT_BITS", "3");
+	b.param(cmb, "INPUT_BITS", "3");
+	b.param(cmb, "Function:0", "f0=S(1,2,4,7)");	// Odd parity
+	b.param(cmb, "Function:1", "f1=P(0)");		// OR
+	b.param(cmb, "Function:2", "f2=E8");		// Majority, in hex
+	for (unsigned long i = 0; i < 3; i++) b.in(cmb, pin("IN", i), inWires[i]);
+	vector< IDType > outWires = b.outs(cmb, "OUT", 3);
+
+	for (unsigned long word = 0; word < 8; word++) {
+		b.param(inputs, "OUTPUT_NUM", toString(word));
+		b.step(10);
+
+		unsigned long ones = (word & 1) + ((word >> 1) & 1) + ((word >> 2) & 1);
+		long long expected = (ones % 2) | ((ones > 0) << 1) | ((ones >= 2) << 2);
+		check(b.busValue(outWires) == expected, "CMB outputs for inputs " + toString(word));
+	}
+}
+
+// Runs a Mealy FSM with "inputBits" inputs through a list of clock edges:
+static void runFsm(unsigned long inputBits) {
+	Circuit cir(NULL);
+	TestBuilder b(&cir);
+
+	IDType inputs, clock;
+	vector< IDType > inWires = b.driver(inputBits, inputs);
+	vector< IDType > clockWire = b.driver(1, clock);
+	IDType fsm = b.gate("FSM_SYNC");
+	b.param(fsm, "OUTPUT_BITS", "2");
+	b.param(fsm, "INPUT_BITS", toString(inputBits));
+	b.param(fsm, "State:0", "A 01-B/01 1X-C/10");
+	b.param(fsm, "State:1", "B 00-A/11 X1-C/01");
+	b.param(fsm, "State:2", "C 11-A/00");
+	b.in(fsm, "CLOCK", clockWire[0]);
+	for (unsigned long i = 0; i < inputBits; i++) b.in(fsm, pin("IN", i), inWires[i]);
+	vector< IDType > outWires = b.outs(fsm, "OUT", 2);
+	b.step(10);
+
+	// The inputs for each clock edge, and then the state and outputs
+	// (from the new state's row, for the same inputs):
+	struct edge {
+		unsigned long long inputs;
+		string state;
+		long long outputs;
+	};
+	vector< edge > edges = {
+		{ 1, "B", 1 },
+		{ 1, "C", 0 },
+		{ 3, "A", 2 },
+		{ 2, "C", 0 },
+		{ 0, "C", 0 },
+		{ 3, "A", 2 },
+		{ 1, "B", 1 },
+		{ 0, "A", 0 },
+	};
+	if (inputBits > 2) {
+		// (The inputs past a transition's length must be 0.)
+		edges.push_back({ (1ULL << (inputBits - 1)) | 1, "A", 0 });
+	}
+
+	for (unsigned long i = 0; i < edges.size(); i++) {
+		string what = "FSM with " + toString(inputBits) + " inputs, edge " + toString(i);
+		b.param(inputs, "OUTPUT_NUM", toString(edges[i].inputs));
+		b.step(10);
+		b.param(clock, "OUTPUT_NUM", "1");
+		b.step(10);
+		b.param(clock, "OUTPUT_NUM", "0");
+		b.step(10);
+		checkEqual(cir.getGateParameter(fsm, "CURRENT_STATE"), edges[i].state, what + " state");
+		check(b.busValue(outWires) == edges[i].outputs, what + " outputs");
+	}
+
+	// The outputs of a Mealy FSM follow the inputs between edges:
+	b.param(inputs, "OUTPUT_NUM", "2");
+	b.step(10);
+	checkEqual(cir.getGateParameter(fsm, "CURRENT_STATE"), "A", "FSM state without an edge");
+	check(b.busValue(outWires) == 2, "FSM outputs without an edge");
+}
+
+// An FSM gives the same states and outputs with a table (up to 12 inputs)
+// as with its lists of transitions (a table of 40 inputs wouldn't fit):
+static void testFsmOutputs() {
+	runFsm(2);
+	runFsm(40);
+}
+
+// The faults of an output that doesn't lead to the outputs are counted as
+// unobservable, not as undetected:
+static void testFaultUnobservable() {
+	Circuit cir(NULL);
+	TestBuilder b(&cir);
+
+	IDType inputs;
+	vector< IDType > inWires = b.driver(2, inputs);
+	IDType decoder = b.gate("DECODER");
+	b.param(decoder, "INPUT_BITS", "2");
+	b.in(decoder, "IN_0", inWires[0]);
+	b.in(decoder, "IN_1", inWires[1]);
+	b.cir->setGateInputParameter(decoder, "ENABLE", "PULL_UP", "TRUE");
+	IDType used = b.wire(), unused = b.wire();
+	b.out(decoder, "OUT_0", used);
+	b.out(decoder, "OUT_3", unused);
+
+	vector< vector< StateType > > vectors;
+	for (unsigned long word = 0; word < 4; word++) {
+		vectors.push_back({ (word & 1) ? ONE : ZERO, (word & 2) ? ONE : ZERO });
+	}
+	FaultSim faultSim(&cir);
+	check(faultSim.build(inWires, vector< IDType >(1, used)), "building the fault simulation");
+	check(faultSim.run(vectors), "running the fault simulation");
+	check(faultSim.getNumUnobservable() == 2, "2 unobservable faults, found " + toString(faultSim.getNumUnobservable()));
+	check(faultSim.getNumDetected() == faultSim.getNumFaults(), "every observable fault is detected");
+}
+
+// The parts of buildEventCircuit() that applyEdits() changes:
+struct EventCircuit {
+	vector< IDType > wires;
+	IDType counter, xorGate, xorInput, spareWire;
+};
+
+// Builds "copies" copies of a circuit with some of everything that the event
+// engine handles: a clock and a counter, gates on the count, a RAM that is
+// written and read back, and T gates that join two driven wires and split
+// them again. Copy k's clock has a half cycle of 3 + k % halfCycles, so
+// some of the copies tick together. Returns the wires to compare, and the
+// parts of the first copy that get edited:
+static EventCircuit buildEventCircuit(TestBuilder &b, unsigned long copies, unsigned long halfCycles) {
+	EventCircuit built;
+	for (unsigned long k = 0; k < copies; k++) {
+		vector< IDType > wires;
+
+		IDType clock = b.gate("CLOCK");
+		b.param(clock, "HALF_CYCLE", toString(3 + k % halfCycles));
+		IDType clk = b.wire();
+		b.out(clock, "CLK", clk);
+		wires.push_back(clk);
+
+		IDType counter = b.gate("REGISTER");
+		b.param(counter, "INPUT_BITS", "8");
+		b.param(counter, "MAX_COUNT", "255");
+		b.param(counter, "CURRENT_VALUE", toString(k * 37 % 256));
+		b.in(counter, "CLOCK", clk);
+		b.cir->setGateInputParameter(counter, "COUNT_ENABLE", "PULL_UP", "TRUE");
+		vector< IDType > count = b.outs(counter, "OUT", 8);
+		wires.insert(wires.end(), count.begin(), count.end());
+
+		IDType xorGate;
+		IDType xorOut = b.gate2("XOR", count[0], count[3], &xorGate);
+		IDType andOut = b.gate2("AND", xorOut, count[5]);
+		IDType orOut = b.gate2("OR", andOut, count[6]);
+		wires.push_back(xorOut);
+		wires.push_back(andOut);
+		wires.push_back(orOut);
+
+		// A RAM that is written with the count at every other clock edge:
+		IDType ram = b.gate("RAM");
+		b.param(ram, "ADDRESS_BITS", "4");
+		b.param(ram, "DATA_BITS", "8");
+		for (unsigned long i = 0; i < 4; i++) b.in(ram, pin("ADDRESS", i), count[i + 4]);
+		for (unsigned long i = 0; i < 8; i++) b.in(ram, pin("DATA_IN", i), count[(i + k) % 8]);
+		b.in(ram, "WRITE_CLOCK", clk);
+		b.in(ram, "WRITE_ENABLE", count[1]);
+		vector< IDType > data = b.outs(ram, "DATA_OUT", 8);
+		wires.insert(wires.end(), data.begin(), data.end());
+		wires.push_back(b.gate2("OR", data[0], data[7]));
+
+		// Two driven wires joined by a T gate, and a third and fourth wire
+		// that other T gates join on:
+		IDType left = b.gate2("BUFFER", count[1], ID_NONE);
+		IDType right = b.gate2("BUFFER", xorOut, ID_NONE);
+		IDType third = b.wire(), spare = b.wire();
+		IDType joins[3][3] = { { left, right, count[2] }, { right, third, count[5] }, { third, spare, clk } };
+		for (unsigned long j = 0; j < 3; j++) {
+			IDType tgate = b.gate("TGATE");
+			b.in(tgate, "T_IN", joins[j][0]);
+			b.in(tgate, "T_IN2", joins[j][1]);
+			b.in(tgate, "T_CTRL", joins[j][2]);
+		}
+		wires.push_back(left);
+		wires.push_back(right);
+		wires.push_back(third);
+		wires.push_back(b.gate2("AND", third, left));
+
+		if (k == 0) {
+			built.counter = counter;
+			built.xorGate = xorGate;
+			built.xorInput = count[3];
+			built.spareWire = spare;
+		} else {
+			wires.push_back(spare);
+		}
+		built.wires.insert(built.wires.end(), wires.begin(), wires.end());
+	}
+	return built;
+}
+
+// Edits the first copy of buildEventCircuit() during a run, at the same
+// steps in every run:
+static void applyEdits(Circuit &cir, const EventCircuit &built, unsigned long step) {
+	if (step == 250) cir.setGateParameter(built.counter, "CURRENT_VALUE", "200");
+	if (step == 400) cir.disconnectGateInput(built.xorGate, "IN_1");
+	if (step == 550) cir.deleteWire(built.spareWire);
+	if (step == 700) {
+		cir.beginBatch();
+		cir.connectGateInput(built.xorGate, "IN_1", built.xorInput);
+		cir.commitBatch();
+	}
+}
+
+// Steps two copies of buildEventCircuit(), with the same edits, and checks
+// that every wire is the same after every step. "switchAt" is called on
+// the right-hand circuit before each step:
+static void compareEventRuns(Circuit &leftCir, Circuit &rightCir, unsigned long copies, unsigned long halfCycles,
+	unsigned long numSteps, void (*switchAt)(Circuit &, unsigned long) = NULL) {
+	TestBuilder leftBuilder(&leftCir), rightBuilder(&rightCir);
+	EventCircuit left = buildEventCircuit(leftBuilder, copies, halfCycles);
+	EventCircuit right = buildEventCircuit(rightBuilder, copies, halfCycles);
+
+	for (unsigned long step = 0; step < numSteps; step++) {
+		if (switchAt != NULL) switchAt(rightCir, step);
+		applyEdits(leftCir, left, step);
+		applyEdits(rightCir, right, step);
+		leftCir.step(NULL);
+		rightCir.step(NULL);
+
+		for (unsigned long w = 0; w < left.wires.size(); w++) {
+			if (leftCir.getWireState(left.wires[w]) != rightCir.getWireState(right.wires[w])) {
+				check(false, "wire " + toString(right.wires[w]) + " differs after step " + toString(step));
+				return;
+			}
+		}
+	}
+	check(leftCir.getEventCount() == rightCir.getEventCount(), "the same number of events ("
+		+ toString(leftCir.getEventCount()) + " and " + toString(rightCir.getEventCount()) + ")");
+}
+
+// Half way through, the timing wheel hands its events to the heap:
+static void switchToHeap(Circuit &cir, unsigned long step) {
+	if (step == 500) cir.setEventScheduler(EventQueue::SCHED_HEAP);
+}
+
+// The timing wheel gives the same events in the same order as the heap,
+// and a switch between them keeps the events that are waiting:
+static void testSchedulers() {
+	{
+		Circuit heapCir(NULL), wheelCir(NULL);
+		heapCir.setEventScheduler(EventQueue::SCHED_HEAP);
+		wheelCir.setEventScheduler(EventQueue::SCHED_TIMING_WHEEL);
+		compareEventRuns(heapCir, wheelCir, 6, 5, 1000);
+	}
+	{
+		Circuit heapCir(NULL), wheelCir(NULL);
+		heapCir.setEventScheduler(EventQueue::SCHED_HEAP);
+		wheelCir.setEventScheduler(EventQueue::SCHED_TIMING_WHEEL);
+		compareEventRuns(heapCir, wheelCir, 6, 5, 1000, switchToHeap);
+	}
+}
+
+// The netlist is turned on after a few steps, and off again after more:
+static void switchNetlist(Circuit &cir, unsigned long step) {
+	if (step == 300) cir.setCompiledNetlist(true);
+	if (step == 800) cir.setCompiledNetlist(false);
+}
+
+// step() on the compiled netlist gives the same wires as step() on the
+// wire and gate maps, through edits, and when it is turned on and off:
+static void testNetlistSteps() {
+	{
+		Circuit mapCir(NULL), netlistCir(NULL);
+		netlistCir.setCompiledNetlist(true);
+		compareEventRuns(mapCir, netlistCir, 6, 5, 1000);
+	}
+	{
+		Circuit mapCir(NULL), netlistCir(NULL);
+		compareEventRuns(mapCir, netlistCir, 6, 5, 1000, switchNetlist);
+	}
+}
+
+// Updating the gates on several threads gives the same wires and events as
+// one thread, on the maps and on the netlist. (All of the copies tick
+// together, so each clock edge updates a counter, a RAM and a T gate in 88
+// copies, which is enough gates to use the threads.)
+static void testGateThreads() {
+	for (int useNetlist = 0; useNetlist < 2; useNetlist++) {
+		Circuit oneCir(NULL), fourCir(NULL);
+		oneCir.setCompiledNetlist(useNetlist != 0);
+		fourCir.setCompiledNetlist(useNetlist != 0);
+		fourCir.setGateThreads(4);
+		compareEventRuns(oneCir, fourCir, 88, 1, 600);
+	}
+}
+
+// The pattern simulation gives the same states as the event simulation, for
+// every input word of a circuit with each kind of pattern gate. Two BUFFERs
+// drive one wire, so some patterns have a CONFLICT on it and UNKNOWNs after
+// it, and the MUX has a SEL value with no input:
+static void testPatternSim() {
+	Circuit cir(NULL);
+	TestBuilder b(&cir);
+
+	IDType inputs;
+	vector< IDType > d = b.driver(8, inputs);
+	vector< IDType > outWires;
+	IDType andWire = b.gate2("AND", d[0], d[1]);
+	IDType orWire = b.gate2("OR", d[2], d[3]);
+	IDType xorWire = b.gate2("XOR", andWire, orWire);
+	IDType eqWire = b.gate2("EQUIVALENCE", d[4], xorWire);
+	outWires.insert(outWires.end(), { andWire, orWire, xorWire, eqWire });
+
+	IDType shared = b.wire();
+	for (unsigned long i = 5; i <= 6; i++) {
+		IDType buffer = b.gate("BUFFER");
+		b.param(buffer, "INPUT_BITS", "1");
+		b.in(buffer, "IN_0", d[i]);
+		b.out(buffer, "OUT_0", shared);
+	}
+	outWires.push_back(shared);
+
+	IDType mux = b.gate("MUX");
+	b.param(mux, "INPUT_BITS", "3");
+	b.in(mux, "IN_0", xorWire);
+	b.in(mux, "IN_1", eqWire);
+	b.in(mux, "IN_2", shared);
+	b.in(mux, "SEL_0", d[6]);
+	b.in(mux, "SEL_1", d[7]);
+	IDType muxWire = b.wire();
+	b.out(mux, "OUT", muxWire);
+	outWires.push_back(muxWire);
+	outWires.push_back(b.gate2("BUFFER", muxWire, ID_NONE));
+
+	IDType decoder = b.gate("DECODER");
+	b.param(decoder, "INPUT_BITS", "2");
+	b.in(decoder, "IN_0", d[0]);
+	b.in(decoder, "IN_1", d[7]);
+	b.in(decoder, "ENABLE", eqWire);
+	vector< IDType > decoded = b.outs(decoder, "OUT", 4);
+	outWires.insert(outWires.end(), decoded.begin(), decoded.end());
+
+	IDType cmb = b.gate("CMB");
+	b.param(cmb, "OUTPUT_BITS", "2");
+	b.param(cmb, "INPUT_BITS", "3");
+	b.param(cmb, "Function:0", "f0=S(1,2,4,7)");
+	b.param(cmb, "Function:1", "f1=P(0)");
+	b.in(cmb, "IN_0", muxWire);
+	b.in(cmb, "IN_1", decoded[1]);
+	b.in(cmb, "IN_2", shared);
+	vector< IDType > cmbWires = b.outs(cmb, "OUT", 2);
+	outWires.insert(outWires.end(), cmbWires.begin(), cmbWires.end());
+
+	PatternSim patterns(&cir);
+	check(patterns.build(d, outWires), "building the pattern simulation");
+	check(patterns.runAllPatterns(), "running the patterns");
+	if (!testPassed) return;
+
+	for (unsigned long word = 0; word < 256; word++) {
+		b.param(inputs, "OUTPUT_NUM", toString(word));
+		b.step(10);
+		for (unsigned long i = 0; i < outWires.size(); i++) {
+			StateType found = patterns.getOutputState(i, word);
+			StateType expected = cir.getWireState(outWires[i]);
+			if (found != expected) {
+				check(false, "output " + toString(i) + " for inputs " + toString(word) + " is state "
+					+ toString(found) + ", the event simulation has " + toString(expected));
+				return;
+			}
+		}
+	}
+}
+
+// Builds the circuit of testCompiledGates(): a clock, a counter, and a
+// register that loads, on each edge, the outputs of a few layers of gates on
+// the count and on the register itself. Returns all of its wires:
+static vector< IDType > buildCompiledCircuit(TestBuilder &b) {
+	vector< IDType > wires;
+
+	IDType clock = b.gate("CLOCK");
+	b.param(clock, "HALF_CYCLE", "10");
+	IDType clk = b.wire();
+	b.out(clock, "CLK", clk);
+	wires.push_back(clk);
+
+	IDType counter = b.gate("REGISTER");
+	b.param(counter, "INPUT_BITS", "8");
+	b.param(counter, "MAX_COUNT", "255");
+	b.in(counter, "CLOCK", clk);
+	b.cir->setGateInputParameter(counter, "COUNT_ENABLE", "PULL_UP", "TRUE");
+	vector< IDType > count = b.outs(counter, "OUT", 8);
+	wires.insert(wires.end(), count.begin(), count.end());
+
+	IDType reg = b.gate("REGISTER");
+	b.param(reg, "INPUT_BITS", "8");
+	b.param(reg, "CURRENT_VALUE", "90");
+	b.param(reg, "SYNC_LOAD", "true");
+	b.in(reg, "CLOCK", clk);
+	b.cir->setGateInputParameter(reg, "LOAD", "PULL_UP", "TRUE");
+	vector< IDType > state = b.outs(reg, "OUT", 8);
+	wires.insert(wires.end(), state.begin(), state.end());
+
+	for (unsigned long i = 0; i < 8; i++) {
+		IDType andWire = b.gate2("AND", count[i], state[(i + 1) % 8]);
+		IDType orWire = b.gate2("OR", count[(i + 3) % 8], andWire);
+		IDType xorWire = b.gate2("XOR", orWire, state[i]);
+		IDType eqWire = b.gate2("EQUIVALENCE", xorWire, count[(i + 5) % 8]);
+		IDType bufWire = b.gate2("BUFFER", eqWire, ID_NONE);
+		b.in(reg, pin("IN", i), bufWire);
+		wires.insert(wires.end(), { andWire, orWire, xorWire, eqWire, bufWire });
+	}
+	return wires;
+}
+
+// In cycle mode, the compiled gates step the same as the gates run one at
+// a time. (Skipped if there's no compiler to build them with.)
+static void testCompiledGates() {
+	Circuit interpretedCir(NULL), compiledCir(NULL);
+	TestBuilder interpretedBuilder(&interpretedCir), compiledBuilder(&compiledCir);
+	vector< IDType > interpretedWires = buildCompiledCircuit(interpretedBuilder);
+	vector< IDType > compiledWires = buildCompiledCircuit(compiledBuilder);
+	interpretedCir.setCycleMode(true);
+	compiledCir.setCycleMode(true);
+	compiledCir.setCompiledGates(true);
+
+	bool usedCycles = false;
+	for (unsigned long step = 0; step < 400; step++) {
+		interpretedCir.step(NULL);
+		compiledCir.step(NULL);
+		if (compiledCir.getCycleFallback() != "") continue;
+		usedCycles = true;
+
+		if (!compiledCir.getCompiledGates()) {
+			// Only a missing compiler or loader skips the test, not a gate
+			// that can't be compiled:
+			string reason = compiledCir.getCompileFallback();
+			if (reason.find("no compiled version") != string::npos) check(false, "the gates compiled (" + reason + ")");
+			else skip(reason);
+			return;
+		}
+
+		for (unsigned long w = 0; w < interpretedWires.size(); w++) {
+			if (interpretedCir.getWireState(interpretedWires[w]) != compiledCir.getWireState(compiledWires[w])) {
+				check(false, "wire " + toString(compiledWires[w]) + " differs after step " + toString(step));
+				return;
+			}
+		}
+	}
+	check(usedCycles, "the circuit stepped a cycle at a time (" + compiledCir.getCycleFallback() + ")");
+}
+
+// Sets a DRIVER's output word and lets the circuit settle:
+static void drive(TestBuilder &b, IDType driverID, unsigned long long value) {
+	b.param(driverID, "OUTPUT_NUM", toString(value));
+	b.step(10);
+}
+
+// Checks the word on a bus:
+static void checkBus(TestBuilder &b, const vector< IDType > &wires, unsigned long long expected, const string &what) {
+	unsigned long long found;
+	if (!b.busWord(wires, found)) check(false, what + " isn't binary");
+	else check(found == expected, what + " is " + toString(found) + ", expected " + toString(expected));
+}
+
+// ADDERs, REGISTERs and RAMs with busses of 33 to 64 bits keep their high
+// bits, the carries across bit 32, and the carry and overflow of the top bit:
+static void testWideBuses() {
+	Circuit cir(NULL);
+	TestBuilder b(&cir);
+
+	// The sums, on 48 and 64 bits:
+	struct addition {
+		unsigned long bits;
+		unsigned long long a, b, carryIn, sum, carryOut, overflow;
+	};
+	const addition additions[] = {
+		{ 48, 0x123456789ABCULL, 0x0FEDCBA98765ULL, 1, 0x222222222222ULL, 0, 0 },
+		{ 48, 0x800000000000ULL, 0x800000000000ULL, 0, 0, 1, 1 },
+		{ 48, 0x7FFFFFFFFFFFULL, 1, 0, 0x800000000000ULL, 0, 1 },
+		{ 48, 0xFFFFFFFFFFFFULL, 0, 1, 0, 1, 0 },
+		{ 64, 0x00000001FFFFFFFFULL, 1, 0, 0x0000000200000000ULL, 0, 0 },
+		{ 64, 0xFFFFFFFFFFFFFFFFULL, 1, 0, 0, 1, 0 },
+		{ 64, 0x7FFFFFFFFFFFFFFFULL, 0x7FFFFFFFFFFFFFFFULL, 1, 0xFFFFFFFFFFFFFFFFULL, 0, 1 },
+		{ 64, 0x8000000000000000ULL, 0xFFFFFFFF00000000ULL, 0, 0x7FFFFFFF00000000ULL, 1, 1 },
+	};
+	for (unsigned long bits = 48; bits <= 64; bits += 16) {
+		IDType aDriver, bDriver, carryDriver;
+		vector< IDType > aWires = b.driver(bits, aDriver);
+		vector< IDType > bWires = b.driver(bits, bDriver);
+		vector< IDType > carryIn = b.driver(1, carryDriver);
+		IDType adder = b.gate("ADDER");
+		b.param(adder, "INPUT_BITS", toString(bits));
+		for (unsigned long i = 0; i < bits; i++) {
+			b.in(adder, pin("IN", i), aWires[i]);
+			b.in(adder, pin("IN_B", i), bWires[i]);
+		}
+		b.in(adder, "CARRY_IN", carryIn[0]);
+		vector< IDType > sumWires = b.outs(adder, "OUT", bits);
+		vector< IDType > flagWires(2);
+		flagWires[0] = b.wire();
+		flagWires[1] = b.wire();
+		b.out(adder, "CARRY_OUT", flagWires[0]);
+		b.out(adder, "OVERFLOW", flagWires[1]);
+
+		for (unsigned long n = 0; n < sizeof(additions) / sizeof(additions[0]); n++) {
+			const addition &add = additions[n];
+			if (add.bits != bits) continue;
+			drive(b, aDriver, add.a);
+			drive(b, bDriver, add.b);
+			drive(b, carryDriver, add.carryIn);
+			string what = toString(bits) + " bit sum " + toString(n);
+			checkBus(b, sumWires, add.sum, what);
+			checkBus(b, flagWires, add.carryOut | (add.overflow << 1), what + " carry and overflow");
+		}
+	}
+
+	// A 40 bit counter counts across bit 32, and wraps after a MAX_COUNT
+	// past 2^32. Then it loads a word from its inputs:
+	IDType clock, load, inDriver;
+	vector< IDType > clockWire = b.driver(1, clock);
+	vector< IDType > loadWire = b.driver(1, load);
+	vector< IDType > inWires = b.driver(40, inDriver);
+	IDType reg = b.gate("REGISTER");
+	b.param(reg, "INPUT_BITS", "40");
+	b.param(reg, "MAX_COUNT", toString(0x100000002ULL));
+	b.param(reg, "CURRENT_VALUE", toString(0xFFFFFFFEULL));
+	b.in(reg, "CLOCK", clockWire[0]);
+	b.in(reg, "LOAD", loadWire[0]);
+	for (unsigned long i = 0; i < 40; i++) b.in(reg, pin("IN", i), inWires[i]);
+	b.cir->setGateInputParameter(reg, "COUNT_ENABLE", "PULL_UP", "TRUE");
+	vector< IDType > regWires = b.outs(reg, "OUT", 40);
+	b.step(10);
+	checkBus(b, regWires, 0xFFFFFFFEULL, "the register's first value");
+
+	const unsigned long long counts[] = { 0xFFFFFFFFULL, 0x100000000ULL, 0x100000001ULL, 0x100000002ULL, 0 };
+	for (unsigned long n = 0; n < sizeof(counts) / sizeof(counts[0]); n++) {
+		drive(b, clock, 1);
+		drive(b, clock, 0);
+		checkBus(b, regWires, counts[n], "the register after " + toString(n + 1) + " counts");
+	}
+	checkEqual(cir.getGateParameter(reg, "CURRENT_VALUE"), "0", "the register's CURRENT_VALUE after wrapping");
+
+	drive(b, inDriver, 0xABCDEF0123ULL);
+	drive(b, load, 1);
+	drive(b, clock, 1);
+	drive(b, clock, 0);
+	drive(b, load, 0);
+	checkBus(b, regWires, 0xABCDEF0123ULL, "the register after loading");
+	checkEqual(cir.getGateParameter(reg, "CURRENT_VALUE"), toString(0xABCDEF0123ULL), "the register's CURRENT_VALUE after loading");
+
+	// A RAM with 40 address bits and 48 data bits keeps words that only
+	// differ in their high address bits apart:
+	IDType addressDriver, dataDriver, writeClock, writeEnable;
+	vector< IDType > addressWires = b.driver(40, addressDriver);
+	vector< IDType > dataWires = b.driver(48, dataDriver);
+	vector< IDType > writeClockWire = b.driver(1, writeClock);
+	vector< IDType > writeEnableWire = b.driver(1, writeEnable);
+	IDType ram = b.gate("RAM");
+	b.param(ram, "ADDRESS_BITS", "40");
+	b.param(ram, "DATA_BITS", "48");
+	for (unsigned long i = 0; i < 40; i++) b.in(ram, pin("ADDRESS", i), addressWires[i]);
+	for (unsigned long i = 0; i < 48; i++) b.in(ram, pin("DATA_IN", i), dataWires[i]);
+	b.in(ram, "WRITE_CLOCK", writeClockWire[0]);
+	b.in(ram, "WRITE_ENABLE", writeEnableWire[0]);
+	vector< IDType > ramWires = b.outs(ram, "DATA_OUT", 48);
+
+	const unsigned long long addresses[] = { 0x8000000005ULL, 5 };
+	const unsigned long long words[] = { 0xFEDCBA987654ULL, 0x123456789ABCULL };
+	for (unsigned long n = 0; n < 2; n++) {
+		drive(b, addressDriver, addresses[n]);
+		drive(b, dataDriver, words[n]);
+		drive(b, writeEnable, 1);
+		drive(b, writeClock, 1);
+		drive(b, writeClock, 0);
+		drive(b, writeEnable, 0);
+	}
+	for (unsigned long n = 0; n < 2; n++) {
+		drive(b, addressDriver, addresses[n]);
+		checkBus(b, ramWires, words[n], "RAM word " + toString(addresses[n]));
+		checkEqual(cir.getGateParameter(ram, "Address:" + toString(addresses[n])), toString(words[n]),
+			"the RAM's Address:" + toString(addresses[n]));
+	}
+}
+
+struct regressionTest {
+	string name;
+	void (*run)();
+};
+
+static const regressionTest tests[] = {
+	{ "ram_round_trip", testRamRoundTrip },
+	{ "intel_hex", testIntelHex },
+	{ "cycle_mixed_steps", testCycleMixedSteps },
+	{ "cmb_outputs", testCmbOutputs },
+	{ "fsm_outputs", testFsmOutputs },
+	{ "fault_unobservable", testFaultUnobservable },
+	{ "schedulers", testSchedulers },
+	{ "netlist_steps", testNetlistSteps },
+	{ "gate_threads", testGateThreads },
+	{ "pattern_sim", testPatternSim },
+	{ "compiled_gates", testCompiledGates },
+	{ "wide_buses", testWideBuses },
+};
+static const unsigned long numTests = sizeof(tests) / sizeof(tests[0]);
+
+static void usage() {
+	cerr << "Usage: cedarlogic-tests [test]" << endl
+		<< "Runs one test, or all of them:";
+	for (unsigned long n = 0; n < numTests; n++) {
+		cerr << " " << tests[n].name;
+	}
+	cerr << endl;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc > 2) {
+		usage();
+		return 2;
+	}
+	string only = (argc == 2) ? argv[1] : "";
+
+	bool found = false;
+	bool allPassed = true;
+	bool allSkipped = true;
+	for (unsigned long n = 0; n < numTests; n++) {
+		if (only != "" && tests[n].name != only) continue;
+		found = true;
+
+		testPassed = true;
+		skipReason = "";
+		tests[n].run();
+		if (testPassed && skipReason != "") {
+			cout << "SKIP " << tests[n].name << " (" << skipReason << ")" << endl;
+			continue;
+		}
+		cout << (testPassed ? "PASS " : "FAIL ") << tests[n].name << endl;
+		allPassed = allPassed && testPassed;
+		allSkipped = false;
+	}
+	if (!found) {
+		usage();
+		return 2;
+	}
+	// (77 is the exit code that ctest is told means skipped.)
+	if (allSkipped) return 77;
+	return allPassed ? 0 : 1;
+}